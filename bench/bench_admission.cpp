@@ -0,0 +1,120 @@
+// Well-behaved clients next to a misbehaving poller, on the simulated clock. Two clients poll the
+// device every 200 ms, each on a new connection. The poller holds 4 keep-alive connections from one
+// address, and sends its next request as soon as it's answered. A request takes 2 ms of the
+// device's time, each pass of the loop calls handle() and moves the clock by 100 us.
+// The server is unprotected, turns clients away with admission control past 3 active connections,
+// rate limits every address to 10 requests a second, or both.
+// Reports the latency of the well-behaved clients' requests, in simulated time, whatever they were
+// answered, the share of them answered 200, and the poller's requests answered 200 a second
+
+#include "HostBench.h"
+#include "ArduinoExpress.h"
+
+static const std::string POLL = "GET /api/status HTTP/1.1\r\nHost: device\r\nConnection: close\r\n\r\n";
+static const std::string FLOOD = "GET /api/status HTTP/1.1\r\nHost: device\r\n\r\n";
+
+static const int CLIENTS_COUNT = 2;
+static const unsigned long POLL_INTERVAL_US = 200000;
+static const int POLLER_CONNECTIONS_COUNT = 4;
+static const uint32_t POLLER_IP = IPAddress(10, 0, 0, 66);
+
+static bool answered200(const std::string& response) {return response.compare(0, 12, "HTTP/1.1 200") == 0;}
+
+
+// a well-behaved client: one request, then a pause
+struct Client{
+  host::SimulatedClient connection;
+  uint32_t remoteIP;
+  unsigned long sentAt = 0;
+  unsigned long nextAt = 0;
+  bool waiting = false;
+};
+
+
+static void serve(const char* protection, bool admission, bool rateLimit, int pollerCount, size_t count)
+{
+  host::resetNetwork();
+  ArduinoExpress app;
+  HTTP_RateLimiter limiter(600, 20);
+  if(rateLimit) app.use(ArduinoExpress::RateLimit(limiter));
+  if(admission) app.setAdmission(ArduinoExpressConfig::MAX_CONNECTIONS_COUNT - 1);
+  app.get("/api/status", [](Req&, Res& res) -> void* {
+    delay(2);
+    res.json(200, "{\"uptime\":86400,\"heap\":23120,\"rssi\":-61}");
+    return nullptr;
+  });
+  app.freeze();
+  app.begin(80);
+
+  std::vector<host::SimulatedClient> poller;
+  for(int i = 0; i < pollerCount; ++i){
+    poller.push_back(host::connect(80, POLLER_IP));
+    poller.back().send(FLOOD);
+  }
+  std::vector<Client> clients(CLIENTS_COUNT);
+  for(int i = 0; i < CLIENTS_COUNT; ++i){
+    clients[i].remoteIP = IPAddress(10, 0, 0, 2 + i);
+    clients[i].nextAt = micros() + i * POLL_INTERVAL_US / CLIENTS_COUNT;
+  }
+
+  host::Latencies latencies;
+  size_t requests = 0, served = 0, pollerServed = 0;
+  unsigned long start = micros();
+  while(requests < count)
+  {
+    app.handle();
+    host::advanceClock(100);
+    unsigned long now = micros();
+
+    for(host::SimulatedClient& connection : poller)
+    {
+      size_t length = host::responseLength(connection.received());
+      if(length == 0) continue;
+      pollerServed += answered200(connection.received());
+      connection.socket().outbound.erase(0, length);
+      if(connection.closedByServer()) connection = host::connect(80, POLLER_IP);
+      connection.send(FLOOD);
+    }
+
+    for(Client& client : clients)
+    {
+      if(!client.waiting){
+        if((long)(now - client.nextAt) < 0) continue;
+        client.connection = host::connect(80, client.remoteIP);
+        client.connection.send(POLL);
+        client.connection.close();
+        client.sentAt = now;
+        client.nextAt += POLL_INTERVAL_US;
+        client.waiting = true;
+        continue;
+      }
+      if(host::responseLength(client.connection.received()) == 0) continue;
+
+      client.waiting = false;
+      ++requests;
+      served += answered200(client.connection.received());
+      latencies.add(now - client.sentAt);
+    }
+  }
+  double seconds = (micros() - start) / 1e6;
+
+  host::printRow({protection, std::to_string(pollerCount), host::format(latencies.percentile(0.5) / 1000.0, 1),
+                  host::format(latencies.percentile(0.99) / 1000.0, 1), host::format(100.0 * served / requests, 1),
+                  host::format(pollerServed / seconds, 0)});
+}
+
+
+int main(int argc, char** argv)
+{
+  size_t count = host::iterations(argc, argv, 1000);
+  host::useSimulatedClock(true);
+
+  host::printHeader("Well-behaved clients next to a misbehaving poller",
+                    {"protection", "poller conns", "p50 ms", "p99 ms", "200 %", "poller 200/s"});
+  serve("none", false, false, 0, count);
+  serve("none", false, false, POLLER_CONNECTIONS_COUNT, count);
+  serve("admission", true, false, POLLER_CONNECTIONS_COUNT, count);
+  serve("rate limit", false, true, POLLER_CONNECTIONS_COUNT, count);
+  serve("both", true, true, POLLER_CONNECTIONS_COUNT, count);
+  return 0;
+}
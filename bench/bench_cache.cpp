@@ -0,0 +1,127 @@
+// A cached response: GET /api/status served by ArduinoExpress::Cache() from the response cache,
+// against the handler that builds it, a JSON document of the device's state, on every request.
+// Then If-None-Match requests answered with 304 from the cache.
+// Reports the latency percentiles, the allocations and the bytes written for a request
+
+#include "HostBench.h"
+#include "ArduinoExpress.h"
+
+// the router, with its callback chain callable from the benchmark
+struct BenchRouter : public ArduinoExpressRouter{
+  using ArduinoExpressRouter::execute;
+};
+
+// a transport that counts the bytes written by its clients. It keeps them only when recording
+struct CountingTransport : public HTTP_Transport{
+  size_t bytes = 0;
+  bool recording = false;
+  std::string recorded;
+
+  bool begin(int) override {return true;}
+  bool accept(int) override {return false;}
+  int available(int) override {return 0;}
+  int read(int, uint8_t*, size_t) override {return 0;}
+  size_t write(int, const uint8_t* data, size_t length) override
+  {
+    if(recording) recorded.append((const char*)data, length);
+    bytes += length;
+    return length;
+  }
+  bool connected(int) override {return true;}
+  void stop(int) override {}
+};
+
+static int _handled = 0;
+
+static void* sendStatus(Req&, Res& res)
+{
+  ++_handled;
+  StaticJsonBuffer<512> buffer;
+  JsonObject& status = buffer.createObject();
+  status["uptime"] = 86400;
+  status["heap"] = 31244;
+  status["rssi"] = -61;
+  status["firmware"] = "2.4.1";
+  JsonArray& sensors = buffer.createArray();
+  for(int i = 0; i < 8; ++i) sensors.add(20 + i);
+  status["sensors"] = sensors;
+
+  char body[256];
+  status.printTo(body, sizeof(body));
+  res.send(200, "application/json", body);
+  return nullptr;
+}
+
+
+static void measure(const char* name, BenchRouter& router, const std::string& request, size_t count)
+{
+  HTTP_RequestParser parser;
+  HTTP_Request req;
+  CountingTransport transport;
+  HTTP_Client client(transport, 0);
+  HTTP_Response res(&client);
+  String prefix;
+
+  auto serve = [&]{
+    req.clear();
+    parser.begin(req);
+    parser.feed(request.data(), request.size());
+    res.reset();
+    router.execute(prefix, req, res, Next{});
+  };
+
+  // the first request fills the cache, and sizes the response's buffers
+  serve();
+  serve();
+  transport.bytes = 0;
+  _handled = 0;
+
+  host::Latencies latencies;
+  host::Measurement run;
+  for(size_t i = 0; i < count; ++i){
+    uint64_t start = host::nanoseconds();
+    serve();
+    latencies.add(host::nanoseconds() - start);
+  }
+  run.stop();
+
+  host::printRow({name, host::format(latencies.percentile(0.5), 0), host::format(latencies.percentile(0.99), 0),
+                  host::format((double)run.allocations() / count, 2), host::format((double)transport.bytes / count, 0),
+                  host::format((double)_handled / count, 2)});
+}
+
+
+int main(int argc, char** argv)
+{
+  size_t count = host::iterations(argc, argv, 200000);
+
+  HTTP_ResponseCache cache;
+  BenchRouter cached;
+  cached.get("/api/status", ArduinoExpress::Cache(cache, 3600000), sendStatus);
+  cached.freeze();
+  BenchRouter uncached;
+  uncached.get("/api/status", sendStatus);
+  uncached.freeze();
+
+  std::string request = "GET /api/status HTTP/1.1\r\nHost: device\r\nAccept: application/json\r\n\r\n";
+  host::printHeader("GET /api/status", {"served by", "p50 ns", "p99 ns", "allocs/req", "bytes/req", "handler/req"});
+  measure("handler", uncached, request, count);
+  measure("cache", cached, request, count);
+
+  // the ETag of the cached response, sent back by the client
+  HTTP_RequestParser parser;
+  HTTP_Request req;
+  parser.begin(req);
+  parser.feed(request.data(), request.size());
+  CountingTransport transport;
+  transport.recording = true;
+  HTTP_Client client(transport, 0);
+  HTTP_Response res(&client);
+  String prefix;
+  cached.execute(prefix, req, res, Next{});
+  size_t etag = transport.recorded.find("ETag: ") + 6;
+  std::string conditional = "GET /api/status HTTP/1.1\r\nHost: device\r\nIf-None-Match: " +
+                            transport.recorded.substr(etag, transport.recorded.find("\r\n", etag) - etag) + "\r\n\r\n";
+  measure("cache, 304", cached, conditional, count);
+  return 0;
+}
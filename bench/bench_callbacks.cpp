@@ -0,0 +1,122 @@
+// The storage of handlers and middlewares: std::function, and InplaceFunction, which stores them
+// with ARDUINOEXPRESS_INPLACE_CALLBACKS. Calls a stored function, a captureless lambda and a lambda
+// capturing three pointers through both. Then stores 64 routes without a middleware: with both
+// functions in the route, and as RouteCallback does in this build, which only allocates a
+// middleware for the routes that have one. Reports what a route takes: the bytes it keeps (in the
+// router's table and on the heap), and the allocations storing it needed
+
+#include "HostBench.h"
+#include "ArduinoExpress.h"
+
+#include <functional>
+
+using InplaceEndpoint = InplaceFunction<void*(Req&, Res&), ArduinoExpressConfig::ENDPOINT_STORAGE_SIZE>;
+using InplaceMiddleware = InplaceFunction<void*(Req&, Res&, Next), ArduinoExpressConfig::MIDDLEWARE_STORAGE_SIZE>;
+
+static int _calls = 0;
+
+static void* handle(Req&, Res&)
+{
+  ++_calls;
+  return nullptr;
+}
+
+
+// calls each of the functions in turn, count times in all. Reports the nanoseconds a call takes
+template<typename Function>
+static void call(const char* callable, const char* storage, std::vector<Function>& functions, size_t count)
+{
+  HTTP_Request req;
+  HTTP_Response res(nullptr);
+
+  host::Measurement run;
+  for(size_t i = 0; i < count; ++i) functions[i % functions.size()](req, res);
+  run.stop();
+
+  if(_calls != (int)count){
+    fprintf(stderr, "%d calls of %d\n", _calls, (int)count);
+    exit(1);
+  }
+  _calls = 0;
+  host::printRow({callable, storage, host::format(run.seconds() * 1e9 / count, 2), host::format((double)sizeof(Function)),
+                  host::format((double)run.allocations() / count, 2)});
+}
+
+template<typename Callable>
+static void call(const char* callable, Callable function, size_t count)
+{
+  std::vector<std::function<void*(Req&, Res&)>> standard(16, function);
+  std::vector<InplaceEndpoint> inplace(16, function);
+  call(callable, "std::function", standard, count);
+  call(callable, "InplaceFunction", inplace, count);
+}
+
+
+// a route with its middleware and callback in place, in a std::function or an InplaceFunction
+template<typename Middleware, typename Endpoint>
+struct FunctionsRoute{
+  RoutePath path;
+  HTTP_Method method;
+  Middleware middleware;
+  Endpoint callback;
+};
+using StandardRoute = FunctionsRoute<std::function<void*(Req&, Res&, Next)>, std::function<void*(Req&, Res&)>>;
+using InplaceRoute = FunctionsRoute<InplaceMiddleware, InplaceEndpoint>;
+
+static String routePath(int index)
+{
+  return String("/api/item") + String(index);
+}
+
+// stores routesCount routes made by route(path) in a table. Reports the bytes a route takes, in
+// the table and on the heap, and the allocations storing it needed
+template<typename Route, typename MakeRoute>
+static void routes(const char* callable, const char* storage, int routesCount, MakeRoute route)
+{
+  std::vector<String> paths;
+  for(int i = 0; i < routesCount; ++i) paths.push_back(routePath(i));
+
+  RouterTable<Route> table;
+  host::AllocationStats before = host::allocationStats();
+  table.reserve(routesCount);
+  for(int i = 0; i < routesCount; ++i) table.push_back(route(paths[i]));
+  host::AllocationStats after = host::allocationStats();
+
+  double bytes = (double)(after.liveBytes - before.liveBytes) / routesCount;
+  double allocations = (double)(after.allocations - before.allocations) / routesCount;
+  host::printRow({callable, storage, host::format((double)sizeof(Route)), host::format(bytes, 0), host::format(allocations, 2)});
+}
+
+template<typename Callable>
+static void routes(const char* callable, int routesCount, Callable callback)
+{
+  routes<StandardRoute>(callable, "std::function", routesCount, [&](const String& path){
+    return StandardRoute{path, HTTP_Method::GET, nullptr, callback};
+  });
+  routes<InplaceRoute>(callable, "InplaceFunction", routesCount, [&](const String& path){
+    return InplaceRoute{path, HTTP_Method::GET, nullptr, callback};
+  });
+  routes<RouteCallback>(callable, "RouteCallback", routesCount, [&](const String& path){
+    return RouteCallback{HTTP_Method::GET, path, callback};
+  });
+}
+
+
+int main(int argc, char** argv)
+{
+  size_t count = host::iterations(argc, argv, 10000000);
+
+  host::printHeader("Calling a handler", {"callable", "storage", "ns/call", "bytes", "allocs/call"});
+  struct Context{void* a; void* b; void* c;} context{nullptr, nullptr, nullptr};
+  call("function", handle, count);
+  call("lambda", [](Req& req, Res& res){return handle(req, res);}, count);
+  call("3 pointers", [context](Req& req, Res& res){(void)context; return handle(req, res);}, count);
+
+  // the route's path takes the same in both, the difference is the callbacks'
+  String label = "a label too long to be stored inline";
+  host::printHeader("Storing 64 routes", {"callable", "storage", "sizeof", "bytes/route", "allocs/route"});
+  routes("function", 64, handle);
+  routes("3 pointers", 64, [context](Req& req, Res& res){(void)context; return handle(req, res);});
+  routes("a String", 64, [label](Req& req, Res& res){(void)label; return handle(req, res);});
+  return 0;
+}
@@ -0,0 +1,114 @@
+// Compressed responses on a throttled link: a 16 KB JSON document and 16 KB of random bytes sent
+// uncompressed, with gzip and with deflate by the Compress() middleware, over a WiFi link of
+// 1 Mbit/s and 2 ms of round trip, on the simulated clock.
+// Reports the bytes on the wire, the time the server spends on a response, and the time until its
+// last byte reaches the client: compression is worth its CPU time when the link is the bottleneck
+
+#include "HostBench.h"
+#include "ArduinoExpress.h"
+
+static const size_t BODY_SIZE = 16 * 1024;
+static String _body;
+
+static String json(size_t size)
+{
+  String body = "[";
+  for(int i = 0; body.length() < size - 64; ++i){
+    if(i > 0) body += ",";
+    body += String("{\"sensor\":\"t") + String(i % 17) + "\",\"value\":" + String(i * 7 % 1000) + ",\"unit\":\"C\"}";
+  }
+  return body + "]";
+}
+
+static String random(size_t size)
+{
+  String body;
+  body.reserve(size);
+  uint32_t state = 2463534242u;
+  while(body.length() < size){
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    // printable, so it's sent as the text it's labelled
+    body += (char)(' ' + state % 95);
+  }
+  return body;
+}
+
+static void* sendBody(Req&, Res& res)
+{
+  res.send(200, "application/json", _body);
+  return nullptr;
+}
+
+
+static void serve(ArduinoExpress& app, const char* bodyName, const char* encoding, size_t count)
+{
+  host::NetworkConditions wifi;
+  wifi.latencyUs = 1000;
+  wifi.bytesPerSecond = 125000;
+  host::setConditions(wifi);
+  std::string request = std::string("GET /data HTTP/1.1\r\nHost: device\r\nAccept-Encoding: ") + encoding + "\r\n\r\n";
+
+  host::SimulatedClient client = host::connect();
+  host::Latencies serverTimes;
+  uint64_t wire = 0;
+  unsigned long simulated = 0;
+
+  host::Measurement run;
+  for(size_t i = 0; i < count; ++i)
+  {
+    unsigned long sentAt = micros();
+    client.send(request);
+
+    // the server's time is measured on the PC's clock, apart from the network's on the simulated one
+    uint64_t serverTime = 0;
+    size_t length = 0;
+    while(true){
+      {
+        host::AllocationPause pause;
+        length = host::responseLength(client.received());
+      }
+      if(length > 0 && (long)(micros() - client.receivedAt()) >= 0) break;
+      uint64_t start = host::nanoseconds();
+      app.handle();
+      serverTime += host::nanoseconds() - start;
+      host::advanceClock(100);
+    }
+    serverTimes.add(serverTime);
+    wire += length;
+    simulated += client.receivedAt() - sentAt;
+
+    host::AllocationPause pause;
+    client.socket().outbound.clear();
+    // a keep-alive connection serves MAX_KEEP_ALIVE_REQUESTS requests
+    if(client.closedByServer()) client = host::connect();
+  }
+  run.stop();
+  client.close();
+  host::pump(app, [&]{return client.closedByServer();});
+
+  host::printRow({bodyName, encoding, host::format((double)wire / count, 0), host::format(serverTimes.percentile(0.5) / 1000.0, 1),
+                  host::format(simulated / 1000.0 / count, 1), host::format((double)run.allocations() / count, 2)});
+}
+
+
+int main(int argc, char** argv)
+{
+  size_t count = host::iterations(argc, argv, 1000);
+  if(count < 2) count = 2;
+  host::useSimulatedClock(true);
+
+  static ArduinoExpress app;
+  app.use(ArduinoExpress::Compress());
+  app.get("/data", sendBody);
+  app.freeze();
+  app.begin(80);
+
+  host::printHeader("A 16 KB response on a 1 Mbit/s WiFi link", {"body", "accepted", "wire B", "server us", "last byte ms", "allocs/resp"});
+  for(const char* bodyName : {"json", "random"}){
+    _body = strcmp(bodyName, "json") == 0 ? json(BODY_SIZE) : random(BODY_SIZE);
+    for(const char* encoding : {"identity", "gzip", "deflate"}) serve(app, bodyName, encoding, count);
+  }
+  return 0;
+}
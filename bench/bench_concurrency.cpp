@@ -0,0 +1,155 @@
+// Fast clients served next to 0 to 3 slow ones, which send their requests a byte every 5 ms over a
+// link with 50 ms of latency, on the simulated clock. Each pass of the loop calls handle() and
+// moves the clock by 100 us.
+// Reports the fast clients' requests per second, their latency in wall-clock time and in passes
+// of the loop, and the requests the slow clients got answered meanwhile.
+// Then the fast client next to 0 to 3 slow readers, which download a 16 KB body over a link of
+// 20 KB/s. Reports its latency in simulated time, and the bodies the slow readers got meanwhile
+
+#include "HostBench.h"
+#include "ArduinoExpress.h"
+
+static const std::string REQUEST = "GET /api/status HTTP/1.1\r\nHost: 192.168.4.1\r\nAccept: application/json\r\n\r\n";
+static const host::NetworkConditions SLOW{1, 50000, 200};
+static const host::NetworkConditions FAST{};
+
+static const std::string DOWNLOAD = "GET /firmware HTTP/1.1\r\nHost: 192.168.4.1\r\n\r\n";
+static const size_t DOWNLOAD_SIZE = 16384;
+static const host::NetworkConditions SLOW_READER{0, 0, 20000};
+
+static host::SimulatedClient connectWith(const host::NetworkConditions& conditions, const std::string& request = REQUEST)
+{
+  host::setConditions(conditions);
+  host::SimulatedClient client = host::connect();
+  client.send(request);
+  return client;
+}
+
+// takes the client's response if it's complete, and sends the next request. Returns true if it did
+static bool nextRequest(host::SimulatedClient& client, const host::NetworkConditions& conditions,
+                        const std::string& request = REQUEST)
+{
+  size_t length = host::responseLength(client.received());
+  if(length == 0) return false;
+
+  host::AllocationPause pause;
+  client.socket().outbound.erase(0, length);
+  if(client.closedByServer()) client = connectWith(conditions, request);
+  else client.send(request);
+  return true;
+}
+
+// closes the clients, and serves the app until their connections are closed
+static void closeAll(ArduinoExpress& app, std::vector<host::SimulatedClient>& clients)
+{
+  for(host::SimulatedClient& client : clients) client.close();
+  host::pump(app, [&]{
+    host::advanceClock(100);
+    for(host::SimulatedClient& client : clients) if(!client.closedByServer()) return false;
+    return true;
+  });
+}
+
+
+static void serve(ArduinoExpress& app, int slowCount, size_t count)
+{
+  host::resetNetwork();
+  app.begin(80);
+
+  std::vector<host::SimulatedClient> slow;
+  for(int i = 0; i < slowCount; ++i) slow.push_back(connectWith(SLOW));
+  host::SimulatedClient fast = connectWith(FAST);
+
+  host::Latencies latencies, passes;
+  size_t slowServed = 0;
+  uint64_t start = host::nanoseconds();
+  size_t passCount = 0;
+
+  host::Measurement run;
+  for(size_t served = 0; served < count; )
+  {
+    app.handle();
+    host::advanceClock(100);
+    ++passCount;
+
+    for(host::SimulatedClient& client : slow) slowServed += nextRequest(client, SLOW);
+    if(nextRequest(fast, FAST)){
+      uint64_t now = host::nanoseconds();
+      latencies.add(now - start);
+      passes.add(passCount);
+      start = now;
+      passCount = 0;
+      ++served;
+    }
+  }
+  run.stop();
+
+  // the next round starts with every slot free
+  slow.push_back(fast);
+  closeAll(app, slow);
+
+  host::printRow({std::to_string(slowCount), host::format(count / run.seconds()), host::format(latencies.percentile(0.5) / 1000.0, 2),
+                  host::format(latencies.percentile(0.99) / 1000.0, 2), host::format((double)passes.percentile(0.99)),
+                  std::to_string(slowServed)});
+}
+
+
+static void serveNextToReaders(ArduinoExpress& app, int readerCount, size_t count)
+{
+  host::resetNetwork();
+  app.begin(80);
+
+  std::vector<host::SimulatedClient> readers;
+  for(int i = 0; i < readerCount; ++i) readers.push_back(connectWith(SLOW_READER, DOWNLOAD));
+  host::SimulatedClient fast = connectWith(FAST);
+
+  host::Latencies latencies;
+  size_t downloads = 0;
+  unsigned long sentAt = micros();
+  for(size_t served = 0; served < count; )
+  {
+    app.handle();
+    host::advanceClock(100);
+
+    for(host::SimulatedClient& client : readers) downloads += nextRequest(client, SLOW_READER, DOWNLOAD);
+    if(nextRequest(fast, FAST)){
+      unsigned long now = micros();
+      latencies.add(now - sentAt);
+      sentAt = now;
+      ++served;
+    }
+  }
+
+  readers.push_back(fast);
+  closeAll(app, readers);
+
+  host::printRow({std::to_string(readerCount), host::format(latencies.percentile(0.5) / 1000.0, 1),
+                  host::format(latencies.percentile(0.99) / 1000.0, 1), std::to_string(downloads)});
+}
+
+
+int main(int argc, char** argv)
+{
+  size_t count = host::iterations(argc, argv, 100000);
+  host::useSimulatedClock(true);
+
+  static ArduinoExpress app;
+  app.get("/api/status", [](Req&, Res& res) -> void* {
+    res.json(200, "{\"uptime\":86400,\"heap\":23120,\"rssi\":-61,\"clients\":2}");
+    return nullptr;
+  });
+  static const std::string image(DOWNLOAD_SIZE, 'x');
+  static const String firmware(image.data(), image.size());
+  app.get("/firmware", [](Req&, Res& res) -> void* {
+    res.send(200, "application/octet-stream", firmware);
+    return nullptr;
+  });
+  app.freeze();
+
+  host::printHeader("A fast client next to slow ones", {"slow clients", "fast req/s", "p50 us", "p99 us", "p99 passes", "slow served"});
+  for(int slowCount = 0; slowCount < ArduinoExpressConfig::MAX_CONNECTIONS_COUNT; ++slowCount) serve(app, slowCount, count);
+
+  host::printHeader("A fast client next to slow readers", {"slow readers", "p50 ms", "p99 ms", "downloads"});
+  for(int readerCount = 0; readerCount < ArduinoExpressConfig::MAX_CONNECTIONS_COUNT; ++readerCount) serveNextToReaders(app, readerCount, count);
+  return 0;
+}
@@ -0,0 +1,153 @@
+// Running a request through a chain of 1, 10 and 50 callbacks: middlewares that all call next(),
+// then the route. ArduinoExpressRouter::execute walks the chain in a loop, with a Next that only
+// records it was called; the baseline is the recursion it replaced, where each callback got a
+// std::function<void()> next that captured the prefix, the request and the response, and called
+// the next callback from inside the previous one. Routers nested in routers are measured too.
+// Reports the latency, the allocations and the most stack a dispatch takes
+
+#include "HostBench.h"
+#include "ArduinoExpress.h"
+
+#include <functional>
+#include <memory>
+
+// the router, with its callback chain callable from the benchmark
+struct BenchRouter : public ArduinoExpressRouter{
+  using ArduinoExpressRouter::execute;
+};
+
+static int _calls = 0;
+
+static void* passOn(Req&, Res&, Next next)
+{
+  ++_calls;
+  next();
+  return nullptr;
+}
+
+static void* handle(Req&, Res&)
+{
+  ++_calls;
+  return nullptr;
+}
+
+
+// the recursive chain: callback i calls callback i + 1 through the std::function it's given
+using RecursiveCallback = std::function<void(Req&, Res&, std::function<void()>)>;
+
+static void executeRecursively(const std::vector<RecursiveCallback>& chain, size_t position, const String& prefix, Req& req, Res& res)
+{
+  if(position >= chain.size()) return;
+  chain[position](req, res, [&chain, position, prefix, &req, &res](){
+    executeRecursively(chain, position + 1, prefix, req, res);
+  });
+}
+
+
+struct Result{
+  host::Latencies latencies;
+  uint64_t allocations = 0;
+  size_t stack = 0;
+};
+
+template<typename Dispatch>
+static Result measure(size_t count, Dispatch dispatch)
+{
+  Result result;
+  // the first dispatch initialises what's lazily initialised, it's not the one measured
+  dispatch();
+  host::StackProbe probe;
+  probe.paint();
+  dispatch();
+  result.stack = probe.used();
+
+  host::Measurement run;
+  for(size_t i = 0; i < count; ++i){
+    uint64_t start = host::nanoseconds();
+    dispatch();
+    result.latencies.add(host::nanoseconds() - start);
+  }
+  run.stop();
+  result.allocations = run.allocations();
+  return result;
+}
+
+static void printResult(const char* chain, const char* dispatcher, Result& result, size_t count)
+{
+  host::printRow({chain, dispatcher, host::format(result.latencies.percentile(0.5), 0), host::format(result.latencies.percentile(0.99), 0),
+                  host::format((double)result.allocations / count, 2), host::format((double)result.stack)});
+}
+
+
+static void checkCalls(int expected)
+{
+  if(_calls != expected){
+    fprintf(stderr, "%d callbacks of %d called\n", _calls, expected);
+    exit(1);
+  }
+  _calls = 0;
+}
+
+
+static void flat(int callbacksCount, size_t count, HTTP_Request& req)
+{
+  BenchRouter router;
+  std::vector<RecursiveCallback> chain;
+  for(int i = 0; i < callbacksCount - 1; ++i){
+    router.use(passOn);
+    chain.push_back([](Req& req, Res& res, std::function<void()> next){++_calls; (void)req; (void)res; next();});
+  }
+  router.get("/api/status", handle);
+  chain.push_back([](Req& req, Res& res, std::function<void()>){handle(req, res);});
+  router.freeze();
+
+  HTTP_Response res(nullptr);
+  String prefix;
+  Result looped = measure(count, [&]{router.execute(prefix, req, res, Next{});});
+  checkCalls((int)(count + 2) * callbacksCount);
+  Result recursive = measure(count, [&]{executeRecursively(chain, 0, prefix, req, res);});
+  checkCalls((int)(count + 2) * callbacksCount);
+
+  String name = String(callbacksCount) + " flat";
+  printResult(name.c_str(), "loop", looped, count);
+  printResult(name.c_str(), "recursion", recursive, count);
+}
+
+
+static void nested(int depth, size_t count, HTTP_Request& req)
+{
+  // each router has a middleware and the next router, the last one has the route
+  std::vector<std::unique_ptr<BenchRouter>> routers;
+  for(int i = 0; i < depth; ++i) routers.emplace_back(new BenchRouter());
+  for(int i = 0; i < depth; ++i){
+    routers[i]->use(passOn);
+    if(i + 1 < depth) routers[i]->use(routers[i + 1].get());
+    else routers[i]->get("/api/status", handle);
+  }
+  for(int i = depth - 1; i >= 0; --i) routers[i]->freeze();
+
+  HTTP_Response res(nullptr);
+  String prefix;
+  Result looped = measure(count, [&]{routers[0]->execute(prefix, req, res, Next{});});
+  checkCalls((int)(count + 2) * (depth + 1));
+
+  String name = String(depth) + " nested";
+  printResult(name.c_str(), "loop", looped, count);
+}
+
+
+int main(int argc, char** argv)
+{
+  size_t count = host::iterations(argc, argv, 100000);
+
+  static const char request[] = "GET /api/status HTTP/1.1\r\nHost: device\r\n\r\n";
+  HTTP_RequestParser parser;
+  HTTP_Request req;
+  parser.begin(req);
+  parser.feed(request, sizeof(request) - 1);
+
+  host::printHeader("Dispatching a request through a chain of callbacks", {"callbacks", "dispatch", "p50 ns", "p99 ns", "allocs/req", "stack B"});
+  for(int callbacksCount : {1, 10, 50}) flat(callbacksCount, count, req);
+  for(int depth : {1, 10}) nested(depth, count, req);
+  return 0;
+}
@@ -0,0 +1,134 @@
+// Decoding form bodies: a 1 MB file in a multipart body, fed to HTTP_MultipartParser in the pieces
+// a connection reads (64 bytes to the request buffer's size), against buffering the body in a
+// String and splitting it at its boundaries once it's complete. Then a urlencoded settings form,
+// decoded in place by parseUrlEncoded().
+// Reports the throughput, the allocations and the peak heap of decoding a body
+
+#include "HostBench.h"
+#include "ArduinoExpress.h"
+
+static const char BOUNDARY[] = "----form7MA4YWxkTrZu0gW";
+static const size_t FILE_SIZE = 1024 * 1024;
+
+static size_t _received = 0;
+
+static void receivePart(HTTP_Request&, const HTTP_FormPart&, const uint8_t*, size_t length)
+{
+  _received += length;
+}
+
+static std::string multipartBody()
+{
+  std::string content(FILE_SIZE, '\0');
+  uint32_t state = 12345;
+  for(char& byte : content){
+    state = state * 1103515245 + 12345;
+    byte = (char)(state >> 24);
+  }
+  return std::string("--") + BOUNDARY + "\r\nContent-Disposition: form-data; name=\"name\"\r\n\r\nsensor-1\r\n" +
+         "--" + BOUNDARY + "\r\nContent-Disposition: form-data; name=\"firmware\"; filename=\"firmware.bin\"\r\n" +
+         "Content-Type: application/octet-stream\r\n\r\n" + content + "\r\n--" + BOUNDARY + "--\r\n";
+}
+
+
+// the body buffered whole, then split at the delimiters
+static size_t splitBuffered(const std::string& body, size_t pieceSize)
+{
+  String buffered;
+  for(size_t offset = 0; offset < body.size(); offset += pieceSize){
+    size_t length = std::min(pieceSize, body.size() - offset);
+    buffered.concat(body.data() + offset, length);
+  }
+
+  String delimiter = String("\r\n--") + BOUNDARY;
+  size_t received = 0;
+  int start = buffered.indexOf(BOUNDARY);
+  while(start >= 0){
+    int content = buffered.indexOf("\r\n\r\n", start);
+    if(content < 0) break;
+    content += 4;
+    int end = -1;
+    // the content is binary, the delimiter is searched with memmem rather than indexOf
+    const char* found = (const char*)memmem(buffered.c_str() + content, buffered.length() - content, delimiter.c_str(), delimiter.length());
+    if(found) end = found - buffered.c_str();
+    if(end < 0) break;
+    received += end - content;
+    start = end + 4;
+  }
+  return received;
+}
+
+
+static void multipart(const std::string& body, size_t pieceSize, size_t repeats)
+{
+  HTTP_Request req;
+  HTTP_MultipartParser parser;
+  HTTP_StringView boundary(BOUNDARY, sizeof(BOUNDARY) - 1);
+  size_t expected = FILE_SIZE + 8;
+
+  host::Measurement streamed;
+  for(size_t repeat = 0; repeat < repeats; ++repeat){
+    req.clear();
+    _received = 0;
+    parser.begin(req, boundary, receivePart);
+    for(size_t offset = 0; offset < body.size(); offset += pieceSize){
+      parser.feed((const uint8_t*)body.data() + offset, std::min(pieceSize, body.size() - offset));
+    }
+    if(!parser.done() || _received != expected){
+      fprintf(stderr, "%u bytes of %u received\n", (unsigned)_received, (unsigned)expected);
+      exit(1);
+    }
+  }
+  streamed.stop();
+
+  host::Measurement buffered;
+  for(size_t repeat = 0; repeat < repeats; ++repeat){
+    if(splitBuffered(body, pieceSize) != expected){
+      fprintf(stderr, "the buffered body was not split\n");
+      exit(1);
+    }
+  }
+  buffered.stop();
+
+  double megabytes = (double)body.size() * repeats / (1024 * 1024);
+  host::printRow({String((unsigned)pieceSize).c_str(), "streamed", host::format(megabytes / streamed.seconds(), 1),
+                  host::format((double)streamed.allocations() / repeats, 1), host::format((double)streamed.peakBytes())});
+  host::printRow({String((unsigned)pieceSize).c_str(), "buffered", host::format(megabytes / buffered.seconds(), 1),
+                  host::format((double)buffered.allocations() / repeats, 1), host::format((double)buffered.peakBytes())});
+}
+
+
+static void urlencoded(size_t count)
+{
+  static const char form[] = "ssid=My+Home%20WiFi&password=p%40ss%26word&hostname=sensor-1&interval=60&mode=auto";
+  char text[sizeof(form)];
+  HTTP_Param params[ArduinoExpressConfig::MAX_QUERY_COUNT];
+
+  host::Latencies latencies;
+  host::Measurement run;
+  for(size_t i = 0; i < count; ++i){
+    uint64_t start = host::nanoseconds();
+    memcpy(text, form, sizeof(form));
+    if(parseUrlEncoded(text, params, 0, ArduinoExpressConfig::MAX_QUERY_COUNT) != 5) exit(1);
+    latencies.add(host::nanoseconds() - start);
+  }
+  run.stop();
+
+  host::printHeader("A urlencoded form of 5 fields", {"decoder", "p50 ns", "p99 ns", "allocs/form"});
+  host::printRow({"in place", host::format(latencies.percentile(0.5), 0), host::format(latencies.percentile(0.99), 0),
+                  host::format((double)run.allocations() / count, 2)});
+}
+
+
+int main(int argc, char** argv)
+{
+  size_t repeats = host::iterations(argc, argv, 100);
+  if(repeats < 2) repeats = 2;
+  std::string body = multipartBody();
+
+  host::printHeader("A 1 MB file in a multipart body", {"piece B", "decoder", "MB/s", "allocs/body", "peak B"});
+  for(int pieceSize : {64, 536, 1460, ArduinoExpressConfig::REQUEST_BUFFER_SIZE}) multipart(body, pieceSize, repeats);
+
+  urlencoded(repeats * 10000);
+  return 0;
+}
@@ -0,0 +1,158 @@
+// Looking up the headers of requests sent by browsers and HTTP clients: the HTTP_HeaderIndex of
+// HTTP_Request, which finds a well known header by its id and any other by a hash of its name,
+// against the scan it replaced, which compared the name to every one of MAX_HEADERS_COUNT String
+// slots, set or empty, case-sensitively.
+// Each request is parsed, then the headers a server typically reads are looked up, some missing: by
+// name as a handler does, and by HTTP_HeaderId as the library does. Reports the time of the lookups,
+// and of the parse with them, and the allocations of a request
+
+#include "HostBench.h"
+#include "ArduinoExpress.h"
+
+struct HeaderSet{
+  const char* name;
+  const char* request;
+};
+
+static const HeaderSet HEADER_SETS[] = {
+  {"chrome",
+   "GET /api/status HTTP/1.1\r\nHost: 192.168.4.1\r\nConnection: keep-alive\r\n"
+   "sec-ch-ua: \"Chromium\";v=\"124\", \"Google Chrome\";v=\"124\"\r\nsec-ch-ua-mobile: ?0\r\n"
+   "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/124.0 Safari/537.36\r\n"
+   "sec-ch-ua-platform: \"Linux\"\r\nAccept: */*\r\nSec-Fetch-Site: same-origin\r\nSec-Fetch-Mode: cors\r\n"
+   "Sec-Fetch-Dest: empty\r\nReferer: http://192.168.4.1/\r\nAccept-Encoding: gzip, deflate\r\n"
+   "Accept-Language: en-US,en;q=0.9\r\nIf-None-Match: \"1a2b\"\r\n\r\n"},
+  {"firefox",
+   "GET /api/status HTTP/1.1\r\nHost: 192.168.4.1\r\n"
+   "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:125.0) Gecko/20100101 Firefox/125.0\r\nAccept: */*\r\n"
+   "Accept-Language: en-US,en;q=0.5\r\nAccept-Encoding: gzip, deflate\r\nReferer: http://192.168.4.1/\r\n"
+   "Connection: keep-alive\r\nSec-Fetch-Dest: empty\r\nSec-Fetch-Mode: cors\r\nSec-Fetch-Site: same-origin\r\n"
+   "Priority: u=4\r\n\r\n"},
+  {"safari",
+   "GET /api/status HTTP/1.1\r\nHost: 192.168.4.1\r\nAccept: */*\r\nSec-Fetch-Site: same-origin\r\n"
+   "Accept-Language: en-GB,en;q=0.9\r\nAccept-Encoding: gzip, deflate\r\nSec-Fetch-Mode: cors\r\n"
+   "User-Agent: Mozilla/5.0 (Macintosh; Intel Mac OS X 10_15_7) AppleWebKit/605.1.15 (KHTML, like Gecko) Version/17.4 Safari/605.1.15\r\n"
+   "Referer: http://192.168.4.1/\r\nConnection: keep-alive\r\nSec-Fetch-Dest: empty\r\n\r\n"},
+  {"curl",
+   "GET /api/status HTTP/1.1\r\nHost: 192.168.4.1\r\nUser-Agent: curl/8.4.0\r\nAccept: */*\r\n\r\n"},
+  {"esp client",
+   "POST /api/readings HTTP/1.1\r\nHost: 192.168.4.1\r\nUser-Agent: ESP8266HTTPClient\r\n"
+   "Connection: keep-alive\r\nAccept-Encoding: identity;q=1,chunked;q=0.1,*;q=0\r\n"
+   "Authorization: Bearer 0123456789abcdef\r\nContent-Type: application/json\r\nContent-Length: 0\r\n\r\n"},
+};
+
+// the headers a server reads, as the names a handler passes
+static const char* const LOOKUPS[] = {"Host", "Connection", "Accept-Encoding", "Content-Length", "Content-Type",
+                                      "Authorization", "If-None-Match", "Origin", "Sec-Fetch-Mode", "X-Requested-With"};
+static const int LOOKUPS_COUNT = sizeof(LOOKUPS) / sizeof(LOOKUPS[0]);
+static HTTP_HeaderId _lookupIds[LOOKUPS_COUNT];
+
+// the headers as the scan kept them
+struct ScannedHeaders{
+  String keys[ArduinoExpressConfig::MAX_HEADERS_COUNT];
+  String values[ArduinoExpressConfig::MAX_HEADERS_COUNT];
+};
+
+static const String& scanHeader(const ScannedHeaders& headers, const String& key)
+{
+  static const String none;
+  for(int i = 0; i < ArduinoExpressConfig::MAX_HEADERS_COUNT; ++i){
+    if(headers.keys[i] == key) return headers.values[i];
+  }
+  return none;
+}
+
+
+static void measure(const HeaderSet& set, size_t count)
+{
+  HTTP_RequestParser parser;
+  HTTP_Request req;
+  size_t length = strlen(set.request);
+  String lookups[LOOKUPS_COUNT];
+  for(int i = 0; i < LOOKUPS_COUNT; ++i) lookups[i] = LOOKUPS[i];
+  size_t found = 0;
+
+  host::Latencies indexLatencies, indexLookupLatencies;
+  host::Measurement indexed;
+  for(size_t i = 0; i < count; ++i){
+    uint64_t start = host::nanoseconds();
+    req.clear();
+    parser.begin(req);
+    parser.feed(set.request, length);
+    uint64_t parsed = host::nanoseconds();
+    for(int lookup = 0; lookup < LOOKUPS_COUNT; ++lookup) found += req.getHeader(LOOKUPS[lookup]).length();
+    uint64_t end = host::nanoseconds();
+    indexLatencies.add(end - start);
+    indexLookupLatencies.add(end - parsed);
+  }
+  indexed.stop();
+
+  // the well known headers by id, the others by name
+  host::Latencies idLatencies, idLookupLatencies;
+  host::Measurement byId;
+  for(size_t i = 0; i < count; ++i){
+    uint64_t start = host::nanoseconds();
+    req.clear();
+    parser.begin(req);
+    parser.feed(set.request, length);
+    uint64_t parsed = host::nanoseconds();
+    for(int lookup = 0; lookup < LOOKUPS_COUNT; ++lookup){
+      HTTP_HeaderId id = _lookupIds[lookup];
+      found += (id != HEADER_OTHER ? req.getHeader(id) : req.getHeader(LOOKUPS[lookup])).length();
+    }
+    uint64_t end = host::nanoseconds();
+    idLatencies.add(end - start);
+    idLookupLatencies.add(end - parsed);
+  }
+  byId.stop();
+
+  // the scan kept the parsed headers in Strings
+  ScannedHeaders headers;
+  host::Latencies scanLatencies, scanLookupLatencies;
+  host::Measurement scanned;
+  for(size_t i = 0; i < count; ++i){
+    uint64_t start = host::nanoseconds();
+    req.clear();
+    parser.begin(req);
+    parser.feed(set.request, length);
+    for(int slot = 0; slot < ArduinoExpressConfig::MAX_HEADERS_COUNT; ++slot){
+      headers.keys[slot] = slot < req.headersCount ? req.headers[slot].key.c_str() : "";
+      headers.values[slot] = slot < req.headersCount ? req.headers[slot].value.c_str() : "";
+    }
+    uint64_t parsed = host::nanoseconds();
+    for(int lookup = 0; lookup < LOOKUPS_COUNT; ++lookup) found += scanHeader(headers, lookups[lookup]).length();
+    uint64_t end = host::nanoseconds();
+    scanLatencies.add(end - start);
+    scanLookupLatencies.add(end - parsed);
+  }
+  scanned.stop();
+
+  if(found == 0){
+    fprintf(stderr, "%s: no header found\n", set.name);
+    exit(1);
+  }
+
+  String headersCount(req.headersCount);
+  host::printRow({set.name, headersCount.c_str(), "index, ids", host::format(idLookupLatencies.percentile(0.5), 0),
+                  host::format(idLatencies.percentile(0.5), 0), host::format(idLatencies.percentile(0.99), 0),
+                  host::format((double)byId.allocations() / count, 2)});
+  host::printRow({set.name, headersCount.c_str(), "index", host::format(indexLookupLatencies.percentile(0.5), 0),
+                  host::format(indexLatencies.percentile(0.5), 0), host::format(indexLatencies.percentile(0.99), 0),
+                  host::format((double)indexed.allocations() / count, 2)});
+  host::printRow({set.name, headersCount.c_str(), "scan", host::format(scanLookupLatencies.percentile(0.5), 0),
+                  host::format(scanLatencies.percentile(0.5), 0), host::format(scanLatencies.percentile(0.99), 0),
+                  host::format((double)scanned.allocations() / count, 2)});
+}
+
+
+int main(int argc, char** argv)
+{
+  size_t count = host::iterations(argc, argv, 200000);
+  for(int lookup = 0; lookup < LOOKUPS_COUNT; ++lookup) _lookupIds[lookup] = toHeaderId(LOOKUPS[lookup], strlen(LOOKUPS[lookup]));
+
+  char title[80];
+  snprintf(title, sizeof(title), "Parsing a request and looking up %d headers", LOOKUPS_COUNT);
+  host::printHeader(title, {"client", "headers", "lookup", "lookups ns", "p50 ns", "p99 ns", "allocs/req"});
+  for(const HeaderSet& set : HEADER_SETS) measure(set, count);
+  return 0;
+}
@@ -0,0 +1,80 @@
+// Reading N fields of a JSON body: req.bodyJSON(), which parses the body once into the arena the
+// connection keeps, against what it did before: a DynamicJsonBuffer created and the whole body
+// parsed again for each field read.
+// Reports the time and the allocations of a request, its parse included
+
+#include "HostBench.h"
+#include "ArduinoExpress.h"
+
+// HTTP_Request::bodyJSON() before the document was kept
+static long reparse(const HTTP_Request& req, const char* key)
+{
+  DynamicJsonBuffer buffer(200);
+  JsonObject& document = buffer.parseObject(req.body.c_str());
+  if(!document.success()) return 0;
+  return document.get<long>(key);
+}
+
+
+static void measure(int fieldsCount, size_t count)
+{
+  // a body of 20 fields, of which fieldsCount are read
+  std::string body = "{";
+  std::vector<std::string> keys;
+  for(int i = 0; i < 20; ++i){
+    keys.push_back("field" + std::to_string(i));
+    body += (i ? ",\"" : "\"") + keys.back() + "\":" + std::to_string(1000 + i);
+  }
+  body += "}";
+  std::string request = "POST /config HTTP/1.1\r\nContent-Type: application/json\r\nContent-Length: " +
+                        std::to_string(body.size()) + "\r\n\r\n" + body;
+
+  HTTP_RequestParser parser;
+  HTTP_Request req;
+  long sum = 0;
+
+  host::Latencies cachedLatencies;
+  host::Measurement cached;
+  for(size_t i = 0; i < count; ++i){
+    uint64_t start = host::nanoseconds();
+    req.clear();
+    parser.begin(req);
+    parser.feed(request.data(), request.size());
+    for(int field = 0; field < fieldsCount; ++field) sum += req.bodyJSON(keys[field].c_str()).as<long>();
+    cachedLatencies.add(host::nanoseconds() - start);
+  }
+  cached.stop();
+
+  host::Latencies reparsedLatencies;
+  host::Measurement reparsed;
+  for(size_t i = 0; i < count; ++i){
+    uint64_t start = host::nanoseconds();
+    req.clear();
+    parser.begin(req);
+    parser.feed(request.data(), request.size());
+    for(int field = 0; field < fieldsCount; ++field) sum -= reparse(req, keys[field].c_str());
+    reparsedLatencies.add(host::nanoseconds() - start);
+  }
+  reparsed.stop();
+
+  if(sum != 0){
+    fprintf(stderr, "the fields read differ\n");
+    exit(1);
+  }
+
+  String fields(fieldsCount);
+  host::printRow({fields.c_str(), "cached", host::format(cachedLatencies.percentile(0.5), 0), host::format(cachedLatencies.percentile(0.99), 0),
+                  host::format((double)cached.allocations() / count, 2), host::format((double)cached.peakBytes())});
+  host::printRow({fields.c_str(), "reparsed", host::format(reparsedLatencies.percentile(0.5), 0), host::format(reparsedLatencies.percentile(0.99), 0),
+                  host::format((double)reparsed.allocations() / count, 2), host::format((double)reparsed.peakBytes())});
+}
+
+
+int main(int argc, char** argv)
+{
+  size_t count = host::iterations(argc, argv, 50000);
+
+  host::printHeader("Reading fields of a 20 field JSON body", {"fields", "document", "p50 ns", "p99 ns", "allocs/req", "peak B"});
+  for(int fieldsCount : {1, 5, 20}) measure(fieldsCount, count);
+  return 0;
+}
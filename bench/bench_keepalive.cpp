@@ -0,0 +1,114 @@
+// The dashboard corpus served on one keep-alive connection, pipelined or one request at a time,
+// and on a new connection per request, as before keep-alive.
+// Reports the requests per second, the latency percentiles and the allocations per request, then
+// the time a request takes on a WiFi link with 2 ms of round trip, where a new connection costs a
+// round trip of TCP handshake, on the simulated clock
+
+#include "HostBench.h"
+#include "ArduinoExpress.h"
+
+enum Mode {KEEP_ALIVE, PIPELINED, CLOSE};
+static const int PIPELINE_DEPTH = 4;
+
+static std::vector<std::string> loadRequests(Mode mode)
+{
+  std::vector<std::string> corpus = host::loadCorpus(CORPUS_DIR "/dashboard.http");
+  for(std::string& request : corpus){
+    size_t header = request.find("Connection: keep-alive");
+    if(header != std::string::npos && mode == CLOSE) request.replace(header, 22, "Connection: close");
+  }
+  return corpus;
+}
+
+
+struct Result{
+  double requestsPerSecond;
+  double p50, p99;  // us
+  double allocations;
+  double simulatedMs;  // per request, on the simulated clock
+};
+
+static Result serve(ArduinoExpress& app, Mode mode, size_t count, const host::NetworkConditions& conditions)
+{
+  std::vector<std::string> corpus = loadRequests(mode);
+  host::setConditions(conditions);
+  unsigned long simulatedStart = micros();
+  host::SimulatedClient client = host::connect();
+  host::Latencies latencies;
+  size_t batch = mode == PIPELINED ? PIPELINE_DEPTH : 1;
+
+  host::Measurement run;
+  for(size_t i = 0; i < count; i += batch)
+  {
+    uint64_t start = host::nanoseconds();
+    if(mode == CLOSE) client = host::connect();
+    for(size_t j = 0; j < batch; ++j) client.send(corpus[(i + j) % corpus.size()]);
+
+    // the responses are taken off the client as they arrive
+    size_t received = 0;
+    host::pump(app, [&]{
+      host::AllocationPause pause;
+      while(host::responseLength(client.received()) && (long)(micros() - client.receivedAt()) >= 0){
+        client.socket().outbound.erase(0, host::responseLength(client.received()));
+        ++received;
+      }
+      if(received == batch && (mode != CLOSE || client.closedByServer())) return true;
+      if(conditions.latencyUs) host::advanceClock(10);
+      return false;
+    });
+    latencies.add((host::nanoseconds() - start) / batch);
+
+    if(mode != CLOSE && client.closedByServer()) client = host::connect();
+  }
+  run.stop();
+  unsigned long simulated = micros() - simulatedStart;
+  client.close();
+  host::pump(app, [&]{return client.closedByServer();});
+
+  return {count / run.seconds(), latencies.percentile(0.5) / 1000.0, latencies.percentile(0.99) / 1000.0,
+          (double)run.allocations() / count, simulated / 1000.0 / count};
+}
+
+
+static void compare(ArduinoExpress& app, Mode mode, const char* name, size_t count)
+{
+  Result cpu = serve(app, mode, count, host::NetworkConditions{});
+  host::NetworkConditions wifi;
+  wifi.latencyUs = 1000;
+  wifi.connectUs = 2000;
+  Result link = serve(app, mode, count / 10 ? count / 10 : 1, wifi);
+
+  host::printRow({name, host::format(cpu.requestsPerSecond), host::format(cpu.p50, 2), host::format(cpu.p99, 2),
+                  host::format(cpu.allocations, 2), host::format(link.simulatedMs, 2)});
+}
+
+
+int main(int argc, char** argv)
+{
+  size_t count = host::iterations(argc, argv, 200000);
+  host::useSimulatedClock(true);
+
+  static ArduinoExpress app;
+  app.get("/api/status", [](Req&, Res& res) -> void* {
+    res.json(200, "{\"uptime\":86400,\"heap\":23120,\"rssi\":-61,\"clients\":2}");
+    return nullptr;
+  });
+  app.get("/api/devices/:id/state", [](Req& req, Res& res) -> void* {
+    char body[64];
+    snprintf(body, sizeof(body), "{\"id\":%s,\"state\":\"on\"}", req.getParam("id").c_str());
+    res.json(200, body);
+    return nullptr;
+  });
+  app.get("/api/sensors", [](Req&, Res& res) -> void* {
+    res.json(200, "[21.5,21.7,21.6]");
+    return nullptr;
+  });
+  app.freeze();
+  app.begin(80);
+
+  host::printHeader("The dashboard corpus on persistent and new connections", {"connection", "requests/s", "p50 us", "p99 us", "allocs/req", "WiFi ms/req"});
+  compare(app, KEEP_ALIVE, "keep-alive", count);
+  compare(app, PIPELINED, "pipelined x4", count);
+  compare(app, CLOSE, "close", count);
+  return 0;
+}
@@ -0,0 +1,59 @@
+// Serving a request with the library's logging at each level: built once for each library variant
+// of CMakeLists.txt, with ARDUINOEXPRESS_LOG_LEVEL and ARDUINOEXPRESS_LOG_BUFFER_SIZE set. Serial
+// is begun at 115200 baud, so a message written to it directly waits for the UART as on the device,
+// while a log buffer queues it and drains it between requests.
+// Reports the throughput, latency and allocations of a request, and the bytes it logs
+
+#include "HostBench.h"
+#include "ArduinoExpress.h"
+
+static const char* const LEVEL_NAMES[] = {"DEBUG", "INFO", "WARN", "ERROR", "FATAL", "NONE"};
+
+static void* status(Req&, Res& res)
+{
+  res.json(200, "{\"uptime\":86400,\"heap\":23120,\"rssi\":-61}");
+  return nullptr;
+}
+
+
+int main(int argc, char** argv)
+{
+  // a request logged to Serial at DEBUG takes about 10 ms
+  size_t count = host::iterations(argc, argv, 2000);
+  host::setSerialOutput(nullptr);
+  Serial.begin(115200);
+
+  ArduinoExpress app;
+  app.use([](Req&, Res&, Next next) -> void* {next(); return nullptr;});
+  app.get("/api/status", status);
+  app.begin(80);
+
+  const std::string request = "GET /api/status HTTP/1.1\r\nHost: device\r\nAccept: */*\r\n\r\n";
+  host::SimulatedClient client = host::connect();
+  uint64_t logged = host::serialBytesWritten();
+
+  host::Latencies latencies;
+  host::Measurement run;
+  for(size_t i = 0; i < count; ++i){
+    if(client.closedByServer()) client = host::connect();
+
+    uint64_t start = host::nanoseconds();
+    client.send(request);
+    host::pump(app, [&]{return host::responseLength(client.received()) != 0;});
+    latencies.add(host::nanoseconds() - start);
+
+    host::AllocationPause pause;
+    client.socket().outbound.clear();
+  }
+  run.stop();
+  logged = host::serialBytesWritten() - logged;
+
+  char title[96];
+  snprintf(title, sizeof(title), "Serving a request, logging at %s %s", LEVEL_NAMES[ARDUINOEXPRESS_LOG_LEVEL],
+           ARDUINOEXPRESS_LOG_BUFFER_SIZE > 0 ? "to a log buffer" : "to Serial");
+  host::printHeader(title, {"level", "req/s", "p50 us", "p99 us", "allocs/req", "logged B/req"});
+  host::printRow({LEVEL_NAMES[ARDUINOEXPRESS_LOG_LEVEL], host::format(count / run.seconds()), host::format(latencies.percentile(0.5) / 1e3, 1),
+                  host::format(latencies.percentile(0.99) / 1e3, 1), host::format((double)run.allocations() / count, 2),
+                  host::format((double)logged / count, 1)});
+  return 0;
+}
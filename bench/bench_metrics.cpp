@@ -0,0 +1,50 @@
+// The cost of the request metrics: built once against the library without them and once with
+// ARDUINOEXPRESS_METRICS=1, serving the same keep-alive requests to a route behind a middleware.
+// Reports the throughput, latency and allocations of a request
+
+#include "HostBench.h"
+#include "ArduinoExpress.h"
+
+static void* status(Req&, Res& res)
+{
+  res.json(200, "{\"uptime\":86400,\"heap\":23120,\"rssi\":-61}");
+  return nullptr;
+}
+
+
+int main(int argc, char** argv)
+{
+  size_t count = host::iterations(argc, argv, 200000);
+
+  ArduinoExpress app;
+  app.use([](Req&, Res&, Next next) -> void* {next(); return nullptr;});
+  app.get("/api/status", status);
+#if ARDUINOEXPRESS_METRICS
+  app.get("/metrics", ArduinoExpress::Metrics());
+#endif
+  app.begin(80);
+
+  const std::string request = "GET /api/status HTTP/1.1\r\nHost: device\r\nAccept: */*\r\n\r\n";
+  host::SimulatedClient client = host::connect();
+
+  host::Latencies latencies;
+  host::Measurement run;
+  for(size_t i = 0; i < count; ++i){
+    if(client.closedByServer()) client = host::connect();
+
+    uint64_t start = host::nanoseconds();
+    client.send(request);
+    host::pump(app, [&]{return host::responseLength(client.received()) != 0;});
+    latencies.add(host::nanoseconds() - start);
+
+    host::AllocationPause pause;
+    client.socket().outbound.clear();
+  }
+  run.stop();
+
+  host::printHeader(ARDUINOEXPRESS_METRICS ? "Serving a request with metrics" : "Serving a request without metrics",
+                    {"metrics", "req/s", "p50 ns", "p99 ns", "allocs/req"});
+  host::printRow({ARDUINOEXPRESS_METRICS ? "on" : "off", host::format(count / run.seconds()), host::format(latencies.percentile(0.5), 0),
+                  host::format(latencies.percentile(0.99), 0), host::format((double)run.allocations() / count, 2)});
+  return 0;
+}
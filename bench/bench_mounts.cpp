@@ -0,0 +1,128 @@
+// Dispatching in a tree of routers 4 levels deep: the app's router uses 2 routers, which use 2
+// each, which use 2 each, and each of these 8 holds 25 routes, 200 in all:
+// "/r1/s0/t1/item24" is the route "/item24" of the router mounted at "/t1" in "/s0" in "/r1".
+// Each router matches the route against its full prefix, joined once when it was mounted, and skips
+// everything it holds if it doesn't match. The baseline is one router holding the 200 full paths.
+// Reports the latency and the allocations of the dispatch of the first route, the last one, and of
+// a path no route matches
+
+#include "HostBench.h"
+#include "ArduinoExpress.h"
+
+#include <memory>
+
+// the router, with its callback chain callable from the benchmark
+struct BenchRouter : public ArduinoExpressRouter{
+  using ArduinoExpressRouter::execute;
+};
+
+static const int FANOUT = 2;
+static const int ROUTES_PER_ROUTER = 25;
+
+static int _calls = 0;
+
+static void* handle(Req&, Res&)
+{
+  ++_calls;
+  return nullptr;
+}
+
+static String itemPath(int item) {return String("/item") + String(item);}
+
+
+// the routers of the tree, kept alive while it's measured
+struct RouterTree{
+  BenchRouter root;
+  std::vector<std::unique_ptr<BenchRouter>> routers;
+
+  RouterTree()
+  {
+    addChildren(this->root, 0);
+    // freezes the routers it uses too
+    this->root.freeze();
+  }
+
+  void addChildren(BenchRouter& parent, int level)
+  {
+    for(int i = 0; i < FANOUT; ++i){
+      this->routers.emplace_back(new BenchRouter());
+      BenchRouter& child = *this->routers.back();
+      if(level + 1 < 3) addChildren(child, level + 1);
+      else for(int item = 0; item < ROUTES_PER_ROUTER; ++item) child.get(itemPath(item), handle);
+      parent.use(String(levelName(level)) + String(i), &child);
+    }
+  }
+
+  static const char* levelName(int level)
+  {
+    static const char* const LEVELS[] = {"/r", "/s", "/t"};
+    return LEVELS[level];
+  }
+};
+
+
+template<typename Dispatch>
+static void measure(const char* router, const char* path, size_t count, int expectedCalls, Dispatch dispatch)
+{
+  dispatch();
+  _calls = 0;
+
+  host::Latencies latencies;
+  host::Measurement run;
+  for(size_t i = 0; i < count; ++i){
+    uint64_t start = host::nanoseconds();
+    dispatch();
+    latencies.add(host::nanoseconds() - start);
+  }
+  run.stop();
+
+  if(_calls != (int)count * expectedCalls){
+    fprintf(stderr, "%s %s: %d routes called for %d requests\n", router, path, _calls, (int)count);
+    exit(1);
+  }
+  host::printRow({router, path, host::format(latencies.percentile(0.5), 0), host::format(latencies.percentile(0.99), 0),
+                  host::format((double)run.allocations() / count, 2)});
+}
+
+
+int main(int argc, char** argv)
+{
+  size_t count = host::iterations(argc, argv, 100000);
+
+  RouterTree tree;
+  BenchRouter flat;
+  for(int r = 0; r < FANOUT; ++r){
+    for(int s = 0; s < FANOUT; ++s){
+      for(int t = 0; t < FANOUT; ++t){
+        String prefix = String("/r") + String(r) + "/s" + String(s) + "/t" + String(t);
+        for(int item = 0; item < ROUTES_PER_ROUTER; ++item) flat.get(prefix + itemPath(item), handle);
+      }
+    }
+  }
+  flat.freeze();
+
+  struct Path{
+    const char* name;
+    const char* request;
+    int calls;
+  };
+  static const Path PATHS[] = {
+    {"/r0/s0/t0/item0", "GET /r0/s0/t0/item0 HTTP/1.1\r\n\r\n", 1},
+    {"/r1/s1/t1/item24", "GET /r1/s1/t1/item24 HTTP/1.1\r\n\r\n", 1},
+    {"/r1/s1/t1/none", "GET /r1/s1/t1/none HTTP/1.1\r\n\r\n", 0},
+  };
+
+  host::printHeader("Dispatching in a tree of routers, 4 levels and 200 routes", {"router", "path", "p50 ns", "p99 ns", "allocs/req"});
+  for(const Path& path : PATHS){
+    HTTP_RequestParser parser;
+    HTTP_Request req;
+    parser.begin(req);
+    parser.feed(path.request, strlen(path.request));
+    HTTP_Response res(nullptr);
+    String prefix;
+
+    measure("tree", path.name, count, path.calls, [&]{tree.root.execute(prefix, req, res, Next{});});
+    measure("flat", path.name, count, path.calls, [&]{flat.execute(prefix, req, res, Next{});});
+  }
+  return 0;
+}
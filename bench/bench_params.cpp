@@ -0,0 +1,168 @@
+// Routing a request of a REST API table of 64 routes: static routes only, routes with ":name"
+// parameters, and the same with a query string to split and decode. Each request is parsed, then
+// dispatched, and its handler reads its parameters. The baseline is parsed the same way, then splits
+// the path and the query into Strings and compares them to each route in turn, as routing did before
+// the parameters were captured as views of the request buffer by the RouteTrie.
+// Reports the latency percentiles and the allocations of a request
+
+#include "HostBench.h"
+#include "ArduinoExpress.h"
+
+#include <random>
+
+// the router, with its callback chain callable from the benchmark
+struct BenchRouter : public ArduinoExpressRouter{
+  using ArduinoExpressRouter::execute;
+};
+
+static size_t _read = 0;
+
+static void* readParams(Req& req, Res&)
+{
+  _read += req.getParam("id").length() + req.getParam("field").length() + req.getQuery("unit").length();
+  return nullptr;
+}
+
+
+// the path and the query split in Strings, and the path matched against each route's segments
+static size_t splitWithStrings(const char* target, const std::vector<std::vector<String>>& routes)
+{
+  String route = target;
+  String query;
+  int mark = route.indexOf('?');
+  if(mark != -1){
+    query = route.substring(mark + 1);
+    route = route.substring(0, mark);
+  }
+
+  String segments[8];
+  int count = 0;
+  int start = 1;
+  while(start < (int)route.length() && count < 8){
+    int end = route.indexOf('/', start);
+    if(end == -1) end = route.length();
+    segments[count++] = route.substring(start, end);
+    start = end + 1;
+  }
+
+  size_t read = 0;
+  for(const std::vector<String>& pattern : routes){
+    if((int)pattern.size() != count) continue;
+    size_t captured = 0;
+    int i = 0;
+    for(; i < count; ++i){
+      if(pattern[i].startsWith(":")) captured += segments[i].length();
+      else if(!(segments[i] == pattern[i])) break;
+    }
+    if(i < count) continue;
+    read = captured;
+    break;
+  }
+  while(query.length() > 0){
+    int end = query.indexOf('&');
+    String pair = end == -1 ? query : query.substring(0, end);
+    query = end == -1 ? String() : query.substring(end + 1);
+    int equals = pair.indexOf('=');
+    if(equals != -1 && pair.substring(0, equals) == "unit") read += pair.length() - equals - 1;
+  }
+  return read;
+}
+
+
+struct RouteTable{
+  const char* name;
+  const char* route;    // %d is the resource
+  const char* target;   // %d is the resource
+  bool captures;        // the route has parameters or a query
+};
+
+
+static void measure(const RouteTable& table, size_t count)
+{
+  const int ROUTES_COUNT = 64;
+  BenchRouter router;
+  char text[128];
+  for(int i = 0; i < ROUTES_COUNT; ++i){
+    snprintf(text, sizeof(text), table.route, i);
+    router.get(String(text), readParams);  // the buffer is reused, the route keeps a copy
+  }
+  router.freeze();
+
+  std::vector<std::string> targets, requests;
+  for(int i = 0; i < ROUTES_COUNT; ++i){
+    host::AllocationPause pause;
+    snprintf(text, sizeof(text), table.target, i);
+    targets.push_back(text);
+    requests.push_back("GET " + targets.back() + " HTTP/1.1\r\nHost: device\r\n\r\n");
+  }
+
+  std::vector<std::vector<String>> patterns(ROUTES_COUNT);
+  for(int i = 0; i < ROUTES_COUNT; ++i){
+    host::AllocationPause pause;
+    snprintf(text, sizeof(text), table.route, i);
+    for(char* segment = strtok(text, "/"); segment; segment = strtok(nullptr, "/")) patterns[i].push_back(segment);
+  }
+
+  std::mt19937 random(ROUTES_COUNT);
+  std::vector<int> order(count);
+  for(int& index : order) index = random() % ROUTES_COUNT;
+
+  HTTP_RequestParser parser;
+  HTTP_Request req;
+  HTTP_Response res(nullptr);
+  String prefix;
+
+  host::Latencies routedLatencies;
+  host::Measurement routed;
+  for(int index : order)
+  {
+    uint64_t start = host::nanoseconds();
+    req.clear();
+    parser.begin(req);
+    parser.feed(requests[index].data(), requests[index].size());
+    router.execute(prefix, req, res, Next{});
+    routedLatencies.add(host::nanoseconds() - start);
+  }
+  routed.stop();
+
+  host::Latencies splitLatencies;
+  host::Measurement split;
+  size_t read = 0;
+  for(int index : order)
+  {
+    uint64_t start = host::nanoseconds();
+    req.clear();
+    parser.begin(req);
+    parser.feed(requests[index].data(), requests[index].size());
+    read += splitWithStrings(targets[index].c_str(), patterns);
+    splitLatencies.add(host::nanoseconds() - start);
+  }
+  split.stop();
+
+  if(table.captures && (_read == 0 || read == 0)){
+    fprintf(stderr, "%s: no parameter was read\n", table.name);
+    exit(1);
+  }
+  _read = 0;
+
+  host::printRow({table.name, "views", host::format(routedLatencies.percentile(0.5), 0),
+                  host::format(routedLatencies.percentile(0.99), 0), host::format((double)routed.allocations() / count, 2)});
+  host::printRow({table.name, "Strings", host::format(splitLatencies.percentile(0.5), 0),
+                  host::format(splitLatencies.percentile(0.99), 0), host::format((double)split.allocations() / count, 2)});
+}
+
+
+int main(int argc, char** argv)
+{
+  size_t count = host::iterations(argc, argv, 200000);
+
+  const RouteTable tables[] = {
+    {"static", "/api/resource%d/status", "/api/resource%d/status", false},
+    {"params", "/api/resource%d/:id/readings/:field", "/api/resource%d/1234/readings/temperature", true},
+    {"params+query", "/api/resource%d/:id/readings/:field", "/api/resource%d/1234/readings/temperature?unit=c&window=60&avg=1", true},
+  };
+
+  host::printHeader("Routing to 64 parameterized routes (parse + dispatch)", {"table", "captures", "p50 ns", "p99 ns", "allocs/req"});
+  for(const RouteTable& table : tables) measure(table, count);
+  return 0;
+}
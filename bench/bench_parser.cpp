@@ -0,0 +1,53 @@
+// HTTP_RequestParser fed the recorded corpora in segments of 1, 16 and 128 bytes, and whole, as a
+// request arrives over TCP in one or several reads.
+// Reports the throughput, the latency percentiles of a request and its allocations
+
+#include "HostBench.h"
+#include "HTTP_Parser.h"
+
+static void parseSegmented(const char* name, size_t segmentSize, size_t count)
+{
+  std::vector<std::string> corpus = host::loadCorpus((std::string(CORPUS_DIR "/") + name + ".http").c_str());
+  static HTTP_RequestParser parser;
+  static HTTP_Request req;
+  host::Latencies latencies;
+  size_t bytes = 0, failed = 0;
+
+  host::Measurement run;
+  for(size_t i = 0; i < count; ++i)
+  {
+    const std::string& request = corpus[i % corpus.size()];
+    size_t segment = segmentSize ? segmentSize : request.size();
+    uint64_t start = host::nanoseconds();
+    req.clear();
+    parser.begin(req);
+    for(size_t offset = 0; offset < request.size() && !parser.complete() && !parser.failed(); offset += segment){
+      parser.feed(request.data() + offset, request.size() - offset < segment ? request.size() - offset : segment);
+    }
+    latencies.add(host::nanoseconds() - start);
+    bytes += request.size();
+    if(!parser.complete()) ++failed;
+  }
+  run.stop();
+
+  if(failed){
+    fprintf(stderr, "%u requests of %s were not parsed\n", (unsigned)failed, name);
+    exit(1);
+  }
+  host::printRow({name, segmentSize ? std::to_string(segmentSize) : "whole", host::format(count / run.seconds()),
+                  host::format(bytes / run.seconds() / 1e6, 1), host::format(latencies.percentile(0.5), 0),
+                  host::format(latencies.percentile(0.99), 0), host::format((double)run.allocations() / count, 2)});
+}
+
+
+int main(int argc, char** argv)
+{
+  size_t count = host::iterations(argc, argv, 200000);
+
+  host::printHeader("Parsing of a request fed in segments",
+                    {"corpus", "segment", "requests/s", "MB/s", "p50 ns", "p99 ns", "allocs/req"});
+  for(const char* corpus : {"dashboard", "gateway", "browser"}){
+    for(size_t segmentSize : {1, 16, 128, 0}) parseSegmented(corpus, segmentSize, count);
+  }
+  return 0;
+}
@@ -0,0 +1,148 @@
+// ArduinoExpress as a Linux gateway: HTTP_PosixTransport serving 1 to 8 client threads over TCP on
+// localhost. Each client sends its requests one after the other on a keep-alive connection, and
+// reconnects when the server closes it. The server is one thread, like on a device: the clients
+// share it, and the ones beyond MAX_CONNECTIONS_COUNT wait in the listen backlog for a free slot.
+// Reports the requests per second of all the clients, and the latency of a request from its send
+// to its last byte received
+
+#include "HostBench.h"
+#include "ArduinoExpress.h"
+
+#include <atomic>
+#include <thread>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static const std::string REQUEST = "GET /api/status HTTP/1.1\r\nHost: gateway\r\nAccept: application/json\r\n\r\n";
+
+static int connectTo(uint16_t port)
+{
+  int client = socket(AF_INET, SOCK_STREAM, 0);
+  int noDelay = 1;
+  setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+  // a client that gets no answer gives up instead of hanging the benchmark
+  timeval timeout = {5, 0};
+  setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(port);
+  if(connect(client, (sockaddr*)&address, sizeof(address)) == 0) return client;
+  close(client);
+  return -1;
+}
+
+
+// a client thread: sends count requests, and records how long each took
+struct LoadClient{
+  std::vector<uint64_t> latencies;
+  size_t errors = 0;
+
+  void run(uint16_t port, size_t count)
+  {
+    host::AllocationPause pause;
+    this->latencies.reserve(count);
+    std::string response;
+    int client = -1;
+    for(size_t i = 0; i < count; ++i)
+    {
+      if(client == -1) client = connectTo(port);
+      if(client == -1){
+        ++this->errors;
+        continue;
+      }
+
+      uint64_t start = host::nanoseconds();
+      send(client, REQUEST.data(), REQUEST.size(), MSG_NOSIGNAL);
+      response.clear();
+      while(host::responseLength(response) == 0)
+      {
+        char buffer[1024];
+        ssize_t received = recv(client, buffer, sizeof(buffer), 0);
+        if(received <= 0) break;
+        response.append(buffer, received);
+      }
+
+      if(host::responseLength(response) == 0){
+        ++this->errors;
+        close(client);
+        client = -1;
+        continue;
+      }
+      this->latencies.push_back(host::nanoseconds() - start);
+      if(response.find("Connection: close") != std::string::npos){
+        close(client);
+        client = -1;
+      }
+    }
+    if(client != -1) close(client);
+  }
+};
+
+
+static void load(uint16_t port, int clientsCount, size_t count)
+{
+  std::vector<LoadClient> clients(clientsCount);
+  std::vector<std::thread> threads;
+  uint64_t start = host::nanoseconds();
+  for(LoadClient& client : clients) threads.emplace_back([&client, port, count]{client.run(port, count);});
+  for(std::thread& thread : threads) thread.join();
+  double seconds = (host::nanoseconds() - start) / 1e9;
+
+  host::Latencies latencies;
+  size_t errors = 0;
+  for(LoadClient& client : clients){
+    for(uint64_t latency : client.latencies) latencies.add(latency);
+    errors += client.errors;
+  }
+
+  host::printRow({std::to_string(clientsCount), host::format(latencies.count() / seconds),
+                  host::format(latencies.percentile(0.5) / 1000.0, 1), host::format(latencies.percentile(0.99) / 1000.0, 1),
+                  std::to_string(errors)});
+}
+
+
+int main(int argc, char** argv)
+{
+  size_t count = host::iterations(argc, argv, 20000);
+
+  static ArduinoExpress app;
+  static HTTP_PosixTransport transport;
+  app.setTransport(transport);
+  app.get("/api/status", [](Req&, Res& res) -> void* {
+    res.json(200, "{\"uptime\":86400,\"heap\":23120,\"rssi\":-61,\"clients\":2}");
+    return nullptr;
+  });
+  app.freeze();
+
+  // a port nothing listens on
+  int probe = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  socklen_t length = sizeof(address);
+  bind(probe, (sockaddr*)&address, sizeof(address));
+  getsockname(probe, (sockaddr*)&address, &length);
+  uint16_t port = ntohs(address.sin_port);
+  close(probe);
+  if(!app.begin(port)) return 1;
+
+  // the loop of listen(), until the clients are done. The epoll set is level-triggered, so the wait
+  // ends as soon as a client has bytes to read
+  std::atomic<bool> serving{true};
+  std::thread server([&]{
+    while(serving){
+      app.handle();
+      transport.wait(1);
+    }
+  });
+
+  host::printHeader("Clients of a POSIX transport over TCP", {"clients", "req/s", "p50 us", "p99 us", "errors"});
+  for(int clientsCount : {1, 2, 4, 8}) load(port, clientsCount, count / clientsCount);
+
+  serving = false;
+  server.join();
+  return 0;
+}
@@ -0,0 +1,109 @@
+// Writing a response: the output buffer of HTTP_Response, where the status line, headers and a
+// small body are copied into one fixed buffer and the constant text comes from flash, against the
+// String the response was built in before, by concatenating each line, and printed to the client.
+// Reports the time, the allocations and the client writes a response takes
+
+#include "HostBench.h"
+#include "ArduinoExpress.h"
+
+// a transport that counts the writes of its clients, and keeps none of their bytes
+struct CountingTransport : public HTTP_Transport{
+  size_t writes = 0;
+  size_t bytes = 0;
+
+  bool begin(int) override {return true;}
+  bool accept(int) override {return false;}
+  int available(int) override {return 0;}
+  int read(int, uint8_t*, size_t) override {return 0;}
+  size_t write(int, const uint8_t*, size_t length) override {++writes; bytes += length; return length;}
+  bool connected(int) override {return true;}
+  void stop(int) override {}
+};
+
+// the same for Print, what the String response was printed to
+struct CountingPrint : public Print{
+  size_t writes = 0;
+  size_t bytes = 0;
+
+  size_t write(uint8_t) override {++writes; ++bytes; return 1;}
+  size_t write(const uint8_t*, size_t length) override {++writes; bytes += length; return length;}
+};
+
+
+struct ResponseCase{
+  const char* name;
+  const char* contentType;
+  std::string body;
+  std::vector<std::pair<const char*, const char*>> headers;
+};
+
+
+// HTTP_Response::send before the output buffer: every line concatenated into one String
+static void sendAsString(Print& client, int status, const String& contentType, const String& body,
+                         const std::vector<std::pair<const char*, const char*>>& extraHeaders)
+{
+  String keys[ArduinoExpressConfig::MAX_HEADERS_COUNT], values[ArduinoExpressConfig::MAX_HEADERS_COUNT];
+  int count = 0;
+  for(const auto& header : extraHeaders){keys[count] = header.first; values[count++] = header.second;}
+  keys[count] = "Content-type"; values[count++] = contentType;
+  keys[count] = "Content-Length"; values[count++] = String(body.length());
+  keys[count] = "Connection"; values[count++] = "close";
+
+  String statusText = HTTPStatusText(status);
+  String response = "HTTP/1.1 " + String(status) + " " + statusText + "\n";
+  for(int i = 0; i < count; ++i) response += keys[i] + ": " + values[i] + "\n";
+  response += "\n";
+  response += body;
+  response += "\n";
+  client.print(response);
+}
+
+
+static void measure(const ResponseCase& response, size_t count)
+{
+  CountingTransport transport;
+  static HTTP_Client client(transport, 0);
+  static HTTP_Response res(&client);
+  CountingPrint print;
+
+  host::Latencies bufferLatencies, stringLatencies;
+  host::Measurement buffered;
+  for(size_t i = 0; i < count; ++i){
+    uint64_t start = host::nanoseconds();
+    res.reset();
+    for(const auto& header : response.headers) res.setHeader(header.first, header.second);
+    res.send(200, response.contentType, response.body.c_str());
+    bufferLatencies.add(host::nanoseconds() - start);
+  }
+  buffered.stop();
+
+  host::Measurement concatenated;
+  for(size_t i = 0; i < count; ++i){
+    uint64_t start = host::nanoseconds();
+    sendAsString(print, 200, response.contentType, response.body.c_str(), response.headers);
+    stringLatencies.add(host::nanoseconds() - start);
+  }
+  concatenated.stop();
+
+  host::printRow({response.name, "buffer", host::format(bufferLatencies.percentile(0.5), 0), host::format((double)buffered.allocations() / count, 2),
+                  host::format((double)transport.writes / count, 2), host::format((double)transport.bytes / count)});
+  host::printRow({response.name, "String", host::format(stringLatencies.percentile(0.5), 0), host::format((double)concatenated.allocations() / count, 2),
+                  host::format((double)print.writes / count, 2), host::format((double)print.bytes / count)});
+}
+
+
+int main(int argc, char** argv)
+{
+  size_t count = host::iterations(argc, argv, 200000);
+
+  std::vector<ResponseCase> cases = {
+    {"json 52 B", "application/json", "{\"uptime\":86400,\"heap\":23120,\"rssi\":-61,\"clients\":2}", {}},
+    {"4 hdrs, 300 B", "text/html", std::string(300, 'h'),
+      {{"Cache-Control", "max-age=60"}, {"ETag", "\"5f3a-12\""}, {"Access-Control-Allow-Origin", "*"}, {"X-Device", "gateway-4"}}},
+    {"2 KB", "application/octet-stream", std::string(2048, 'b'), {}},
+  };
+
+  host::printHeader("Writing a response", {"response", "path", "p50 ns", "allocs/res", "writes/res", "bytes/res"});
+  for(const ResponseCase& response : cases) measure(response, count);
+  return 0;
+}
@@ -0,0 +1,115 @@
+// Dispatch of a request to one of 8, 64 and 512 routes: the RouteTrie lookup of
+// ArduinoExpressRouter, against the scan it replaced, which compared the request to every route
+// in turn and built prefix + path and the method's name in Strings to do it.
+// Reports the latency percentiles and the allocations of a dispatch
+
+#include "HostBench.h"
+#include "ArduinoExpress.h"
+
+#include <random>
+
+// the router, with its callback chain callable from the benchmark
+struct BenchRouter : public ArduinoExpressRouter{
+  using ArduinoExpressRouter::execute;
+};
+
+// a route as the scan kept it
+struct ScannedRoute{
+  String path;
+  HTTP_Method method;
+};
+
+static int _dispatched = 0;
+
+static void* countDispatch(Req&, Res&)
+{
+  ++_dispatched;
+  return nullptr;
+}
+
+// the match the scan ran on each route, until one matched
+static bool scanMatch(const String& prefix, const ScannedRoute& route, const HTTP_Request& req)
+{
+  return prefix + route.path == req.route.c_str() && toText(route.method) == req.method.c_str();
+}
+
+static String routePath(int index)
+{
+  return String("/api/group") + String(index / 8) + "/item" + String(index % 8);
+}
+
+
+static void dispatch(int routesCount, size_t count)
+{
+  BenchRouter router;
+  std::vector<ScannedRoute> scanned;
+  for(int i = 0; i < routesCount; ++i){
+    router.get(routePath(i), countDispatch);
+    host::AllocationPause pause;
+    scanned.push_back({routePath(i), HTTP_Method::GET});
+  }
+  router.freeze();
+
+  // the requests are parsed once, the benchmark only dispatches them
+  std::vector<std::string> requests;
+  std::vector<HTTP_RequestParser> parsers(routesCount);
+  std::vector<HTTP_Request> reqs(routesCount);
+  for(int i = 0; i < routesCount; ++i){
+    requests.push_back(std::string("GET ") + routePath(i).c_str() + " HTTP/1.1\r\n\r\n");
+    parsers[i].begin(reqs[i]);
+    parsers[i].feed(requests[i].data(), requests[i].size());
+  }
+
+  std::mt19937 random(routesCount);
+  std::vector<int> order(count);
+  for(int& index : order) index = random() % routesCount;
+
+  HTTP_Response res(nullptr);
+  String prefix;
+
+  host::Latencies trieLatencies;
+  host::Measurement trie;
+  for(int index : order)
+  {
+    uint64_t start = host::nanoseconds();
+    router.execute(prefix, reqs[index], res, Next{});
+    trieLatencies.add(host::nanoseconds() - start);
+  }
+  trie.stop();
+
+  host::Latencies scanLatencies;
+  host::Measurement scan;
+  for(int index : order)
+  {
+    uint64_t start = host::nanoseconds();
+    for(const ScannedRoute& route : scanned){
+      if(scanMatch(prefix, route, reqs[index])){
+        countDispatch(reqs[index], res);
+        break;
+      }
+    }
+    scanLatencies.add(host::nanoseconds() - start);
+  }
+  scan.stop();
+
+  if(_dispatched != (int)(2 * count)){
+    fprintf(stderr, "%d requests of %d dispatched\n", _dispatched, (int)(2 * count));
+    exit(1);
+  }
+  _dispatched = 0;
+
+  host::printRow({String(routesCount).c_str(), "trie", host::format(trieLatencies.percentile(0.5), 0),
+                  host::format(trieLatencies.percentile(0.99), 0), host::format((double)trie.allocations() / count, 2)});
+  host::printRow({String(routesCount).c_str(), "scan", host::format(scanLatencies.percentile(0.5), 0),
+                  host::format(scanLatencies.percentile(0.99), 0), host::format((double)scan.allocations() / count, 2)});
+}
+
+
+int main(int argc, char** argv)
+{
+  size_t count = host::iterations(argc, argv, 200000);
+
+  host::printHeader("Dispatch of a request to its route", {"routes", "index", "p50 ns", "p99 ns", "allocs/req"});
+  for(int routesCount : {8, 64, 512}) dispatch(routesCount, count);
+  return 0;
+}
@@ -0,0 +1,151 @@
+// Replays the recorded request corpora of bench/corpus through the whole server, on keep-alive
+// connections of the simulated network, then measures the parser and the response writer alone.
+// Each connection is kept for as many requests as the server allows.
+// Reports requests per second, latency percentiles, and the allocations and peak heap per request
+
+#include "HostBench.h"
+#include "ArduinoExpress.h"
+
+// a transport whose client takes every byte and keeps none, to time the response writer alone
+struct NullTransport : public HTTP_Transport{
+  bool begin(int) override {return true;}
+  bool accept(int) override {return false;}
+  int available(int) override {return 0;}
+  int read(int, uint8_t*, size_t) override {return 0;}
+  size_t write(int, const uint8_t*, size_t length) override {return length;}
+  bool connected(int) override {return true;}
+  void stop(int) override {}
+};
+
+
+static void setupRoutes(ArduinoExpress& app)
+{
+  app.use(ArduinoExpress::Json());
+  app.get("/", [](Req&, Res& res) -> void* {
+    res.send(200, "text/html", "<!doctype html><title>Gateway</title><script src=/app.js></script>");
+    return nullptr;
+  });
+  app.get("/api/status", [](Req&, Res& res) -> void* {
+    res.json(200, "{\"uptime\":86400,\"heap\":23120,\"rssi\":-61,\"clients\":2}");
+    return nullptr;
+  });
+  app.get("/api/devices/:id/state", [](Req& req, Res& res) -> void* {
+    char body[64];
+    snprintf(body, sizeof(body), "{\"id\":%s,\"state\":\"on\"}", req.getParam("id").c_str());
+    res.json(200, body);
+    return nullptr;
+  });
+  app.post("/api/devices/:id/state", [](Req& req, Res& res) -> void* {
+    const char* state = req.bodyJSON("state").as<const char*>();
+    res.json(200, state && strcmp(state, "on") == 0 ? "{\"ok\":true}" : "{\"ok\":false}");
+    return nullptr;
+  });
+  app.get("/api/sensors", [](Req& req, Res& res) -> void* {
+    res.setHeader(HEADER_CACHE_CONTROL, "no-cache");
+    res.json(200, req.getQuery("limit").isEmpty() ? "[]" : "[21.5,21.7,21.6]");
+    return nullptr;
+  });
+  app.post("/raise", [](Req&, Res& res) -> void* {
+    res.send(200, "text/plain", "Hello AlarmInitiate!");
+    return nullptr;
+  });
+}
+
+
+static void replay(ArduinoExpress& app, const char* name, size_t count)
+{
+  std::vector<std::string> corpus = host::loadCorpus((std::string(CORPUS_DIR "/") + name + ".http").c_str());
+  host::SimulatedClient client = host::connect();
+  host::Latencies latencies;
+
+  host::Measurement run;
+  for(size_t i = 0; i < count; ++i)
+  {
+    const std::string& request = corpus[i % corpus.size()];
+    uint64_t start = host::nanoseconds();
+    client.send(request);
+    host::pump(app, [&]{return host::responseLength(client.received()) > 0;});
+    latencies.add(host::nanoseconds() - start);
+
+    // the response is taken off the client, so the next one is found at the start. The server
+    // closes a connection after MAX_KEEP_ALIVE_REQUESTS, the client then opens another one
+    host::AllocationPause pause;
+    client.socket().outbound.erase(0, host::responseLength(client.received()));
+    if(client.closedByServer()) client = host::connect();
+  }
+  run.stop();
+  client.close();
+  host::pump(app, [&]{return client.closedByServer();});
+
+  host::printRow({name, host::format(count / run.seconds()), host::format(latencies.percentile(0.5) / 1000.0, 2),
+                  host::format(latencies.percentile(0.99) / 1000.0, 2), host::format((double)run.allocations() / count, 2),
+                  host::format(run.peakBytes())});
+}
+
+
+static void parseOnly(const char* name, size_t count)
+{
+  std::vector<std::string> corpus = host::loadCorpus((std::string(CORPUS_DIR "/") + name + ".http").c_str());
+  static HTTP_RequestParser parser;
+  static HTTP_Request req;
+  host::Latencies latencies;
+
+  host::Measurement run;
+  for(size_t i = 0; i < count; ++i)
+  {
+    const std::string& request = corpus[i % corpus.size()];
+    uint64_t start = host::nanoseconds();
+    req.clear();
+    parser.begin(req);
+    parser.feed(request.data(), request.size());
+    latencies.add(host::nanoseconds() - start);
+  }
+  run.stop();
+
+  host::printRow({std::string("parse ") + name, host::format(count / run.seconds()), host::format(latencies.percentile(0.5) / 1000.0, 2),
+                  host::format(latencies.percentile(0.99) / 1000.0, 2), host::format((double)run.allocations() / count, 2),
+                  host::format(run.peakBytes())});
+}
+
+
+static void sendOnly(size_t count)
+{
+  NullTransport transport;
+  static HTTP_Client client(transport, 0);
+  static HTTP_Response res(&client);
+  host::Latencies latencies;
+
+  host::Measurement run;
+  for(size_t i = 0; i < count; ++i)
+  {
+    uint64_t start = host::nanoseconds();
+    res.reset();
+    res.setHeader(HEADER_CACHE_CONTROL, "no-cache");
+    res.json(200, "{\"uptime\":86400,\"heap\":23120,\"rssi\":-61,\"clients\":2}");
+    latencies.add(host::nanoseconds() - start);
+  }
+  run.stop();
+
+  host::printRow({"send json", host::format(count / run.seconds()), host::format(latencies.percentile(0.5) / 1000.0, 2),
+                  host::format(latencies.percentile(0.99) / 1000.0, 2), host::format((double)run.allocations() / count, 2),
+                  host::format(run.peakBytes())});
+}
+
+
+int main(int argc, char** argv)
+{
+  size_t count = host::iterations(argc, argv, 200000);
+
+  static ArduinoExpress app;
+  setupRoutes(app);
+  app.freeze();
+  app.begin(80);
+
+  host::printHeader("Corpus replay over a keep-alive connection", {"corpus", "requests/s", "p50 us", "p99 us", "allocs/req", "peak bytes"});
+  for(const char* corpus : {"dashboard", "gateway", "browser"}) replay(app, corpus, count);
+
+  host::printHeader("Subsystems", {"subsystem", "ops/s", "p50 us", "p99 us", "allocs/op", "peak bytes"});
+  for(const char* corpus : {"dashboard", "gateway", "browser"}) parseOnly(corpus, count);
+  sendOnly(count);
+  return 0;
+}
@@ -0,0 +1,100 @@
+// A soak run: a million requests (ten thousand with --quick) served on 4 keep-alive connections,
+// a mix of small responses, JSON bodies, a header too large for the response arena and 404s.
+// Every tenth of the run reports the heap the process holds: the bytes and blocks still allocated,
+// the allocations a request made in that tenth, and the free bytes malloc keeps between its blocks.
+// On the ESP8266 the heap can't be compacted, so a steady run keeps all four flat: the connections'
+// arenas are allocated by the first requests and reused by all the others
+
+#include "HostBench.h"
+#include "ArduinoExpress.h"
+
+#include <malloc.h>
+
+static const int CLIENTS_COUNT = 4;
+
+static const std::string LARGE_POLICY(ArduinoExpressConfig::RESPONSE_ARENA_SIZE + 64, 'p');
+
+static std::string requestOf(size_t index)
+{
+  switch(index % 4){
+    case 0: return "GET /api/status HTTP/1.1\r\nHost: device\r\nAccept: application/json\r\n\r\n";
+    case 1: {
+      std::string body = "{\"led\":" + std::to_string(index % 16) + ",\"brightness\":" + std::to_string(index % 256) + "}";
+      return "POST /api/led HTTP/1.1\r\nContent-Type: application/json\r\nContent-Length: " +
+             std::to_string(body.size()) + "\r\n\r\n" + body;
+    }
+    case 2: return "GET /page HTTP/1.1\r\nHost: device\r\n\r\n";
+    default: return "GET /missing/" + std::to_string(index % 1000) + " HTTP/1.1\r\n\r\n";
+  }
+}
+
+
+int main(int argc, char** argv)
+{
+  size_t count = host::iterations(argc, argv, 1000000);
+
+  static ArduinoExpress app;
+  app.get("/api/status", [](Req&, Res& res) -> void* {
+    res.setHeader(HEADER_CACHE_CONTROL, "no-store");
+    res.json(200, "{\"uptime\":86400,\"heap\":23120,\"rssi\":-61}");
+    return nullptr;
+  });
+  app.post("/api/led", [](Req& req, Res& res) -> void* {
+    JsonVariant led = req.json();
+    if(!led.success()){
+      res.send(req.jsonStatus(), "text/plain", "");
+      return nullptr;
+    }
+    char body[48];
+    snprintf(body, sizeof(body), "{\"led\":%ld,\"on\":true}", led["led"].as<long>());
+    res.json(200, body);
+    return nullptr;
+  });
+  app.get("/page", [](Req&, Res& res) -> void* {
+    // larger than the response arena: it takes a heap block of its own, freed with the request
+    res.setHeader("Content-Security-Policy", LARGE_POLICY.c_str());
+    res.send(200, "text/html", "<h1>device</h1>");
+    return nullptr;
+  });
+  app.freeze();
+  app.begin(80);
+
+  std::vector<host::SimulatedClient> clients;
+  std::vector<size_t> pending(CLIENTS_COUNT);
+  for(int i = 0; i < CLIENTS_COUNT; ++i){
+    host::AllocationPause pause;
+    clients.push_back(host::connect());
+    clients[i].send(requestOf(i));
+  }
+
+  host::printHeader("Heap over a soak run", {"requests", "live bytes", "live blocks", "allocs/req", "malloc free"});
+  size_t served = 0;
+  size_t next = CLIENTS_COUNT;
+  size_t reportEvery = count / 10 ? count / 10 : 1;
+  uint64_t allocations = host::allocationStats().allocations;
+  while(served < count)
+  {
+    app.handle();
+    for(int i = 0; i < CLIENTS_COUNT; ++i)
+    {
+      host::SimulatedClient& client = clients[i];
+      size_t length = host::responseLength(client.received());
+      if(length == 0) continue;
+
+      host::AllocationPause pause;
+      client.socket().outbound.erase(0, length);
+      if(client.closedByServer()) client = host::connect();
+      client.send(requestOf(next++));
+
+      if(++served % reportEvery == 0){
+        host::AllocationStats stats = host::allocationStats();
+        struct mallinfo2 heap = mallinfo2();
+        host::printRow({std::to_string(served), std::to_string(stats.liveBytes), std::to_string(stats.liveBlocks),
+                        host::format((double)(stats.allocations - allocations) / reportEvery, 2),
+                        std::to_string(heap.fordblks)});
+        allocations = stats.allocations;
+      }
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,70 @@
+// Serving files with ArduinoExpress::Static: the throughput of 4 KB, 64 KB and 512 KB files sent in
+// STATIC_CHUNK_SIZE pieces through the output buffer, with the allocations, the client writes and
+// the peak heap a request takes. The heap should not grow with the file
+#include "HostBench.h"
+#include "ArduinoExpress.h"
+#include "FS.h"
+
+static void measure(ArduinoExpress& app, const char* name, const std::string& path, size_t size, size_t count)
+{
+  std::string request = "GET " + path + " HTTP/1.1\r\nHost: device\r\n\r\n";
+  // what the client receives is kept in a buffer reserved once, so the peak is the server's
+  auto connect = [&]{
+    host::SimulatedClient client = host::connect();
+    host::AllocationPause pause;
+    client.socket().outbound.reserve(size + 1024);
+    return client;
+  };
+  host::SimulatedClient client = connect();
+  size_t writes = 0;
+
+  host::Latencies latencies;
+  host::Measurement run;
+  for(size_t i = 0; i < count; ++i){
+    // the server closes a connection after MAX_KEEP_ALIVE_REQUESTS
+    if(client.closedByServer()){
+      writes += client.writes();
+      client = connect();
+    }
+
+    uint64_t start = host::nanoseconds();
+    client.send(request);
+    host::pump(app, [&]{return host::responseLength(client.received()) != 0;});
+    latencies.add(host::nanoseconds() - start);
+
+    host::AllocationPause pause;
+    client.socket().outbound.clear();
+  }
+  run.stop();
+  writes += client.writes();
+  client.close();
+  host::pump(app, [&]{return client.closedByServer();});
+
+  host::printRow({name, host::format(count / run.seconds()), host::format(size * count / run.seconds() / 1e6, 1),
+                  host::format(latencies.percentile(0.5) / 1e3, 1), host::format(latencies.percentile(0.99) / 1e3, 1),
+                  host::format((double)run.allocations() / count, 2), host::format((double)writes / count, 1),
+                  host::format((double)run.peakBytes())});
+}
+
+
+int main(int argc, char** argv)
+{
+  size_t count = host::iterations(argc, argv, 20000);
+
+  host::TemporaryDirectory directory;
+  const struct {const char* name; const char* file; size_t size; size_t count;} files[] = {
+    {"4 KB", "small.bin", 4 * 1024, count},
+    {"64 KB", "medium.bin", 64 * 1024, count / 8 + 1},
+    {"512 KB", "large.bin", 512 * 1024, count / 64 + 1},
+  };
+  for(const auto& file : files) directory.write(std::string("www/") + file.file, std::string(file.size, 'f'));
+
+  fs::FS storage(directory.path());
+  ArduinoExpress app;
+  app.use(ArduinoExpress::Static("/", storage, "/www"));
+  app.begin(80);
+
+  host::printHeader("Serving static files", {"file", "req/s", "MB/s", "p50 us", "p99 us", "allocs/req", "writes/req", "peak B"});
+  for(const auto& file : files) measure(app, file.name, std::string("/") + file.file, file.size, file.count);
+  return 0;
+}
@@ -0,0 +1,72 @@
+// What a route costs in RAM with router tables sized by what's registered: 10, 100 and 500 routes
+// registered in a router as it grows, then frozen, and in a router reserved for them up front.
+// Reports the bytes of the router's tables and the bytes it holds on the heap in all (the tables
+// and the routes' paths), per route, with the allocations and the time registering took
+
+#include "HostBench.h"
+#include "ArduinoExpress.h"
+
+static void* handle(Req&, Res&)
+{
+  return nullptr;
+}
+
+static String routePath(int index)
+{
+  if(index % 4 == 3) return String("/api/group") + String(index) + "/:id";
+  return String("/api/group") + String(index / 8) + "/item" + String(index);
+}
+
+static void printResult(int routesCount, const char* tables, const ArduinoExpressRouter& router, int64_t liveBytes,
+                        uint64_t allocations, double seconds)
+{
+  host::printRow({String(routesCount).c_str(), tables, host::format((double)router.memoryUsage() / routesCount, 0),
+                  host::format((double)liveBytes / routesCount, 0), host::format((double)allocations / routesCount, 2),
+                  host::format(seconds * 1e9 / routesCount, 0)});
+}
+
+
+static void registerRoutes(int routesCount, size_t repeats)
+{
+  std::vector<String> paths;
+  for(int i = 0; i < routesCount; ++i) paths.push_back(routePath(i));
+
+  for(size_t repeat = 0; repeat < repeats; ++repeat)
+  {
+    bool print = repeat == repeats - 1;
+    {
+      int64_t before = host::allocationStats().liveBytes;
+      ArduinoExpressRouter router;
+      host::Measurement run;
+      for(int i = 0; i < routesCount; ++i) router.get(paths[i], handle);
+      run.stop();
+      if(print) printResult(routesCount, "grown", router, host::allocationStats().liveBytes - before, run.allocations(), run.seconds());
+
+      host::Measurement freeze;
+      router.freeze();
+      freeze.stop();
+      if(print) printResult(routesCount, "frozen", router, host::allocationStats().liveBytes - before,
+                            run.allocations() + freeze.allocations(), run.seconds() + freeze.seconds());
+    }
+    {
+      int64_t before = host::allocationStats().liveBytes;
+      ArduinoExpressRouter router;
+      host::Measurement run;
+      router.reserve(routesCount, 0);
+      for(int i = 0; i < routesCount; ++i) router.get(paths[i], handle);
+      router.freeze();
+      run.stop();
+      if(print) printResult(routesCount, "reserved", router, host::allocationStats().liveBytes - before, run.allocations(), run.seconds());
+    }
+  }
+}
+
+
+int main(int argc, char** argv)
+{
+  size_t repeats = host::iterations(argc, argv, 100);
+
+  host::printHeader("The RAM of a route", {"routes", "tables", "table B/route", "heap B/route", "allocs/route", "ns/route"});
+  for(int routesCount : {10, 100, 500}) registerRoutes(routesCount, repeats);
+  return 0;
+}
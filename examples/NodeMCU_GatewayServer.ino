@@ -1,11 +1,12 @@
-// TODO: Change implementattion to store char* for route/path instead of String. strcmp can be used instead of ==
-
 #include <ArduinoExpress.h>
 
 // Setup WiFi
 const char *ssid = "Alarm AP";
 // WiFiServer server(80);
 
+// the app holds a buffer for each connection, it's too big to live on the stack of setup()
+ArduinoExpress app;
+
 void setup()
 {
   WiFi.mode(WIFI_AP);
@@ -13,20 +14,10 @@ void setup()
   IPAddress myIP = WiFi.softAPIP();
 
   Serial.begin(115200);
+  uint32_t heapBefore = ESP.getFreeHeap();
 
-  auto app = ArduinoExpress();
-
-  app.use([](Req &req, Res &res, Next next) -> void *
-          { 
-            // FIXME: Add this middleware to ArdiunoExpress
-            DynamicJsonBuffer buffer(200);
-            if (buffer.parseObject(req.body).success()){
-              next();
-            }
-            else{
-              res.send(400, "text/plain", "Invalid JSON body");
-            }
-          });
+  // JSON bodies are parsed once, handlers read them with req.json()
+  app.use(ArduinoExpress::Json());
 
   app.get("/",
       [](Req &req, Res &res, Next next) -> void *
@@ -40,7 +31,8 @@ void setup()
         res.send(200, "text/plain", "Hello World!");
       });
 
-  app.post("/raise",
+  // F() keeps the path in flash, it takes no RAM
+  app.post(F("/raise"),
       [](Req &req, Res &res, Next next) -> void *
       {
         // We just want to test this
@@ -53,7 +45,13 @@ void setup()
         res.send(200, "text/plain", "Hello AlarmInitiate!");
       });
 
-  app.listen(80, []() -> void {}); // TODO: Only provide this callback as an extra feature
+  // every route is registered: compact the router tables
+  app.freeze();
+  Serial.printf("Routes use %u bytes of heap\n", (unsigned)(heapBefore - ESP.getFreeHeap()));
+  app.begin(80);
 }
 
-void loop() {}
\ No newline at end of file
+void loop()
+{
+  app.handle();
+}
\ No newline at end of file
@@ -0,0 +1,376 @@
+#include "Arduino.h"
+
+#include <chrono>
+#include <thread>
+
+HardwareSerial Serial;
+EspClass ESP;
+
+static FILE* _serialOutput = stdout;
+static uint64_t _serialBytesWritten = 0;
+static uint32_t _freeHeap = 40000;  // about what an ESP8266 has left once WiFi is up
+
+static bool _simulatedClock = false;
+static unsigned long _simulatedMicros = 0;
+static const auto _start = std::chrono::steady_clock::now();
+
+
+// CLOCK
+
+unsigned long micros()
+{
+  if(_simulatedClock) return _simulatedMicros;
+  return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - _start).count();
+}
+
+
+unsigned long millis()
+{
+  if(_simulatedClock) return _simulatedMicros / 1000;
+  return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _start).count();
+}
+
+
+void delay(unsigned long ms)
+{
+  if(_simulatedClock) _simulatedMicros += ms * 1000;
+  else std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+
+void yield() {}
+
+
+void host::useSimulatedClock(bool simulated, unsigned long startMicros)
+{
+  _simulatedClock = simulated;
+  _simulatedMicros = startMicros;
+}
+
+
+void host::advanceClock(unsigned long microseconds) {_simulatedMicros += microseconds;}
+bool host::simulatedClock() {return _simulatedClock;}
+void host::setFreeHeap(uint32_t bytes) {_freeHeap = bytes;}
+void host::setSerialOutput(FILE* output) {_serialOutput = output;}
+uint64_t host::serialBytesWritten() {return _serialBytesWritten;}
+uint32_t EspClass::getFreeHeap() {return _freeHeap;}
+
+
+int snprintf_P(char* buffer, size_t size, PGM_P format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  int count = vsnprintf(buffer, size, format, args);
+  va_end(args);
+  return count;
+}
+
+
+int sprintf_P(char* buffer, PGM_P format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  int count = vsprintf(buffer, format, args);
+  va_end(args);
+  return count;
+}
+
+
+// STRING
+
+void String::assign(const char* text, unsigned int length)
+{
+  if(!reserve(length)) return;
+  memmove(buffer(), text, length);
+  buffer()[length] = '\0';
+  this->_length = length;
+}
+
+
+void String::move(String& other)
+{
+  if(other._heap){
+    this->_heap = other._heap;
+    this->_capacity = other._capacity;
+  }
+  else{
+    memcpy(this->_sso, other._sso, sizeof(this->_sso));
+    this->_capacity = SSO_CAPACITY;
+  }
+  this->_length = other._length;
+
+  other._heap = nullptr;
+  other._sso[0] = '\0';
+  other._length = 0;
+  other._capacity = SSO_CAPACITY;
+}
+
+
+bool String::reserve(unsigned int capacity)
+{
+  if(capacity <= this->_capacity) return true;
+
+  // grown like the core's String: to what's asked for, no more
+  char* heap = (char*)realloc(this->_heap, capacity + 1);
+  if(!heap) return false;
+  if(!this->_heap) memcpy(heap, this->_sso, this->_length + 1);
+  this->_heap = heap;
+  this->_capacity = capacity;
+  return true;
+}
+
+
+bool String::concat(const char* text, unsigned int length)
+{
+  if(length == 0) return true;
+  // text may be in this String
+  if(text >= c_str() && text < c_str() + this->_capacity + 1){
+    String copy(text, length);
+    return concat(copy.c_str(), length);
+  }
+  if(!reserve(this->_length + length)) return false;
+  memcpy(buffer() + this->_length, text, length);
+  this->_length += length;
+  buffer()[this->_length] = '\0';
+  return true;
+}
+
+
+static String formatNumber(unsigned long long value, unsigned char base, bool negative)
+{
+  char digits[68];
+  char* end = digits + sizeof(digits) - 1;
+  char* start = end;
+  *end = '\0';
+  if(base < 2) base = 10;
+  do{
+    unsigned digit = value % base;
+    *--start = digit < 10 ? '0' + digit : 'a' + digit - 10;
+    value /= base;
+  } while(value);
+  if(negative) *--start = '-';
+  return String(start);
+}
+
+
+String::String(unsigned char value, unsigned char base): String(formatNumber(value, base, false)) {}
+String::String(int value, unsigned char base)
+  : String(base == 10 && value < 0 ? formatNumber(-(long long)value, 10, true) : formatNumber((unsigned)value, base, false)) {}
+String::String(unsigned int value, unsigned char base): String(formatNumber(value, base, false)) {}
+String::String(long value, unsigned char base)
+  : String(base == 10 && value < 0 ? formatNumber(-(long long)value, 10, true) : formatNumber((unsigned long)value, base, false)) {}
+String::String(unsigned long value, unsigned char base): String(formatNumber(value, base, false)) {}
+String::String(long long value): String(value < 0 ? formatNumber(-(unsigned long long)value, 10, true) : formatNumber(value, 10, false)) {}
+String::String(unsigned long long value): String(formatNumber(value, 10, false)) {}
+
+
+String::String(double value, unsigned char decimalPlaces)
+{
+  char text[64];
+  snprintf(text, sizeof(text), "%.*f", decimalPlaces, value);
+  assign(text, strlen(text));
+}
+
+
+bool String::endsWith(const String& suffix) const
+{
+  return suffix._length <= this->_length &&
+         memcmp(c_str() + this->_length - suffix._length, suffix.c_str(), suffix._length) == 0;
+}
+
+
+char& String::operator[](unsigned int index)
+{
+  static char outOfRange;
+  if(index >= this->_length){
+    outOfRange = '\0';
+    return outOfRange;
+  }
+  return buffer()[index];
+}
+
+
+int String::indexOf(char c, unsigned int from) const
+{
+  if(from >= this->_length) return -1;
+  const char* found = (const char*)memchr(c_str() + from, c, this->_length - from);
+  return found ? found - c_str() : -1;
+}
+
+
+int String::indexOf(const String& text, unsigned int from) const
+{
+  if(from > this->_length) return -1;
+  const char* found = strstr(c_str() + from, text.c_str());
+  return found ? found - c_str() : -1;
+}
+
+
+int String::lastIndexOf(char c) const
+{
+  const char* found = strrchr(c_str(), c);
+  return found ? found - c_str() : -1;
+}
+
+
+String String::substring(unsigned int from, unsigned int to) const
+{
+  if(from > to){
+    unsigned int swap = from;
+    from = to;
+    to = swap;
+  }
+  if(from >= this->_length) return String();
+  if(to > this->_length) to = this->_length;
+  return String(c_str() + from, to - from);
+}
+
+
+void String::replace(char find, char replacement)
+{
+  for(char& c : *this){
+    if(c == find) c = replacement;
+  }
+}
+
+
+void String::replace(const String& find, const String& replacement)
+{
+  if(find.isEmpty()) return;
+  String result;
+  unsigned int position = 0;
+  int found;
+  while((found = indexOf(find, position)) != -1){
+    result.concat(c_str() + position, found - position);
+    result.concat(replacement);
+    position = found + find.length();
+  }
+  result.concat(c_str() + position, this->_length - position);
+  *this = static_cast<String&&>(result);
+}
+
+
+void String::remove(unsigned int index, unsigned int count)
+{
+  if(index >= this->_length) return;
+  if(count > this->_length - index) count = this->_length - index;
+  memmove(buffer() + index, buffer() + index + count, this->_length - index - count + 1);
+  this->_length -= count;
+}
+
+
+void String::toLowerCase()
+{
+  for(char& c : *this) c = tolower((unsigned char)c);
+}
+
+
+void String::toUpperCase()
+{
+  for(char& c : *this) c = toupper((unsigned char)c);
+}
+
+
+void String::trim()
+{
+  unsigned int start = 0;
+  while(start < this->_length && isspace((unsigned char)c_str()[start])) ++start;
+  unsigned int end = this->_length;
+  while(end > start && isspace((unsigned char)c_str()[end - 1])) --end;
+  memmove(buffer(), buffer() + start, end - start);
+  this->_length = end - start;
+  buffer()[this->_length] = '\0';
+}
+
+
+void String::getBytes(unsigned char* destination, unsigned int size, unsigned int index) const
+{
+  if(size == 0) return;
+  unsigned int count = index < this->_length ? this->_length - index : 0;
+  if(count > size - 1) count = size - 1;
+  memcpy(destination, c_str() + index, count);
+  destination[count] = '\0';
+}
+
+
+String IPAddress::toString() const
+{
+  char text[16];
+  snprintf(text, sizeof(text), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+  return String(text);
+}
+
+
+// PRINT
+
+size_t Print::write(const uint8_t* data, size_t length)
+{
+  size_t count = 0;
+  while(length--) count += write(*data++);
+  return count;
+}
+
+
+size_t Print::printf(const char* format, ...)
+{
+  char line[256];
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(line, sizeof(line), format, args);
+  va_end(args);
+  if(length < 0) return 0;
+  return write((const uint8_t*)line, (size_t)length < sizeof(line) ? length : sizeof(line) - 1);
+}
+
+
+size_t Print::printf_P(PGM_P format, ...)
+{
+  char line[256];
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(line, sizeof(line), format, args);
+  va_end(args);
+  if(length < 0) return 0;
+  return write((const uint8_t*)line, (size_t)length < sizeof(line) ? length : sizeof(line) - 1);
+}
+
+
+size_t Stream::readBytes(char* buffer, size_t length)
+{
+  size_t count = 0;
+  while(count < length && available() > 0){
+    int c = read();
+    if(c < 0) break;
+    buffer[count++] = (char)c;
+  }
+  return count;
+}
+
+
+int HardwareSerial::availableForWrite()
+{
+  if(this->_baud == 0) return FIFO_SIZE;
+  long pendingMicros = (long)(this->_emptyAt - micros());
+  if(pendingMicros <= 0) return FIFO_SIZE;
+  long pending = (long)((uint64_t)pendingMicros * this->_baud / 10000000) + 1;
+  return pending >= FIFO_SIZE ? 0 : FIFO_SIZE - pending;
+}
+
+
+size_t HardwareSerial::write(const uint8_t* data, size_t length)
+{
+  if(_serialOutput) fwrite(data, 1, length, _serialOutput);
+  _serialBytesWritten += length;
+  if(this->_baud == 0) return length;
+
+  // the bytes are queued after the ones in the FIFO, the write returns once the last ones fit in it
+  unsigned long now = micros();
+  unsigned long start = (long)(this->_emptyAt - now) > 0 ? this->_emptyAt : now;
+  this->_emptyAt = start + (unsigned long)((uint64_t)length * 10000000 / this->_baud);
+  unsigned long fitsAt = this->_emptyAt - (unsigned long)((uint64_t)FIFO_SIZE * 10000000 / this->_baud);
+  if((long)(fitsAt - now) > 0){
+    if(_simulatedClock) _simulatedMicros = fitsAt;
+    else while((long)(fitsAt - micros()) > 0) {}
+  }
+  return length;
+}
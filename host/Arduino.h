@@ -0,0 +1,270 @@
+/*
+ * The Arduino core on a PC: String, Print, Stream, Serial, IPAddress, ESP, millis() and micros(),
+ * and the PROGMEM functions, which read RAM. It's what the library is built against by the native
+ * host target (see CMakeLists.txt), for its tests and benchmarks
+ */
+
+#ifndef HOST_ARDUINO_HEADER
+#define HOST_ARDUINO_HEADER
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <math.h>
+#include <functional>
+
+// PROGMEM: there is one address space, flash strings are plain strings
+#define PROGMEM
+#define PGM_P const char*
+#define PSTR(text) (text)
+class __FlashStringHelper;
+#define F(text) (reinterpret_cast<const __FlashStringHelper*>(PSTR(text)))
+#define FPSTR(pointer) (reinterpret_cast<const __FlashStringHelper*>(pointer))
+
+inline uint8_t pgm_read_byte(const void* address) {return *(const uint8_t*)address;}
+inline uint16_t pgm_read_word(const void* address) {uint16_t value; memcpy(&value, address, sizeof(value)); return value;}
+inline uint32_t pgm_read_dword(const void* address) {uint32_t value; memcpy(&value, address, sizeof(value)); return value;}
+inline const void* pgm_read_ptr(const void* address) {return *(const void* const*)address;}
+
+inline size_t strlen_P(PGM_P text) {return strlen(text);}
+inline char* strcpy_P(char* destination, PGM_P source) {return strcpy(destination, source);}
+inline char* strncpy_P(char* destination, PGM_P source, size_t length) {return strncpy(destination, source, length);}
+inline void* memcpy_P(void* destination, const void* source, size_t length) {return memcpy(destination, source, length);}
+inline int memcmp_P(const void* a, const void* b, size_t length) {return memcmp(a, b, length);}
+inline int strcmp_P(const char* a, PGM_P b) {return strcmp(a, b);}
+inline int strncmp_P(const char* a, PGM_P b, size_t length) {return strncmp(a, b, length);}
+inline int strcasecmp_P(const char* a, PGM_P b) {return strcasecmp(a, b);}
+inline int strncasecmp_P(const char* a, PGM_P b, size_t length) {return strncasecmp(a, b, length);}
+inline const char* strchr_P(PGM_P text, int c) {return strchr(text, c);}
+inline int vsnprintf_P(char* buffer, size_t size, PGM_P format, va_list args) {return vsnprintf(buffer, size, format, args);}
+int snprintf_P(char* buffer, size_t size, PGM_P format, ...) __attribute__((format(printf, 3, 4)));
+int sprintf_P(char* buffer, PGM_P format, ...) __attribute__((format(printf, 2, 3)));
+
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void yield();
+
+namespace host {
+  // the clock millis() and micros() read. It's the PC's clock unless the simulated one is used:
+  // it then only moves with advanceClock() and delay(), for tests of timeouts and rate limits
+  void useSimulatedClock(bool simulated, unsigned long startMicros = 0);
+  void advanceClock(unsigned long microseconds);
+  bool simulatedClock();
+
+  // what ESP.getFreeHeap() reports
+  void setFreeHeap(uint32_t bytes);
+
+  // where Serial writes: stdout by default, nowhere with null
+  void setSerialOutput(FILE* output);
+  // the bytes written to Serial so far
+  uint64_t serialBytesWritten();
+}
+
+
+/* String is the ESP8266 core's String: its text is kept in the object up to SSO_CAPACITY
+  * characters, on the heap beyond, so the allocations a host build counts are the device's.
+  * Only the methods the library, its tests and sketches use are provided
+*/
+class String{
+  private:
+    const static unsigned int SSO_CAPACITY = 11;
+    char _sso[SSO_CAPACITY + 1] = {0};
+    char* _heap = nullptr;
+    unsigned int _length = 0;
+    unsigned int _capacity = SSO_CAPACITY;
+
+    char* buffer() {return this->_heap ? this->_heap : this->_sso;}
+    void assign(const char* text, unsigned int length);
+    void move(String& other);
+
+  public:
+    String(const char* text = "") {assign(text ? text : "", text ? strlen(text) : 0);}
+    String(const char* text, unsigned int length) {assign(text, length);}
+    String(const __FlashStringHelper* text) {assign((const char*)text, strlen((const char*)text));}
+    String(const String& other) {assign(other.c_str(), other._length);}
+    String(String&& other) {move(other);}
+    explicit String(char c) {assign(&c, 1);}
+    explicit String(unsigned char value, unsigned char base = 10);
+    explicit String(int value, unsigned char base = 10);
+    explicit String(unsigned int value, unsigned char base = 10);
+    explicit String(long value, unsigned char base = 10);
+    explicit String(unsigned long value, unsigned char base = 10);
+    explicit String(long long value);
+    explicit String(unsigned long long value);
+    explicit String(double value, unsigned char decimalPlaces = 2);
+    ~String() {free(this->_heap);}
+
+    String& operator=(const String& other) {if(this != &other) assign(other.c_str(), other._length); return *this;}
+    String& operator=(String&& other) {if(this != &other){free(this->_heap); this->_heap = nullptr; move(other);} return *this;}
+    String& operator=(const char* text) {assign(text ? text : "", text ? strlen(text) : 0); return *this;}
+    String& operator=(const __FlashStringHelper* text) {return *this = (const char*)text;}
+
+    bool reserve(unsigned int capacity);
+    unsigned int length() const {return this->_length;}
+    bool isEmpty() const {return this->_length == 0;}
+    const char* c_str() const {return this->_heap ? this->_heap : this->_sso;}
+    char* begin() {return buffer();}
+    char* end() {return buffer() + this->_length;}
+    const char* begin() const {return c_str();}
+    const char* end() const {return c_str() + this->_length;}
+    explicit operator bool() const {return true;}
+
+    bool concat(const char* text, unsigned int length);
+    bool concat(const String& text) {return concat(text.c_str(), text._length);}
+    bool concat(const char* text) {return text && concat(text, strlen(text));}
+    bool concat(const __FlashStringHelper* text) {return concat((const char*)text);}
+    bool concat(char c) {return concat(&c, 1);}
+    bool concat(int value) {return concat(String(value));}
+    bool concat(unsigned int value) {return concat(String(value));}
+    bool concat(long value) {return concat(String(value));}
+    bool concat(unsigned long value) {return concat(String(value));}
+    bool concat(double value) {return concat(String(value));}
+    template<typename T> String& operator+=(const T& value) {concat(value); return *this;}
+
+    friend String operator+(const String& a, const String& b) {String sum(a); sum.concat(b); return sum;}
+    friend String operator+(const String& a, const char* b) {String sum(a); sum.concat(b); return sum;}
+    friend String operator+(const char* a, const String& b) {String sum(a); sum.concat(b); return sum;}
+    friend String operator+(const String& a, const __FlashStringHelper* b) {String sum(a); sum.concat(b); return sum;}
+    friend String operator+(const String& a, char b) {String sum(a); sum.concat(b); return sum;}
+    friend String operator+(const String& a, int b) {String sum(a); sum.concat(b); return sum;}
+    friend String operator+(const String& a, unsigned int b) {String sum(a); sum.concat(b); return sum;}
+    friend String operator+(const String& a, long b) {String sum(a); sum.concat(b); return sum;}
+    friend String operator+(const String& a, unsigned long b) {String sum(a); sum.concat(b); return sum;}
+
+    bool equals(const String& other) const {return this->_length == other._length && memcmp(c_str(), other.c_str(), this->_length) == 0;}
+    bool equals(const char* text) const {return strcmp(c_str(), text ? text : "") == 0;}
+    bool equalsIgnoreCase(const String& other) const {return this->_length == other._length && strcasecmp(c_str(), other.c_str()) == 0;}
+    bool operator==(const String& other) const {return equals(other);}
+    bool operator==(const char* text) const {return equals(text);}
+    bool operator!=(const String& other) const {return !equals(other);}
+    bool operator!=(const char* text) const {return !equals(text);}
+    bool operator<(const String& other) const {return strcmp(c_str(), other.c_str()) < 0;}
+    int compareTo(const String& other) const {return strcmp(c_str(), other.c_str());}
+    bool startsWith(const String& prefix) const {return prefix._length <= this->_length && memcmp(c_str(), prefix.c_str(), prefix._length) == 0;}
+    bool endsWith(const String& suffix) const;
+
+    char charAt(unsigned int index) const {return index < this->_length ? c_str()[index] : 0;}
+    void setCharAt(unsigned int index, char c) {if(index < this->_length) buffer()[index] = c;}
+    char operator[](unsigned int index) const {return charAt(index);}
+    char& operator[](unsigned int index);
+
+    int indexOf(char c, unsigned int from = 0) const;
+    int indexOf(const String& text, unsigned int from = 0) const;
+    int lastIndexOf(char c) const;
+    String substring(unsigned int from) const {return substring(from, this->_length);}
+    String substring(unsigned int from, unsigned int to) const;
+
+    void replace(char find, char replacement);
+    void replace(const String& find, const String& replacement);
+    void remove(unsigned int index, unsigned int count = (unsigned int)-1);
+    void toLowerCase();
+    void toUpperCase();
+    void trim();
+
+    long toInt() const {return atol(c_str());}
+    float toFloat() const {return (float)atof(c_str());}
+    double toDouble() const {return atof(c_str());}
+    void getBytes(unsigned char* buffer, unsigned int size, unsigned int index = 0) const;
+    void toCharArray(char* buffer, unsigned int size, unsigned int index = 0) const {getBytes((unsigned char*)buffer, size, index);}
+};
+
+
+/* Print writes bytes, write(uint8_t) is all a subclass has to provide */
+class Print{
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t) = 0;
+    virtual size_t write(const uint8_t* data, size_t length);
+    size_t write(const char* text) {return text ? write((const uint8_t*)text, strlen(text)) : 0;}
+    size_t write(const char* text, size_t length) {return write((const uint8_t*)text, length);}
+    virtual int availableForWrite() {return 0;}
+    virtual void flush() {}
+
+    size_t print(const String& text) {return write((const uint8_t*)text.c_str(), text.length());}
+    size_t print(const char* text) {return write(text);}
+    size_t print(const __FlashStringHelper* text) {return write((const char*)text);}
+    size_t print(char c) {return write((uint8_t)c);}
+    size_t print(int value) {return print(String(value));}
+    size_t print(unsigned int value) {return print(String(value));}
+    size_t print(long value) {return print(String(value));}
+    size_t print(unsigned long value) {return print(String(value));}
+    size_t print(double value, int decimalPlaces = 2) {return print(String(value, decimalPlaces));}
+    size_t println() {return write("\r\n");}
+    template<typename T> size_t println(const T& value) {size_t count = print(value); return count + println();}
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+    size_t printf_P(PGM_P format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+
+class Stream : public Print{
+  public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    virtual size_t readBytes(char* buffer, size_t length);
+    size_t readBytes(uint8_t* buffer, size_t length) {return readBytes((char*)buffer, length);}
+    void setTimeout(unsigned long) {}
+};
+
+
+/* Serial is the UART of an ESP8266: once begun at a baud rate, the bytes written leave one every
+  * 10 bits, through a FIFO of FIFO_SIZE bytes. A write that doesn't fit in the FIFO waits until the
+  * rest has left, as on the device (the simulated clock is advanced instead of waiting). Before
+  * begin(), writes don't take any time
+*/
+class HardwareSerial : public Stream{
+  private:
+    unsigned long _baud = 0;
+    unsigned long _emptyAt = 0;   // micros() when the FIFO is empty
+
+  public:
+    const static int FIFO_SIZE = 128;
+
+    using Print::write;
+    void begin(unsigned long baud) {this->_baud = baud; this->_emptyAt = micros();}
+    size_t write(uint8_t c) override {return write(&c, 1);}
+    size_t write(const uint8_t* data, size_t length) override;
+    int availableForWrite() override;
+    int available() override {return 0;}
+    int read() override {return -1;}
+    int peek() override {return -1;}
+};
+
+extern HardwareSerial Serial;
+
+
+/* IPAddress holds an IPv4 address in network order, like the ESP8266 core's: a.b.c.d converts to
+  * the uint32_t whose first byte in memory is a
+*/
+class IPAddress{
+  private:
+    uint32_t _address = 0;
+
+  public:
+    IPAddress() {}
+    IPAddress(uint32_t address): _address{address} {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d): _address{(uint32_t)a | (uint32_t)b << 8 | (uint32_t)c << 16 | (uint32_t)d << 24} {}
+    operator uint32_t() const {return this->_address;}
+    uint8_t operator[](int index) const {return (this->_address >> (8 * index)) & 0xff;}
+    String toString() const;
+};
+
+
+class EspClass{
+  public:
+    uint32_t getFreeHeap();
+    uint32_t getMaxFreeBlockSize() {return getFreeHeap();}
+    uint8_t getHeapFragmentation() {return 0;}
+};
+
+extern EspClass ESP;
+
+#endif
@@ -0,0 +1,472 @@
+#include "ArduinoJson.h"
+
+#include <new>
+
+JsonVariant::JsonVariant(JsonArray& array): _type{array.success() ? ARRAY : UNDEFINED}, _array{&array} {}
+JsonVariant::JsonVariant(JsonObject& object): _type{object.success() ? OBJECT : UNDEFINED}, _object{&object} {}
+
+
+JsonVariant JsonVariant::operator[](const char* key) const
+{
+  return this->_type == OBJECT ? this->_object->get(key) : JsonVariant();
+}
+
+
+JsonVariant JsonVariant::operator[](int index) const
+{
+  return this->_type == ARRAY && index >= 0 ? this->_array->get(index) : JsonVariant();
+}
+
+
+// ARRAYS AND OBJECTS
+
+size_t JsonArray::size() const
+{
+  size_t count = 0;
+  for(JsonNode* node = this->_first; node; node = node->next) ++count;
+  return count;
+}
+
+
+JsonVariant JsonArray::get(size_t index) const
+{
+  JsonNode* node = this->_first;
+  while(node && index--) node = node->next;
+  return node ? node->value : JsonVariant();
+}
+
+
+bool JsonArray::add(const JsonVariant& value)
+{
+  if(!this->_buffer) return false;
+  void* memory = this->_buffer->alloc(sizeof(JsonNode));
+  if(!memory) return false;
+
+  JsonNode* node = new (memory) JsonNode{nullptr, value, nullptr};
+  JsonNode** last = &this->_first;
+  while(*last) last = &(*last)->next;
+  *last = node;
+  return true;
+}
+
+
+JsonNode* JsonObject::find(const char* key) const
+{
+  for(JsonNode* node = this->_first; node; node = node->next){
+    if(strcmp(node->key, key) == 0) return node;
+  }
+  return nullptr;
+}
+
+
+size_t JsonObject::size() const
+{
+  size_t count = 0;
+  for(JsonNode* node = this->_first; node; node = node->next) ++count;
+  return count;
+}
+
+
+JsonVariant JsonObject::get(const char* key) const
+{
+  JsonNode* node = find(key);
+  return node ? node->value : JsonVariant();
+}
+
+
+bool JsonObject::set(const char* key, const JsonVariant& value)
+{
+  if(!this->_buffer) return false;
+  JsonNode* node = find(key);
+  if(node){
+    node->value = value;
+    return true;
+  }
+
+  void* memory = this->_buffer->alloc(sizeof(JsonNode));
+  if(!memory) return false;
+  node = new (memory) JsonNode{key, value, nullptr};
+  JsonNode** last = &this->_first;
+  while(*last) last = &(*last)->next;
+  *last = node;
+  return true;
+}
+
+
+// BUFFERS
+
+JsonArray& JsonBuffer::createArray()
+{
+  void* memory = alloc(sizeof(JsonArray));
+  return memory ? *new (memory) JsonArray(this) : JsonArray::invalid();
+}
+
+
+JsonObject& JsonBuffer::createObject()
+{
+  void* memory = alloc(sizeof(JsonObject));
+  return memory ? *new (memory) JsonObject(this) : JsonObject::invalid();
+}
+
+
+char* JsonBuffer::strdup(const char* text, size_t length)
+{
+  char* copy = (char*)alloc(length + 1);
+  if(!copy) return nullptr;
+  memcpy(copy, text, length);
+  copy[length] = '\0';
+  return copy;
+}
+
+
+void* DynamicJsonBuffer::alloc(size_t size)
+{
+  size = (size + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+  if(!this->_head || this->_head->size - this->_head->used < size)
+  {
+    size_t blockSize = size > this->_blockSize ? size : this->_blockSize;
+    Block* block = (Block*)malloc(sizeof(Block) + blockSize);
+    if(!block) return nullptr;
+    *block = Block{this->_head, blockSize, 0};
+    this->_head = block;
+  }
+
+  void* memory = (uint8_t*)(this->_head + 1) + this->_head->used;
+  this->_head->used += size;
+  return memory;
+}
+
+
+void DynamicJsonBuffer::clear()
+{
+  while(this->_head){
+    Block* next = this->_head->next;
+    free(this->_head);
+    this->_head = next;
+  }
+}
+
+
+size_t DynamicJsonBuffer::size() const
+{
+  size_t total = 0;
+  for(Block* block = this->_head; block; block = block->next) total += block->used;
+  return total;
+}
+
+
+// PARSING
+
+namespace {
+
+// parses a document in place: its strings are unescaped where they are
+struct JsonParser{
+  JsonBuffer& buffer;
+  char* cursor;
+  uint8_t nestingLimit;
+
+  void skipSpaces()
+  {
+    while(*this->cursor == ' ' || *this->cursor == '\t' || *this->cursor == '\r' || *this->cursor == '\n') ++this->cursor;
+  }
+
+  bool skip(const char* word)
+  {
+    size_t length = strlen(word);
+    if(strncmp(this->cursor, word, length) != 0) return false;
+    this->cursor += length;
+    return true;
+  }
+
+  static void appendUtf8(char*& out, uint32_t codepoint)
+  {
+    if(codepoint < 0x80) *out++ = codepoint;
+    else if(codepoint < 0x800){
+      *out++ = 0xc0 | (codepoint >> 6);
+      *out++ = 0x80 | (codepoint & 0x3f);
+    }
+    else{
+      *out++ = 0xe0 | (codepoint >> 12);
+      *out++ = 0x80 | ((codepoint >> 6) & 0x3f);
+      *out++ = 0x80 | (codepoint & 0x3f);
+    }
+  }
+
+  // returns the unescaped string at the cursor, null if it's not one
+  const char* parseString()
+  {
+    if(*this->cursor != '"') return nullptr;
+    char* start = ++this->cursor;
+    char* out = start;
+    while(*this->cursor != '"')
+    {
+      char c = *this->cursor++;
+      if(c == '\0' || (unsigned char)c < 0x20) return nullptr;
+      if(c != '\\'){
+        *out++ = c;
+        continue;
+      }
+      c = *this->cursor++;
+      switch(c){
+        case '"': case '\\': case '/': *out++ = c; break;
+        case 'b': *out++ = '\b'; break;
+        case 'f': *out++ = '\f'; break;
+        case 'n': *out++ = '\n'; break;
+        case 'r': *out++ = '\r'; break;
+        case 't': *out++ = '\t'; break;
+        case 'u':{
+          uint32_t codepoint = 0;
+          for(int i = 0; i < 4; ++i){
+            char digit = *this->cursor++;
+            if(!isxdigit((unsigned char)digit)) return nullptr;
+            codepoint = codepoint * 16 + (isdigit((unsigned char)digit) ? digit - '0' : (tolower(digit) - 'a' + 10));
+          }
+          appendUtf8(out, codepoint);
+          break;
+        }
+        default: return nullptr;
+      }
+    }
+    ++this->cursor;
+    *out = '\0';
+    return start;
+  }
+
+  bool parseValue(JsonVariant& value, uint8_t depth)
+  {
+    skipSpaces();
+    char c = *this->cursor;
+    if(c == '{' || c == '['){
+      if(depth >= this->nestingLimit) return false;
+      return c == '{' ? parseObject(value, depth + 1) : parseArray(value, depth + 1);
+    }
+    if(c == '"'){
+      const char* text = parseString();
+      if(!text) return false;
+      value = JsonVariant(text);
+      return true;
+    }
+    if(skip("true")){value = JsonVariant(true); return true;}
+    if(skip("false")){value = JsonVariant(false); return true;}
+    if(skip("null")){value = JsonVariant(nullptr); return true;}
+
+    char* end;
+    long integer = strtol(this->cursor, &end, 10);
+    if(end != this->cursor && *end != '.' && *end != 'e' && *end != 'E'){
+      this->cursor = end;
+      value = JsonVariant(integer);
+      return true;
+    }
+    double number = strtod(this->cursor, &end);
+    if(end == this->cursor) return false;
+    this->cursor = end;
+    value = JsonVariant(number);
+    return true;
+  }
+
+  bool parseArray(JsonVariant& value, uint8_t depth)
+  {
+    JsonArray& array = this->buffer.createArray();
+    if(!array.success()) return false;
+    ++this->cursor;
+    skipSpaces();
+    if(*this->cursor == ']'){
+      ++this->cursor;
+      value = JsonVariant(array);
+      return true;
+    }
+    while(true)
+    {
+      JsonVariant element;
+      if(!parseValue(element, depth) || !array.add(element)) return false;
+      skipSpaces();
+      if(*this->cursor == ','){++this->cursor; continue;}
+      if(*this->cursor == ']'){++this->cursor; break;}
+      return false;
+    }
+    value = JsonVariant(array);
+    return true;
+  }
+
+  bool parseObject(JsonVariant& value, uint8_t depth)
+  {
+    JsonObject& object = this->buffer.createObject();
+    if(!object.success()) return false;
+    ++this->cursor;
+    skipSpaces();
+    if(*this->cursor == '}'){
+      ++this->cursor;
+      value = JsonVariant(object);
+      return true;
+    }
+    while(true)
+    {
+      skipSpaces();
+      const char* key = parseString();
+      if(!key) return false;
+      skipSpaces();
+      if(*this->cursor++ != ':') return false;
+      JsonVariant member;
+      if(!parseValue(member, depth) || !object.set(key, member)) return false;
+      skipSpaces();
+      if(*this->cursor == ','){++this->cursor; continue;}
+      if(*this->cursor == '}'){++this->cursor; break;}
+      return false;
+    }
+    value = JsonVariant(object);
+    return true;
+  }
+};
+
+}
+
+
+JsonVariant JsonBuffer::parse(char* text, uint8_t nestingLimit)
+{
+  if(!text) return JsonVariant();
+  JsonParser parser{*this, text, nestingLimit};
+  JsonVariant document;
+  if(!parser.parseValue(document, 0)) return JsonVariant();
+  parser.skipSpaces();
+  if(*parser.cursor != '\0') return JsonVariant();
+  return document;
+}
+
+
+// PRINTING
+
+namespace {
+
+// counts what it's given, and passes it on to the output if there is one
+struct JsonWriter{
+  Print* output;
+  size_t count = 0;
+
+  void write(const char* text, size_t length)
+  {
+    if(this->output) this->output->write((const uint8_t*)text, length);
+    this->count += length;
+  }
+  void write(const char* text) {write(text, strlen(text));}
+
+  void writeString(const char* text)
+  {
+    write("\"", 1);
+    for(const char* c = text; *c; ++c)
+    {
+      const char* escape = nullptr;
+      switch(*c){
+        case '"': escape = "\\\""; break;
+        case '\\': escape = "\\\\"; break;
+        case '\n': escape = "\\n"; break;
+        case '\r': escape = "\\r"; break;
+        case '\t': escape = "\\t"; break;
+        case '\b': escape = "\\b"; break;
+        case '\f': escape = "\\f"; break;
+      }
+      if(escape) write(escape);
+      else if((unsigned char)*c < 0x20){
+        char code[8];
+        snprintf(code, sizeof(code), "\\u%04x", *c);
+        write(code);
+      }
+      else write(c, 1);
+    }
+    write("\"", 1);
+  }
+
+  void writeValue(const JsonVariant& value)
+  {
+    char number[32];
+    switch(value.type()){
+      case JsonVariant::UNDEFINED: break;
+      case JsonVariant::NUL: write("null"); break;
+      case JsonVariant::BOOLEAN: write(value.as<bool>() ? "true" : "false"); break;
+      case JsonVariant::INTEGER:
+        snprintf(number, sizeof(number), "%ld", value.as<long>());
+        write(number);
+        break;
+      case JsonVariant::FLOAT:
+        snprintf(number, sizeof(number), "%.9g", value.as<double>());
+        write(number);
+        break;
+      case JsonVariant::TEXT: writeString(value.as<const char*>()); break;
+      case JsonVariant::ARRAY:
+        write("[", 1);
+        for(JsonNode* node = value.as<JsonArray&>().first(); node; node = node->next){
+          writeValue(node->value);
+          if(node->next) write(",", 1);
+        }
+        write("]", 1);
+        break;
+      case JsonVariant::OBJECT:
+        write("{", 1);
+        for(JsonNode* node = value.as<JsonObject&>().first(); node; node = node->next){
+          writeString(node->key);
+          write(":", 1);
+          writeValue(node->value);
+          if(node->next) write(",", 1);
+        }
+        write("}", 1);
+        break;
+    }
+  }
+};
+
+
+// writes to a char buffer, cut at its size
+struct BufferPrint : public Print{
+  char* buffer;
+  size_t size;
+  size_t length = 0;
+
+  BufferPrint(char* buffer, size_t size): buffer{buffer}, size{size} {}
+
+  size_t write(uint8_t c) override
+  {
+    if(this->length + 1 < this->size) this->buffer[this->length++] = c;
+    return 1;
+  }
+};
+
+
+struct StringPrint : public Print{
+  String& text;
+  explicit StringPrint(String& text): text{text} {}
+  size_t write(uint8_t c) override {this->text += (char)c; return 1;}
+  size_t write(const uint8_t* data, size_t length) override {this->text.concat((const char*)data, length); return length;}
+};
+
+}
+
+
+size_t JsonVariant::printTo(Print& output) const
+{
+  JsonWriter writer{&output};
+  writer.writeValue(*this);
+  return writer.count;
+}
+
+
+size_t JsonVariant::printTo(char* buffer, size_t size) const
+{
+  BufferPrint output(buffer, size);
+  printTo(output);
+  if(size > 0) buffer[output.length] = '\0';
+  return output.length;
+}
+
+
+size_t JsonVariant::printTo(String& text) const
+{
+  StringPrint output(text);
+  return printTo(output);
+}
+
+
+size_t JsonVariant::measureLength() const
+{
+  JsonWriter writer{nullptr};
+  writer.writeValue(*this);
+  return writer.count;
+}
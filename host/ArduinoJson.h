@@ -0,0 +1,298 @@
+/*
+ * A stand-in for ArduinoJson 5 on a host build that has no copy of it (see ARDUINOJSON_DIR in
+ * CMakeLists.txt). It parses and prints JSON with the same classes and the same buffers, allocating
+ * from the JsonBuffer like the library does; only the part of the API ArduinoExpress, its tests
+ * and benchmarks use is provided
+ */
+
+#ifndef HOST_ARDUINOJSON_HEADER
+#define HOST_ARDUINOJSON_HEADER
+
+#include "Arduino.h"
+
+#include <type_traits>
+
+class JsonArray;
+class JsonObject;
+class JsonBuffer;
+
+class JsonVariant{
+  public:
+    enum Type : uint8_t {UNDEFINED, NUL, BOOLEAN, INTEGER, FLOAT, TEXT, ARRAY, OBJECT};
+
+  private:
+    Type _type = UNDEFINED;
+    union{
+      bool _boolean;
+      long _integer;
+      double _float;
+      const char* _text;
+      JsonArray* _array;
+      JsonObject* _object;
+    };
+
+    template<typename T> struct As;
+
+  public:
+    JsonVariant(): _integer{0} {}
+    JsonVariant(std::nullptr_t): _type{NUL}, _integer{0} {}
+    JsonVariant(bool value): _type{BOOLEAN}, _boolean{value} {}
+    template<typename T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, int>::type = 0>
+    JsonVariant(T value): _type{INTEGER}, _integer{(long)value} {}
+    template<typename T, typename std::enable_if<std::is_floating_point<T>::value, int>::type = 0>
+    JsonVariant(T value): _type{FLOAT}, _float{value} {}
+    JsonVariant(const char* value): _type{value ? TEXT : NUL}, _text{value} {}
+    JsonVariant(JsonArray& array);
+    JsonVariant(JsonObject& object);
+
+    Type type() const {return this->_type;}
+    bool success() const {return this->_type != UNDEFINED;}
+
+    template<typename T> bool is() const {return As<T>::is(*this);}
+    template<typename T> typename As<T>::Result as() const {return As<T>::get(*this);}
+    template<typename T> operator T() const {return as<T>();}
+
+    JsonVariant operator[](const char* key) const;
+    JsonVariant operator[](const String& key) const {return (*this)[key.c_str()];}
+    JsonVariant operator[](int index) const;
+
+    size_t printTo(Print& output) const;
+    size_t printTo(char* buffer, size_t size) const;
+    size_t printTo(String& output) const;
+    size_t measureLength() const;
+};
+
+
+// an object's member, or an array's element, in the buffer
+struct JsonNode{
+  const char* key;
+  JsonVariant value;
+  JsonNode* next;
+};
+
+
+class JsonArray{
+  private:
+    JsonBuffer* _buffer;
+    JsonNode* _first = nullptr;
+
+  public:
+    explicit JsonArray(JsonBuffer* buffer): _buffer{buffer} {}
+    static JsonArray& invalid() {static JsonArray array(nullptr); return array;}
+
+    bool success() const {return this->_buffer != nullptr;}
+    size_t size() const;
+    JsonVariant get(size_t index) const;
+    template<typename T> T get(size_t index) const {return get(index).as<T>();}
+    JsonVariant operator[](size_t index) const {return get(index);}
+    bool add(const JsonVariant& value);
+    JsonNode* first() const {return this->_first;}
+
+    size_t printTo(Print& output) const {return JsonVariant(const_cast<JsonArray&>(*this)).printTo(output);}
+    size_t printTo(char* buffer, size_t size) const {return JsonVariant(const_cast<JsonArray&>(*this)).printTo(buffer, size);}
+    size_t measureLength() const {return JsonVariant(const_cast<JsonArray&>(*this)).measureLength();}
+};
+
+
+class JsonObject{
+  private:
+    JsonBuffer* _buffer;
+    JsonNode* _first = nullptr;
+
+    JsonNode* find(const char* key) const;
+
+  public:
+    // a member read or assigned with object["key"]
+    class Subscript{
+      private:
+        JsonObject& _object;
+        const char* _key;
+
+      public:
+        Subscript(JsonObject& object, const char* key): _object{object}, _key{key} {}
+        Subscript& operator=(const JsonVariant& value) {this->_object.set(this->_key, value); return *this;}
+        bool success() const {return this->_object.containsKey(this->_key);}
+        template<typename T> bool is() const {return this->_object.get(this->_key).template is<T>();}
+        template<typename T> auto as() const -> decltype(JsonVariant().as<T>()) {return this->_object.get(this->_key).template as<T>();}
+        template<typename T> operator T() const {return this->_object.get(this->_key).template as<T>();}
+        operator JsonVariant() const {return this->_object.get(this->_key);}
+    };
+
+    explicit JsonObject(JsonBuffer* buffer): _buffer{buffer} {}
+    static JsonObject& invalid() {static JsonObject object(nullptr); return object;}
+
+    bool success() const {return this->_buffer != nullptr;}
+    size_t size() const;
+    bool containsKey(const char* key) const {return find(key) != nullptr;}
+    bool containsKey(const String& key) const {return containsKey(key.c_str());}
+    JsonVariant get(const char* key) const;
+    template<typename T> auto get(const char* key) const -> decltype(JsonVariant().as<T>()) {return get(key).as<T>();}
+    template<typename T> auto get(const String& key) const -> decltype(JsonVariant().as<T>()) {return get(key.c_str()).as<T>();}
+    bool set(const char* key, const JsonVariant& value);
+    Subscript operator[](const char* key) {return Subscript(*this, key);}
+    Subscript operator[](const String& key) {return Subscript(*this, key.c_str());}
+    JsonVariant operator[](const char* key) const {return get(key);}
+    JsonNode* first() const {return this->_first;}
+
+    size_t printTo(Print& output) const {return JsonVariant(const_cast<JsonObject&>(*this)).printTo(output);}
+    size_t printTo(char* buffer, size_t size) const {return JsonVariant(const_cast<JsonObject&>(*this)).printTo(buffer, size);}
+    size_t printTo(String& output) const {return JsonVariant(const_cast<JsonObject&>(*this)).printTo(output);}
+    size_t measureLength() const {return JsonVariant(const_cast<JsonObject&>(*this)).measureLength();}
+};
+
+
+// the conversions of is<T>() and as<T>()
+template<typename T> struct JsonVariant::As{
+  using Result = T;
+  static bool is(const JsonVariant& variant)
+  {
+    if(std::is_same<T, bool>::value) return variant._type == BOOLEAN;
+    if(std::is_integral<T>::value) return variant._type == INTEGER;
+    return variant._type == INTEGER || variant._type == FLOAT;
+  }
+  static T get(const JsonVariant& variant)
+  {
+    switch(variant._type){
+      case BOOLEAN: return (T)variant._boolean;
+      case INTEGER: return (T)variant._integer;
+      case FLOAT: return (T)variant._float;
+      case TEXT: return (T)(std::is_integral<T>::value ? atol(variant._text) : atof(variant._text));
+      default: return T();
+    }
+  }
+};
+
+template<> struct JsonVariant::As<const char*>{
+  using Result = const char*;
+  static bool is(const JsonVariant& variant) {return variant._type == TEXT;}
+  static const char* get(const JsonVariant& variant) {return variant._type == TEXT ? variant._text : nullptr;}
+};
+
+template<> struct JsonVariant::As<char*>{
+  using Result = const char*;
+  static bool is(const JsonVariant& variant) {return variant._type == TEXT;}
+  static const char* get(const JsonVariant& variant) {return variant._type == TEXT ? variant._text : nullptr;}
+};
+
+template<> struct JsonVariant::As<String>{
+  using Result = String;
+  static bool is(const JsonVariant& variant) {return variant._type == TEXT;}
+  static String get(const JsonVariant& variant)
+  {
+    if(variant._type == TEXT) return String(variant._text);
+    String text;
+    if(variant._type != UNDEFINED && variant._type != NUL) variant.printTo(text);
+    return text;
+  }
+};
+
+template<> struct JsonVariant::As<JsonVariant>{
+  using Result = JsonVariant;
+  static bool is(const JsonVariant& variant) {return variant.success();}
+  static JsonVariant get(const JsonVariant& variant) {return variant;}
+};
+
+template<> struct JsonVariant::As<JsonObject&>{
+  using Result = JsonObject&;
+  static bool is(const JsonVariant& variant) {return variant._type == OBJECT;}
+  static JsonObject& get(const JsonVariant& variant) {return variant._type == OBJECT ? *variant._object : JsonObject::invalid();}
+};
+
+template<> struct JsonVariant::As<JsonObject>: JsonVariant::As<JsonObject&> {};
+
+template<> struct JsonVariant::As<JsonArray&>{
+  using Result = JsonArray&;
+  static bool is(const JsonVariant& variant) {return variant._type == ARRAY;}
+  static JsonArray& get(const JsonVariant& variant) {return variant._type == ARRAY ? *variant._array : JsonArray::invalid();}
+};
+
+template<> struct JsonVariant::As<JsonArray>: JsonVariant::As<JsonArray&> {};
+
+// the memory a document takes, as with ArduinoJson
+#define JSON_OBJECT_SIZE(count) (sizeof(JsonObject) + (count) * sizeof(JsonNode))
+#define JSON_ARRAY_SIZE(count) (sizeof(JsonArray) + (count) * sizeof(JsonNode))
+
+
+/* JsonBuffer allocates a document's arrays, objects, members and strings with alloc() */
+class JsonBuffer{
+  public:
+    JsonBuffer() {}
+    JsonBuffer(const JsonBuffer&) = delete;
+    JsonBuffer& operator=(const JsonBuffer&) = delete;
+    virtual ~JsonBuffer() {}
+
+    virtual void* alloc(size_t size) = 0;
+
+    JsonArray& createArray();
+    JsonObject& createObject();
+    char* strdup(const char* text, size_t length);
+    char* strdup(const char* text) {return text ? strdup(text, strlen(text)) : nullptr;}
+
+    // parses text in place. A const text is copied to the buffer first
+    JsonVariant parse(char* text, uint8_t nestingLimit = 10);
+    JsonVariant parse(const char* text, uint8_t nestingLimit = 10) {return parse(strdup(text), nestingLimit);}
+    JsonVariant parse(const String& text, uint8_t nestingLimit = 10) {return parse(text.c_str(), nestingLimit);}
+    template<typename T> JsonObject& parseObject(T text, uint8_t nestingLimit = 10);
+    template<typename T> JsonArray& parseArray(T text, uint8_t nestingLimit = 10);
+};
+
+namespace ArduinoJson { namespace Internals {
+  template<typename TDerived> class JsonBufferBase : public JsonBuffer {};
+}}
+
+
+class DynamicJsonBuffer : public ArduinoJson::Internals::JsonBufferBase<DynamicJsonBuffer>{
+  private:
+    struct Block{
+      Block* next;
+      size_t size;
+      size_t used;
+    };
+    Block* _head = nullptr;
+    size_t _blockSize;
+
+  public:
+    explicit DynamicJsonBuffer(size_t blockSize = 256): _blockSize{blockSize} {}
+    ~DynamicJsonBuffer() {clear();}
+    void* alloc(size_t size) override;
+    void clear();
+    size_t size() const;
+};
+
+
+template<size_t CAPACITY>
+class StaticJsonBuffer : public ArduinoJson::Internals::JsonBufferBase<StaticJsonBuffer<CAPACITY>>{
+  private:
+    alignas(void*) uint8_t _memory[CAPACITY];
+    size_t _size = 0;
+
+  public:
+    void* alloc(size_t size) override
+    {
+      size = (size + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+      if(size > CAPACITY - this->_size) return nullptr;
+      void* block = this->_memory + this->_size;
+      this->_size += size;
+      return block;
+    }
+    void clear() {this->_size = 0;}
+    size_t size() const {return this->_size;}
+    size_t capacity() const {return CAPACITY;}
+};
+
+
+template<typename T> JsonObject& JsonBuffer::parseObject(T text, uint8_t nestingLimit)
+{
+  JsonVariant document = parse(text, nestingLimit);
+  return document.template as<JsonObject&>();
+}
+
+
+template<typename T> JsonArray& JsonBuffer::parseArray(T text, uint8_t nestingLimit)
+{
+  JsonVariant document = parse(text, nestingLimit);
+  return document.template as<JsonArray&>();
+}
+
+
+#endif
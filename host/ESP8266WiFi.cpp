@@ -0,0 +1,96 @@
+#include "ESP8266WiFi.h"
+#include "HostMemory.h"
+
+size_t WiFiClient::write(const uint8_t* data, size_t length)
+{
+  if(!this->_socket || this->_socket->serverClosed || length == 0) return 0;
+
+  // the harness's copy of the bytes is not the server's allocation
+  host::AllocationPause pause;
+  host::SimulatedSocket& socket = *this->_socket;
+  socket.outbound.append((const char*)data, length);
+  ++socket.writes;
+
+  // the bytes leave once the link is free, and arrive latencyUs later
+  unsigned long now = micros();
+  unsigned long start = (long)(socket.outboundFreeAt - now) > 0 ? socket.outboundFreeAt : now;
+  uint32_t bandwidth = socket.conditions.bytesPerSecond;
+  socket.outboundFreeAt = start + (bandwidth ? (unsigned long)((uint64_t)length * 1000000 / bandwidth) : 0);
+  socket.outboundArrivesAt = socket.outboundFreeAt + socket.conditions.latencyUs;
+
+  // the write returns once the last bytes fit in the send buffer
+  if(bandwidth){
+    unsigned long fitsAt = socket.outboundFreeAt - (unsigned long)((uint64_t)SEND_BUFFER_SIZE * 1000000 / bandwidth);
+    if((long)(fitsAt - now) > 0){
+      if(host::simulatedClock()) host::advanceClock(fitsAt - now);
+      else while((long)(fitsAt - micros()) > 0) {}
+    }
+  }
+  return length;
+}
+
+
+int WiFiClient::availableForWrite()
+{
+  if(!this->_socket || this->_socket->serverClosed) return 0;
+  uint32_t bandwidth = this->_socket->conditions.bytesPerSecond;
+  long pendingMicros = (long)(this->_socket->outboundFreeAt - micros());
+  if(bandwidth == 0 || pendingMicros <= 0) return SEND_BUFFER_SIZE;
+  long pending = (long)((uint64_t)pendingMicros * bandwidth / 1000000) + 1;
+  return pending >= SEND_BUFFER_SIZE ? 0 : SEND_BUFFER_SIZE - pending;
+}
+
+
+int WiFiClient::read(uint8_t* data, size_t length)
+{
+  if(!this->_socket) return 0;
+
+  host::AllocationPause pause;
+  host::SimulatedSocket& socket = *this->_socket;
+  size_t count = 0;
+  size_t arrived = socket.arrived();
+  while(count < length && arrived > 0)
+  {
+    host::SimulatedSocket::Segment& segment = socket.inbound.front();
+    size_t take = segment.data.size() - socket.inboundOffset;
+    if(take > length - count) take = length - count;
+    memcpy(data + count, segment.data.data() + socket.inboundOffset, take);
+    count += take;
+    arrived -= take;
+    socket.inboundOffset += take;
+    if(socket.inboundOffset == segment.data.size()){
+      socket.inbound.pop_front();
+      socket.inboundOffset = 0;
+    }
+  }
+  return (int)count;
+}
+
+
+int WiFiClient::read()
+{
+  uint8_t c;
+  return read(&c, 1) == 1 ? c : -1;
+}
+
+
+int WiFiClient::peek()
+{
+  if(!this->_socket || this->_socket->arrived() == 0) return -1;
+  return (uint8_t)this->_socket->inbound.front().data[this->_socket->inboundOffset];
+}
+
+
+uint8_t WiFiClient::connected()
+{
+  if(!this->_socket || this->_socket->serverClosed) return false;
+  return !this->_socket->clientClosed || !this->_socket->inbound.empty();
+}
+
+
+void WiFiClient::stop()
+{
+  host::AllocationPause pause;
+  if(this->_socket) this->_socket->serverClosed = true;
+  this->_socket = nullptr;
+}
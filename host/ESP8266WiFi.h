@@ -0,0 +1,60 @@
+/*
+ * WiFiClient and WiFiServer on the simulated network of a host build, see SimulatedNetwork.h
+ */
+
+#ifndef HOST_ESP8266_WIFI_HEADER
+#define HOST_ESP8266_WIFI_HEADER
+
+#include "Arduino.h"
+#include "SimulatedNetwork.h"
+
+class WiFiClient : public Stream{
+  private:
+    std::shared_ptr<host::SimulatedSocket> _socket;
+
+  public:
+    // the bytes written that haven't left on the link yet, like lwIP's TCP_SND_BUF on the ESP8266
+    const static int SEND_BUFFER_SIZE = 2920;
+
+    WiFiClient() {}
+    explicit WiFiClient(std::shared_ptr<host::SimulatedSocket> socket): _socket{std::move(socket)} {}
+
+    using Print::write;
+    size_t write(uint8_t c) override {return write(&c, 1);}
+    size_t write(const uint8_t* data, size_t length) override;
+    int availableForWrite() override;
+
+    int available() override {return this->_socket ? (int)this->_socket->arrived() : 0;}
+    int read() override;
+    int read(uint8_t* data, size_t length);
+    int peek() override;
+
+    // true while the server hasn't stopped the client, and the client is open or has bytes left
+    uint8_t connected();
+    void stop();
+    void setNoDelay(bool) {}
+    IPAddress remoteIP() const {return this->_socket ? IPAddress(this->_socket->remoteIP) : IPAddress();}
+
+    explicit operator bool() const {return this->_socket != nullptr;}
+};
+
+
+class WiFiServer{
+  private:
+    uint16_t _port;
+    bool _listening = false;
+
+  public:
+    WiFiServer(uint16_t port): _port{port} {}
+
+    void begin() {host::detail::listen(this->_port); this->_listening = true;}
+    void stop() {if(this->_listening) host::detail::unlisten(this->_port); this->_listening = false;}
+    void setNoDelay(bool) {}
+
+    // returns the next client waiting to be accepted, a false WiFiClient if there's none
+    WiFiClient available() {return this->_listening ? WiFiClient(host::detail::accept(this->_port)) : WiFiClient();}
+    WiFiClient accept() {return available();}
+    bool hasClient() {return this->_listening && host::pendingConnections(this->_port) > 0;}
+};
+
+#endif
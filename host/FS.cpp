@@ -0,0 +1,85 @@
+#include "FS.h"
+#include "HostMemory.h"
+
+#include <filesystem>
+#include <fstream>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+namespace fs {
+
+int File::available()
+{
+  if(!this->_file) return 0;
+  long position = ftell(this->_file.get());
+  return position < 0 || (size_t)position >= this->_size ? 0 : (int)(this->_size - position);
+}
+
+
+int File::peek()
+{
+  if(!this->_file) return -1;
+  int c = fgetc(this->_file.get());
+  if(c != EOF) ungetc(c, this->_file.get());
+  return c;
+}
+
+
+File FS::open(const char* path, const char* mode)
+{
+  // what stdio allocates is not what LittleFS does on the device, it's not counted. The file is
+  // unbuffered, stdio would allocate its buffer on the first read
+  host::AllocationPause pause;
+  std::string fullPath = pathOf(path);
+  struct stat status;
+  bool found = stat(fullPath.c_str(), &status) == 0;
+  if(found && S_ISDIR(status.st_mode)) return File(nullptr, path, 0, status.st_mtime, true);
+
+  FILE* file = fopen(fullPath.c_str(), mode);
+  if(!file) return File();
+  setvbuf(file, nullptr, _IONBF, 0);
+  if(!found) stat(fullPath.c_str(), &status);
+  return File(std::shared_ptr<FILE>(file, fclose), path, status.st_size, status.st_mtime, false);
+}
+
+
+bool FS::exists(const char* path)
+{
+  struct stat status;
+  return stat(pathOf(path).c_str(), &status) == 0;
+}
+
+}
+
+
+namespace host {
+
+TemporaryDirectory::TemporaryDirectory()
+{
+  AllocationPause pause;
+  std::string pattern = (std::filesystem::temp_directory_path() / "arduinoexpress-XXXXXX").string();
+  if(!mkdtemp(&pattern[0])){
+    perror("mkdtemp");
+    exit(1);
+  }
+  this->_path = pattern;
+}
+
+
+TemporaryDirectory::~TemporaryDirectory()
+{
+  AllocationPause pause;
+  std::error_code error;
+  std::filesystem::remove_all(this->_path, error);
+}
+
+
+void TemporaryDirectory::write(const std::string& name, const std::string& data)
+{
+  AllocationPause pause;
+  std::filesystem::path path = std::filesystem::path(this->_path) / name;
+  std::filesystem::create_directories(path.parent_path());
+  std::ofstream(path, std::ios::binary) << data;
+}
+
+}
@@ -0,0 +1,95 @@
+/*
+ * The file system of a host build: an fs::FS serves the files of a directory of the PC, like
+ * LittleFS serves the device's flash
+ */
+
+#ifndef HOST_FS_HEADER
+#define HOST_FS_HEADER
+
+#include "Arduino.h"
+
+#include <memory>
+#include <string>
+
+namespace fs {
+
+enum SeekMode {SeekSet = 0, SeekCur = 1, SeekEnd = 2};
+
+class File : public Stream{
+  private:
+    std::shared_ptr<FILE> _file;
+    std::string _name;
+    size_t _size = 0;
+    time_t _lastWrite = 0;
+    bool _directory = false;
+
+  public:
+    File() {}
+    File(std::shared_ptr<FILE> file, std::string name, size_t size, time_t lastWrite, bool directory)
+      : _file{std::move(file)}, _name{std::move(name)}, _size{size}, _lastWrite{lastWrite}, _directory{directory} {}
+
+    using Print::write;
+    size_t write(uint8_t c) override {return write(&c, 1);}
+    size_t write(const uint8_t* data, size_t length) override {return this->_file ? fwrite(data, 1, length, this->_file.get()) : 0;}
+
+    int available() override;
+    int read() override {return this->_file ? fgetc(this->_file.get()) : -1;}
+    int peek() override;
+    size_t read(uint8_t* data, size_t length) {return this->_file ? fread(data, 1, length, this->_file.get()) : 0;}
+    bool seek(uint32_t position, SeekMode mode = SeekSet) {return this->_file && fseek(this->_file.get(), position, mode) == 0;}
+    size_t position() const {return this->_file ? ftell(this->_file.get()) : 0;}
+
+    size_t size() const {return this->_size;}
+    time_t getLastWrite() const {return this->_lastWrite;}
+    bool isDirectory() const {return this->_directory;}
+    const char* name() const {return this->_name.c_str();}
+    void close() {this->_file = nullptr; this->_directory = false;}
+    explicit operator bool() const {return this->_file != nullptr || this->_directory;}
+};
+
+
+class FS{
+  private:
+    std::string _root;
+
+    std::string pathOf(const char* path) const {return this->_root + (path[0] == '/' ? "" : "/") + path;}
+
+  public:
+    // serves the files under the root directory of the PC
+    explicit FS(const std::string& root): _root{root} {}
+
+    File open(const char* path, const char* mode = "r");
+    File open(const String& path, const char* mode = "r") {return open(path.c_str(), mode);}
+    bool exists(const char* path);
+    bool exists(const String& path) {return exists(path.c_str());}
+};
+
+}
+
+using fs::FS;
+using fs::File;
+
+
+namespace host {
+
+/* TemporaryDirectory is a directory of the PC for the files a test or a benchmark serves, removed
+  with them when it goes out of scope. e.g. fs::FS files(directory.path())
+*/
+class TemporaryDirectory{
+  private:
+    std::string _path;
+
+  public:
+    TemporaryDirectory();
+    ~TemporaryDirectory();
+    TemporaryDirectory(const TemporaryDirectory&) = delete;
+    TemporaryDirectory& operator=(const TemporaryDirectory&) = delete;
+
+    const std::string& path() const {return this->_path;}
+    // writes a file, name is relative to the directory and can have subdirectories
+    void write(const std::string& name, const std::string& data);
+};
+
+}
+
+#endif
@@ -0,0 +1,120 @@
+#include "HostBench.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <numeric>
+
+namespace host {
+
+static const int COLUMN_WIDTH = 14;
+
+
+size_t iterations(int argc, char** argv, size_t count)
+{
+  host::setSerialOutput(nullptr);
+  for(int i = 1; i < argc; ++i){
+    if(strcmp(argv[i], "--quick") == 0) return count / 100 ? count / 100 : 1;
+  }
+  return count;
+}
+
+
+double Latencies::mean() const
+{
+  if(this->_samples.empty()) return 0;
+  return std::accumulate(this->_samples.begin(), this->_samples.end(), 0.0) / this->_samples.size();
+}
+
+
+uint64_t Latencies::percentile(double fraction)
+{
+  if(this->_samples.empty()) return 0;
+  if(!this->_sorted){
+    std::sort(this->_samples.begin(), this->_samples.end());
+    this->_sorted = true;
+  }
+  size_t index = (size_t)(fraction * (this->_samples.size() - 1) + 0.5);
+  return this->_samples[index];
+}
+
+
+static const uint8_t STACK_PATTERN = 0xa5;
+
+// the region is in this function's frame, below the caller's: what is called after it returns runs there
+__attribute__((noinline, no_sanitize_address)) void StackProbe::paint()
+{
+  volatile uint8_t region[SIZE];
+  for(size_t i = 0; i < SIZE; ++i) region[i] = STACK_PATTERN;
+  this->_low = (uintptr_t)region;
+}
+
+
+__attribute__((noinline, no_sanitize_address)) size_t StackProbe::used() const
+{
+  // the stack grows down: the lowest byte overwritten is the deepest the call went
+  const volatile uint8_t* region = (const volatile uint8_t*)this->_low;
+  size_t untouched = 0;
+  while(untouched < SIZE && region[untouched] == STACK_PATTERN) ++untouched;
+  return SIZE - untouched;
+}
+
+
+std::vector<std::string> loadCorpus(const char* path)
+{
+  std::ifstream file(path);
+  if(!file){
+    fprintf(stderr, "Could not open the corpus %s\n", path);
+    exit(1);
+  }
+
+  std::vector<std::string> requests;
+  std::string line, head, body;
+  bool inBody = false;
+  auto finish = [&]{
+    if(head.empty()) return;
+    if(!body.empty() && body.back() == '\n') body.pop_back();
+    requests.push_back(head + "\r\n" + body);
+    head.clear();
+    body.clear();
+    inBody = false;
+  };
+
+  while(std::getline(file, line))
+  {
+    if(line == "%%") finish();
+    else if(inBody) body += line + "\n";
+    else if(line.empty()) inBody = !head.empty();
+    else head += line + "\r\n";
+  }
+  finish();
+  return requests;
+}
+
+
+void printHeader(const char* title, const std::vector<std::string>& columns)
+{
+  printf("\n%s\n", title);
+  printRow(columns);
+  printf("%s\n", std::string(COLUMN_WIDTH * columns.size(), '-').c_str());
+}
+
+
+void printRow(const std::vector<std::string>& cells)
+{
+  for(size_t i = 0; i < cells.size(); ++i){
+    if(i == 0) printf("%-*s", COLUMN_WIDTH, cells[i].c_str());
+    else printf("%*s", COLUMN_WIDTH, cells[i].c_str());
+  }
+  printf("\n");
+}
+
+
+std::string format(double value, int decimals)
+{
+  char text[32];
+  snprintf(text, sizeof(text), "%.*f", decimals, value);
+  return text;
+}
+
+}
@@ -0,0 +1,104 @@
+/*
+ * The benchmarks of a host build: each one is an executable that measures a subsystem and prints a
+ * table of rows, with the latencies, throughput and heap use it measured. Run with --quick, a
+ * benchmark does fewer iterations, to only check it still runs
+ */
+
+#ifndef HOST_BENCH_HEADER
+#define HOST_BENCH_HEADER
+
+#include "Arduino.h"
+#include "HostMemory.h"
+#include "SimulatedNetwork.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace host {
+
+// parses the benchmark's arguments. Returns the number of iterations to run, count or fewer
+// with --quick
+size_t iterations(int argc, char** argv, size_t count);
+
+// returns the PC's clock in nanoseconds, whatever clock millis() reads
+inline uint64_t nanoseconds()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+/* Latencies keeps samples in nanoseconds, and reports their percentiles */
+class Latencies{
+  private:
+    std::vector<uint64_t> _samples;
+    bool _sorted = true;
+
+  public:
+    Latencies() {_samples.reserve(1 << 16);}
+    void add(uint64_t nanoseconds) {AllocationPause pause; this->_samples.push_back(nanoseconds); this->_sorted = false;}
+    size_t count() const {return this->_samples.size();}
+    double mean() const;
+    // returns the sample under which fraction of the samples are, e.g. percentile(0.99)
+    uint64_t percentile(double fraction);
+};
+
+
+/* A measurement of a block of work: its time, and the allocations and peak heap it needed.
+  * e.g. Measurement run;
+  *      for(...) serve(request);
+  *      run.stop();
+*/
+class Measurement{
+  private:
+    uint64_t _start;
+    uint64_t _elapsed = 0;
+    AllocationStats _before;
+    AllocationStats _after;
+
+  public:
+    Measurement(): _start{nanoseconds()}, _before{(resetPeak(), allocationStats())} {}
+    void stop() {this->_elapsed = nanoseconds() - this->_start; this->_after = allocationStats();}
+
+    double seconds() const {return this->_elapsed / 1e9;}
+    uint64_t allocations() const {return this->_after.allocations - this->_before.allocations;}
+    // the most the heap grew during the measurement
+    int64_t peakBytes() const {return this->_after.peakBytes - this->_before.liveBytes;}
+};
+
+
+/* StackProbe measures the most stack a call takes: paint() fills the stack below it with a pattern,
+  * used() returns how much of it was overwritten since. Both are called from the same function as
+  * the call measured, e.g. StackProbe probe;
+  *      probe.paint();
+  *      router.execute(prefix, req, res, next);
+  *      size_t bytes = probe.used();
+*/
+class StackProbe{
+  private:
+    static const size_t SIZE = 256 * 1024;
+    uintptr_t _low = 0;   // the lowest address painted
+
+  public:
+    void paint();
+    size_t used() const;
+};
+
+
+/* std::vector<std::string> loadCorpus(path)
+  * returns the requests recorded in a corpus file, ready to be sent. The file holds requests separated
+  * by lines of "%%", each written as it was sent but with plain line ends: the lines of the head end
+  * with CRLF once loaded, the body after the empty line is kept as it is, without its last line end
+*/
+std::vector<std::string> loadCorpus(const char* path);
+
+// prints the header of a table, then rows of the same columns. Columns are padded to width
+void printHeader(const char* title, const std::vector<std::string>& columns);
+void printRow(const std::vector<std::string>& cells);
+
+// formats a number for a table
+std::string format(double value, int decimals = 0);
+
+}
+
+#endif
@@ -0,0 +1,129 @@
+#include "HostMemory.h"
+
+#include <atomic>
+#include <malloc.h>
+#include <new>
+#include <stdlib.h>
+
+extern "C" {
+  void* __real_malloc(size_t size);
+  void* __real_calloc(size_t count, size_t size);
+  void* __real_realloc(void* block, size_t size);
+  void __real_free(void* block);
+}
+
+namespace host {
+
+static std::atomic<uint64_t> _allocations{0};
+static std::atomic<uint64_t> _frees{0};
+static std::atomic<int64_t> _liveBytes{0};
+static std::atomic<int64_t> _peakBytes{0};
+static std::atomic<int64_t> _liveBlocks{0};
+static thread_local int _paused = 0;
+
+
+static void counted(void* block, bool newBlock)
+{
+  if(!block) return;
+  int64_t size = malloc_usable_size(block);
+  int64_t live = _liveBytes += size;
+  if(newBlock) ++_liveBlocks;
+  if(_paused) return;
+
+  ++_allocations;
+  int64_t peak = _peakBytes.load();
+  while(live > peak && !_peakBytes.compare_exchange_weak(peak, live)) {}
+}
+
+
+static void uncounted(void* block)
+{
+  if(!block) return;
+  _liveBytes -= malloc_usable_size(block);
+  --_liveBlocks;
+  if(!_paused) ++_frees;
+}
+
+
+AllocationStats allocationStats()
+{
+  AllocationStats stats;
+  stats.allocations = _allocations;
+  stats.frees = _frees;
+  stats.liveBytes = _liveBytes;
+  stats.peakBytes = _peakBytes;
+  stats.liveBlocks = _liveBlocks;
+  return stats;
+}
+
+
+void resetPeak() {_peakBytes = _liveBytes.load();}
+AllocationPause::AllocationPause() {++_paused;}
+AllocationPause::~AllocationPause() {--_paused;}
+
+}
+
+
+extern "C" {
+
+void* __wrap_malloc(size_t size)
+{
+  void* block = __real_malloc(size);
+  host::counted(block, true);
+  return block;
+}
+
+
+void* __wrap_calloc(size_t count, size_t size)
+{
+  void* block = __real_calloc(count, size);
+  host::counted(block, true);
+  return block;
+}
+
+
+void* __wrap_realloc(void* block, size_t size)
+{
+  if(!block) return __wrap_malloc(size);
+  size_t before = malloc_usable_size(block);
+  host::_liveBytes -= before;
+  void* moved = __real_realloc(block, size);
+  if(!moved){
+    host::_liveBytes += before;
+    return nullptr;
+  }
+  // a block that grows in place is not an allocation, one that moves is
+  if(moved != block || malloc_usable_size(moved) > before){
+    host::counted(moved, false);
+    if(!host::_paused) ++host::_frees;
+  }
+  else host::_liveBytes += malloc_usable_size(moved);
+  return moved;
+}
+
+
+void __wrap_free(void* block)
+{
+  host::uncounted(block);
+  __real_free(block);
+}
+
+}
+
+
+void* operator new(size_t size)
+{
+  void* block = __wrap_malloc(size ? size : 1);
+  if(!block) throw std::bad_alloc();
+  return block;
+}
+
+void* operator new[](size_t size) {return operator new(size);}
+void* operator new(size_t size, const std::nothrow_t&) noexcept {return __wrap_malloc(size ? size : 1);}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {return __wrap_malloc(size ? size : 1);}
+void operator delete(void* block) noexcept {__wrap_free(block);}
+void operator delete[](void* block) noexcept {__wrap_free(block);}
+void operator delete(void* block, size_t) noexcept {__wrap_free(block);}
+void operator delete[](void* block, size_t) noexcept {__wrap_free(block);}
+void operator delete(void* block, const std::nothrow_t&) noexcept {__wrap_free(block);}
+void operator delete[](void* block, const std::nothrow_t&) noexcept {__wrap_free(block);}
@@ -0,0 +1,39 @@
+/*
+ * The heap of a host build is counted: every malloc, realloc and new of the library, the tests and
+ * the benchmarks goes through the counters here (the executables are linked with --wrap=malloc...),
+ * so a test can check what a request allocates and a benchmark can report its peak memory
+ */
+
+#ifndef HOST_MEMORY_HEADER
+#define HOST_MEMORY_HEADER
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace host {
+
+struct AllocationStats{
+  uint64_t allocations = 0;   // malloc, calloc, new, and realloc calls that move or grow a block
+  uint64_t frees = 0;
+  int64_t liveBytes = 0;      // allocated and not freed
+  int64_t peakBytes = 0;      // the most liveBytes have been since resetPeak()
+  int64_t liveBlocks = 0;
+};
+
+AllocationStats allocationStats();
+
+// starts measuring the peak from the bytes allocated now
+void resetPeak();
+
+// the allocations of the harness itself, e.g. of the simulated network, are not counted while an
+// AllocationPause is in scope on the thread
+struct AllocationPause{
+  AllocationPause();
+  ~AllocationPause();
+  AllocationPause(const AllocationPause&) = delete;
+  AllocationPause& operator=(const AllocationPause&) = delete;
+};
+
+}
+
+#endif
@@ -0,0 +1,56 @@
+#include "HostTest.h"
+
+#include <vector>
+
+namespace host {
+
+struct RegisteredTest{
+  const char* name;
+  TestFunction function;
+};
+
+static std::vector<RegisteredTest>& tests()
+{
+  static std::vector<RegisteredTest> registered;
+  return registered;
+}
+
+static int _failures = 0;
+
+
+TestCase::TestCase(const char* name, TestFunction function)
+{
+  AllocationPause pause;
+  tests().push_back({name, function});
+}
+
+
+void fail(const char* expression, const char* file, int line)
+{
+  fprintf(stderr, "%s:%d: CHECK(%s) failed\n", file, line, expression);
+  ++_failures;
+}
+
+}
+
+
+int main(int argc, char** argv)
+{
+  // the library's log messages are not part of the test's output
+  host::setSerialOutput(nullptr);
+
+  int failedTests = 0;
+  for(const host::RegisteredTest& test : host::tests())
+  {
+    if(argc > 1 && strcmp(argv[1], test.name) != 0) continue;
+
+    int failuresBefore = host::_failures;
+    host::resetNetwork();
+    host::useSimulatedClock(false);
+    test.function();
+    bool passed = host::_failures == failuresBefore;
+    if(!passed) ++failedTests;
+    printf("%s %s\n", passed ? "PASS" : "FAIL", test.name);
+  }
+  return failedTests == 0 ? 0 : 1;
+}
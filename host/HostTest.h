@@ -0,0 +1,51 @@
+/*
+ * The tests of a host build: a test file defines TEST(name) functions that CHECK() what they
+ * expect, and is linked with HostTest.cpp, whose main() runs them all
+ */
+
+#ifndef HOST_TEST_HEADER
+#define HOST_TEST_HEADER
+
+#include "Arduino.h"
+#include "SimulatedNetwork.h"
+#include "HostMemory.h"
+
+#include <string>
+
+namespace host {
+
+using TestFunction = void (*)();
+
+struct TestCase{
+  TestCase(const char* name, TestFunction function);
+};
+
+// records a failed check, the test goes on
+void fail(const char* expression, const char* file, int line);
+
+// std::string exchange(app, request, port)
+// sends request on a new connection and closes it, then serves it. Returns everything the server
+// wrote until it closed the connection
+template<typename App>
+std::string exchange(App& app, const std::string& request, uint16_t port = 80)
+{
+  SimulatedClient client = connect(port);
+  client.send(request);
+  client.close();
+  pump(app, [&]{return client.closedByServer();});
+  return client.received();
+}
+
+// returns true if text contains part
+inline bool contains(const std::string& text, const std::string& part) {return text.find(part) != std::string::npos;}
+
+}
+
+#define CHECK(expression) ((expression) ? (void)0 : host::fail(#expression, __FILE__, __LINE__))
+
+#define TEST(name) \
+  static void name(); \
+  static host::TestCase name##Case(#name, name); \
+  static void name()
+
+#endif
@@ -0,0 +1,154 @@
+#include "SimulatedNetwork.h"
+#include "HostMemory.h"
+
+#include <map>
+
+namespace host {
+
+static NetworkConditions _conditions;
+static std::map<uint16_t, std::deque<std::shared_ptr<SimulatedSocket>>> _listeners;
+
+
+// unsigned long transmit(freeAt, length, conditions)
+// sends length bytes on a link that's free at freeAt. Returns when the last one has left
+static unsigned long transmit(unsigned long& freeAt, size_t length, const NetworkConditions& conditions)
+{
+  unsigned long now = micros();
+  unsigned long start = (long)(freeAt - now) > 0 ? freeAt : now;
+  unsigned long duration = conditions.bytesPerSecond ? (unsigned long)((uint64_t)length * 1000000 / conditions.bytesPerSecond) : 0;
+  freeAt = start + duration;
+  return freeAt;
+}
+
+
+size_t SimulatedSocket::arrived() const
+{
+  unsigned long now = micros();
+  size_t count = 0;
+  for(const Segment& segment : this->inbound){
+    if((long)(segment.arrivesAt - now) > 0) break;
+    count += segment.data.size();
+  }
+  return count - this->inboundOffset;
+}
+
+
+void SimulatedClient::send(const std::string& data)
+{
+  AllocationPause pause;
+  SimulatedSocket& socket = *this->_socket;
+  size_t segmentSize = socket.conditions.segmentSize ? socket.conditions.segmentSize : data.size();
+  for(size_t offset = 0; offset < data.size(); offset += segmentSize)
+  {
+    std::string segment = data.substr(offset, segmentSize);
+    unsigned long sentAt = transmit(socket.inboundFreeAt, segment.size(), socket.conditions);
+    socket.inbound.push_back({std::move(segment), sentAt + socket.conditions.latencyUs});
+  }
+}
+
+
+void SimulatedClient::close()
+{
+  this->_socket->clientClosed = true;
+}
+
+
+std::string SimulatedClient::take()
+{
+  AllocationPause pause;
+  std::string data = this->_socket->outbound.substr(this->_receivedOffset);
+  this->_receivedOffset = this->_socket->outbound.size();
+  return data;
+}
+
+
+size_t responseLength(const std::string& data)
+{
+  AllocationPause pause;
+  size_t headEnd = data.find("\r\n\r\n");
+  if(headEnd == std::string::npos) return 0;
+  headEnd += 4;
+
+  // the header names are matched case-insensitively, at the start of a line
+  std::string head = data.substr(0, headEnd);
+  for(char& c : head) c = tolower((unsigned char)c);
+
+  int status = atoi(head.c_str() + 9);
+  if(status / 100 == 1 || status == 204 || status == 304) return headEnd;
+
+  size_t length = head.find("\r\ncontent-length:");
+  if(length != std::string::npos){
+    size_t bodyLength = strtoul(head.c_str() + length + 17, nullptr, 10);
+    return data.size() >= headEnd + bodyLength ? headEnd + bodyLength : 0;
+  }
+  if(head.find("\r\ntransfer-encoding: chunked") != std::string::npos){
+    size_t end = data.find("\r\n0\r\n\r\n", headEnd - 2);
+    return end == std::string::npos ? 0 : end + 7;
+  }
+  return 0;
+}
+
+
+void setConditions(const NetworkConditions& conditions)
+{
+  _conditions = conditions;
+}
+
+
+SimulatedClient connect(uint16_t port, uint32_t remoteIP)
+{
+  AllocationPause pause;
+  auto socket = std::make_shared<SimulatedSocket>();
+  socket->port = port;
+  socket->remoteIP = remoteIP;
+  socket->conditions = _conditions;
+  socket->inboundFreeAt = micros() + _conditions.connectUs;
+  _listeners[port].push_back(socket);
+  return SimulatedClient{socket};
+}
+
+
+size_t pendingConnections(uint16_t port)
+{
+  auto listener = _listeners.find(port);
+  return listener == _listeners.end() ? 0 : listener->second.size();
+}
+
+
+void resetNetwork()
+{
+  _listeners.clear();
+  _conditions = NetworkConditions{};
+}
+
+
+void detail::listen(uint16_t port)
+{
+  _listeners[port];
+}
+
+
+void detail::unlisten(uint16_t port)
+{
+  _listeners.erase(port);
+}
+
+
+std::shared_ptr<SimulatedSocket> detail::accept(uint16_t port)
+{
+  auto listener = _listeners.find(port);
+  if(listener == _listeners.end()) return nullptr;
+
+  // a client that gave up before it was accepted is dropped, like by a TCP stack
+  while(!listener->second.empty())
+  {
+    std::shared_ptr<SimulatedSocket> socket = listener->second.front();
+    listener->second.pop_front();
+    if(socket->clientClosed && socket->inbound.empty()) continue;
+    socket->accepted = true;
+    return socket;
+  }
+  return nullptr;
+}
+
+}
@@ -0,0 +1,127 @@
+/*
+ * The network of a host build: WiFiServer and WiFiClient (see ESP8266WiFi.h) serve connections a test
+ * or benchmark opens with host::connect(), in memory. The connection's conditions cut what the
+ * client sends into segments, delay them, and limit the bandwidth both ways. Like on the ESP8266,
+ * a write waits while the server's send buffer is full (WiFiClient::SEND_BUFFER_SIZE)
+ */
+
+#ifndef HOST_SIMULATED_NETWORK_HEADER
+#define HOST_SIMULATED_NETWORK_HEADER
+
+#include "Arduino.h"
+
+#include <deque>
+#include <memory>
+#include <string>
+
+namespace host {
+
+// how a connection carries bytes
+struct NetworkConditions{
+  size_t segmentSize = 0;         // what the client sends arrives in segments of this size, 0 for one segment a send
+  unsigned long latencyUs = 0;    // a segment arrives this long after it's sent, both ways
+  uint32_t bytesPerSecond = 0;    // the bandwidth of the link, both ways. 0 for unlimited
+  unsigned long connectUs = 0;    // the client sends once the connection is established, this long after connect()
+};
+
+
+// a connection: the segments the client sent, and the bytes the server wrote
+struct SimulatedSocket{
+  struct Segment{
+    std::string data;
+    unsigned long arrivesAt;  // micros()
+  };
+
+  uint16_t port = 0;
+  uint32_t remoteIP = 0;
+  NetworkConditions conditions;
+
+  std::deque<Segment> inbound;
+  size_t inboundOffset = 0;     // bytes of the first segment the server has read
+  unsigned long inboundFreeAt = 0;  // when the link from the client is free again
+
+  std::string outbound;
+  unsigned long outboundFreeAt = 0;
+  unsigned long outboundArrivesAt = 0;  // when the last byte written reaches the client
+  size_t writes = 0;      // the server's write calls
+
+  bool accepted = false;
+  bool clientClosed = false;
+  bool serverClosed = false;
+
+  // returns the bytes that have arrived and the server hasn't read
+  size_t arrived() const;
+};
+
+
+/* SimulatedClient is the client side of a connection */
+class SimulatedClient{
+  private:
+    std::shared_ptr<SimulatedSocket> _socket;
+    size_t _receivedOffset = 0;   // the bytes of outbound taken by take()
+
+  public:
+    SimulatedClient() {}
+    explicit SimulatedClient(std::shared_ptr<SimulatedSocket> socket): _socket{std::move(socket)} {}
+
+    // sends data, cut in segments by the connection's conditions
+    void send(const std::string& data);
+    // closes the client's side. The server reads what it sent, then sees it disconnected
+    void close();
+
+    // returns what the server wrote since the last take(), and forgets it
+    std::string take();
+    // returns everything the server wrote
+    const std::string& received() const {return this->_socket->outbound;}
+
+    // returns true once the server read all the client sent
+    bool drained() const {return this->_socket->inbound.empty();}
+    bool accepted() const {return this->_socket->accepted;}
+    bool closedByServer() const {return this->_socket->serverClosed;}
+    size_t writes() const {return this->_socket->writes;}
+    // returns when the last byte the server wrote reaches the client, in micros()
+    unsigned long receivedAt() const {return this->_socket->outboundArrivesAt;}
+
+    SimulatedSocket& socket() {return *this->_socket;}
+};
+
+
+// size_t responseLength(data)
+// returns the length of the HTTP response at the start of data, framed by its Content-Length or
+// chunked, 0 while it's not complete. A response without either ends with the connection
+size_t responseLength(const std::string& data);
+
+// the conditions of the connections opened from now on
+void setConditions(const NetworkConditions& );
+
+// SimulatedClient connect(port, remoteIP)
+// opens a connection to the WiFiServer listening on port. It waits to be accepted, like in a backlog
+SimulatedClient connect(uint16_t port = 80, uint32_t remoteIP = IPAddress(127, 0, 0, 1));
+
+// returns the connections waiting to be accepted on port
+size_t pendingConnections(uint16_t port = 80);
+
+// forgets every connection and listener, and restores the default conditions
+void resetNetwork();
+
+// calls app.handle() until done() is true, at most steps times. Returns done()
+template<typename App, typename Done>
+bool pump(App& app, Done done, int steps = 100000)
+{
+  for(int i = 0; i < steps; ++i){
+    if(done()) return true;
+    app.handle();
+  }
+  return done();
+}
+
+
+namespace detail {
+  void listen(uint16_t port);
+  void unlisten(uint16_t port);
+  std::shared_ptr<SimulatedSocket> accept(uint16_t port);
+}
+
+}
+
+#endif
@@ -0,0 +1,9 @@
+/*
+ * A stand-in for the author's utilities library, that HTTP_Utilities.h includes on the ESP8266.
+ * ArduinoExpress no longer uses anything from it, so it's empty on a host build
+ */
+
+#ifndef HOST_UTILITIES_HEADER
+#define HOST_UTILITIES_HEADER
+
+#endif
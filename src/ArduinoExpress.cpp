@@ -1,139 +1,299 @@
 #include "ArduinoExpress.h"
 
-void RouteCallback::get(const String& path, MiddlewareFunction middleware, EndpointFunction callback)
+RouteCallback::RouteCallback(RouteCallback&& other)
+  : _path{std::move(other._path)}, _method{other._method}, _middleware{other._middleware},
+    _callback{std::move(other._callback)}, _chainPosition{other._chainPosition}
 {
-    this->_path = path;
-    this->_middleware = middleware;
-    this->_callback = callback;
+#if ARDUINOEXPRESS_METRICS
+  this->_metricsSlot = other._metricsSlot;
+#endif
+  other._middleware = nullptr;
+}
+
+
+RouteCallback& RouteCallback::operator=(RouteCallback&& other)
+{
+  if(this != &other){
+    delete this->_middleware;
+    this->_path = std::move(other._path);
+    this->_method = other._method;
+    this->_middleware = other._middleware;
+    this->_callback = std::move(other._callback);
+    this->_chainPosition = other._chainPosition;
+#if ARDUINOEXPRESS_METRICS
+    this->_metricsSlot = other._metricsSlot;
+#endif
+    other._middleware = nullptr;
+  }
+  return *this;
+}
+
+
+bool RouteCallback::setMiddleware(MiddlewareFunction middleware)
+{
+  delete this->_middleware;
+  this->_middleware = nullptr;
+  if(!middleware) return true;
+
+  this->_middleware = new (std::nothrow) MiddlewareFunction(std::move(middleware));
+  return this->_middleware != nullptr;
+}
+
+
+bool RouteCallback::get(RoutePath path, MiddlewareFunction middleware, EndpointFunction callback)
+{
+    this->_path = std::move(path);
+    this->_callback = std::move(callback);
     this->_method = HTTP_Method::GET;
+    return setMiddleware(std::move(middleware));
 }
 
 
-void RouteCallback::post(const String& path, MiddlewareFunction middleware, EndpointFunction callback)
+bool RouteCallback::post(RoutePath path, MiddlewareFunction middleware, EndpointFunction callback)
 {
-    this->_path = path;
-    this->_middleware = middleware;
-    this->_callback = callback;
+    this->_path = std::move(path);
+    this->_callback = std::move(callback);
     this->_method = HTTP_Method::POST;
+    return setMiddleware(std::move(middleware));
 }
 
 
-void RouteCallback::inspect(const String& path, MiddlewareFunction middleware, EndpointFunction callback)
+bool RouteCallback::inspect(RoutePath path, MiddlewareFunction middleware, EndpointFunction callback)
 {
-    this->_path = path;
-    this->_middleware = middleware;
-    this->_callback = callback;
+    this->_path = std::move(path);
+    this->_callback = std::move(callback);
     this->_method = HTTP_Method::INSPECT;
+    return setMiddleware(std::move(middleware));
 }
 
 
 void RouteCallback::executeCallbacks(HTTP_Request &req, HTTP_Response &res)
 {
   if(this->_middleware){
-    this->_middleware(req, res, [&](){
-                                      this->_callback(req, res);
-                                    });
+    bool called = false;
+    (*this->_middleware)(req, res, Next{&called});
+    if(called && this->_callback) this->_callback(req, res);
   }else if(this->_callback){
     this->_callback(req, res);
   }
 }
 
 
-bool RouteCallback::match(const String &prefix, const HTTP_Request &req) const
+// --------------------ArduinoExpressRouter-----------------------------
+// ---------------------------------------------------------------------
+
+
+bool ArduinoExpressRouter::get(RoutePath path, EndpointFunction callback)
 {
-  return ((prefix + this->_path == req.route) && (toText(this->_method) == req.method));
+  return addRoute(HTTP_Method::GET, std::move(path), nullptr, std::move(callback));
 }
 
 
-void RouteCallback::execute(const String &prefix, HTTP_Request &req, HTTP_Response &res, Next next)
+bool ArduinoExpressRouter::get(RoutePath path, MiddlewareFunction middleware, EndpointFunction callback)
 {
-  logdebug(_path + "got request");
-  // If request is matched, the callback is executed and the callback chain is broken
-  // else, the next callback is called
-  if(match(prefix, req)){
-    logdebug(_path + "matched request");
-    executeCallbacks(req, res);
-  } else {
-    next();
+  return addRoute(HTTP_Method::GET, std::move(path), std::move(middleware), std::move(callback));
+}
+
+
+bool ArduinoExpressRouter::post(RoutePath path, EndpointFunction callback)
+{
+  return addRoute(HTTP_Method::POST, std::move(path), nullptr, std::move(callback));
+}
+
+
+bool ArduinoExpressRouter::post(RoutePath path, MiddlewareFunction middleware, EndpointFunction callback)
+{
+  return addRoute(HTTP_Method::POST, std::move(path), std::move(middleware), std::move(callback));
+}
+
+
+bool ArduinoExpressRouter::addRouteCallback(RouteCallback&& routeCallback)
+{
+  if(frozen()){
+    logerr("Router is frozen, could not add %s", routeCallback.path().toString().c_str());
+    return false;
+  }
+
+  if(!routeCallback.path().valid() || !this->_routeCallbacks.push_back(std::move(routeCallback))){
+    logerr("Not enough memory to add a route");
+    return false;
   }
+  RouteCallback& added = this->_routeCallbacks.back();
+  added.setChainPosition(this->_allCallbacks.size());
+
+  // the trie points into the route's path, which the route keeps for as long as the router lives
+  if(!this->_routeTrie.insert(added.path(), added.method(), this->_routeCallbacks.size() - 1)){
+    logerr("Could not index %s: invalid path or not enough memory", added.path().toString().c_str());
+    this->_routeCallbacks.pop_back();
+    return false;
+  }
+  return true;
 }
 
 
-// --------------------ArduinoExpressRouter-----------------------------
-// ---------------------------------------------------------------------
+bool ArduinoExpressRouter::addAllCallback(const ChainEntry& entry, const RoutePath& path)
+{
+  if(frozen()){
+    logerr("Router is frozen, could not add %s", path.toString().c_str());
+    return false;
+  }
 
+  if(!path.valid() || !this->_allCallbacks.push_back(entry)){
+    logerr("Not enough memory to add %s", path.toString().c_str());
+    return false;
+  }
+  return true;
+}
 
-void ArduinoExpressRouter::get(const String& path, EndpointFunction callback)
+
+Callback* ArduinoExpressRouter::chainCallback(int position)
 {
-  get(path, nullptr, callback);
+  const ChainEntry& entry = this->_allCallbacks[position];
+  if(entry.router) return entry.router;
+  return &this->_middlewareCallbacks[entry.middleware];
 }
 
 
-void ArduinoExpressRouter::get(const String& path, MiddlewareFunction middleware, EndpointFunction callback)
+bool ArduinoExpressRouter::reserve(int routesCount, int middlewaresCount)
 {
-  addRouteCallback(RouteCallback{HTTP_Method::GET, path, middleware, callback});
+  bool reserved = this->_routeCallbacks.reserve(routesCount) &&
+                  this->_middlewareCallbacks.reserve(middlewaresCount) &&
+                  this->_allCallbacks.reserve(middlewaresCount);
+  if(!reserved) logerr("Could not reserve %d routes and %d middlewares", routesCount, middlewaresCount);
+  return reserved;
 }
 
 
-void ArduinoExpressRouter::post(const String& path, EndpointFunction callback)
+void ArduinoExpressRouter::freeze()
 {
-  post(path, nullptr, callback);
+  if(frozen()) return;
+
+  this->_routeCallbacks.freeze();
+  this->_middlewareCallbacks.freeze();
+  this->_allCallbacks.freeze();
+  this->_routeTrie.freeze();
+
+  for(int i = 0; i < this->_allCallbacks.size(); ++i){
+    if(this->_allCallbacks[i].router) this->_allCallbacks[i].router->freeze();
+  }
+
+  loginfo("Router %s frozen: %d routes in %u bytes", this->_mountPrefix.c_str(), 
+          this->_routeCallbacks.size(), (unsigned)memoryUsage());
+}
+
+
+size_t ArduinoExpressRouter::memoryUsage() const
+{
+  return this->_routeCallbacks.memoryUsage() + this->_middlewareCallbacks.memoryUsage() +
+         this->_allCallbacks.memoryUsage() + this->_routeTrie.memoryUsage();
 }
 
 
-void ArduinoExpressRouter::post(const String& path, MiddlewareFunction middleware, EndpointFunction callback)
+void ArduinoExpressRouter::setRoutePrefix(RoutePath prefix)
 {
-  addRouteCallback(RouteCallback{HTTP_Method::POST, path, middleware, callback});
+  // the router is mounted again under the same parent, with its new prefix
+  String parentPrefix = this->_mountPrefix.substring(0, this->_mountPrefix.length() - this->_routePrefix.length());
+  this->_routePrefix = std::move(prefix);
+  mount(parentPrefix);
 }
 
 
-void ArduinoExpressRouter::addRouteCallback(const RouteCallback& routeCallback)
+void ArduinoExpressRouter::mount(const String& parentPrefix)
 {
-  if(this->_routeCallbacks.size() < MAX_ROUTECALLBACKS_COUNT){
-    this->_routeCallbacks.push_back(routeCallback);
-    addAllCallback(&_routeCallbacks.back()); 
-  }else{
-    // FIXME: Throw an error
+  this->_mountPrefix = parentPrefix;
+  this->_routePrefix.appendTo(this->_mountPrefix);
+
+  for(int i = 0; i < this->_allCallbacks.size(); ++i){
+    if(this->_allCallbacks[i].router) this->_allCallbacks[i].router->mount(this->_mountPrefix);
   }
 }
 
 
-void ArduinoExpressRouter::addAllCallback(Callback* callback)
+bool ArduinoExpressRouter::uses(const ArduinoExpressRouter* router) const
 {
-  if(this->_allCallbacks.size() < MAX_CALLBACKS_COUNT){
-    this->_allCallbacks.push_back(callback);   
-  }else{
-    // FIXME: Throw an error
+  if(router == this) return true;
+  for(int i = 0; i < this->_allCallbacks.size(); ++i){
+    if(this->_allCallbacks[i].router && this->_allCallbacks[i].router->uses(router)) return true;
   }
+  return false;
 }
 
 
-bool ArduinoExpressRouter::match(const String& prefix, const HTTP_Request &req) const
+bool ArduinoExpressRouter::match(const HTTP_Request &req) const
 {
-  return ((prefix + this->_routePrefix).isEmpty() || req.route.startsWith(prefix + this->_routePrefix));
+  return req.route.length() >= this->_mountPrefix.length() && 
+         memcmp(req.route.c_str(), this->_mountPrefix.c_str(), this->_mountPrefix.length()) == 0 &&
+         endsOnSegment(req.route, this->_mountPrefix.length());
 }
 
 
-void ArduinoExpressRouter::executeNext(const String& prefix, HTTP_Request &req, HTTP_Response &res)
+void ArduinoExpressRouter::setParams(const RouteTrieMatch& match, HTTP_Request &req) const
 {
-  if(_currentCallback < _allCallbacks.size())
+  req.paramsCount = 0;
+  for(int i = 0; i < match.paramsCount; ++i)
   {
-    logdebug("Calling callback " + String(_currentCallback));
-    _allCallbacks[_currentCallback++]->execute(prefix + this->_routePrefix, req, res, [&](){
-      executeNext(prefix, req, res);
-    });
+    const RouteTrieParam& param = match.params[i];
+    size_t offset = this->_mountPrefix.length() + param.offset;
+
+    HTTP_Param& reqParam = req.params[req.paramsCount++];
+    reqParam.key = _routeTrie.paramName(param);
+    // a parameter is one decoded segment, a wildcard the rest of the path as it was sent
+    reqParam.value = _routeTrie.isWildcard(param) ? 
+                       HTTP_StringView{req.route.c_str() + offset, req.route.length() - offset} :
+                       req.pathSegment(offset);
   }
 }
 
 
-void ArduinoExpressRouter::execute(const String& prefix, HTTP_Request &req, HTTP_Response &res, Next next)
+void ArduinoExpressRouter::executeRoute(const RouteTrieMatch& match, HTTP_Request &req, HTTP_Response &res)
 {
-  if(match(prefix, req)){
-    // reset the _currentCallback to 0
-    _currentCallback = 0;
+  RouteCallback& route = _routeCallbacks[match.route];
+  logdebug("%s matched request", route.path().toString().c_str());
+  setParams(match, req);
+
+#if ARDUINOEXPRESS_METRICS
+  // the handler's time doesn't count the time it spent writing to the client
+  req.metrics.route = route.metricsSlot(this->_mountPrefix);
+  unsigned long start = metricsNow();
+  unsigned long sendTime = res.sendTime();
+  route.executeCallbacks(req, res);
+  req.metrics.phases[PHASE_HANDLER] += (metricsNow() - start) - (res.sendTime() - sendTime);
+#else
+  route.executeCallbacks(req, res);
+#endif
+}
+
+
+void ArduinoExpressRouter::execute(const String& , HTTP_Request &req, HTTP_Response &res, Next next)
+{
+  // the prefix of the router this one is used by is not needed: _mountPrefix already starts with it
+  // a router that doesn't match skips everything it holds, the routers it uses included
+  if(match(req)){
+    const String& routerPrefix = this->_mountPrefix;
+
+    // find the route once, the callback chain only has to reach its position
+    RouteTrieMatch routeMatch;
+    _routeTrie.lookup(req.route.c_str() + routerPrefix.length(), 
+                      req.route.length() - routerPrefix.length(), 
+                      toMethod(req.method.c_str()), routeMatch);
+
+    // run the callback chain while each callback calls next().
+    // The matched route runs in the slot it was registered in, so middlewares registered before it
+    // run first. Once it's executed the callback chain is broken.
+    int position = 0;
+    bool called = true;
+    while(called)
+    {
+      if(routeMatch.route != -1 && position == _routeCallbacks[routeMatch.route].chainPosition()){
+        executeRoute(routeMatch, req, res);
+        break;
+      }
+      if(position >= _allCallbacks.size()) break;
 
-    // start executing the callback chain
-    executeNext(prefix, req, res);
+      called = false;
+      logdebug("Calling callback %d", position);
+      chainCallback(position++)->execute(routerPrefix, req, res, Next{&called});
+    }
   }
   
   // If no callback in this router has handled the request, call the next on the callback chain
@@ -143,19 +303,59 @@ void ArduinoExpressRouter::execute(const String& prefix, HTTP_Request &req, HTTP
 }
 
 
-void ArduinoExpressRouter::use(const String &path, MiddlewareFunction callback) 
+bool ArduinoExpressRouter::use(RoutePath path, MiddlewareFunction callback) 
 {
-  if(_middlewareCallbacks.size() < MAX_MIDDLEWARECALLBACKS_COUNT){
-    this->_middlewareCallbacks.push_back(MiddlewareCallback{path, callback});
-    addAllCallback(&_middlewareCallbacks.back());
-  }else{
-    // FIXME: Throw an error
+  if(frozen()){
+    logerr("Router is frozen, could not add %s", path.toString().c_str());
+    return false;
   }
+
+  if(!path.valid() || !this->_middlewareCallbacks.push_back(MiddlewareCallback{std::move(path), std::move(callback)})){
+    logerr("Not enough memory to add a middleware");
+    return false;
+  }
+
+  ChainEntry entry;
+  entry.middleware = this->_middlewareCallbacks.size() - 1;
+  if(!addAllCallback(entry, this->_middlewareCallbacks.back().path())){
+    this->_middlewareCallbacks.pop_back();
+    return false;
+  }
+  return true;
 }
 
-void ArduinoExpressRouter::use(MiddlewareFunction callback)
+bool ArduinoExpressRouter::use(MiddlewareFunction callback)
 {
-  use("", callback);
+  return use("", std::move(callback));
+}
+
+
+bool ArduinoExpressRouter::use(RoutePath path, ArduinoExpressRouter *router)
+{
+  if(router->uses(this)){
+    logerr("Router %s can't be used by a router it uses", path.toString().c_str());
+    return false;
+  }
+  // its full prefix, its trie and its frozen state would be shared by both places
+  if(router->_mounted){
+    logerr("Router %s is already mounted", path.toString().c_str());
+    return false;
+  }
+
+  ChainEntry entry;
+  entry.router = router;
+  if(!addAllCallback(entry, path)) return false;
+
+  router->_routePrefix = std::move(path);
+  router->_mounted = true;
+  router->mount(this->_mountPrefix);
+  return true;
+}
+
+
+bool ArduinoExpressRouter::use(ArduinoExpressRouter *router)
+{
+  return use("", router);
 }
 
 
@@ -163,118 +363,208 @@ void ArduinoExpressRouter::use(MiddlewareFunction callback)
 // ---------------------------------------------------------------------
 
 
+bool ArduinoExpress::begin(int port)
+{
+  return this->_transport->begin(port);
+}
+
+
 void ArduinoExpress::listen(int port, std::function<void()> callback)
 {
-  this->_server = WiFiServer{port};
-  this->_server.begin();
+  if(!begin(port)) return;
 
   while(true){
-    execute();
-    //if (callback) callback();   // FIXME: Enable this, use a default of nullptr
+    handle();
+    if (callback) callback();
+    // the transport wakes up as soon as a client needs it
+    if(!hasInput() && !hasOutput()) this->_transport->wait(ArduinoExpressConfig::TRANSPORT_WAIT_MS);
+    yield();
   }
 }
 
 
-void ArduinoExpress::execute()
+void ArduinoExpress::handle()
 {
-    WiFiClient client = this->_server.available();
-    this->_client = &client;
-
-    // if there's a new client
-    if(*_client){
-      this->_req.clear();
-      this->_res.clear();
+  acceptClients();
 
-      parseRequest();
-      this->_res = HTTP_Response{this->_client};
-
-      _req.printToSerial();
-
-      // Execute the request
-      ArduinoExpressRouter::execute("", this->_req, this->_res, [](){});
-      
+  for(int i = 0; i < MAX_CONNECTIONS_COUNT; ++i)
+  {
+    HTTP_Connection& connection = this->_connections[i];
+    if(connection.isFree()) continue;
 
-      // Confirm a response has being sent. If not, send one.
-      if (!this->_res.responseSent()){
-        this->_res.send(500, "text/plain", "No response");
+    if(connection.poll()){
+      if(respond(connection)) connection.finishRequest();
+    }
+    else if(!connection.isFree() && connection.timedOut()){
+      if(connection.parser().started() && !connection.res().responseSent()){
+        connection.res().send(408, "text/plain", HTTPStatusText(408));
       }
-      
-      // Disconnect the client
-      client.stop();
-      loginfo("[Client disconnected]");
+      connection.close();
     }
+  }
 
+  // the queued log messages are written between requests
+  logflush();
 }
 
 
-void ArduinoExpress::parseRequest()
+void ArduinoExpress::acceptClients()
 {
-  // GET THE REQUEST LINE
-  while(this->_client->connected()){
-    if (this->_client->available())
-    {
-      this->_req.method = this->_client->readStringUntil(' ');
-      this->_req.route = this->_client->readStringUntil(' ');
-      // Get the request's query
-      this->_req.method.trim();
-      this->_req.route.trim();
-      this->_client->readStringUntil('\r');
-      break;
-    }
+  // the connections draining clients turned away are not active, they only hold their slot
+  int activeCount = 0;
+  for(int i = 0; i < MAX_CONNECTIONS_COUNT; ++i){
+    HTTP_Connection::State state = this->_connections[i].state();
+    if(state != HTTP_Connection::FREE && state != HTTP_Connection::DRAINING) ++activeCount;
   }
-    
 
-  // GET THE REQUEST HEADERS
-  int count = 0;
-  while(this->_client->connected())
+  for(int i = 0; i < MAX_CONNECTIONS_COUNT; ++i)
   {
-    // read line by line what the client (web browser) is requesting
-    if (this->_client->available())
-    {
-      String line = this->_client->readStringUntil('\r');
+    HTTP_Connection& connection = this->_connections[i];
+    if(!connection.isFree()) continue;
 
-      if (line.length() == 1 && line[0] == '\n')
-      {
-        break;
-      }
+    // clients that find no free connection wait in the server's backlog
+    if(!this->_transport->accept(i)) return;
 
-      if (count < this->_req.MAX_HEADERS_COUNT)
-      {
-        int colonIndex = line.indexOf(':');
-        this->_req.headers[count].key = line.substring(0, colonIndex);
-        this->_req.headers[count].value = line.substring(colonIndex+1);
-        this->_req.headers[count].key.trim();
-        this->_req.headers[count].value.trim();
-        count = count + 1;
-      }
+    connection.open(HTTP_Client{*this->_transport, i});
+    if(activeCount < this->_maxActiveConnections &&
+       (this->_minFreeHeap == 0 || ARDUINOEXPRESS_FREE_HEAP() >= this->_minFreeHeap)){
+      ++activeCount;
+      continue;
     }
+
+    // shed the client before reading its request, the connection is free again once it's drained
+    logdebug("Server overloaded, client turned away");
+    char retryAfter[12];
+    snprintf(retryAfter, sizeof(retryAfter), "%d", ArduinoExpressConfig::ADMISSION_RETRY_AFTER_S);
+    connection.res().setKeepAlive(false);
+    connection.res().setHeader(HEADER_RETRY_AFTER, retryAfter);
+    connection.res().send(503, "text/plain", HTTPStatusText(503));
+    connection.drain();
   }
+}
 
 
-  // GET THE REQUEST BODY
-  while (this->_client->available()) {
-    // but first, let client finish its request
-    // that's diplomatic compliance to protocols
-    // (and otherwise some clients may complain, like curl)
-    // (that is an example, prefer using a proper webserver library)
-    this->_req.body += this->_client->readStringUntil('\r');
+bool ArduinoExpress::hasInput() const
+{
+  for(int i = 0; i < MAX_CONNECTIONS_COUNT; ++i){
+    if(this->_connections[i].hasInput()) return true;
   }
+  return false;
 }
 
 
-void ArduinoExpress::use(const String &path, ArduinoExpressRouter *router)
+bool ArduinoExpress::hasOutput()
 {
-  if(this->_routers.size() < MAX_ROUTERS_COUNT){
-    this->_routers.push_back(router);
-    this->_routers.back()->setRoutePrefix(path);
-    addAllCallback(this->_routers.back());
-  }else{
-    // FIXME: Throw an error
+  for(int i = 0; i < MAX_CONNECTIONS_COUNT; ++i){
+    if(this->_connections[i].hasOutput()) return true;
   }
+  return false;
 }
 
 
-void ArduinoExpress::use(ArduinoExpressRouter *router)
+bool ArduinoExpress::respond(HTTP_Connection& connection)
 {
-  use("", router);
+  HTTP_Request& req = connection.req();
+  HTTP_Response& res = connection.res();
+  const HTTP_RequestParser& parser = connection.parser();
+
+#if ARDUINOEXPRESS_METRICS
+  unsigned long start = metricsNow();
+#endif
+
+  bool finished = true;
+  if(parser.failed()){
+    // the request could not be parsed, it can't be routed. 
+    // A request with a streamed body may have been answered before its body failed
+    int status = parser.errorStatus();
+    if(!res.responseSent()) res.send(status, "text/plain", HTTPStatusText(status));
+  }
+  else if(parser.streamStart()){
+    finished = dispatchStream(connection);
+  }
+  else if(parser.streamed()){
+    // the streamed body is complete
+    req.streamEnd();
+    endResponse(res);
+  }
+  else{
+    dispatch(req, res);
+  }
+
+#if ARDUINOEXPRESS_METRICS
+  // a request with a streamed body is responded to in several steps, their time adds up.
+  // Dispatching is what's left of the time once the handler and the writes are counted
+  req.metrics.phases[PHASE_DISPATCH] += metricsNow() - start;
+  if(finished){
+    req.metrics.phases[PHASE_SEND] = res.sendTime();
+    req.metrics.phases[PHASE_DISPATCH] -= req.metrics.phases[PHASE_HANDLER] + res.sendTime();
+    recordMetrics(req.metrics, res.status(), res.bytesSent());
+  }
+#endif
+
+  return finished;
+}
+
+
+void ArduinoExpress::dispatch(HTTP_Request& req, HTTP_Response& res)
+{
+  logdebug("%s %s", req.method.c_str(), req.route.c_str());
+
+  // Execute the request
+  ArduinoExpressRouter::execute("", req, res, Next{});
+
+  // A buffered body is passed to the consumers at once
+  if(req.hasBodyConsumer()){
+    req.streamData((const uint8_t*)req.body.c_str(), req.body.length());
+    req.streamEnd();
+  }
+
+  endResponse(res);
+}
+
+
+bool ArduinoExpress::dispatchStream(HTTP_Connection& connection)
+{
+  HTTP_Request& req = connection.req();
+  HTTP_Response& res = connection.res();
+  logdebug("%s %s (streamed body)", req.method.c_str(), req.route.c_str());
+
+  ArduinoExpressRouter::execute("", req, res, Next{});
+
+  // the body is read even if the response is sent already, e.g. an upload answered with 202
+  if(req.hasBodyConsumer()){
+    connection.streamBody();
+    return false;
+  }
+
+  // no callback reads the body, and it can't be buffered
+  if(!res.responseSent() && !res.streaming()) res.send(413, "text/plain", HTTPStatusText(413));
+  endResponse(res);
+  return true;
+}
+
+
+void ArduinoExpress::endResponse(HTTP_Response& res)
+{
+  // Finish a streamed response the handler left open
+  if (res.streaming()) res.end();
+
+  // Confirm a response has being sent. If not, send one.
+  if (!res.responseSent()){
+    res.send(500, "text/plain", "No response");
+  }
+}
+
+
+void ArduinoExpress::setMaxBodySize(size_t maxBodySize)
+{
+  for(int i = 0; i < MAX_CONNECTIONS_COUNT; ++i) this->_connections[i].setMaxBodySize(maxBodySize);
+}
+
+
+void ArduinoExpress::setAdmission(int maxActiveConnections, size_t minFreeHeap)
+{
+  this->_maxActiveConnections = maxActiveConnections;
+  this->_minFreeHeap = minFreeHeap;
 }
+
@@ -1,21 +1,59 @@
 #ifndef ARDUINO_EXPRESS_HEADER
 #define ARDUINO_EXPRESS_HEADER
 
-#include <ESP8266WiFi.h>
 #include "HTTP_Request.h"
 #include "HTTP_Response.h"
-#include <Vector.h>
+#include "HTTP_Connection.h"
+#include "HTTP_PosixTransport.h"
+#include "HTTP_Cache.h"
+#include "HTTP_RateLimit.h"
+#include "HTTP_Multipart.h"
+#include "RouteTrie.h"
+#include "RouterTable.h"
+#include "RoutePath.h"
+#include "InplaceFunction.h"
+
+namespace fs { class FS; }
 
 // Req is an alias for HTTP_Request, Res is an alias for HTTP_Response
 using Req = HTTP_Request;
 using Res = HTTP_Response;
 
-// Next is an alias for void(*)(), which is a function that takes no arguments and returns void
-using Next = std::function<void()>;
+/* Next is given to middlewares: calling next() passes the request on to the next callback in the 
+  * callback chain. The next callback runs once the middleware has returned, so the chain is run by a
+  * loop instead of nested calls: the stack doesn't grow with the number of callbacks, and next()
+  * allocates nothing. Code after next() in a middleware runs before the next callback.
+*/
+struct Next{
+  private:
+    bool* _called = nullptr;  // set by next(), read by the callback chain once the middleware returns
+
+  public:
+    Next() {}
+    explicit Next(bool* called): _called{called} {}
+
+    void operator()() const {if(this->_called) *this->_called = true;}
+};
+
+
+// handlers and middlewares: any function, lambda or functor with these signatures. They are stored
+// in a std::function, or in place with ARDUINOEXPRESS_INPLACE_CALLBACKS (see InplaceFunction)
+#if ARDUINOEXPRESS_INPLACE_CALLBACKS
+using EndpointFunction = InplaceFunction<void*(Req&, Res&), ArduinoExpressConfig::ENDPOINT_STORAGE_SIZE>;
+using MiddlewareFunction = InplaceFunction<void*(Req&, Res&, Next), ArduinoExpressConfig::MIDDLEWARE_STORAGE_SIZE>;
+#else
 using EndpointFunction = std::function<void*(Req&, Res&)>;
 using MiddlewareFunction = std::function<void*(Req&, Res&, Next)>;
+#endif
 
-/* Inherited by RouteCallback, MiddlewarCallback and the ArduinoExpressRouter which implement 
+// the callables the template overloads of get() and post() take: those an EndpointFunction or a
+// MiddlewareFunction can store
+template<typename Function>
+using IfEndpoint = typename std::enable_if<std::is_constructible<EndpointFunction, Function&&>::value>::type;
+template<typename Function>
+using IfMiddleware = typename std::enable_if<std::is_constructible<MiddlewareFunction, Function&&>::value>::type;
+
+/* Inherited by MiddlewarCallback and the ArduinoExpressRouter which implement 
    * the pure virtual execute() method.
    *
    * method: execute(route, req, res, next)
@@ -36,34 +74,53 @@ struct Callback{
   * This include the path, the HTTP method, middleware(s) and the actual endpoint callback.
   * Note: The path is the relative path to the endpoint in the router where this callback belongs.
 */
-struct RouteCallback: public Callback{
+struct RouteCallback{
   private:
-    String _path; // the path this callback listens to
+    RoutePath _path; // the path this callback listens to
     HTTP_Method _method;  // the http method this callback listens to
     // This can be different from the complete HTTP request route if a router with a prefix is used
     // with this callback.
 
-    MiddlewareFunction _middleware = nullptr;
+    // allocated only for the routes that have a middleware, most don't
+    MiddlewareFunction* _middleware = nullptr;
     EndpointFunction _callback = nullptr;
+
+    int _chainPosition = 0; // number of middlewares and routers registered before this route
+
+#if ARDUINOEXPRESS_METRICS
+    int _metricsSlot = -1;
+#endif
   
   public:
     RouteCallback() {}
-    RouteCallback(HTTP_Method method, const String& path, 
-                  MiddlewareFunction middleware, 
-                  EndpointFunction callback)
-      : _method{method}, _path{path}, _middleware{middleware}, _callback{callback} {}
+    // the callback is constructed in the route from callback, see setMiddleware() for a middleware
+    template<typename Endpoint>
+    RouteCallback(HTTP_Method method, RoutePath path, Endpoint&& callback)
+      : _path{std::move(path)}, _method{method}, _callback{std::forward<Endpoint>(callback)} {}
+
+    RouteCallback(const RouteCallback& ) = delete;
+    RouteCallback& operator=(const RouteCallback& ) = delete;
+    RouteCallback(RouteCallback&& );
+    RouteCallback& operator=(RouteCallback&& );
+    ~RouteCallback() {delete this->_middleware;}
+
+    // bool setMiddleware(middleware)
+    // sets the middleware run before the callback, allocated for it. An empty one removes it.
+    // Returns false if there's not enough memory
+    bool setMiddleware(MiddlewareFunction );
     
-    // void get(path, middleware, callback)
-    // creates a callback that responds to a GET request to the given path
-    void get(const String&, MiddlewareFunction, EndpointFunction);
+    // bool get(path, middleware, callback)
+    // creates a callback that responds to a GET request to the given path. Returns false if there's
+    // not enough memory for the middleware
+    bool get(RoutePath, MiddlewareFunction, EndpointFunction);
     
-    // void post(path, middleware, callback)
+    // bool post(path, middleware, callback)
     // creates a callback that responds to a POST request to the given path
-    void post(const String&, MiddlewareFunction, EndpointFunction);
+    bool post(RoutePath, MiddlewareFunction, EndpointFunction);
     
-    // void inspect(path, middleware, callback)
+    // bool inspect(path, middleware, callback)
     // creates a callback that responds to an INSPECT request to the given path
-    void inspect(const String&, MiddlewareFunction, EndpointFunction);
+    bool inspect(RoutePath, MiddlewareFunction, EndpointFunction);
 
     // void put(const String&, MiddlewareFunction, EndpointFunction);
     // void deleteMethod(const String&, MiddlewareFunction, EndpointFunction);
@@ -73,19 +130,28 @@ struct RouteCallback: public Callback{
       * This can be different from the complete HTTP request route if a router with a prefix is used
       * with this callback.
       * */
-    const String& path() const {return this->_path;}
+    const RoutePath& path() const {return this->_path;}
 
-    /* executes all the middlewares and callbacks on this route */
-    void executeCallbacks(Req&, Res& );
+    HTTP_Method method() const {return this->_method;}
 
-    /* Returns true if the request matches this route */
-    bool match(const String&, const Req& ) const;
-
-    /* void execute(prefix, req, res, next)
-      * - prefix: the prefix used by the router that this callback belongs to
-      * executes the callback, if the request matches this route 
+    /* The position of this route in its router's callback chain. The route runs after the
+      * middlewares and routers registered before it, i.e. after the first chainPosition() callbacks.
       * */
-    void execute(const String&, Req&, Res&, Next);
+    int chainPosition() const {return this->_chainPosition;}
+    void setChainPosition(int position) {this->_chainPosition = position;}
+
+#if ARDUINOEXPRESS_METRICS
+    // int metricsSlot(prefix)
+    // returns the metrics slot of this route, taken the first time the route is executed
+    int metricsSlot(const String& prefix)
+    {
+      if(this->_metricsSlot == -1) this->_metricsSlot = metricsRoute(this->_method, prefix, this->_path.toString());
+      return this->_metricsSlot;
+    }
+#endif
+
+    /* executes all the middlewares and callbacks on this route */
+    void executeCallbacks(Req&, Res& );
 };
 
 
@@ -98,17 +164,17 @@ struct RouteCallback: public Callback{
 */
 struct MiddlewareCallback: public Callback{
   private:
-    String _path; // the path this middleware acts on
+    RoutePath _path; // the path this middleware acts on
     MiddlewareFunction _callback = nullptr;
 
   public:
     MiddlewareCallback() {}
-    MiddlewareCallback(const String& path, MiddlewareFunction callback)
-      : _path{path}, _callback{callback} {}
+    MiddlewareCallback(RoutePath path, MiddlewareFunction callback)
+      : _path{std::move(path)}, _callback{std::move(callback)} {}
 
-    // const String& path()
+    // const RoutePath& path()
     // returns the path this middleware acts on
-    const String& path() const {return this->_path;}
+    const RoutePath& path() const {return this->_path;}
 
     // void executeCallback(req, res, next)
     // executes the middleware callback
@@ -118,7 +184,7 @@ struct MiddlewareCallback: public Callback{
     // returns true if the request's route matches this middleware (in the router it belongs)
     bool match(const String &prefix, const Req &req) const 
     {
-      return req.route.startsWith(prefix + this->_path) || (prefix + this->_path).isEmpty();
+      return this->_path.matchesStart(prefix, req.route);
     }
     
     // void execute(prefix, req, res, next)
@@ -127,116 +193,362 @@ struct MiddlewareCallback: public Callback{
     {
       if (match(prefix, req)){
         executeCallbacks(req, res, next);
+      } else {
+        next();
       }
     }
   
 };
 
 
+/* A router holds routes, middlewares and other routers, and runs the requests under its prefix
+  * through them.
+  * Its tables grow as callbacks are registered, so a router only takes the memory of what it holds.
+  * Registering returns false, and logs an error, when there's not enough memory or the router is
+  * frozen. freeze() shrinks the tables once the router is set up, and makes it read-only.
+  * Routers nest: a router used by another one is mounted under the other's prefix. The full
+  * prefix of each router is joined when it's mounted, and joined again for the routers it uses
+  * whenever it's mounted somewhere else, so a request is matched against a router with a single
+  * compare, and skips all it holds if it doesn't match. A router that is not used by another one
+  * is mounted at the root.
+*/
 struct ArduinoExpressRouter: public Callback{
   protected:
-    String _routePrefix = "";
+    RoutePath _routePrefix;
+    // the prefixes of the routers this router is mounted in, and its own: the start of the routes it
+    // handles
+    String _mountPrefix;
+    // true once the router is used by another one
+    bool _mounted = false;
     
-    const static int MAX_ROUTECALLBACKS_COUNT = ArduinoExpressConfig::MAX_ROUTECALLBACKS_COUNT;
-    RouteCallback _routeCallbacksStorageArray[MAX_ROUTECALLBACKS_COUNT];
-    Vector<RouteCallback> _routeCallbacks{_routeCallbacksStorageArray};
+    RouterTable<RouteCallback> _routeCallbacks;
+    RouterTable<MiddlewareCallback> _middlewareCallbacks;
 
-    const static int MAX_MIDDLEWARECALLBACKS_COUNT = ArduinoExpressConfig::MAX_MIDDLEWARECALLBACKS_COUNT;
-    MiddlewareCallback _middlewareCallbacksStorageArray[MAX_MIDDLEWARECALLBACKS_COUNT];
-    Vector<MiddlewareCallback> _middlewareCallbacks{_middlewareCallbacksStorageArray};
+    // an entry of the callback chain: one of this router's middlewares, or a router used by it.
+    // Middlewares are kept by index, their table can move as it grows
+    struct ChainEntry{
+      int16_t middleware = -1;  // index in _middlewareCallbacks, -1 for a router
+      ArduinoExpressRouter* router = nullptr;
+    };
 
-    const static int MAX_CALLBACKS_COUNT = ArduinoExpressConfig::MAX_CALLBACKS_COUNT;
-    Callback* _callbacksStorageArray[MAX_CALLBACKS_COUNT];
-    Vector<Callback*> _allCallbacks{_callbacksStorageArray};
+    // the middlewares and routers, in the order they were registered. 
+    // RouteCallbacks are not in this chain, they are found with _routeTrie
+    RouterTable<ChainEntry> _allCallbacks;
 
-    int _currentCallback = 0;
+    // index of the RouteCallbacks, built as routes are registered
+    RouteTrie _routeTrie;
 
-    // void addRouteCallback(RouteCallback& callback)
-    // adds a new callback to _routeCallbacks.
-    // This also calls addAllCallbacks() to add the callback to _allCallbacks
-    void addRouteCallback(const RouteCallback& );
 
-    // void addAllCallback(Callback* callback)
-    // adds a new callback to _allCallbacks
-    void addAllCallback(Callback* );
+    // bool addRouteCallback(RouteCallback& callback)
+    // adds a new callback to _routeCallbacks and indexes it in _routeTrie
+    bool addRouteCallback(RouteCallback&& );
 
-    // bool match (prefix, req)
-    // returns true if the request's route matches (prefix + this router's prefix)
+    // bool addRoute(method, path, middleware, callback)
+    // adds a route whose callback is constructed from callback, with middleware if it's not empty
+    template<typename Middleware, typename Endpoint>
+    bool addRoute(HTTP_Method method, RoutePath path, Middleware&& middleware, Endpoint&& callback)
+    {
+      RouteCallback route{method, std::move(path), std::forward<Endpoint>(callback)};
+      if(!route.setMiddleware(std::forward<Middleware>(middleware))){
+        logerr("Not enough memory to add a route");
+        return false;
+      }
+      return addRouteCallback(std::move(route));
+    }
+
+    // void setParams(match, req)
+    // fills the request's params with the parameters captured by a lookup of _routeTrie
+    void setParams(const RouteTrieMatch&, Req& ) const;
+
+    // bool addAllCallback(entry, path)
+    // adds a new entry to _allCallbacks. path is the one logged if it can't be added
+    bool addAllCallback(const ChainEntry&, const RoutePath& );
+
+    // Callback* chainCallback(position)
+    // returns the middleware or router at position in the callback chain
+    Callback* chainCallback(int);
+
+    // void mount(parentPrefix)
+    // joins the full prefix of this router, and of the routers it uses, under parentPrefix
+    void mount(const String& );
+
+    // bool uses(router)
+    // returns true if router is this router, or one of the routers it uses, at any depth
+    bool uses(const ArduinoExpressRouter* ) const;
+
+    // bool match (req)
+    // returns true if the request's route starts with the full prefix of this router, as whole
+    // segments: "/api" doesn't match "/apix"
     // This allows a router to be used in another router - the root app is also a router
-    bool match(const String&, const Req&) const;
+    bool match(const Req&) const;
 
-    // void executeNext(prefix, req, res)
-    // executes the next callback in the callback chain
-    virtual void executeNext(const String&, Req&, Res&);
+    // void executeRoute(match, req, res)
+    // executes the RouteCallback found by a lookup of _routeTrie
+    void executeRoute(const RouteTrieMatch&, Req&, Res& );
 
     // void execute(prefix, req, res, next)
-    // executes all the middlewares and callbacks on this router if the prefix matches
+    // executes the middlewares and callbacks on this router if its full prefix matches, one after
+    // the other while they call next(). The matched route is executed when the chain reaches its 
+    // chainPosition(), and ends the chain. The router matches with the full prefix it was mounted
+    // with, prefix is not used.
+    // The position in the chain is kept on the stack, so a router holds no state of the requests
+    // it executes
     virtual void execute(const String&, Req&, Res&, Next);
 
   public:
+    ArduinoExpressRouter() {}
+    ArduinoExpressRouter(ArduinoExpressRouter&& ) = default;
+
     // Adds a RouteCallback with the HTTP GET method to the router
-    // no middleware is added to the callback
-    void get(const String&, EndpointFunction);
+    // no middleware is added to the callback.
+    // The path can be a literal, kept where it is, F("/path") to keep it in flash, or a String,
+    // which is copied. See RoutePath
+    bool get(RoutePath, EndpointFunction);
 
     // Adds a RouteCallback with the HTTP GET method to the router
-    void get(const String&, MiddlewareFunction, EndpointFunction);
+    bool get(RoutePath, MiddlewareFunction, EndpointFunction);
     
     // Adds a RouteCallback with the HTTP POST method to the router
     // no middleware is added to this callback
-    void post(const String&, EndpointFunction);
+    bool post(RoutePath, EndpointFunction);
 
     // Adds a RouteCallback with the HTTP POST method to the router
-    void post(const String&, MiddlewareFunction, EndpointFunction);
+    bool post(RoutePath, MiddlewareFunction, EndpointFunction);
 
-    void setRoutePrefix(const String& prefix) {this->_routePrefix = prefix;}
+    // the same, for a callable of any type, e.g. app.get("/led", [&led](Req&, Res& res) {...}): the
+    // route's function is constructed from it, without a temporary one, and with
+    // ARDUINOEXPRESS_INPLACE_CALLBACKS one that doesn't fit fails to compile at this call
+    template<typename Endpoint, typename = IfEndpoint<Endpoint>>
+    bool get(RoutePath path, Endpoint&& callback)
+    {
+      return addRoute(HTTP_Method::GET, std::move(path), nullptr, std::forward<Endpoint>(callback));
+    }
+    template<typename Middleware, typename Endpoint, typename = IfMiddleware<Middleware>, typename = IfEndpoint<Endpoint>>
+    bool get(RoutePath path, Middleware&& middleware, Endpoint&& callback)
+    {
+      return addRoute(HTTP_Method::GET, std::move(path), std::forward<Middleware>(middleware), std::forward<Endpoint>(callback));
+    }
+    template<typename Endpoint, typename = IfEndpoint<Endpoint>>
+    bool post(RoutePath path, Endpoint&& callback)
+    {
+      return addRoute(HTTP_Method::POST, std::move(path), nullptr, std::forward<Endpoint>(callback));
+    }
+    template<typename Middleware, typename Endpoint, typename = IfMiddleware<Middleware>, typename = IfEndpoint<Endpoint>>
+    bool post(RoutePath path, Middleware&& middleware, Endpoint&& callback)
+    {
+      return addRoute(HTTP_Method::POST, std::move(path), std::forward<Middleware>(middleware), std::forward<Endpoint>(callback));
+    }
+
+    // void setRoutePrefix(prefix)
+    // sets the path this router is mounted on, under the prefix of the router that uses it
+    void setRoutePrefix(RoutePath );
 
     // adds a middleware to the router on the specified path
-    virtual void use(const String&, MiddlewareFunction);
+    virtual bool use(RoutePath, MiddlewareFunction);
 
     // adds a middleware to the router at the root of the router. 
     // i.e. all request to this router will go through it
-    virtual void use(MiddlewareFunction);
+    virtual bool use(MiddlewareFunction);
+
+    // bool use(path, router)
+    // mounts router on path, under this router's prefix, e.g. api.use("/v1", &v1) serves v1's
+    // "/led" at "/api/v1/led" once api is used on "/api". The router must outlive this one.
+    // A router is mounted in one place: it can't use itself or a router it's used by, and can't be
+    // used again once it's mounted
+    bool use(RoutePath, ArduinoExpressRouter* );
+
+    // mounts a router on the root of this router
+    bool use(ArduinoExpressRouter* );
+
+    // returns the full prefix of the router, where its routes start
+    const String& mountPrefix() const {return this->_mountPrefix;}
+
+    // bool reserve(routesCount, middlewaresCount)
+    // allocates the route and middleware tables once, for a router whose size is known.
+    // More callbacks can still be registered, the tables then grow
+    bool reserve(int, int);
+
+    // void freeze()
+    // shrinks the tables of this router, and of the routers it uses, to what is registered, and
+    // makes them read-only. Call it at the end of setup(): registering after it fails
+    void freeze();
+    bool frozen() const {return this->_routeTrie.frozen();}
+
+    // size_t memoryUsage()
+    // returns the bytes of this router's tables: its routes, middlewares, callback chain and route
+    // index. The routers it uses and the text of the paths are not counted
+    size_t memoryUsage() const;
+
+    int routesCount() const {return this->_routeCallbacks.size();}
 };
-// FIXME: add functionality to add router objects to the router
 
 
 struct ArduinoExpress : public ArduinoExpressRouter
 {
   private:
-    WiFiClient* _client = nullptr;
-    WiFiServer _server{80};
+#if ARDUINOEXPRESS_POSIX_TRANSPORT
+    HTTP_PosixTransport _defaultTransport;
+#else
+    HTTP_WiFiTransport _defaultTransport;
+#endif
+    HTTP_Transport* _transport = &_defaultTransport;
 
-    HTTP_Request _req;
-    HTTP_Response _res{nullptr};
+    const static int MAX_CONNECTIONS_COUNT = ArduinoExpressConfig::MAX_CONNECTIONS_COUNT;
+    HTTP_Connection _connections[MAX_CONNECTIONS_COUNT];
 
-    void parseRequest();
-    void execute();
+    // new clients are answered 503 past these, see setAdmission()
+    int _maxActiveConnections = ArduinoExpressConfig::MAX_ACTIVE_CONNECTIONS_COUNT;
+    size_t _minFreeHeap = ArduinoExpressConfig::MIN_FREE_HEAP;
+
+    // void acceptClients()
+    // gives the waiting clients a free connection, if there's any, and turns them away with 503
+    // when the server is overloaded
+    void acceptClients();
+
+    // bool hasInput()
+    // returns true if a connection has bytes left to parse, that the transport would not wait for
+    bool hasInput() const;
+
+    // bool hasOutput()
+    // returns true if a connection has a chunk of a response to write, that its client takes now
+    bool hasOutput();
+
+    // bool respond(connection)
+    // executes the request read on the connection, or answers it with the parser's error.
+    // Returns false if the request is not finished: its body is being streamed
+    bool respond(HTTP_Connection& );
+
+    // void dispatch(req, res)
+    // runs the request through the callback chain, and passes its buffered body to the consumers
+    void dispatch(Req&, Res& );
+
+    // bool dispatchStream(connection)
+    // routes a request whose body is streamed, once its headers are read. Returns false if a 
+    // callback registered a consumer, and the body should be streamed to it
+    bool dispatchStream(HTTP_Connection& );
+
+    // void endResponse(res)
+    // finishes a streamed response the handler left open, or answers a request that got no response
+    void endResponse(Res& );
 
-    const static int MAX_ROUTERS_COUNT = ArduinoExpressConfig::MAX_ROUTERS_COUNT;
-    ArduinoExpressRouter* _routersStorageArray[MAX_ROUTERS_COUNT];
-    Vector<ArduinoExpressRouter*> _routers{_routersStorageArray};
-    
 
   public:
+    // void setTransport(transport)
+    // serves the clients of transport instead of the default one: a WiFiServer's, or TCP sockets with
+    // ARDUINOEXPRESS_POSIX_TRANSPORT. Call it before begin(), the transport must outlive the server
+    void setTransport(HTTP_Transport& transport) {this->_transport = &transport;}
+
+    // starts the server on the given port. handle() must then be called from the sketch's loop().
+    // Returns false if the transport can't listen on port
+    bool begin(int port);
+
+    // accepts new clients and advances every connection by one bounded step. 
+    // A slow client never blocks the other connections or the sketch
+    void handle();
+
+    // void setMaxBodySize(maxBodySize)
+    // request bodies larger than maxBodySize are answered with 413, 0 for no limit.
+    // MAX_BODY_SIZE by default
+    void setMaxBodySize(size_t );
+
+    // void setAdmission(maxActiveConnections, minFreeHeap)
+    // answers new clients with 503 and Retry-After while maxActiveConnections connections are
+    // active, or while the free heap is under minFreeHeap bytes (0 to not check it), and closes them
+    // once they are drained: an overloaded server sheds load before reading a request, instead of
+    // running out of memory in the middle of one. By default no client is turned away while a
+    // connection is free: e.g. setAdmission(MAX_CONNECTIONS_COUNT - 1) keeps the last connection to
+    // answer the clients waiting in the backlog at once
+    void setAdmission(int maxActiveConnections, size_t minFreeHeap = 0);
+
+    // starts the server and handles clients forever.
     // Pass a callback function to perform tasks at the end of each ArduinoExpress pass
-    void listen(int port, std::function<void()> callback); // iterate_all option: default False || add express callback
+    void listen(int port, std::function<void()> callback = nullptr);
 
-    // add a router on the specified path
-    void use(const String&, ArduinoExpressRouter* );
-    
-    // add a router on the root path
-    void use(ArduinoExpressRouter* );
-    
-    // add a middleware on the specified path
-    void use(const String &path, MiddlewareFunction callback) 
-    {ArduinoExpressRouter::use(path, callback);}
-
-    // add a middleware on the root path
-    void use(MiddlewareFunction callback) 
-    {ArduinoExpressRouter::use(callback);}
-    
-    // creates and return an ArduinoExpressRouter object
+    // creates and return an ArduinoExpressRouter object. It holds no memory until a callback is
+    // registered on it
     static ArduinoExpressRouter Router() {return ArduinoExpressRouter();}
+
+    /* MiddlewareFunction Static(mountPath, fs, root, cacheControl)
+      * creates a middleware that serves the files under root in fs for the requests under mountPath.
+      * e.g. app.use(ArduinoExpress::Static("/assets", LittleFS, "/www")) serves /www/app.js for 
+      * GET /assets/app.js, and /www/index.html for GET /assets/
+      * - A precompressed "<file>.gz" is served instead of the file if the client accepts gzip
+      * - Responses carry an ETag, If-None-Match is answered with 304
+      * - Single byte ranges (Range: bytes=start-end) are answered with 206
+      * Requests for files that don't exist are passed to the next callback.
+      * */
+    static MiddlewareFunction Static(const String&, fs::FS&, const String&, 
+                                     const String& cacheControl = "public, max-age=86400");
+
+    /* MiddlewareFunction Json(maxBodySize)
+      * creates a middleware that parses the body of "application/json" requests with req.json(),
+      * so the next callbacks get the parsed document for free.
+      * Bodies larger than maxBodySize (0 for no limit) are answered with 413, bodies that are not
+      * valid JSON with 400. Other requests are passed to the next callback.
+      * */
+    static MiddlewareFunction Json(size_t maxBodySize = ArduinoExpressConfig::MAX_JSON_BODY_SIZE);
+
+    /* MiddlewareFunction Form(onPart)
+      * creates a middleware that decodes form bodies into req.fields, read with req.getField().
+      * - "application/x-www-form-urlencoded" bodies are decoded before the next callbacks run.
+      *   Bodies larger than the request buffer are answered with 413
+      * - "multipart/form-data" bodies are decoded as they arrive, after the callbacks have run:
+      *   each part's content is passed to onPart, and the fields that are not files are added to
+      *   req.fields. The handler answers from req.onEnd(), where req.multipartDone() tells whether
+      *   the whole form was received. Bodies of any size are streamed, up to the app's max body size
+      * e.g. app.post("/upload", ArduinoExpress::Form([](Req& req, const HTTP_FormPart& part,
+      *        const uint8_t* data, size_t length){ ... }), [](Req& req, Res& res){
+      *        req.onEnd([&req, &res](){ res.send(200, "text/plain", req.getField("ssid").toString()); });
+      *        return nullptr; });
+      * Other requests are passed to the next callback.
+      * */
+    static MiddlewareFunction Form(HTTP_PartFunction onPart = nullptr);
+
+    /* MiddlewareFunction Compress(minSize)
+      * creates a middleware that compresses the bodies the next callbacks send() with gzip, or deflate,
+      * when the request's Accept-Encoding allows it and the body is at least minSize bytes of text.
+      * The q-values of Accept-Encoding are honoured: the preferred encoding is used, and q=0 refuses one.
+      * e.g. app.use(ArduinoExpress::Compress()). See HTTP_Response::setCompression()
+      * */
+    static MiddlewareFunction Compress(size_t minSize = ArduinoExpressConfig::MIN_COMPRESS_SIZE);
+
+    /* EndpointFunction Asset(contentType, gzipData, length)
+      * creates an endpoint that serves a body compressed with gzip at build time and kept in flash,
+      * sent as it is, without compressing it or copying it to RAM whole. e.g. with the output of
+      * "gzip -9 -c index.html | xxd -i":
+      *   static const uint8_t INDEX_HTML_GZ[] PROGMEM = {0x1f, 0x8b, ...};
+      *   app.get("/", ArduinoExpress::Asset("text/html", INDEX_HTML_GZ, sizeof(INDEX_HTML_GZ)));
+      * Only the compressed body is kept, so clients that don't accept gzip (no "gzip" in their
+      * Accept-Encoding, or "gzip;q=0") are answered with 406 Not Acceptable. To serve them too, give
+      * the route a middleware that sends them an uncompressed copy, and calls next() for the others.
+      * */
+    static EndpointFunction Asset(const char*, const uint8_t*, size_t);
+
+    /* MiddlewareFunction Cache(cache, ttl, varyHeaders)
+      * creates a middleware that answers GET requests from cache, and stores the responses of the
+      * next callbacks in it for ttl milliseconds. varyHeaders is a comma separated list of the request
+      * headers the response depends on, e.g. "Accept-Encoding".
+      * Use it on a router, app.use("/api", ArduinoExpress::Cache(cache, 2000)), or on one route,
+      * app.get("/info", ArduinoExpress::Cache(cache, 5000), handler). See HTTP_ResponseCache
+      * */
+    static MiddlewareFunction Cache(HTTP_ResponseCache&, unsigned long, const String& varyHeaders = "");
+
+    /* MiddlewareFunction RateLimit(limiter, keyHeader)
+      * creates a middleware that takes a request from the client's bucket in limiter, and answers
+      * 429 with Retry-After when it's empty. Clients are told apart by their IP address, or by the
+      * value of the keyHeader request header if it's given, e.g. "X-API-Key"; requests without it
+      * fall back to their IP address.
+      * e.g. app.use("/api", ArduinoExpress::RateLimit(limiter)). See HTTP_RateLimiter
+      * */
+    static MiddlewareFunction RateLimit(HTTP_RateLimiter&, const String& keyHeader = "");
+
+#if ARDUINOEXPRESS_METRICS
+    /* EndpointFunction Metrics()
+      * creates an endpoint that serves the metrics of every route in the Prometheus text format,
+      * e.g. app.get("/metrics", ArduinoExpress::Metrics())
+      * */
+    static EndpointFunction Metrics();
+#endif
   
 };
 
@@ -0,0 +1,37 @@
+#include "ArduinoExpress.h"
+
+/* The middleware created by ArduinoExpress::Cache */
+struct CachedResponses{
+  HTTP_ResponseCache* cache;
+  unsigned long ttl;
+  String varyHeaders;
+
+  void* operator()(Req& req, Res& res, Next next) const
+  {
+    if(!(req.method == "GET")){
+      next();
+      return nullptr;
+    }
+
+    // the key is built on the stack, a hit doesn't allocate
+    char key[ArduinoExpressConfig::MAX_CACHE_KEY_LENGTH];
+    size_t keyLength = HTTP_ResponseCache::makeKey(req, this->varyHeaders, key, sizeof(key));
+    if(keyLength == 0){
+      logdebug("Cache key of %s is too long, it is not cached", req.route.c_str());
+      next();
+      return nullptr;
+    }
+
+    if(this->cache->serve(key, keyLength, req, res)) return nullptr;
+
+    this->cache->expect(key, keyLength, this->ttl, res);
+    next();
+    return nullptr;
+  }
+};
+
+
+MiddlewareFunction ArduinoExpress::Cache(HTTP_ResponseCache& cache, unsigned long ttl, const String& varyHeaders)
+{
+  return CachedResponses{&cache, ttl, varyHeaders};
+}
@@ -0,0 +1,60 @@
+#include "ArduinoExpress.h"
+
+/* The middleware created by ArduinoExpress::Compress */
+struct CompressedResponses{
+  size_t minSize;
+
+  void* operator()(Req& req, Res& res, Next next) const
+  {
+    // compressed bodies are chunked, which HTTP/1.0 clients don't read. The encoding the client
+    // prefers is used, gzip on a tie; one it gives q=0 is refused
+    HTTP_StringView acceptEncoding = req.getHeader(HEADER_ACCEPT_ENCODING);
+    if(req.version.equals("HTTP/1.1")){
+      int gzip = acceptEncoding.tokenQuality("gzip");
+      int deflate = acceptEncoding.tokenQuality("deflate");
+      if(gzip > 0 && gzip >= deflate) res.setCompression(ENCODING_GZIP, this->minSize);
+      else if(deflate > 0) res.setCompression(ENCODING_DEFLATE, this->minSize);
+    }
+
+    next();
+    return nullptr;
+  }
+};
+
+
+MiddlewareFunction ArduinoExpress::Compress(size_t minSize)
+{
+  return CompressedResponses{minSize};
+}
+
+
+/* The endpoint created by ArduinoExpress::Asset */
+struct CompressedAsset{
+  const char* contentType;
+  PGM_P data;
+  size_t length;
+
+  void* operator()(Req& req, Res& res) const
+  {
+    // there's no uncompressed copy to send to a client that doesn't accept gzip
+    if(req.getHeader(HEADER_ACCEPT_ENCODING).tokenQuality("gzip") <= 0){
+      res.send(406, "text/plain", HTTPStatusText(406));
+      return nullptr;
+    }
+
+    // the gzip bytes are never sent without the header that says they are
+    if(!res.setHeader(HEADER_CONTENT_ENCODING, "gzip")){
+      res.send(500, "text/plain", HTTPStatusText(500));
+      return nullptr;
+    }
+    res.setHeader(HEADER_VARY, "Accept-Encoding");
+    res.send_P(200, this->contentType, this->data, this->length);
+    return nullptr;
+  }
+};
+
+
+EndpointFunction ArduinoExpress::Asset(const char* contentType, const uint8_t* gzipData, size_t length)
+{
+  return CompressedAsset{contentType, (PGM_P)gzipData, length};
+}
@@ -0,0 +1,49 @@
+#include "ArduinoExpress.h"
+
+/* The middleware created by ArduinoExpress::Form */
+struct FormBody{
+  HTTP_PartFunction onPart;
+
+  void* operator()(Req& req, Res& res, Next next) const
+  {
+    HTTP_StringView contentType = req.getHeader(HEADER_CONTENT_TYPE);
+
+    if(contentType.containsToken("application/x-www-form-urlencoded")){
+      // a streamed body is larger than the request buffer, it can't be decoded in place
+      if(req.bodyStreamed){
+        res.send(413, "text/plain", HTTPStatusText(413));
+        return nullptr;
+      }
+
+      // the fields view the body, which is decoded in place in the request buffer
+      req.fieldsCount = parseUrlEncoded(const_cast<char*>(req.body.c_str()), req.fields, req.fieldsCount, req.MAX_FIELDS_COUNT);
+      req.body = HTTP_StringView{};
+      next();
+      return nullptr;
+    }
+
+    if(contentType.containsToken("multipart/form-data")){
+      HTTP_MultipartParser* parser = req.multipart();
+      if(!parser){
+        res.send(500, "text/plain", HTTPStatusText(500));
+        return nullptr;
+      }
+      if(!parser->begin(req, headerParameter(contentType, "boundary"), onPart)){
+        res.send(400, "text/plain", HTTPStatusText(400));
+        return nullptr;
+      }
+
+      // the body goes to the parser as it arrives, or all at once after the callbacks if it's buffered
+      req.onData([parser](const uint8_t* data, size_t length){parser->feed(data, length);});
+    }
+
+    next();
+    return nullptr;
+  }
+};
+
+
+MiddlewareFunction ArduinoExpress::Form(HTTP_PartFunction onPart)
+{
+  return FormBody{onPart};
+}
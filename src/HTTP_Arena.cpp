@@ -0,0 +1,73 @@
+#include "HTTP_Arena.h"
+
+bool HTTP_Arena::reserve(size_t capacity)
+{
+  reset();
+  if(capacity <= this->_capacity) return true;
+
+  // what was allocated is freed anyway, there's no need to copy it
+  free(this->_memory);
+  this->_memory = (uint8_t*)malloc(capacity);
+  this->_capacity = this->_memory ? capacity : 0;
+  return this->_memory != nullptr;
+}
+
+
+void* HTTP_Arena::alloc(size_t size)
+{
+  if(!this->_memory && this->_defaultCapacity > 0 && !reserve(this->_defaultCapacity)){
+    logerr("Not enough memory for a request arena of %u bytes", (unsigned)this->_defaultCapacity);
+  }
+
+  // allocations are aligned for the pointers and numbers of a JSON document
+  size = (size + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+  if(this->_size + size > this->_capacity){
+    this->_overflowed = true;
+    if(!this->_heapFallback) return nullptr;
+
+    Overflow* overflow = (Overflow*)malloc(sizeof(Overflow) + size);
+    if(!overflow) return nullptr;
+    overflow->next = this->_overflows;
+    this->_overflows = overflow;
+    return overflow + 1;
+  }
+
+  void* memory = this->_memory + this->_size;
+  this->_size += size;
+  return memory;
+}
+
+
+void* HTTP_Arena::resize(void* block, size_t size, size_t newSize)
+{
+  size = (size + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+  newSize = (newSize + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+  if(!block || size > this->_size || block != this->_memory + this->_size - size ||
+     this->_size - size + newSize > this->_capacity){
+    return nullptr;
+  }
+
+  this->_size = this->_size - size + newSize;
+  return block;
+}
+
+
+void HTTP_Arena::freeOverflows()
+{
+  while(this->_overflows){
+    Overflow* next = this->_overflows->next;
+    free(this->_overflows);
+    this->_overflows = next;
+  }
+}
+
+
+const char* HTTP_Arena::copy(const char* text, size_t length)
+{
+  char* copy = (char*)alloc(length + 1);
+  if(!copy) return nullptr;
+
+  memcpy(copy, text, length);
+  copy[length] = '\0';
+  return copy;
+}
@@ -0,0 +1,75 @@
+/*
+ * This library provides HTTP_Arena, the allocator of what a connection keeps for one request only:
+ * its JSON document, and the headers and status text of its response
+ */
+
+#ifndef HTTP_ARENA_HEADER
+#define HTTP_ARENA_HEADER
+
+#include "HTTP_Utilities.h"
+
+/* An HTTP_Arena hands out memory from a single block, by moving a pointer, and frees all of it at
+  * once with reset(), at the end of the request. The block is allocated on the first allocation
+  * (or reserve()) and kept by the connection for its next requests, so serving requests doesn't
+  * allocate and free small blocks all over the heap.
+  * Allocations never move what's been allocated. The ones that don't fit fail, unless the arena
+  * falls back to the heap: they then get a heap block of their own, freed by reset() too.
+*/
+struct HTTP_Arena{
+  private:
+    // a heap block of an allocation that didn't fit, followed by the allocation
+    struct Overflow{
+      Overflow* next;
+    };
+
+    uint8_t* _memory = nullptr;
+    size_t _capacity = 0;
+    size_t _size = 0;
+    size_t _defaultCapacity = 0;  // the size of the block allocated by the first allocation
+    bool _heapFallback = false;   // allocations that don't fit are allocated from the heap
+    bool _overflowed = false; // an allocation did not fit since the last reset
+    Overflow* _overflows = nullptr;
+
+    // frees the heap blocks of the allocations that didn't fit
+    void freeOverflows();
+
+  public:
+    HTTP_Arena(size_t defaultCapacity = 0, bool heapFallback = false)
+      : _defaultCapacity{defaultCapacity}, _heapFallback{heapFallback} {}
+    ~HTTP_Arena() {freeOverflows(); free(this->_memory);}
+
+    HTTP_Arena(const HTTP_Arena&) = delete;
+    HTTP_Arena& operator=(const HTTP_Arena&) = delete;
+
+    // bool reserve(capacity)
+    // empties the arena and makes sure it can hold capacity bytes. Returns false if it's out of memory
+    bool reserve(size_t );
+
+    // void* alloc(size)
+    // returns size bytes aligned for pointers and numbers, null if they don't fit, or with a heap
+    // fallback if the heap is out of memory
+    void* alloc(size_t );
+
+    // void* resize(block, size, newSize)
+    // grows or shrinks the size bytes of block to newSize where they are, if block is the last
+    // allocation and newSize fits. Returns block, or null if it can't be resized
+    void* resize(void*, size_t, size_t);
+
+    // const char* copy(text, length)
+    // returns a null-terminated copy of text, null if it doesn't fit
+    const char* copy(const char*, size_t);
+
+    // frees everything allocated, in O(1) unless allocations fell back to the heap. The block is kept
+    void reset()
+    {
+      if(this->_overflows) freeOverflows();
+      this->_size = 0;
+      this->_overflowed = false;
+    }
+
+    bool overflowed() const {return this->_overflowed;}
+    size_t size() const {return this->_size;}
+    size_t capacity() const {return this->_capacity;}
+};
+
+#endif
@@ -0,0 +1,248 @@
+#include "HTTP_Cache.h"
+
+// uint32_t fnv1a(data, length, hash)
+// continues an FNV-1a hash over data
+static uint32_t fnv1a(const uint8_t* data, size_t length, uint32_t hash = 2166136261u)
+{
+  for(size_t i = 0; i < length; ++i){
+    hash ^= data[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+
+HTTP_ResponseCache::HTTP_ResponseCache(size_t arenaSize)
+{
+  this->_arena = (uint8_t*)malloc(arenaSize);
+  this->_arenaSize = this->_arena ? arenaSize : 0;
+  if(!this->_arena) logerr("Not enough memory for a response cache of %u bytes", (unsigned)arenaSize);
+}
+
+
+size_t HTTP_ResponseCache::makeKey(const HTTP_Request& req, const String& varyHeaders, char* buffer, size_t capacity)
+{
+  size_t length = 0;
+  bool fits = true;
+  auto append = [&](const char* text, size_t textLength){
+    if(length + textLength > capacity) fits = false;
+    else memcpy(buffer + length, text, textLength);
+    length += textLength;
+  };
+
+  append(req.method.c_str(), req.method.length());
+  append(" ", 1);
+  // the request target as it was sent: the decoded query parameters are ambiguous and can be cut
+  append(req.route.c_str(), req.route.length());
+  if(!req.rawQuery.isEmpty()){
+    append("?", 1);
+    append(req.rawQuery.c_str(), req.rawQuery.length());
+  }
+
+  // the name and the value of each header in varyHeaders, on its own line
+  const char* names = varyHeaders.c_str();
+  while(*names)
+  {
+    while(*names == ' ' || *names == ',') ++names;
+    const char* end = names;
+    while(*end && *end != ',') ++end;
+    size_t nameLength = end - names;
+    while(nameLength > 0 && names[nameLength - 1] == ' ') --nameLength;
+
+    char name[64];
+    if(nameLength > 0 && nameLength < sizeof(name)){
+      memcpy(name, names, nameLength);
+      name[nameLength] = '\0';
+      HTTP_StringView value = req.getHeader(name);
+      append("\n", 1);
+      append(name, nameLength);
+      append(":", 1);
+      append(value.c_str(), value.length());
+    }
+    names = end;
+  }
+
+  return fits ? length : 0;
+}
+
+
+int HTTP_ResponseCache::find(const char* key, size_t length) const
+{
+  uint32_t hash = fnv1a((const uint8_t*)key, length);
+  for(int i = 0; i < this->_entriesCount; ++i){
+    const HTTP_CacheEntry& entry = this->_entries[i];
+    if(entry.keyHash == hash && entry.keyLength == length && memcmp(keyOf(entry), key, length) == 0) return i;
+  }
+
+  return -1;
+}
+
+
+bool HTTP_ResponseCache::serve(const char* key, size_t length, const HTTP_Request& req, HTTP_Response& res)
+{
+  int index = find(key, length);
+  if(index == -1) return false;
+
+  HTTP_CacheEntry& entry = this->_entries[index];
+  if(expired(entry)){
+    remove(index);
+    return false;
+  }
+  entry.lastUsed = ++this->_uses;
+
+  HTTP_StringView ifNoneMatch = req.getHeader(HEADER_IF_NONE_MATCH);
+  if(!ifNoneMatch.isEmpty() && (ifNoneMatch.equals("*") || ifNoneMatch.containsToken(etagOf(entry)))){
+    res.setStatus(304, "");
+    res.setHeader(HEADER_ETAG, etagOf(entry));
+    return res.send();
+  }
+
+  return res.sendSerialized(entry.status, headOf(entry), entry.headLength, bodyOf(entry), entry.bodyLength);
+}
+
+
+HTTP_CachePending* HTTP_ResponseCache::pendingOf(const HTTP_Response* res)
+{
+  for(HTTP_CachePending& pending : this->_pending){
+    if(pending.response == res) return &pending;
+  }
+  return nullptr;
+}
+
+
+void HTTP_ResponseCache::expect(const char* key, size_t length, unsigned long ttl, HTTP_Response& res)
+{
+  if(length > sizeof(HTTP_CachePending::key)) return;
+
+  // the response's slot if it has one, from a miss it never sent, else a free one. With more
+  // responses than connections, the response of the first slot is not stored
+  HTTP_CachePending* pending = pendingOf(&res);
+  if(!pending) pending = pendingOf(nullptr);
+  if(!pending) pending = &this->_pending[0];
+
+  pending->response = &res;
+  memcpy(pending->key, key, length);
+  pending->keyLength = length;
+  pending->ttl = ttl;
+  res.setSendObserver(this);
+}
+
+
+void HTTP_ResponseCache::sending(HTTP_Response& res)
+{
+  HTTP_CachePending* pending = pendingOf(&res);
+  if(!pending) return;
+  pending->response = nullptr;
+  size_t keyLength = pending->keyLength;
+  const char* key = pending->key;
+  if(keyLength == 0 || !this->_arena || res.status() != 200) return;
+
+  HTTP_StringView directives = res.getHeader(HEADER_CACHE_CONTROL);
+  if(directives.containsToken("no-store") || directives.containsToken("private")) return;
+  // a cookie is the client's own, it's not sent to the others
+  if(res.hasHeader(HEADER_SET_COOKIE)) return;
+
+  // the ETag is set on the response, so the first response carries it too
+  HTTP_StringView body = res.body();
+  if(!res.hasHeader(HEADER_ETAG)){
+    char etag[24];
+    uint32_t hash = fnv1a((const uint8_t*)body.c_str(), body.length());
+    snprintf(etag, sizeof(etag), "\"%x-%08lx\"", (unsigned)body.length(), (unsigned long)hash);
+    res.setHeader(HEADER_ETAG, etag);
+  }
+  HTTP_StringView etag = res.getHeader(HEADER_ETAG);
+  size_t headLength = res.serializeHead(nullptr, 0);
+  if(etag.isEmpty() || etag.length() >= 255 || headLength > UINT16_MAX) return;
+
+  HTTP_CacheEntry entry;
+  entry.keyHash = fnv1a((const uint8_t*)key, keyLength);
+  entry.keyLength = keyLength;
+  entry.etagLength = etag.length();
+  entry.headLength = headLength;
+  entry.bodyLength = body.length();
+  entry.status = res.status();
+  entry.storedAt = this->_clock();
+  entry.ttl = pending->ttl;
+  entry.lastUsed = ++this->_uses;
+
+  int previous = find(key, keyLength);
+  if(previous != -1) remove(previous);
+  if(!makeRoom(entry.size())){
+    logdebug("Response of %u bytes is larger than the cache", (unsigned)entry.size());
+    return;
+  }
+
+  entry.offset = this->_used;
+  this->_entries[this->_entriesCount++] = entry;
+  this->_used += entry.size();
+
+  char* data = (char*)this->_arena + entry.offset;
+  memcpy(data, key, keyLength);
+  memcpy(data + keyLength, etag.c_str(), entry.etagLength + 1);
+  res.serializeHead(data + keyLength + entry.etagLength + 1, entry.headLength);
+  memcpy(data + keyLength + entry.etagLength + 1 + entry.headLength, body.c_str(), entry.bodyLength);
+}
+
+
+bool HTTP_ResponseCache::makeRoom(size_t size)
+{
+  if(size > this->_arenaSize) return false;
+
+  while(this->_entriesCount == MAX_CACHE_ENTRIES_COUNT || this->_used + size > this->_arenaSize)
+  {
+    // an expired entry is evicted first, then the least recently used
+    int victim = 0;
+    for(int i = 0; i < this->_entriesCount; ++i){
+      if(expired(this->_entries[i])){
+        victim = i;
+        break;
+      }
+      if(this->_entries[i].lastUsed < this->_entries[victim].lastUsed) victim = i;
+    }
+    remove(victim);
+  }
+
+  return true;
+}
+
+
+void HTTP_ResponseCache::remove(int index)
+{
+  size_t start = this->_entries[index].offset;
+  size_t size = this->_entries[index].size();
+  memmove(this->_arena + start, this->_arena + start + size, this->_used - start - size);
+  this->_used -= size;
+
+  for(int i = index; i < this->_entriesCount - 1; ++i){
+    this->_entries[i] = this->_entries[i + 1];
+    this->_entries[i].offset -= size;
+  }
+  --this->_entriesCount;
+}
+
+
+void HTTP_ResponseCache::invalidate(const char* route)
+{
+  size_t routeLength = strlen(route);
+  for(int i = this->_entriesCount - 1; i >= 0; --i){
+    // the key is "<method> <route>", followed by the query or the headers if there are any
+    const HTTP_CacheEntry& entry = this->_entries[i];
+    const char* key = keyOf(entry);
+    const char* space = (const char*)memchr(key, ' ', entry.keyLength);
+    if(!space) continue;
+
+    size_t start = space + 1 - key;
+    if(start + routeLength > entry.keyLength || memcmp(key + start, route, routeLength) != 0) continue;
+    if(start + routeLength == entry.keyLength || key[start + routeLength] == '?' || key[start + routeLength] == '\n'){
+      remove(i);
+    }
+  }
+}
+
+
+void HTTP_ResponseCache::clear()
+{
+  this->_entriesCount = 0;
+  this->_used = 0;
+  for(HTTP_CachePending& pending : this->_pending) pending.response = nullptr;
+}
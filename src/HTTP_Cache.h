@@ -0,0 +1,140 @@
+/*
+ * This library provides HTTP_ResponseCache, the store of the ArduinoExpress::Cache() middleware:
+ * responses are kept serialized, so a cached response is sent without running its handler
+ */
+
+#ifndef HTTP_CACHE_HEADER
+#define HTTP_CACHE_HEADER
+
+#include "HTTP_Utilities.h"
+#include "HTTP_Request.h"
+#include "HTTP_Response.h"
+
+// a cached response. Its data is stored in the cache's arena, in this order: the key, the ETag
+// (null-terminated), the head (status line and headers) and the body
+struct HTTP_CacheEntry{
+  size_t offset = 0;  // offset of the entry's data in the arena
+  uint32_t keyHash = 0;
+  uint16_t keyLength = 0;
+  uint8_t etagLength = 0; // without the null terminator
+  uint16_t headLength = 0;
+  size_t bodyLength = 0;
+  int status = 0;
+  unsigned long storedAt = 0; // the cache's clock when the response was stored
+  unsigned long ttl = 0;
+  uint32_t lastUsed = 0;  // the cache's use count when the entry was last used
+
+  size_t size() const {return this->keyLength + this->etagLength + 1 + this->headLength + this->bodyLength;}
+};
+
+
+// the key a response is stored under once it's sent, kept from its request's miss
+struct HTTP_CachePending{
+  const HTTP_Response* response = nullptr;  // null for a free slot
+  char key[ArduinoExpressConfig::MAX_CACHE_KEY_LENGTH];
+  size_t keyLength = 0;
+  unsigned long ttl = 0;
+};
+
+
+// the clock the entries expire with, in milliseconds. It's millis() unless another one is set,
+// e.g. a fake clock in tests
+using HTTP_CacheClock = unsigned long (*)();
+
+
+/* HTTP_ResponseCache stores fully serialized responses in a fixed-size arena, allocated once.
+  * Responses are keyed by method, route, query and the values of a chosen set of request headers.
+  * Each response is kept for the TTL of the middleware that stored it; when the arena or the entries
+  * are full, expired responses are evicted first, then the least recently used.
+  * Only 200 responses sent with send() are stored, and not when their Cache-Control is "no-store" or
+  * "private", or when they set a cookie. Stored responses carry an ETag, If-None-Match is answered
+  * with 304. Each connection's response waits for its own key, misses on several connections at
+  * once are all stored.
+  * Handlers invalidate the responses of a route with invalidate(route).
+  * e.g. HTTP_ResponseCache cache;
+  *      app.get("/info", ArduinoExpress::Cache(cache, 5000), infoHandler);
+*/
+struct HTTP_ResponseCache: public HTTP_SendObserver{
+  private:
+    uint8_t* _arena = nullptr;
+    size_t _arenaSize = 0;
+    size_t _used = 0;  // the entries' data is packed at the start of the arena
+
+    // the entries, in the order of their data in the arena
+    const static int MAX_CACHE_ENTRIES_COUNT = ArduinoExpressConfig::MAX_CACHE_ENTRIES_COUNT;
+    HTTP_CacheEntry _entries[MAX_CACHE_ENTRIES_COUNT];
+    int _entriesCount = 0;
+    uint32_t _uses = 0;
+
+    // the keys of the responses expected by misses, one for each connection's response
+    const static int PENDING_COUNT = ArduinoExpressConfig::MAX_CONNECTIONS_COUNT;
+    HTTP_CachePending _pending[PENDING_COUNT];
+
+    HTTP_CacheClock _clock = millis;
+
+    // int find(key, length)
+    // returns the index of the entry stored under key, -1 if there's none
+    int find(const char*, size_t) const;
+
+    bool expired(const HTTP_CacheEntry& entry) const {return this->_clock() - entry.storedAt >= entry.ttl;}
+
+    // HTTP_CachePending* pendingOf(res)
+    // returns the slot of the key res waits for, null if it's waiting for none. pendingOf(nullptr)
+    // returns a free slot
+    HTTP_CachePending* pendingOf(const HTTP_Response*);
+
+    // void remove(index)
+    // removes an entry, and packs the data of the entries after it
+    void remove(int);
+
+    // bool makeRoom(size)
+    // evicts entries until there is an entry and size bytes free. Returns false if size doesn't fit
+    bool makeRoom(size_t);
+
+    const char* keyOf(const HTTP_CacheEntry& entry) const {return (const char*)this->_arena + entry.offset;}
+    const char* etagOf(const HTTP_CacheEntry& entry) const {return keyOf(entry) + entry.keyLength;}
+    const char* headOf(const HTTP_CacheEntry& entry) const {return etagOf(entry) + entry.etagLength + 1;}
+    const uint8_t* bodyOf(const HTTP_CacheEntry& entry) const {return (const uint8_t*)headOf(entry) + entry.headLength;}
+
+  public:
+    HTTP_ResponseCache(size_t arenaSize = ArduinoExpressConfig::CACHE_ARENA_SIZE);
+    HTTP_ResponseCache(const HTTP_ResponseCache&) = delete;
+    HTTP_ResponseCache& operator=(const HTTP_ResponseCache&) = delete;
+    ~HTTP_ResponseCache() {free(this->_arena);}
+
+    void setClock(HTTP_CacheClock clock) {this->_clock = clock;}
+
+    /* size_t makeKey(req, varyHeaders, buffer, capacity)
+      * writes the cache key of a request to buffer: its method, its path and query as they were
+      * sent, and the names and values of the headers listed in varyHeaders, a comma separated list
+      * of names.
+      * Returns the length of the key, 0 if it doesn't fit in capacity.
+      * */
+    static size_t makeKey(const HTTP_Request&, const String&, char*, size_t);
+
+    /* bool serve(key, length, req, res)
+      * sends the response stored under key, or 304 if it matches the request's If-None-Match.
+      * Returns false if no fresh response is stored under key.
+      * */
+    bool serve(const char*, size_t, const HTTP_Request&, HTTP_Response&);
+
+    /* void expect(key, length, ttl, res)
+      * stores the next response res sends under key, for ttl milliseconds
+      * */
+    void expect(const char*, size_t, unsigned long, HTTP_Response&);
+
+    // stores the response under the key expect() was given for it, called by the response before it's sent
+    void sending(HTTP_Response&) override;
+
+    // void invalidate(route)
+    // removes the responses stored for route, whatever their method, query or headers
+    void invalidate(const char*);
+    void invalidate(const String& route) {invalidate(route.c_str());}
+
+    void clear();
+
+    int entriesCount() const {return this->_entriesCount;}
+    size_t used() const {return this->_used;}
+};
+
+#endif
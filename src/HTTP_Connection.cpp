@@ -0,0 +1,142 @@
+#include "HTTP_Connection.h"
+
+void HTTP_Connection::open(const HTTP_Client& client)
+{
+  this->_client = client;
+  resetRequest();
+  this->_req.remoteIP = this->_client.remoteIP();
+
+  this->_readOffset = 0;
+  this->_readLength = 0;
+  this->_requestsCount = 0;
+  this->_state = READING;
+  this->_lastActivity = millis();
+}
+
+
+void HTTP_Connection::close()
+{
+  // a body that wasn't sent whole is dropped, and the file it was read from closed
+  this->_res.reset();
+  this->_client.stop();
+  this->_state = FREE;
+  loginfo("[Client disconnected]");
+}
+
+
+void HTTP_Connection::drain()
+{
+  this->_client.shutdown();
+  this->_readOffset = 0;
+  this->_readLength = 0;
+  this->_state = DRAINING;
+  this->_lastActivity = millis();
+}
+
+
+bool HTTP_Connection::poll()
+{
+  if(this->_state == FREE) return false;
+
+  if(this->_state == WRITING){
+    if(this->_res.sendMore() > 0) this->_lastActivity = millis();
+    if(!this->_res.sendingBody() && !this->_client.sending()) endRequest();
+    return false;
+  }
+
+  if(this->_state == DRAINING){
+    // the bytes are discarded, and don't keep the connection open past its timeout. The client
+    // is half-closed once the transport has sent the response
+    if(this->_client.sending()) return false;
+    if(this->_client.available() > 0) this->_client.read((uint8_t*)this->_readBuffer, READ_CHUNK_SIZE);
+    else if(!this->_client.connected()) close();
+    return false;
+  }
+
+  if(this->_readOffset == this->_readLength)
+  {
+    int available = this->_client.available();
+    if(available > 0)
+    {
+      int length = this->_client.read((uint8_t*)this->_readBuffer, available < READ_CHUNK_SIZE ? available : READ_CHUNK_SIZE);
+      this->_readOffset = 0;
+      this->_readLength = length > 0 ? length : 0;
+      if(length > 0) this->_lastActivity = millis();
+    }
+    else if(!this->_client.connected())
+    {
+      close();
+      return false;
+    }
+  }
+
+  if(this->_readOffset < this->_readLength)
+  {
+    this->_state = READING;
+    bool headersParsed = this->_parser.headersParsed();
+#if ARDUINOEXPRESS_METRICS
+    unsigned long start = metricsNow();
+    size_t consumed = this->_parser.feed(this->_readBuffer + this->_readOffset, this->_readLength - this->_readOffset);
+    this->_req.metrics.phases[PHASE_PARSE] += metricsNow() - start;
+    this->_req.metrics.bytesIn += consumed;
+    this->_readOffset += consumed;
+#else
+    this->_readOffset += this->_parser.feed(this->_readBuffer + this->_readOffset, this->_readLength - this->_readOffset);
+#endif
+
+    // keep-alive is decided as soon as the headers are read, so a response sent before the body
+    // is, e.g. a 202 to an upload, tells the client whether the connection stays open
+    if(!headersParsed && this->_parser.headersParsed()){
+      this->_res.setKeepAlive(this->_parser.keepAlive() && this->_requestsCount + 1 < ArduinoExpressConfig::MAX_KEEP_ALIVE_REQUESTS);
+    }
+  }
+
+  return this->_parser.complete() || this->_parser.failed() || this->_parser.streamStart();
+}
+
+
+void HTTP_Connection::finishRequest()
+{
+  // a slow client is sent the rest of the response across polls
+  if(this->_res.sendingBody() || this->_client.sending()){
+    this->_state = WRITING;
+    this->_lastActivity = millis();
+    return;
+  }
+
+  endRequest();
+}
+
+
+void HTTP_Connection::endRequest()
+{
+  ++this->_requestsCount;
+
+  // the connection is kept open if the response said so: keepAlive() is what was written
+  if(this->_parser.failed() || !this->_res.keepAlive() || !this->_client.connected()){
+    close();
+    return;
+  }
+
+  resetRequest();
+
+  this->_state = IDLE;
+  this->_lastActivity = millis();
+}
+
+
+void HTTP_Connection::resetRequest()
+{
+  this->_req.clear();
+  this->_res.reset();
+  this->_parser.begin(this->_req);
+}
+
+
+bool HTTP_Connection::timedOut() const
+{
+  unsigned long timeout = this->_state == IDLE ? ArduinoExpressConfig::KEEP_ALIVE_TIMEOUT_MS 
+                        : this->_state == DRAINING ? ArduinoExpressConfig::ADMISSION_DRAIN_MS
+                                                   : ArduinoExpressConfig::REQUEST_TIMEOUT_MS;
+  return millis() - this->_lastActivity > timeout;
+}
@@ -0,0 +1,102 @@
+/*
+ * This library provides the connection slots ArduinoExpress serves its clients with
+ */
+
+#ifndef HTTP_CONNECTION_HEADER
+#define HTTP_CONNECTION_HEADER
+
+#include "HTTP_Transport.h"
+#include "HTTP_Request.h"
+#include "HTTP_Response.h"
+#include "HTTP_Parser.h"
+
+/* An HTTP_Connection is one client being served by ArduinoExpress. It holds the client and the
+  * state of the request being read from it, so a request can be read a little at a time,
+  * interleaved with the other connections.
+  * Connections are persistent: after a response the connection waits (IDLE) for the client's next
+  * request. Bytes of pipelined requests that were read with the previous request are kept in the
+  * read buffer, and parsed first.
+  * A response whose body is sent across polls, or that the transport is still sending, is WRITING:
+  * the connection waits for it before reading the next request, or closing the client.
+  * A client turned away before its request is read is DRAINING: see drain()
+*/
+struct HTTP_Connection{
+  enum State : uint8_t {FREE, IDLE, READING, WRITING, DRAINING};
+
+  private:
+    HTTP_Client _client;
+    HTTP_RequestParser _parser;
+    HTTP_Request _req;
+    HTTP_Response _res{&this->_client};
+
+    const static int READ_CHUNK_SIZE = ArduinoExpressConfig::READ_CHUNK_SIZE;
+    char _readBuffer[READ_CHUNK_SIZE];
+    int _readOffset = 0;
+    int _readLength = 0;
+
+    State _state = FREE;
+    unsigned long _lastActivity = 0;
+    int _requestsCount = 0;
+
+    // void resetRequest()
+    // ends the current request: the request, its JSON document, the response and its headers, and
+    // the parser are all reset at once. Their memory is kept for the next request
+    void resetRequest();
+
+    // void endRequest()
+    // keeps the connection open for the next request once the response is sent, or closes it
+    void endRequest();
+
+  public:
+    // void open(client)
+    // starts serving a newly accepted client
+    void open(const HTTP_Client& );
+
+    // void close()
+    // disconnects the client and frees the connection
+    void close();
+
+    // void drain()
+    // closes the connection once a response was sent without reading the request, e.g. a 503 to a
+    // client turned away. Closing a socket with unread bytes resets the connection, and the client
+    // can lose the response: the client is half-closed instead, and what it sends is read and
+    // discarded until it disconnects, or for at most ADMISSION_DRAIN_MS
+    void drain();
+
+    // bool poll()
+    // parses what's left in the read buffer, or reads at most READ_CHUNK_SIZE bytes from the client, 
+    // without waiting for more.
+    // Returns true once the request is complete, or can't be parsed, and should be answered, and
+    // when the headers of a request with a streamed body are read, and it should be routed.
+    // The connection is closed if the client disconnected. A WRITING connection reads nothing: it
+    // writes the next chunk of the response's body, and ends its request once it's all sent
+    bool poll();
+
+    // void streamBody()
+    // reads the rest of a streamed body once the request has been routed, see HTTP_RequestParser
+    void streamBody() {this->_parser.streamBody();}
+
+    void setMaxBodySize(size_t maxBodySize) {this->_parser.setMaxBodySize(maxBodySize);}
+
+    // void finishRequest()
+    // called once the request has been answered, and its body read. Keeps the connection open for the next request,
+    // or closes it if the response was not keep-alive, once the transport has sent the response
+    void finishRequest();
+
+    // returns true if the client has sent nothing for REQUEST_TIMEOUT_MS, or taken nothing as long
+    // while WRITING, or KEEP_ALIVE_TIMEOUT_MS while IDLE, or if it has been DRAINING for ADMISSION_DRAIN_MS
+    bool timedOut() const;
+
+    bool isFree() const {return this->_state == FREE;}
+    // returns true if bytes already read from the client are left to parse now
+    bool hasInput() const {return this->_state != FREE && this->_state != WRITING && this->_readOffset < this->_readLength;}
+    // returns true if the response has a chunk of its body left to write, that the client takes now
+    bool hasOutput() {return this->_state == WRITING && this->_res.sendingBody() && this->_client.availableForWrite() > 0;}
+    State state() const {return this->_state;}
+
+    HTTP_Request& req() {return this->_req;}
+    HTTP_Response& res() {return this->_res;}
+    const HTTP_RequestParser& parser() const {return this->_parser;}
+};
+
+#endif
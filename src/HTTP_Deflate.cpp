@@ -0,0 +1,206 @@
+#include "HTTP_Deflate.h"
+
+// the lengths (3-258) and distances (1-32768) of matches are coded as a symbol, whose base is given
+// here, followed by extra bits
+static const uint16_t LENGTH_BASE[29] PROGMEM = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                                 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t LENGTH_EXTRA[29] PROGMEM = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                                 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t DISTANCE_BASE[30] PROGMEM = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                                   257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+                                                   8193, 12289, 16385, 24577};
+static const uint8_t DISTANCE_EXTRA[30] PROGMEM = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                                   7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+const static size_t MIN_MATCH = 3;
+const static size_t MAX_MATCH = 258;
+
+// CRC-32 a nibble at a time, with a table of 16 entries instead of 256
+static const uint32_t CRC_TABLE[16] PROGMEM = {
+  0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac, 0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+  0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c, 0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c
+};
+
+static uint32_t crc32Of(const uint8_t* data, size_t length)
+{
+  uint32_t crc = 0xffffffff;
+  for(size_t i = 0; i < length; ++i){
+    crc ^= data[i];
+    crc = pgm_read_dword(&CRC_TABLE[crc & 15]) ^ (crc >> 4);
+    crc = pgm_read_dword(&CRC_TABLE[crc & 15]) ^ (crc >> 4);
+  }
+  return ~crc;
+}
+
+// the checksum of a zlib stream
+static uint32_t adler32(const uint8_t* data, size_t length)
+{
+  uint32_t a = 1, b = 0;
+  while(length > 0)
+  {
+    // the sums can't overflow in 5552 bytes
+    size_t count = length < 5552 ? length : 5552;
+    for(size_t i = 0; i < count; ++i){
+      a += data[i];
+      b += a;
+    }
+    a %= 65521;
+    b %= 65521;
+    data += count;
+    length -= count;
+  }
+  return (b << 16) | a;
+}
+
+static inline uint32_t hash3(const uint8_t* data)
+{
+  uint32_t bytes = ((uint32_t)data[0] << 16) | ((uint32_t)data[1] << 8) | data[2];
+  return (bytes * 2654435761u) >> (32 - ArduinoExpressConfig::DEFLATE_HASH_BITS);
+}
+
+
+HTTP_Deflate* HTTP_Deflate::shared()
+{
+  static HTTP_Deflate* deflate = nullptr;
+  if(!deflate){
+    deflate = new (std::nothrow) HTTP_Deflate;
+    if(!deflate) logerr("Not enough memory for the compressor");
+  }
+  return deflate;
+}
+
+
+void HTTP_Deflate::compress(HTTP_Encoding encoding, const uint8_t* data, size_t length, HTTP_DeflateSink sink)
+{
+  this->_sink = sink;
+  this->_bits = 0;
+  this->_bitsCount = 0;
+  this->_outputSize = 0;
+  memset(this->_positions, 0, sizeof(this->_positions));
+
+  if(encoding == ENCODING_GZIP){
+    // no name, no modification time, unknown OS
+    static const uint8_t GZIP_HEADER[10] = {0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 0xff};
+    for(uint8_t byte : GZIP_HEADER) writeByte(byte);
+  }else{
+    // 32K window, fastest compression
+    writeByte(0x78);
+    writeByte(0x01);
+  }
+
+  // a single final block with the fixed Huffman codes
+  writeBits(1, 1);
+  writeBits(1, 2);
+
+  size_t i = 0;
+  while(i + MIN_MATCH <= length)
+  {
+    uint32_t hash = hash3(data + i);
+    size_t distance = (uint16_t)((uint16_t)i - this->_positions[hash]);
+    this->_positions[hash] = (uint16_t)i;
+
+    // the position may be stale or another hash's, the bytes are compared anyway
+    size_t matchLength = 0;
+    if(distance > 0 && distance <= WINDOW_SIZE && distance <= i){
+      const uint8_t* match = data + i - distance;
+      size_t maxLength = length - i < MAX_MATCH ? length - i : MAX_MATCH;
+      while(matchLength < maxLength && match[matchLength] == data[i + matchLength]) ++matchLength;
+    }
+
+    if(matchLength < MIN_MATCH){
+      writeSymbol(data[i]);
+      ++i;
+      continue;
+    }
+
+    writeMatch(matchLength, distance);
+    // the positions inside the match are hashed too, for the next matches
+    size_t end = i + matchLength;
+    for(++i; i < end && i + MIN_MATCH <= length; ++i) this->_positions[hash3(data + i)] = (uint16_t)i;
+    i = end;
+  }
+  for(; i < length; ++i) writeSymbol(data[i]);
+
+  writeSymbol(256);
+  flushBits();
+
+  if(encoding == ENCODING_GZIP){
+    uint32_t crc = crc32Of(data, length);
+    for(int shift = 0; shift < 32; shift += 8) writeByte(crc >> shift);
+    for(int shift = 0; shift < 32; shift += 8) writeByte((uint32_t)length >> shift);
+  }else{
+    uint32_t adler = adler32(data, length);
+    for(int shift = 24; shift >= 0; shift -= 8) writeByte(adler >> shift);
+  }
+
+  flushOutput();
+  this->_sink = nullptr;
+}
+
+
+void HTTP_Deflate::writeMatch(size_t length, size_t distance)
+{
+  int code = 28;
+  while(pgm_read_word(&LENGTH_BASE[code]) > length) --code;
+  writeSymbol(257 + code);
+  writeBits(length - pgm_read_word(&LENGTH_BASE[code]), pgm_read_byte(&LENGTH_EXTRA[code]));
+
+  code = 29;
+  while(pgm_read_word(&DISTANCE_BASE[code]) > distance) --code;
+  writeCode(code, 5);
+  writeBits(distance - pgm_read_word(&DISTANCE_BASE[code]), pgm_read_byte(&DISTANCE_EXTRA[code]));
+}
+
+
+void HTTP_Deflate::writeSymbol(uint16_t symbol)
+{
+  if(symbol < 144) writeCode(0x30 + symbol, 8);
+  else if(symbol < 256) writeCode(0x190 + symbol - 144, 9);
+  else if(symbol < 280) writeCode(symbol - 256, 7);
+  else writeCode(0xc0 + symbol - 280, 8);
+}
+
+
+void HTTP_Deflate::writeCode(uint16_t code, uint8_t length)
+{
+  uint16_t reversed = 0;
+  for(uint8_t i = 0; i < length; ++i){
+    reversed = (reversed << 1) | (code & 1);
+    code >>= 1;
+  }
+  writeBits(reversed, length);
+}
+
+
+void HTTP_Deflate::writeBits(uint32_t bits, uint8_t count)
+{
+  this->_bits |= bits << this->_bitsCount;
+  this->_bitsCount += count;
+  while(this->_bitsCount >= 8){
+    writeByte(this->_bits & 0xff);
+    this->_bits >>= 8;
+    this->_bitsCount -= 8;
+  }
+}
+
+
+void HTTP_Deflate::flushBits()
+{
+  if(this->_bitsCount > 0) writeByte(this->_bits & 0xff);
+  this->_bits = 0;
+  this->_bitsCount = 0;
+}
+
+
+void HTTP_Deflate::writeByte(uint8_t byte)
+{
+  if(this->_outputSize == sizeof(this->_output)) flushOutput();
+  this->_output[this->_outputSize++] = byte;
+}
+
+
+void HTTP_Deflate::flushOutput()
+{
+  if(this->_outputSize > 0) this->_sink(this->_output, this->_outputSize);
+  this->_outputSize = 0;
+}
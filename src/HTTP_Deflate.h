@@ -0,0 +1,61 @@
+/*
+ * This library provides HTTP_Deflate, the compressor HTTP_Response compresses bodies with when
+ * compression is enabled by the ArduinoExpress::Compress() middleware
+ */
+
+#ifndef HTTP_DEFLATE_HEADER
+#define HTTP_DEFLATE_HEADER
+
+#include "HTTP_Utilities.h"
+#include "InplaceFunction.h"
+
+// the Content-Encoding of a response body
+enum HTTP_Encoding : uint8_t {ENCODING_IDENTITY, ENCODING_GZIP, ENCODING_DEFLATE};
+
+// receives the compressed bytes as they are produced
+using HTTP_DeflateSink = InplaceFunction<void(const uint8_t*, size_t), 2 * sizeof(void*)>;
+
+
+/* HTTP_Deflate compresses a body in one pass into a gzip or zlib ("deflate") stream, passed to a
+  * sink a few bytes at a time, so the compressed body is never held in memory.
+  * It favours speed and memory over ratio: matches are found with a single probe of a hash table of
+  * positions, at most DEFLATE_WINDOW_SIZE bytes back, and coded with the fixed Huffman codes.
+  * The body is compressed from where it is, the compressor only holds the hash table.
+  * Responses are sent one at a time, they all share the compressor returned by shared()
+*/
+struct HTTP_Deflate{
+  private:
+    const static int HASH_BITS = ArduinoExpressConfig::DEFLATE_HASH_BITS;
+    const static size_t WINDOW_SIZE = ArduinoExpressConfig::DEFLATE_WINDOW_SIZE;
+    // the low 16 bits of the last position each hash was seen at
+    uint16_t _positions[1 << HASH_BITS];
+
+    HTTP_DeflateSink _sink;
+    uint32_t _bits = 0;  // bits not written yet, the first one in the lowest bit
+    uint8_t _bitsCount = 0;
+    uint8_t _output[64];
+    size_t _outputSize = 0;
+
+    void writeByte(uint8_t );
+    // writes the lowest count bits of bits, the lowest first
+    void writeBits(uint32_t, uint8_t);
+    // writes a Huffman code, whose first bit is its highest one
+    void writeCode(uint16_t, uint8_t);
+    // writes a literal or length symbol (0-287) with its fixed Huffman code
+    void writeSymbol(uint16_t );
+    void writeMatch(size_t length, size_t distance);
+    void flushBits();
+    void flushOutput();
+
+  public:
+    /* void compress(encoding, data, length, sink)
+      * compresses data into a gzip (ENCODING_GZIP) or zlib (ENCODING_DEFLATE) stream, written to sink
+      * */
+    void compress(HTTP_Encoding, const uint8_t*, size_t, HTTP_DeflateSink);
+
+    // HTTP_Deflate* shared()
+    // returns the compressor of the responses, allocated on the first call. Null if it's out of memory
+    static HTTP_Deflate* shared();
+};
+
+#endif
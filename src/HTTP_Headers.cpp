@@ -0,0 +1,144 @@
+#include "HTTP_Headers.h"
+
+// the canonical names of the well known headers, in the order of HTTP_HeaderId
+static const char NAME_OTHER[] PROGMEM = "";
+static const char NAME_ACCEPT[] PROGMEM = "Accept";
+static const char NAME_ACCEPT_ENCODING[] PROGMEM = "Accept-Encoding";
+static const char NAME_ACCEPT_LANGUAGE[] PROGMEM = "Accept-Language";
+static const char NAME_ACCEPT_RANGES[] PROGMEM = "Accept-Ranges";
+static const char NAME_AUTHORIZATION[] PROGMEM = "Authorization";
+static const char NAME_CACHE_CONTROL[] PROGMEM = "Cache-Control";
+static const char NAME_CONNECTION[] PROGMEM = "Connection";
+static const char NAME_CONTENT_ENCODING[] PROGMEM = "Content-Encoding";
+static const char NAME_CONTENT_LENGTH[] PROGMEM = "Content-Length";
+static const char NAME_CONTENT_RANGE[] PROGMEM = "Content-Range";
+static const char NAME_CONTENT_TYPE[] PROGMEM = "Content-Type";
+static const char NAME_COOKIE[] PROGMEM = "Cookie";
+static const char NAME_ETAG[] PROGMEM = "ETag";
+static const char NAME_EXPECT[] PROGMEM = "Expect";
+static const char NAME_HOST[] PROGMEM = "Host";
+static const char NAME_IF_MODIFIED_SINCE[] PROGMEM = "If-Modified-Since";
+static const char NAME_IF_NONE_MATCH[] PROGMEM = "If-None-Match";
+static const char NAME_LAST_MODIFIED[] PROGMEM = "Last-Modified";
+static const char NAME_LOCATION[] PROGMEM = "Location";
+static const char NAME_ORIGIN[] PROGMEM = "Origin";
+static const char NAME_RANGE[] PROGMEM = "Range";
+static const char NAME_REFERER[] PROGMEM = "Referer";
+static const char NAME_RETRY_AFTER[] PROGMEM = "Retry-After";
+static const char NAME_SET_COOKIE[] PROGMEM = "Set-Cookie";
+static const char NAME_TRANSFER_ENCODING[] PROGMEM = "Transfer-Encoding";
+static const char NAME_USER_AGENT[] PROGMEM = "User-Agent";
+static const char NAME_VARY[] PROGMEM = "Vary";
+
+struct HeaderName{
+  PGM_P name;
+  uint8_t length;
+};
+
+static const HeaderName HEADER_NAMES[HTTP_HEADER_IDS_COUNT] PROGMEM = {
+  {NAME_OTHER, sizeof(NAME_OTHER) - 1},
+  {NAME_ACCEPT, sizeof(NAME_ACCEPT) - 1},
+  {NAME_ACCEPT_ENCODING, sizeof(NAME_ACCEPT_ENCODING) - 1},
+  {NAME_ACCEPT_LANGUAGE, sizeof(NAME_ACCEPT_LANGUAGE) - 1},
+  {NAME_ACCEPT_RANGES, sizeof(NAME_ACCEPT_RANGES) - 1},
+  {NAME_AUTHORIZATION, sizeof(NAME_AUTHORIZATION) - 1},
+  {NAME_CACHE_CONTROL, sizeof(NAME_CACHE_CONTROL) - 1},
+  {NAME_CONNECTION, sizeof(NAME_CONNECTION) - 1},
+  {NAME_CONTENT_ENCODING, sizeof(NAME_CONTENT_ENCODING) - 1},
+  {NAME_CONTENT_LENGTH, sizeof(NAME_CONTENT_LENGTH) - 1},
+  {NAME_CONTENT_RANGE, sizeof(NAME_CONTENT_RANGE) - 1},
+  {NAME_CONTENT_TYPE, sizeof(NAME_CONTENT_TYPE) - 1},
+  {NAME_COOKIE, sizeof(NAME_COOKIE) - 1},
+  {NAME_ETAG, sizeof(NAME_ETAG) - 1},
+  {NAME_EXPECT, sizeof(NAME_EXPECT) - 1},
+  {NAME_HOST, sizeof(NAME_HOST) - 1},
+  {NAME_IF_MODIFIED_SINCE, sizeof(NAME_IF_MODIFIED_SINCE) - 1},
+  {NAME_IF_NONE_MATCH, sizeof(NAME_IF_NONE_MATCH) - 1},
+  {NAME_LAST_MODIFIED, sizeof(NAME_LAST_MODIFIED) - 1},
+  {NAME_LOCATION, sizeof(NAME_LOCATION) - 1},
+  {NAME_ORIGIN, sizeof(NAME_ORIGIN) - 1},
+  {NAME_RANGE, sizeof(NAME_RANGE) - 1},
+  {NAME_REFERER, sizeof(NAME_REFERER) - 1},
+  {NAME_RETRY_AFTER, sizeof(NAME_RETRY_AFTER) - 1},
+  {NAME_SET_COOKIE, sizeof(NAME_SET_COOKIE) - 1},
+  {NAME_TRANSFER_ENCODING, sizeof(NAME_TRANSFER_ENCODING) - 1},
+  {NAME_USER_AGENT, sizeof(NAME_USER_AGENT) - 1},
+  {NAME_VARY, sizeof(NAME_VARY) - 1},
+};
+
+
+HTTP_HeaderId toHeaderId(const char* name, size_t length)
+{
+  // the lengths are compared first, few names share a length
+  for(int id = 1; id < HTTP_HEADER_IDS_COUNT; ++id){
+    HeaderName headerName;
+    memcpy_P(&headerName, &HEADER_NAMES[id], sizeof(HeaderName));
+    if(headerName.length == length && strncasecmp_P(name, headerName.name, length) == 0){
+      return static_cast<HTTP_HeaderId>(id);
+    }
+  }
+
+  return HEADER_OTHER;
+}
+
+
+PGM_P headerName(HTTP_HeaderId id)
+{
+  if(id >= HTTP_HEADER_IDS_COUNT) id = HEADER_OTHER;
+  return (PGM_P)pgm_read_ptr(&HEADER_NAMES[id].name);
+}
+
+
+uint16_t headerHash(const char* name, size_t length)
+{
+  // FNV-1a of the lowercase name, folded to 16 bits
+  uint32_t hash = 2166136261u;
+  for(size_t i = 0; i < length; ++i){
+    // header names are ASCII, folded without the locale of tolower()
+    uint8_t c = (uint8_t)name[i];
+    if(c >= 'A' && c <= 'Z') c += 'a' - 'A';
+    hash ^= c;
+    hash *= 16777619u;
+  }
+
+  uint16_t folded = (uint16_t)(hash ^ (hash >> 16));
+  return folded == 0 ? 1 : folded;
+}
+
+
+// --------------------HTTP_HeaderIndex---------------------------------
+// ---------------------------------------------------------------------
+
+
+void HTTP_HeaderIndex::add(int slot, HTTP_HeaderId id, const char* name, size_t length)
+{
+  if(slot < 0 || slot >= MAX_HEADERS_COUNT) return;
+
+  this->_ids[slot] = id;
+  if(id != HEADER_OTHER){
+    this->_hashes[slot] = 0;
+    if(this->_slots[id] == -1) this->_slots[id] = slot;
+  }else{
+    this->_hashes[slot] = headerHash(name, length);
+  }
+}
+
+
+int HTTP_HeaderIndex::nextSlot(uint16_t hash, int from, int count) const
+{
+  for(int slot = from; slot < count; ++slot){
+    if(this->_hashes[slot] == hash) return slot;
+  }
+
+  return -1;
+}
+
+
+void HTTP_HeaderIndex::clear()
+{
+  for(int id = 0; id < HTTP_HEADER_IDS_COUNT; ++id) this->_slots[id] = -1;
+  for(int slot = 0; slot < MAX_HEADERS_COUNT; ++slot){
+    this->_ids[slot] = HEADER_OTHER;
+    this->_hashes[slot] = 0;
+  }
+}
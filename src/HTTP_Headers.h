@@ -0,0 +1,89 @@
+/*
+ * This library provides the header index of HTTP_Request and HTTP_Response: well known header names
+ * are interned into an HTTP_HeaderId, so looking them up doesn't compare any text
+ */
+
+#ifndef HTTP_HEADERS_HEADER
+#define HTTP_HEADERS_HEADER
+
+#include "HTTP_Utilities.h"
+
+// The header names used by the library and sent by most clients.
+// HEADER_OTHER is any other name, it is found by the hash of its name
+enum HTTP_HeaderId : uint8_t{
+  HEADER_OTHER = 0,
+  HEADER_ACCEPT,
+  HEADER_ACCEPT_ENCODING,
+  HEADER_ACCEPT_LANGUAGE,
+  HEADER_ACCEPT_RANGES,
+  HEADER_AUTHORIZATION,
+  HEADER_CACHE_CONTROL,
+  HEADER_CONNECTION,
+  HEADER_CONTENT_ENCODING,
+  HEADER_CONTENT_LENGTH,
+  HEADER_CONTENT_RANGE,
+  HEADER_CONTENT_TYPE,
+  HEADER_COOKIE,
+  HEADER_ETAG,
+  HEADER_EXPECT,
+  HEADER_HOST,
+  HEADER_IF_MODIFIED_SINCE,
+  HEADER_IF_NONE_MATCH,
+  HEADER_LAST_MODIFIED,
+  HEADER_LOCATION,
+  HEADER_ORIGIN,
+  HEADER_RANGE,
+  HEADER_REFERER,
+  HEADER_RETRY_AFTER,
+  HEADER_SET_COOKIE,
+  HEADER_TRANSFER_ENCODING,
+  HEADER_USER_AGENT,
+  HEADER_VARY,
+  HTTP_HEADER_IDS_COUNT
+};
+
+// HTTP_HeaderId toHeaderId(name, length)
+// returns the HTTP_HeaderId of a header name, ignoring case. HEADER_OTHER if it's not a well known name
+HTTP_HeaderId toHeaderId(const char* name, size_t length);
+
+// PGM_P headerName(id)
+// returns the canonical name of a well known header, in flash. Empty for HEADER_OTHER
+PGM_P headerName(HTTP_HeaderId id);
+
+// uint16_t headerHash(name, length)
+// returns a hash of a header name that ignores case. It's never 0
+uint16_t headerHash(const char* name, size_t length);
+
+
+/* The index of the headers of a request or response, kept next to the headers it indexes.
+  * A well known header is found from its HTTP_HeaderId in O(1). Any other header is found by
+  * comparing the hash of its name first, the owner of the headers then compares the names.
+  * When a header is repeated, the index finds the first one.
+*/
+struct HTTP_HeaderIndex{
+  private:
+    const static int MAX_HEADERS_COUNT = ArduinoExpressConfig::MAX_HEADERS_COUNT;
+    int8_t _slots[HTTP_HEADER_IDS_COUNT];  // the slot of each well known header, -1 if there's none
+    HTTP_HeaderId _ids[MAX_HEADERS_COUNT];  // the HTTP_HeaderId of the header in each slot
+    uint16_t _hashes[MAX_HEADERS_COUNT];  // the name hash of the header in each slot, 0 if it's well known
+
+  public:
+    HTTP_HeaderIndex() {clear();}
+
+    // void add(slot, id, name, length)
+    // indexes the header stored in slot
+    void add(int, HTTP_HeaderId, const char*, size_t);
+
+    // returns the slot of a well known header, -1 if it's not set
+    int slot(HTTP_HeaderId id) const {return this->_slots[id];}
+    HTTP_HeaderId id(int slot) const {return this->_ids[slot];}
+
+    // int nextSlot(hash, from, count)
+    // returns the first slot from `from` (below count) of a header which is not well known and has
+    // the given name hash, -1 if there's none
+    int nextSlot(uint16_t, int, int) const;
+
+    void clear();
+};
+
+#endif
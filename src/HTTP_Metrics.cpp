@@ -0,0 +1,73 @@
+#include "HTTP_Metrics.h"
+
+#if ARDUINOEXPRESS_METRICS
+
+static HTTP_MetricsClock _metricsClock = micros;
+
+// the slot 0 is for the requests no route handled
+static HTTP_RouteMetrics _metricsRoutes[ArduinoExpressConfig::MAX_METRICS_ROUTES_COUNT + 1];
+static int _metricsRoutesCount = 1;
+
+
+void setMetricsClock(HTTP_MetricsClock clock)
+{
+  _metricsClock = clock ? clock : micros;
+}
+
+
+unsigned long metricsNow()
+{
+  return _metricsClock();
+}
+
+
+void HTTP_Histogram::record(unsigned long duration)
+{
+  int bucket = 0;
+  while(bucket < ArduinoExpressConfig::METRICS_BUCKETS_COUNT && duration > ArduinoExpressConfig::METRICS_BUCKETS_US[bucket]) ++bucket;
+
+  ++this->buckets[bucket];
+  ++this->count;
+  this->sum += duration;
+}
+
+
+int metricsRoute(HTTP_Method method, const String& prefix, const String& path)
+{
+  for(int slot = 1; slot < _metricsRoutesCount; ++slot){
+    const HTTP_RouteMetrics& route = _metricsRoutes[slot];
+    if(route.method == method && route.path.length() == prefix.length() + path.length() &&
+       route.path.startsWith(prefix) && route.path.endsWith(path)) return slot;
+  }
+
+  if(_metricsRoutesCount > ArduinoExpressConfig::MAX_METRICS_ROUTES_COUNT){
+    logwarn("No metrics slot left for %s%s", prefix.c_str(), path.c_str());
+    return 0;
+  }
+
+  HTTP_RouteMetrics& route = _metricsRoutes[_metricsRoutesCount];
+  route.path = prefix + path;
+  route.method = method;
+  return _metricsRoutesCount++;
+}
+
+
+void recordMetrics(const HTTP_RequestMetrics& request, int status, size_t bytesOut)
+{
+  HTTP_RouteMetrics& route = _metricsRoutes[request.route];
+
+  ++route.requests;
+  if(status >= 100 && status < 600) ++route.statuses[status / 100 - 1];
+  route.bytesIn += request.bytesIn;
+  route.bytesOut += bytesOut;
+  for(int phase = 0; phase < METRICS_PHASES_COUNT; ++phase) route.phases[phase].record(request.phases[phase]);
+}
+
+
+const HTTP_RouteMetrics* metricsRoutes(int& count)
+{
+  count = _metricsRoutesCount;
+  return _metricsRoutes;
+}
+
+#endif
@@ -0,0 +1,70 @@
+/*
+ * This library provides the request metrics of ArduinoExpress: request, status and byte counters,
+ * and latency histograms of each route. They are only compiled with ARDUINOEXPRESS_METRICS
+ */
+
+#ifndef HTTP_METRICS_HEADER
+#define HTTP_METRICS_HEADER
+
+#include "HTTP_Utilities.h"
+
+#if ARDUINOEXPRESS_METRICS
+
+// the phases of serving a request that are timed:
+// parsing it, running the middlewares and routers, running the route's handler, writing to the client
+enum HTTP_MetricsPhase : uint8_t {PHASE_PARSE, PHASE_DISPATCH, PHASE_HANDLER, PHASE_SEND};
+const int METRICS_PHASES_COUNT = 4;
+
+// the clock the phases are timed with, in microseconds. It's micros() unless another one is set,
+// e.g. a fake clock in tests
+using HTTP_MetricsClock = unsigned long (*)();
+void setMetricsClock(HTTP_MetricsClock clock);
+unsigned long metricsNow();
+
+
+// what is measured while a request is served, before it's recorded in its route's metrics
+struct HTTP_RequestMetrics{
+  int route = 0;  // the metrics slot of the route that handled the request
+  unsigned long phases[METRICS_PHASES_COUNT] = {};  // the time spent in each phase
+  size_t bytesIn = 0;
+};
+
+
+struct HTTP_Histogram{
+  // the count of durations up to each bucket's bound, not cumulative. The last bucket is +Inf
+  uint32_t buckets[ArduinoExpressConfig::METRICS_BUCKETS_COUNT + 1] = {};
+  uint32_t count = 0;
+  uint64_t sum = 0; // microseconds
+
+  void record(unsigned long duration);
+};
+
+
+// the metrics of one route. The slot 0 counts the requests no route handled
+struct HTTP_RouteMetrics{
+  String path;  // the route's full path, with the prefix of its router
+  HTTP_Method method = static_cast<HTTP_Method>(0);
+  uint32_t requests = 0;
+  uint32_t statuses[5] = {};  // the responses by status class, 1xx to 5xx
+  uint32_t bytesIn = 0;
+  uint32_t bytesOut = 0;
+  HTTP_Histogram phases[METRICS_PHASES_COUNT];
+};
+
+
+// int metricsRoute(method, prefix, path)
+// returns the metrics slot of a route, and takes a slot for it the first time.
+// Returns 0 when every slot is taken
+int metricsRoute(HTTP_Method, const String&, const String& );
+
+// void recordMetrics(request, status, bytesOut)
+// adds a served request to the metrics of its route
+void recordMetrics(const HTTP_RequestMetrics&, int, size_t );
+
+// const HTTP_RouteMetrics* metricsRoutes(count)
+// returns the metrics of every route, count is set to the number of slots in use
+const HTTP_RouteMetrics* metricsRoutes(int& );
+
+#endif
+
+#endif
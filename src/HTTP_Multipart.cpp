@@ -0,0 +1,242 @@
+#include "HTTP_Multipart.h"
+#include "HTTP_Request.h"
+
+HTTP_StringView headerParameter(const HTTP_StringView& value, const char* name)
+{
+  size_t nameLength = strlen(name);
+  const char* text = value.c_str();
+  const char* end = text + value.length();
+
+  // the parameters follow the first ';'
+  const char* position = (const char*)memchr(text, ';', value.length());
+  while(position && position < end)
+  {
+    ++position;
+    while(position < end && (*position == ' ' || *position == '\t')) ++position;
+
+    const char* equals = position;
+    while(equals < end && *equals != '=' && *equals != ';') ++equals;
+    bool matches = (size_t)(equals - position) == nameLength && strncasecmp(position, name, nameLength) == 0;
+
+    const char* valueStart = equals < end && *equals == '=' ? equals + 1 : equals;
+    const char* valueEnd = valueStart;
+    if(valueStart < end && *valueStart == '"'){
+      ++valueStart;
+      valueEnd = (const char*)memchr(valueStart, '"', end - valueStart);
+      if(!valueEnd) valueEnd = end;
+    }
+    else{
+      while(valueEnd < end && *valueEnd != ';' && *valueEnd != ' ' && *valueEnd != '\t') ++valueEnd;
+    }
+
+    if(matches && equals < end && *equals == '=') return HTTP_StringView{valueStart, (size_t)(valueEnd - valueStart)};
+    position = valueEnd < end ? (const char*)memchr(valueEnd, ';', end - valueEnd) : nullptr;
+  }
+
+  return HTTP_StringView{};
+}
+
+
+bool HTTP_MultipartParser::begin(HTTP_Request& req, const HTTP_StringView& boundary, const HTTP_PartFunction& onPart)
+{
+  this->_req = &req;
+  this->_onPart = onPart;
+  this->_fieldsLength = 0;
+  this->_state = FAILED;
+  if(boundary.isEmpty() || boundary.length() > MAX_BOUNDARY_LENGTH) return false;
+
+  memcpy(this->_delimiter, "\r\n--", 4);
+  memcpy(this->_delimiter + 4, boundary.c_str(), boundary.length());
+  this->_delimiterLength = boundary.length() + 4;
+
+  // the first boundary starts the body, without the CRLF of the next ones: it's taken as matched
+  this->_matched = 2;
+  this->_state = PREAMBLE;
+  return true;
+}
+
+
+void HTTP_MultipartParser::feed(const uint8_t* data, size_t length)
+{
+  size_t i = 0;
+  while(i < length)
+  {
+    switch(this->_state)
+    {
+      case PREAMBLE:
+      case CONTENT:
+      {
+        if(this->_matched == 0){
+          // the delimiter starts with the only CR it holds: everything up to the next CR is content,
+          // and is found with memchr instead of a byte at a time
+          const uint8_t* cr = (const uint8_t*)memchr(data + i, '\r', length - i);
+          size_t end = cr ? cr - data : length;
+          if(end > i && this->_state == CONTENT) partData(data + i, end - i);
+          i = end;
+          if(!cr) break;
+          this->_matched = 1;
+          ++i;
+          break;
+        }
+
+        if(data[i] == (uint8_t)this->_delimiter[this->_matched]){
+          ++i;
+          if(++this->_matched == this->_delimiterLength){
+            this->_matched = 0;
+            if(this->_state == CONTENT) endPart();
+            this->_dashes = 0;
+            this->_state = BOUNDARY_END;
+          }
+          break;
+        }
+
+        // the bytes matched so far were content. The current byte is not consumed, it may start
+        // the delimiter again
+        if(this->_state == CONTENT) partData((const uint8_t*)this->_delimiter, this->_matched);
+        this->_matched = 0;
+        break;
+      }
+
+      case BOUNDARY_END:
+      {
+        // "--" after a boundary ends the body, CRLF starts a part. Whitespace may come before them
+        char c = data[i++];
+        if(c == '-'){
+          if(++this->_dashes == 2) this->_state = DONE;
+        }
+        else if(c == '\n' && this->_dashes == 0){
+          this->_lineLength = 0;
+          this->_lineTooLong = false;
+          this->_infoLength = 0;
+          this->_part = HTTP_FormPart{};
+          this->_state = HEADERS;
+        }
+        else if(c != '\r' && c != ' ' && c != '\t'){
+          fail("Invalid multipart boundary");
+        }
+        break;
+      }
+
+      case HEADERS:
+      {
+        char c = data[i++];
+        if(c == '\r') break;
+        if(c != '\n'){
+          if(this->_lineLength < MAX_PART_HEADER_LENGTH - 1) this->_line[this->_lineLength++] = c;
+          else this->_lineTooLong = true;
+          break;
+        }
+
+        // an empty line ends the headers. Lines that don't fit are ignored
+        if(this->_lineLength == 0){
+          if(this->_part.name.isEmpty()) fail("Multipart part without a name");
+          else beginPart();
+          break;
+        }
+        this->_line[this->_lineLength] = '\0';
+        if(!this->_lineTooLong) parseHeader();
+        this->_lineLength = 0;
+        this->_lineTooLong = false;
+        break;
+      }
+
+      case DONE:
+      case FAILED:
+        return;
+    }
+  }
+}
+
+
+void HTTP_MultipartParser::parseHeader()
+{
+  const char* colon = strchr(this->_line, ':');
+  if(!colon) return;
+
+  const char* value = colon + 1;
+  while(*value == ' ' || *value == '\t') ++value;
+  HTTP_StringView header{value, strlen(value)};
+  size_t nameLength = colon - this->_line;
+
+  if(nameLength == 19 && strncasecmp(this->_line, "Content-Disposition", 19) == 0){
+    this->_part.name = storeInfo(headerParameter(header, "name"));
+    this->_part.filename = storeInfo(headerParameter(header, "filename"));
+  }
+  else if(nameLength == 12 && strncasecmp(this->_line, "Content-Type", 12) == 0){
+    const char* end = (const char*)memchr(value, ';', header.length());
+    this->_part.contentType = storeInfo(HTTP_StringView{value, end ? (size_t)(end - value) : header.length()});
+  }
+}
+
+
+HTTP_StringView HTTP_MultipartParser::storeInfo(const HTTP_StringView& value)
+{
+  if(value.isEmpty() || this->_infoLength + value.length() + 1 > MAX_PART_HEADER_LENGTH) return HTTP_StringView{};
+
+  char* copy = this->_info + this->_infoLength;
+  memcpy(copy, value.c_str(), value.length());
+  copy[value.length()] = '\0';
+  this->_infoLength += value.length() + 1;
+  return HTTP_StringView{copy, value.length()};
+}
+
+
+void HTTP_MultipartParser::beginPart()
+{
+  this->_state = CONTENT;
+  this->_fieldStart = -1;
+  if(!this->_part.filename.isEmpty()) return;
+
+  // a field: its name is copied, its value follows
+  size_t nameLength = this->_part.name.length();
+  if(this->_fieldsLength + nameLength + 2 > MULTIPART_FIELDS_SIZE){
+    logwarn("Multipart field \"%s\" dropped, the fields are full", this->_part.name.c_str());
+    return;
+  }
+  this->_fieldStart = this->_fieldsLength;
+  memcpy(this->_fields + this->_fieldsLength, this->_part.name.c_str(), nameLength + 1);
+  this->_fieldsLength += nameLength + 1;
+  this->_fieldValue = this->_fieldsLength;
+}
+
+
+void HTTP_MultipartParser::partData(const uint8_t* data, size_t length)
+{
+  if(this->_onPart) this->_onPart(*this->_req, this->_part, data, length);
+  this->_part.offset += length;
+
+  if(this->_fieldStart == -1) return;
+  if(this->_fieldsLength + length + 1 > MULTIPART_FIELDS_SIZE){
+    logwarn("Multipart field \"%s\" dropped, the fields are full", this->_part.name.c_str());
+    this->_fieldsLength = this->_fieldStart;
+    this->_fieldStart = -1;
+    return;
+  }
+  memcpy(this->_fields + this->_fieldsLength, data, length);
+  this->_fieldsLength += length;
+}
+
+
+void HTTP_MultipartParser::endPart()
+{
+  this->_part.final = true;
+  if(this->_onPart) this->_onPart(*this->_req, this->_part, nullptr, 0);
+
+  if(this->_fieldStart == -1) return;
+  this->_fields[this->_fieldsLength] = '\0';
+  const char* name = this->_fields + this->_fieldStart;
+  const char* value = this->_fields + this->_fieldValue;
+  if(!this->_req->addField(HTTP_StringView{name, strlen(name)}, HTTP_StringView{value, (size_t)(this->_fieldsLength - this->_fieldValue)})){
+    this->_fieldsLength = this->_fieldStart;
+    return;
+  }
+  ++this->_fieldsLength;
+}
+
+
+void HTTP_MultipartParser::fail(const char* reason)
+{
+  (void)reason; // unused when warnings are not logged
+  logwarn("%s", reason);
+  this->_state = FAILED;
+}
@@ -0,0 +1,101 @@
+/*
+ * This library provides HTTP_MultipartParser, the multipart/form-data decoder of the
+ * ArduinoExpress::Form() middleware. Parts are streamed to a callback as the body arrives
+ */
+
+#ifndef HTTP_MULTIPART_HEADER
+#define HTTP_MULTIPART_HEADER
+
+#include "HTTP_Utilities.h"
+#include "InplaceFunction.h"
+
+struct HTTP_Request;
+
+// the part of a multipart body being received, passed with each piece of its content
+struct HTTP_FormPart{
+  HTTP_StringView name;         // the name of the form field
+  HTTP_StringView filename;     // empty if the part is not a file
+  HTTP_StringView contentType;  // empty if the part has no Content-Type
+  size_t offset = 0;            // the position in the part of the piece passed with this call
+  bool final = false;           // set on the last call of the part, whose piece is empty
+};
+
+// the callback parts are streamed to: it gets each piece of a part's content as it arrives
+using HTTP_PartFunction = InplaceFunction<void(HTTP_Request&, const HTTP_FormPart&, const uint8_t*, size_t),
+                                          ArduinoExpressConfig::PART_FUNCTION_STORAGE_SIZE>;
+
+// HTTP_StringView headerParameter(value, name)
+// returns the parameter name of a header value, e.g. the boundary of "multipart/form-data; boundary=x"
+// or the filename of a Content-Disposition, without its quotes. It's empty if there is none
+HTTP_StringView headerParameter(const HTTP_StringView& value, const char* name);
+
+
+/* HTTP_MultipartParser decodes a multipart/form-data body fed to it a piece at a time, without
+  * buffering it: the content of each part is passed to the part callback as soon as it's known not
+  * to be a boundary. The content of parts that are not files is also kept, up to
+  * MULTIPART_FIELDS_SIZE bytes for all of them, and added to the request's fields.
+  * A request allocates its parser on the first multipart body, see HTTP_Request::multipart()
+*/
+struct HTTP_MultipartParser{
+  private:
+    enum State : uint8_t {PREAMBLE, BOUNDARY_END, HEADERS, CONTENT, DONE, FAILED};
+
+    HTTP_Request* _req = nullptr;
+    HTTP_PartFunction _onPart;
+    State _state = DONE;
+
+    // "\r\n--" and the boundary. _matched bytes of it have been matched by the last bytes fed
+    const static int MAX_BOUNDARY_LENGTH = ArduinoExpressConfig::MAX_BOUNDARY_LENGTH;
+    char _delimiter[MAX_BOUNDARY_LENGTH + 4];
+    uint8_t _delimiterLength = 0;
+    uint8_t _matched = 0;
+    uint8_t _dashes = 0;  // the "-" read after a boundary, "--" ends the body
+
+    // the part header line being read, and the name, filename and content type of the part,
+    // each null-terminated
+    const static int MAX_PART_HEADER_LENGTH = ArduinoExpressConfig::MAX_PART_HEADER_LENGTH;
+    char _line[MAX_PART_HEADER_LENGTH];
+    uint16_t _lineLength = 0;
+    bool _lineTooLong = false;
+    char _info[MAX_PART_HEADER_LENGTH];
+    uint16_t _infoLength = 0;
+    HTTP_FormPart _part;
+
+    // the names and values of the fields, each null-terminated. _fieldStart is the start of the
+    // field being received, -1 if it's a file or doesn't fit
+    const static int MULTIPART_FIELDS_SIZE = ArduinoExpressConfig::MULTIPART_FIELDS_SIZE;
+    char _fields[MULTIPART_FIELDS_SIZE];
+    int _fieldsLength = 0;
+    int _fieldStart = -1;
+    int _fieldValue = 0;
+
+    // void parseHeader()
+    // reads the name, filename or content type of the part from the header line
+    void parseHeader();
+
+    // HTTP_StringView storeInfo(value)
+    // copies value to the part's info, returns the copy
+    HTTP_StringView storeInfo(const HTTP_StringView& );
+
+    void beginPart();
+    void partData(const uint8_t* data, size_t length);
+    void endPart();
+    void fail(const char* reason);
+
+  public:
+    /* bool begin(req, boundary, onPart)
+      * starts on a body, whose parts are passed to onPart (which can be null) and whose fields are
+      * added to req. Returns false if the boundary is empty or too long
+      * */
+    bool begin(HTTP_Request&, const HTTP_StringView&, const HTTP_PartFunction&);
+
+    // void feed(data, length)
+    // decodes the next piece of the body
+    void feed(const uint8_t*, size_t);
+
+    // the closing boundary was read, parts that follow it are ignored
+    bool done() const {return this->_state == DONE;}
+    bool failed() const {return this->_state == FAILED;}
+};
+
+#endif
@@ -0,0 +1,410 @@
+#include "HTTP_Parser.h"
+
+void HTTP_RequestParser::begin(HTTP_Request& req)
+{
+  this->_req = &req;
+  this->_size = 0;
+  this->_lineStart = 0;
+  this->_lineLength = 0;
+  this->_bodyStart = 0;
+  this->_state = REQUEST_LINE;
+  this->_errorStatus = 0;
+  this->_chunked = false;
+  this->_keepAlive = false;
+  this->_hasContentLength = false;
+  this->_cr = false;
+  this->_chunkExtension = false;
+  this->_contentLength = 0;
+  this->_remaining = 0;
+  this->_bodyLength = 0;
+  this->_streamed = false;
+}
+
+
+bool HTTP_RequestParser::fail(int status)
+{
+  this->_state = ERROR;
+  this->_errorStatus = status;
+  return false;
+}
+
+
+bool HTTP_RequestParser::checkLineByte(char c)
+{
+  // a CR is only allowed right before the LF that ends a line
+  if(c == '\0' || (this->_cr && c != '\n')) return fail(400);
+  this->_cr = c == '\r';
+  return true;
+}
+
+
+bool HTTP_RequestParser::storeLineByte(char c, size_t maxLength, int overflowStatus)
+{
+  // lines end at LF, the CR before it is dropped. checkLineByte() made sure the LF follows
+  if(c == '\r') return false;
+
+  if(c == '\n'){
+    this->_buffer[this->_size++] = '\0';
+    return true;
+  }
+
+  // room is always kept for the line's null terminator, and for the one of an empty body
+  if(this->_size - this->_lineStart >= maxLength || this->_size + 2 >= REQUEST_BUFFER_SIZE){
+    return fail(overflowStatus);
+  }
+
+  this->_buffer[this->_size++] = c;
+  return false;
+}
+
+
+void HTTP_RequestParser::parseRequestLine()
+{
+  char* line = this->_buffer + this->_lineStart;
+
+  // empty lines before the request line are ignored
+  if(line[0] == '\0'){
+    this->_size = this->_lineStart;
+    return;
+  }
+
+  // METHOD SP TARGET SP VERSION
+  char* methodEnd = strchr(line, ' ');
+  if(!methodEnd || methodEnd == line){
+    fail(400);
+    return;
+  }
+
+  char* route = methodEnd + 1;
+  char* routeEnd = strchr(route, ' ');
+  if(!routeEnd || routeEnd == route){
+    fail(400);
+    return;
+  }
+
+  char* version = routeEnd + 1;
+  if(strncmp(version, "HTTP/1.", 7) != 0){
+    fail(400);
+    return;
+  }
+
+  *methodEnd = '\0';
+  *routeEnd = '\0';
+
+  // the query string is split from the route
+  char* query = strchr(route, '?');
+  if(query){
+    *query = '\0';
+    if(!parseQuery(query + 1)) return;
+  }
+
+  this->_req->method = HTTP_StringView{line, (size_t)(methodEnd - line)};
+  this->_req->route = HTTP_StringView{route, strlen(route)};
+  this->_req->version = HTTP_StringView{version, strlen(version)};
+  this->_keepAlive = this->_req->version.equals("HTTP/1.1");
+
+  if(!copyPathSegments()) return;
+
+  this->_lineStart = this->_size;
+  this->_state = HEADER_LINE;
+}
+
+
+bool HTTP_RequestParser::parseQuery(char* query)
+{
+  // the decoded parameters can't tell "a=1%26b=2" from "a=1&b=2", and drop those that don't fit
+  size_t length = strlen(query);
+  if(this->_size + length + 2 >= REQUEST_BUFFER_SIZE) return fail(414);
+  char* rawQuery = this->_buffer + this->_size;
+  memcpy(rawQuery, query, length + 1);
+  this->_size += length + 1;
+  this->_req->rawQuery = HTTP_StringView{rawQuery, length};
+
+  this->_req->queryCount = parseUrlEncoded(query, this->_req->query, this->_req->queryCount, this->_req->MAX_QUERY_COUNT);
+  return true;
+}
+
+
+bool HTTP_RequestParser::copyPathSegments()
+{
+  const char* route = this->_req->route.c_str();
+  size_t start = this->_size;
+
+  while(*route)
+  {
+    while(*route == '/') ++route;
+    if(!*route) break;
+
+    const char* segmentEnd = strchr(route, '/');
+    size_t length = segmentEnd ? segmentEnd - route : strlen(route);
+
+    if(this->_size + length + 2 >= REQUEST_BUFFER_SIZE) return fail(414);
+    char* segment = this->_buffer + this->_size;
+    memcpy(segment, route, length);
+    segment[length] = '\0';
+    this->_size += percentDecode(segment, false) + 1;
+
+    route += length;
+  }
+
+  this->_req->pathSegments = HTTP_StringView{this->_buffer + start, this->_size - start};
+  this->_lineStart = this->_size;
+  return true;
+}
+
+
+void HTTP_RequestParser::parseHeaderLine()
+{
+  char* line = this->_buffer + this->_lineStart;
+
+  // an empty line ends the headers
+  if(line[0] == '\0'){
+    endHeaders();
+    return;
+  }
+
+  // obsolete line folding is not supported, nor whitespace between the name and the colon
+  // (RFC 9112 5.1): "Content-Length : 5" would not be read as the framing header
+  char* colon = strchr(line, ':');
+  if(line[0] == ' ' || line[0] == '\t' || !colon || colon == line || colon[-1] == ' ' || colon[-1] == '\t'){
+    fail(400);
+    return;
+  }
+
+  if(this->_req->headersCount >= this->_req->MAX_HEADERS_COUNT){
+    fail(431);
+    return;
+  }
+
+  *colon = '\0';
+  char* value = colon + 1;
+  while(*value == ' ' || *value == '\t') ++value;
+  char* valueEnd = this->_buffer + this->_size - 1;
+  while(valueEnd > value && (valueEnd[-1] == ' ' || valueEnd[-1] == '\t')) --valueEnd;
+  *valueEnd = '\0';
+
+  int slot = this->_req->headersCount++;
+  HTTP_HeaderView& header = this->_req->headers[slot];
+  header.key = HTTP_StringView{line, (size_t)(colon - line)};
+  header.value = HTTP_StringView{value, (size_t)(valueEnd - value)};
+
+  HTTP_HeaderId id = toHeaderId(header.key.c_str(), header.key.length());
+  this->_req->headerIndex.add(slot, id, header.key.c_str(), header.key.length());
+
+  // the framing headers decide how the body is read. A request framed twice, or in two ways, is
+  // rejected: a proxy in front of the server could read it differently (request smuggling)
+  if(id == HEADER_CONTENT_LENGTH){
+    if(this->_hasContentLength || this->_chunked){
+      fail(400);
+      return;
+    }
+    this->_hasContentLength = true;
+    if(header.value.isEmpty() || header.value.length() > 9){
+      fail(header.value.isEmpty() ? 400 : 413);
+      return;
+    }
+    for(size_t i = 0; i < header.value.length(); ++i){
+      if(!isdigit((unsigned char)header.value[i])){
+        fail(400);
+        return;
+      }
+    }
+    this->_contentLength = header.value.toInt();
+  }
+  else if(id == HEADER_TRANSFER_ENCODING){
+    if(this->_hasContentLength || this->_chunked){
+      fail(400);
+      return;
+    }
+    if(!header.value.equalsIgnoreCase("chunked")){
+      fail(501);
+      return;
+    }
+    this->_chunked = true;
+  }
+  else if(id == HEADER_CONNECTION){
+    if(header.value.containsToken("close")) this->_keepAlive = false;
+    else if(header.value.containsToken("keep-alive")) this->_keepAlive = true;
+  }
+
+  this->_lineStart = this->_size;
+}
+
+
+void HTTP_RequestParser::endHeaders()
+{
+  // drop the empty line
+  this->_size = this->_lineStart;
+  this->_bodyStart = this->_size;
+
+  if(this->_chunked){
+    this->_state = CHUNK_SIZE;
+    this->_remaining = 0;
+    this->_lineLength = 0;
+    this->_chunkExtension = false;
+  }
+  else if(this->_contentLength > 0){
+    if(this->_maxBodySize > 0 && this->_contentLength > this->_maxBodySize){
+      fail(413);
+      return;
+    }
+    this->_remaining = this->_contentLength;
+    if(this->_contentLength >= REQUEST_BUFFER_SIZE - this->_size) startStream(BODY);
+    else this->_state = BODY;
+  }
+  else{
+    endBody();
+  }
+}
+
+
+void HTTP_RequestParser::startStream(State state)
+{
+  this->_streamed = true;
+  this->_streamState = state;
+  this->_state = STREAM_START;
+  this->_req->bodyStreamed = true;
+}
+
+
+void HTTP_RequestParser::streamBody()
+{
+  if(this->_state != STREAM_START) return;
+
+  // a chunked body is only streamed once it outgrows the buffer, its first chunks are buffered
+  if(this->_size > this->_bodyStart){
+    this->_req->streamData((const uint8_t*)this->_buffer + this->_bodyStart, this->_size - this->_bodyStart);
+    this->_size = this->_bodyStart;
+  }
+  this->_state = this->_streamState;
+}
+
+
+void HTTP_RequestParser::readBody(const char* data, size_t length)
+{
+  if(this->_streamed){
+    this->_req->streamData((const uint8_t*)data, length);
+  }else{
+    memcpy(this->_buffer + this->_size, data, length);
+    this->_size += length;
+  }
+  this->_bodyLength += length;
+}
+
+
+void HTTP_RequestParser::endBody()
+{
+  this->_buffer[this->_size] = '\0';
+  this->_req->body = HTTP_StringView{this->_buffer + this->_bodyStart, this->_size - this->_bodyStart};
+  this->_state = COMPLETE;
+}
+
+
+size_t HTTP_RequestParser::feed(const char* data, size_t length)
+{
+  size_t i = 0;
+  while(i < length && this->_state != COMPLETE && this->_state != ERROR && this->_state != STREAM_START)
+  {
+    char c = data[i];
+    if(this->_state != BODY && this->_state != CHUNK_DATA && !checkLineByte(c)) break;
+
+    switch(this->_state){
+      case REQUEST_LINE:
+        ++i;
+        if(storeLineByte(c, MAX_REQUEST_LINE_LENGTH, 414)) parseRequestLine();
+        break;
+
+      case HEADER_LINE:
+        ++i;
+        if(storeLineByte(c, MAX_HEADER_LINE_LENGTH, 431)) parseHeaderLine();
+        break;
+
+      case BODY:
+      case CHUNK_DATA:
+      {
+        size_t count = length - i < this->_remaining ? length - i : this->_remaining;
+        readBody(data + i, count);
+        this->_remaining -= count;
+        i += count;
+
+        if(this->_remaining == 0){
+          if(this->_state == BODY) endBody();
+          else this->_state = CHUNK_DATA_END;
+        }
+        break;
+      }
+
+      case CHUNK_SIZE:
+        // hex digits, optionally followed by ";extensions" which are ignored. The line, extensions
+        // included, is at most MAX_HEADER_LINE_LENGTH
+        ++i;
+        if(c == '\r') break;
+        if(c == '\n' || c == ';' || c == ' ' || c == '\t'){
+          if(this->_lineLength == 0){
+            fail(400);
+          }
+          else if(c != '\n'){
+            this->_chunkExtension = true;
+            if(++this->_lineLength > MAX_HEADER_LINE_LENGTH) fail(400);
+          }
+          else if(this->_remaining == 0){
+            this->_state = TRAILER;
+            this->_lineLength = 0;
+          }
+          else if(this->_maxBodySize > 0 && this->_bodyLength + this->_remaining > this->_maxBodySize){
+            fail(413);
+          }
+          else if(!this->_streamed && this->_size + this->_remaining >= REQUEST_BUFFER_SIZE){
+            startStream(CHUNK_DATA);
+          }
+          else{
+            this->_state = CHUNK_DATA;
+          }
+        }
+        else if(this->_chunkExtension){
+          // inside the chunk extensions
+          if(++this->_lineLength > MAX_HEADER_LINE_LENGTH) fail(400);
+        }
+        else if(isxdigit((unsigned char)c) && this->_lineLength < 8){
+          this->_remaining = this->_remaining * 16 + (isdigit((unsigned char)c) ? c - '0' : (tolower((unsigned char)c) - 'a' + 10));
+          ++this->_lineLength;
+        }
+        else{
+          fail(isxdigit((unsigned char)c) ? 413 : 400);
+        }
+        break;
+
+      case CHUNK_DATA_END:
+        ++i;
+        if(c == '\r') break;
+        if(c == '\n'){
+          this->_state = CHUNK_SIZE;
+          this->_remaining = 0;
+          this->_lineLength = 0;
+          this->_chunkExtension = false;
+        }
+        else{
+          fail(400);
+        }
+        break;
+
+      case TRAILER:
+        // trailer fields are read and discarded, an empty line ends the request
+        ++i;
+        if(c == '\r') break;
+        if(c == '\n'){
+          if(this->_lineLength == 0) endBody();
+          this->_lineLength = 0;
+        }
+        else if(++this->_lineLength > MAX_HEADER_LINE_LENGTH){
+          fail(431);
+        }
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  return i;
+}
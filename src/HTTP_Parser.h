@@ -0,0 +1,133 @@
+/*
+ * This library provides an incremental parser that fills an HTTP_Request from the bytes of a connection
+ */
+
+#ifndef HTTP_PARSER_HEADER
+#define HTTP_PARSER_HEADER
+
+#include "HTTP_Request.h"
+
+/* The HTTP_RequestParser is a resumable state machine that is fed the bytes of a request as they
+  * arrive, in segments of any size. The request line, the headers and the body (Content-Length or
+  * chunked) are copied into a fixed buffer owned by the parser, and the fields of the HTTP_Request
+  * are set as views into it. Nothing is allocated while parsing.
+  * A body that doesn't fit in the buffer is streamed: the parser stops at STREAM_START, once the
+  * headers are read, so the request can be routed. After streamBody(), the body is passed to the
+  * request's onData() consumer as it's fed, instead of being copied.
+  *
+  * The framing is strict (RFC 9112): a request with both Content-Length and Transfer-Encoding, or
+  * with several Content-Length headers, is rejected with 400, like a NUL byte or a bare CR in its head.
+  *
+  * A parser belongs to one connection. begin() attaches it to the request it should fill, and must
+  * be called before each request on the connection.
+*/
+struct HTTP_RequestParser{
+  enum State : uint8_t {
+    REQUEST_LINE, HEADER_LINE, BODY,
+    CHUNK_SIZE, CHUNK_DATA, CHUNK_DATA_END, TRAILER,
+    STREAM_START, COMPLETE, ERROR
+  };
+
+  private:
+    const static int REQUEST_BUFFER_SIZE = ArduinoExpressConfig::REQUEST_BUFFER_SIZE;
+    const static int MAX_REQUEST_LINE_LENGTH = ArduinoExpressConfig::MAX_REQUEST_LINE_LENGTH;
+    const static int MAX_HEADER_LINE_LENGTH = ArduinoExpressConfig::MAX_HEADER_LINE_LENGTH;
+
+    char _buffer[REQUEST_BUFFER_SIZE];
+    size_t _size = 0;       // number of bytes used in _buffer
+    size_t _lineStart = 0;  // offset in _buffer of the line being read
+    size_t _lineLength = 0; // length of a line that is not stored in _buffer (chunk sizes, trailers)
+    size_t _bodyStart = 0;
+
+    State _state = REQUEST_LINE;
+    int _errorStatus = 0;
+
+    bool _chunked = false;
+    bool _keepAlive = false;
+    bool _hasContentLength = false;
+    bool _cr = false;       // the last byte of the line being read was a CR
+    bool _chunkExtension = false; // the extensions of a chunk size line are being skipped
+    size_t _contentLength = 0;
+    size_t _remaining = 0;  // bytes left in the body or in the current chunk
+
+    size_t _maxBodySize = ArduinoExpressConfig::MAX_BODY_SIZE;
+    size_t _bodyLength = 0; // bytes of the body received so far
+    bool _streamed = false;
+    State _streamState = BODY; // the state streamBody() resumes in
+
+    HTTP_Request* _req = nullptr;
+
+    // bool fail(status)
+    // stops the parser, status is the response the client should get. Always returns false
+    bool fail(int );
+
+    // bool checkLineByte(c)
+    // fails with 400 on a byte that can't be in the head or the chunk lines of a request: a NUL,
+    // or a CR that isn't followed by LF. Returns false if it failed
+    bool checkLineByte(char);
+
+    // bool storeLineByte(c, maxLength, overflowStatus)
+    // appends c to the line being read. Returns true once the line is complete, and null-terminated
+    bool storeLineByte(char, size_t, int);
+
+    void parseRequestLine();
+
+    // bool parseQuery(query)
+    // appends the query string as it was sent to the buffer, then splits it into the request's
+    // query parameters, decoding them in place. Returns false if it doesn't fit
+    bool parseQuery(char* );
+
+    // bool copyPathSegments()
+    // appends the decoded segments of the route to the buffer, for the route parameters
+    bool copyPathSegments();
+    void parseHeaderLine();
+    void endHeaders();
+    void endBody();
+
+    // void startStream(state)
+    // stops at STREAM_START, the body is read in state once streamBody() is called
+    void startStream(State );
+
+    // void readBody(data, length)
+    // copies bytes of the body to the buffer, or passes them to the request's consumer if it's streamed
+    void readBody(const char*, size_t);
+
+  public:
+    // void begin(req)
+    // resets the parser and attaches it to the request it should fill
+    void begin(HTTP_Request& );
+
+    // size_t feed(data, length)
+    // parses the next bytes of the request. Returns the number of bytes consumed, which is less than
+    // length once the request is complete: the rest belongs to the next request on the connection
+    size_t feed(const char*, size_t);
+
+    // void streamBody()
+    // resumes a parser stopped at STREAM_START. The part of the body already in the buffer is passed
+    // to the request's consumer first
+    void streamBody();
+
+    // bodies larger than maxBodySize are failed with 413, 0 for no limit
+    void setMaxBodySize(size_t maxBodySize) {this->_maxBodySize = maxBodySize;}
+
+    State state() const {return this->_state;}
+    bool complete() const {return this->_state == COMPLETE;}
+    bool failed() const {return this->_state == ERROR;}
+    bool streamStart() const {return this->_state == STREAM_START;}
+    bool streamed() const {return this->_streamed;}
+    // returns true once the request line and the headers are read, the body may not be
+    bool headersParsed() const {return this->_state > HEADER_LINE && this->_state != ERROR;}
+
+    // returns true if the client asked for the connection to be kept open after this request.
+    // HTTP/1.1 connections are persistent unless "Connection: close" is sent,
+    // HTTP/1.0 connections only with "Connection: keep-alive"
+    bool keepAlive() const {return this->_keepAlive;}
+
+    // returns true if part of a request has been received
+    bool started() const {return this->_size > 0 || this->_state != REQUEST_LINE;}
+
+    // the status the request should be answered with if the parser failed. e.g. 400, 413, 431
+    int errorStatus() const {return this->_errorStatus;}
+};
+
+#endif
@@ -0,0 +1,290 @@
+#include "HTTP_PosixTransport.h"
+
+#if ARDUINOEXPRESS_POSIX_TRANSPORT
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/sockios.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// ssize_t sendAvailable(socket, data, length)
+// sends as much of data as the socket takes without waiting. Returns the bytes sent, -1 if the
+// client is gone
+static ssize_t sendAvailable(int socket, const uint8_t* data, size_t length)
+{
+  size_t sent = 0;
+  while(sent < length)
+  {
+    ssize_t count = send(socket, data + sent, length - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if(count > 0) sent += count;
+    else if(count == -1 && errno == EINTR) continue;
+    else if(count == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+    else return -1;
+  }
+  return sent;
+}
+
+HTTP_PosixTransport::HTTP_PosixTransport()
+{
+  for(int i = 0; i < MAX_CONNECTIONS_COUNT; ++i) this->_sockets[i] = -1;
+}
+
+
+HTTP_PosixTransport::~HTTP_PosixTransport()
+{
+  end();
+}
+
+
+void HTTP_PosixTransport::end()
+{
+  for(int i = 0; i < MAX_CONNECTIONS_COUNT; ++i){
+    if(this->_sockets[i] != -1) stop(i);
+  }
+  if(this->_epoll != -1) close(this->_epoll);
+  if(this->_listener != -1) close(this->_listener);
+  this->_epoll = this->_listener = -1;
+  this->_listening = false;
+}
+
+
+bool HTTP_PosixTransport::begin(int port)
+{
+  // begin() can be called again, to move to another port: the previous sockets are closed first
+  end();
+
+  this->_listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if(this->_listener == -1){
+    logerr("Could not create the server socket: %s", strerror(errno));
+    return false;
+  }
+
+  int reuse = 1;
+  setsockopt(this->_listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port = htons(port);
+  if(bind(this->_listener, (sockaddr*)&address, sizeof(address)) == -1 ||
+     ::listen(this->_listener, ArduinoExpressConfig::LISTEN_BACKLOG) == -1){
+    logerr("Could not listen on port %d: %s", port, strerror(errno));
+    end();
+    return false;
+  }
+
+  this->_epoll = epoll_create1(EPOLL_CLOEXEC);
+  if(this->_epoll == -1){
+    logerr("Could not create the epoll set: %s", strerror(errno));
+    end();
+    return false;
+  }
+  watchListener(true);
+  return true;
+}
+
+
+void HTTP_PosixTransport::watchListener(bool listening)
+{
+  if(listening == this->_listening) return;
+
+  // the slots are the clients' data, the listener's is -1
+  epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.u32 = (uint32_t)-1;
+  epoll_ctl(this->_epoll, listening ? EPOLL_CTL_ADD : EPOLL_CTL_DEL, this->_listener, &event);
+  this->_listening = listening;
+}
+
+
+bool HTTP_PosixTransport::accept(int slot)
+{
+  if(this->_listener == -1) return false;
+
+  sockaddr_in address = {};
+  socklen_t addressLength = sizeof(address);
+  int client = accept4(this->_listener, (sockaddr*)&address, &addressLength, SOCK_NONBLOCK | SOCK_CLOEXEC);
+  if(client == -1){
+    if(errno != EAGAIN && errno != EWOULDBLOCK) logwarn("Could not accept a client: %s", strerror(errno));
+    return false;
+  }
+
+  // responses are already written in whole buffers
+  int noDelay = 1;
+  setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+  epoll_event event = {};
+  event.events = EPOLLIN | EPOLLRDHUP;
+  event.data.u32 = slot;
+  epoll_ctl(this->_epoll, EPOLL_CTL_ADD, client, &event);
+
+  this->_sockets[slot] = client;
+  this->_addresses[slot] = address.sin_family == AF_INET ? address.sin_addr.s_addr : 0;
+  return true;
+}
+
+
+int HTTP_PosixTransport::available(int slot)
+{
+  int count = 0;
+  if(this->_sockets[slot] == -1 || ioctl(this->_sockets[slot], FIONREAD, &count) == -1) return 0;
+  return count;
+}
+
+
+int HTTP_PosixTransport::read(int slot, uint8_t* data, size_t length)
+{
+  if(this->_sockets[slot] == -1) return 0;
+  ssize_t count = recv(this->_sockets[slot], data, length, 0);
+  return count > 0 ? count : 0;
+}
+
+
+size_t HTTP_PosixTransport::write(int slot, const uint8_t* data, size_t length)
+{
+  int socket = this->_sockets[slot];
+  if(socket == -1) return 0;
+
+  // the bytes go after the ones still buffered
+  Output& output = this->_outputs[slot];
+  size_t written = 0;
+  if(output.offset == output.size){
+    ssize_t count = sendAvailable(socket, data, length);
+    if(count == -1) return 0;
+    written = count;
+  }
+  if(written == length) return length;
+
+  // the client is slower than the response: the rest is sent as its socket drains
+  size_t remaining = length - written;
+  if(output.size + remaining > output.capacity){
+    size_t capacity = output.capacity ? output.capacity : 4096;
+    while(capacity < output.size + remaining) capacity *= 2;
+    uint8_t* grown = (uint8_t*)realloc(output.data, capacity);
+    if(!grown){
+      logerr("Not enough memory for the output of a client");
+      return written;
+    }
+    output.data = grown;
+    output.capacity = capacity;
+  }
+  memcpy(output.data + output.size, data + written, remaining);
+  output.size += remaining;
+  watchOutput(slot, true);
+  return length;
+}
+
+
+int HTTP_PosixTransport::availableForWrite(int slot)
+{
+  int socket = this->_sockets[slot];
+  if(socket == -1 || sending(slot)) return 0;
+
+  // the room left in the socket's send buffer
+  int capacity = 0, queued = 0;
+  socklen_t length = sizeof(capacity);
+  if(getsockopt(socket, SOL_SOCKET, SO_SNDBUF, &capacity, &length) == -1 || ioctl(socket, SIOCOUTQ, &queued) == -1) return 0;
+  return capacity > queued ? capacity - queued : 0;
+}
+
+
+bool HTTP_PosixTransport::sending(int slot)
+{
+  flush(slot);
+  return this->_outputs[slot].offset < this->_outputs[slot].size;
+}
+
+
+void HTTP_PosixTransport::flush(int slot)
+{
+  Output& output = this->_outputs[slot];
+  if(this->_sockets[slot] == -1 || output.offset == output.size) return;
+
+  ssize_t count = sendAvailable(this->_sockets[slot], output.data + output.offset, output.size - output.offset);
+  output.offset = count == -1 ? output.size : output.offset + count;
+  if(output.offset < output.size) return;
+
+  bool shutdown = output.shutdown;
+  watchOutput(slot, false);
+  dropOutput(slot);
+  if(shutdown) ::shutdown(this->_sockets[slot], SHUT_WR);
+}
+
+
+void HTTP_PosixTransport::watchOutput(int slot, bool watched)
+{
+  Output& output = this->_outputs[slot];
+  if(watched == output.watched) return;
+
+  epoll_event event = {};
+  event.events = watched ? EPOLLIN | EPOLLRDHUP | EPOLLOUT : EPOLLIN | EPOLLRDHUP;
+  event.data.u32 = slot;
+  epoll_ctl(this->_epoll, EPOLL_CTL_MOD, this->_sockets[slot], &event);
+  output.watched = watched;
+}
+
+
+void HTTP_PosixTransport::dropOutput(int slot)
+{
+  free(this->_outputs[slot].data);
+  this->_outputs[slot] = Output{};
+}
+
+
+bool HTTP_PosixTransport::connected(int slot)
+{
+  int socket = this->_sockets[slot];
+  if(socket == -1) return false;
+
+  // a closed socket reads 0 bytes, an open one has nothing to read yet or some bytes
+  uint8_t byte;
+  ssize_t count = recv(socket, &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+  return count > 0 || (count == -1 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR));
+}
+
+
+void HTTP_PosixTransport::stop(int slot)
+{
+  if(this->_sockets[slot] == -1) return;
+  // closing the socket removes it from the epoll set
+  dropOutput(slot);
+  close(this->_sockets[slot]);
+  this->_sockets[slot] = -1;
+}
+
+
+void HTTP_PosixTransport::shutdown(int slot)
+{
+  if(this->_sockets[slot] == -1) return;
+
+  // the end of the stream follows the buffered output
+  Output& output = this->_outputs[slot];
+  if(output.offset < output.size) output.shutdown = true;
+  else ::shutdown(this->_sockets[slot], SHUT_WR);
+}
+
+
+void HTTP_PosixTransport::wait(unsigned long timeout)
+{
+  if(this->_epoll == -1) return;
+
+  bool full = true;
+  for(int i = 0; i < MAX_CONNECTIONS_COUNT && full; ++i) full = this->_sockets[i] != -1;
+  watchListener(!full);
+
+  // the events are level-triggered: the connections are all polled after waiting, the events
+  // only end the wait. The sockets that have room for their buffered output are sent it
+  epoll_event events[MAX_CONNECTIONS_COUNT + 1];
+  int count = epoll_wait(this->_epoll, events, MAX_CONNECTIONS_COUNT + 1, timeout);
+  for(int i = 0; i < count; ++i){
+    if(events[i].data.u32 != (uint32_t)-1 && (events[i].events & (EPOLLOUT | EPOLLERR | EPOLLHUP))) flush(events[i].data.u32);
+  }
+}
+
+#endif
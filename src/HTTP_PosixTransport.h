@@ -0,0 +1,83 @@
+/*
+ * This library provides HTTP_PosixTransport, the transport of ArduinoExpress on Linux, built with
+ * ARDUINOEXPRESS_POSIX_TRANSPORT. The same routes can then be served by a device and by a gateway
+ */
+
+#ifndef HTTP_POSIX_TRANSPORT_HEADER
+#define HTTP_POSIX_TRANSPORT_HEADER
+
+#include "HTTP_Transport.h"
+
+#if ARDUINOEXPRESS_POSIX_TRANSPORT
+
+/* HTTP_PosixTransport serves TCP clients with non-blocking sockets. wait() blocks in epoll until a
+  * client connects or sends bytes, so listen() doesn't spin while there is nothing to do. While every
+  * slot is taken, new clients wait in the listen backlog (LISTEN_BACKLOG) and don't wake it.
+  * A write never waits for a slow client: what its socket doesn't take is buffered for its slot,
+  * and sent as the socket drains, by wait() and by sending(). The connection waits for it before
+  * reading the client's next request or closing it
+*/
+struct HTTP_PosixTransport : public HTTP_Transport{
+  private:
+    const static int MAX_CONNECTIONS_COUNT = ArduinoExpressConfig::MAX_CONNECTIONS_COUNT;
+    int _listener = -1;
+    int _epoll = -1;
+    bool _listening = false;  // the listener is in the epoll set, there is a free slot
+    int _sockets[MAX_CONNECTIONS_COUNT];  // -1 for a free slot
+    uint32_t _addresses[MAX_CONNECTIONS_COUNT] = {};  // the clients' addresses, in network order like an IPAddress
+
+    // the bytes written to a slot its socket hasn't taken yet, sent from offset
+    struct Output{
+      uint8_t* data = nullptr;
+      size_t size = 0;
+      size_t capacity = 0;
+      size_t offset = 0;
+      bool shutdown = false;  // the client is half-closed once they're sent
+      bool watched = false;   // the socket is watched for room to send them
+    };
+    Output _outputs[MAX_CONNECTIONS_COUNT];
+
+    // void end()
+    // disconnects the clients and closes the listener and the epoll set
+    void end();
+
+    // void watchListener(listening)
+    // adds the listener to the epoll set, or removes it from it
+    void watchListener(bool );
+
+    // void flush(slot)
+    // sends the slot's buffered output, as much of it as its socket takes without waiting. The
+    // output of a client that's gone is dropped
+    void flush(int );
+
+    // void watchOutput(slot, watched)
+    // makes epoll wake wait() once the slot's socket has room for its buffered output, or stop
+    void watchOutput(int , bool );
+
+    // void dropOutput(slot)
+    // frees the slot's buffered output
+    void dropOutput(int );
+
+  public:
+    HTTP_PosixTransport();
+    ~HTTP_PosixTransport();
+    HTTP_PosixTransport(const HTTP_PosixTransport&) = delete;
+    HTTP_PosixTransport& operator=(const HTTP_PosixTransport&) = delete;
+
+    bool begin(int port) override;
+    bool accept(int slot) override;
+    int available(int slot) override;
+    int read(int slot, uint8_t*, size_t length) override;
+    size_t write(int slot, const uint8_t*, size_t length) override;
+    int availableForWrite(int slot) override;
+    bool sending(int slot) override;
+    bool connected(int slot) override;
+    void stop(int slot) override;
+    void shutdown(int slot) override;
+    uint32_t remoteIP(int slot) override {return this->_addresses[slot];}
+    void wait(unsigned long timeout) override;
+};
+
+#endif
+
+#endif
@@ -0,0 +1,75 @@
+#include "HTTP_RateLimit.h"
+
+HTTP_RateLimiter::HTTP_RateLimiter(uint32_t requestsPerMinute, uint32_t burst)
+  : _requestsPerMinute{requestsPerMinute}, _capacity{(burst ? burst : 1) * 1000}
+{
+  if(requestsPerMinute == 0) logwarn("A rate limiter of 0 requests per minute never refills");
+}
+
+
+HTTP_RateBucket& HTTP_RateLimiter::find(uint32_t key, unsigned long now)
+{
+  HTTP_RateBucket* oldest = nullptr;
+  for(int i = 0; i < PROBE_LENGTH; ++i)
+  {
+    HTTP_RateBucket& bucket = this->_buckets[(key + i) % ENTRIES_COUNT];
+    if(bucket.key == key) return bucket;
+    if(bucket.key == 0){
+      // a free bucket: the key is in none of the next ones either
+      oldest = &bucket;
+      break;
+    }
+    if(!oldest || now - bucket.updatedAt > now - oldest->updatedAt) oldest = &bucket;
+  }
+
+  oldest->key = key;
+  oldest->tokens = this->_capacity;
+  oldest->updatedAt = now;
+  return *oldest;
+}
+
+
+bool HTTP_RateLimiter::take(uint32_t key, uint32_t& retryAfter)
+{
+  unsigned long now = this->_clock();
+  HTTP_RateBucket& bucket = find(key, now);
+
+  // requestsPerMinute requests a minute are 1000 * requestsPerMinute thousandths in 60000 ms
+  uint64_t refill = (uint64_t)(now - bucket.updatedAt) * this->_requestsPerMinute / 60;
+  bucket.tokens = refill >= this->_capacity - bucket.tokens ? this->_capacity : bucket.tokens + refill;
+  bucket.updatedAt = now;
+
+  if(bucket.tokens >= 1000){
+    bucket.tokens -= 1000;
+    retryAfter = 0;
+    return true;
+  }
+
+  if(this->_requestsPerMinute == 0){
+    retryAfter = 60;
+    return false;
+  }
+  // the milliseconds until the missing thousandths are refilled, rounded up to seconds
+  uint32_t wait = ((1000 - bucket.tokens) * 60 + this->_requestsPerMinute - 1) / this->_requestsPerMinute;
+  retryAfter = (wait + 999) / 1000;
+  return false;
+}
+
+
+void HTTP_RateLimiter::clear()
+{
+  for(int i = 0; i < ENTRIES_COUNT; ++i) this->_buckets[i] = HTTP_RateBucket();
+}
+
+
+uint32_t HTTP_RateLimiter::keyOf(const void* data, size_t length)
+{
+  // FNV-1a
+  const uint8_t* bytes = (const uint8_t*)data;
+  uint32_t hash = 2166136261u;
+  for(size_t i = 0; i < length; ++i){
+    hash ^= bytes[i];
+    hash *= 16777619u;
+  }
+  return hash ? hash : 1;
+}
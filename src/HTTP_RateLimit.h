@@ -0,0 +1,63 @@
+/*
+ * This library provides HTTP_RateLimiter, the token buckets of the ArduinoExpress::RateLimit()
+ * middleware: each client may send a burst of requests, then requests at a steady rate
+ */
+
+#ifndef HTTP_RATE_LIMIT_HEADER
+#define HTTP_RATE_LIMIT_HEADER
+
+#include "HTTP_Utilities.h"
+
+// the bucket of one client
+struct HTTP_RateBucket{
+  uint32_t key = 0;           // the hash of the client's key, 0 for a free bucket
+  uint32_t tokens = 0;        // the requests the client may send now, in thousandths of a request
+  unsigned long updatedAt = 0;  // the clock when the bucket was last refilled, and last used
+};
+
+
+// the clock the buckets are refilled with, in milliseconds. It's millis() unless another one is
+// set, e.g. a fake clock in tests
+using HTTP_RateClock = unsigned long (*)();
+
+
+/* HTTP_RateLimiter gives each client a bucket of burst requests, refilled with requestsPerMinute
+  * requests a minute. A request takes one from its client's bucket, or is refused while it's empty.
+  * The buckets are kept in a fixed table of RATE_LIMIT_ENTRIES_COUNT entries, nothing is allocated:
+  * when the table is full, the least recently used client of the new client's probe window is
+  * forgotten, and starts again with a full bucket.
+  * e.g. HTTP_RateLimiter limiter(60, 10); // 10 requests at once, then one a second
+  *      app.use("/api", ArduinoExpress::RateLimit(limiter));
+*/
+struct HTTP_RateLimiter{
+  private:
+    const static int ENTRIES_COUNT = ArduinoExpressConfig::RATE_LIMIT_ENTRIES_COUNT;
+    const static int PROBE_LENGTH = ArduinoExpressConfig::RATE_LIMIT_PROBE_LENGTH;
+    HTTP_RateBucket _buckets[ENTRIES_COUNT];
+    uint32_t _requestsPerMinute;
+    uint32_t _capacity; // burst, in thousandths of a request
+    HTTP_RateClock _clock = millis;
+
+    // HTTP_RateBucket& find(key, now)
+    // returns the bucket of key, or the bucket given to it: a free one, else the least recently used
+    HTTP_RateBucket& find(uint32_t, unsigned long);
+
+  public:
+    HTTP_RateLimiter(uint32_t requestsPerMinute, uint32_t burst);
+
+    void setClock(HTTP_RateClock clock) {this->_clock = clock;}
+
+    // bool take(key, retryAfter)
+    // takes a request from the bucket of key. Returns false if it's empty, retryAfter is then the
+    // seconds until it holds a request again
+    bool take(uint32_t, uint32_t& retryAfter);
+
+    // forgets every client
+    void clear();
+
+    // uint32_t keyOf(data, length)
+    // returns the key of a client identified by data, e.g. its IP address or its API key. Never 0
+    static uint32_t keyOf(const void*, size_t );
+};
+
+#endif
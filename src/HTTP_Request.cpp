@@ -1,69 +1,250 @@
 #include "HTTP_Request.h"
+#include "HTTP_Multipart.h"
+
+HTTP_Request::~HTTP_Request()
+{
+  delete this->_multipart;
+}
+
 
 void HTTP_Request::printToSerial() const
 {
-  String reqLine = "Method: ";
-  Serial.println(reqLine + this->method + " Route: " + this->route + "\n");
+  Serial.print("Method: ");
+  Serial.print(this->method.c_str());
+  Serial.print(" Route: ");
+  Serial.println(this->route.c_str());
+  Serial.println();
   
-  int count = 0;
-  while(count < this->MAX_HEADERS_COUNT && this->headers[count].key != ""){
-    Serial.print(this->headers[count].key);
+  for(int i = 0; i < this->headersCount; ++i){
+    Serial.print(this->headers[i].key.c_str());
     Serial.print(": ");
-    Serial.println(this->headers[count].value);
-    count = count + 1; 
+    Serial.println(this->headers[i].value.c_str());
   }
   Serial.println();
-  Serial.println(this->body);
+  Serial.println(this->body.c_str());
   Serial.println();
 }
 
 
-const String& HTTP_Request::getHeader(const String& headerKey) const
+void HTTP_Request::clear()
+{
+  this->method = HTTP_StringView{};
+  this->route = HTTP_StringView{};
+  this->rawQuery = HTTP_StringView{};
+  this->version = HTTP_StringView{};
+  this->pathSegments = HTTP_StringView{};
+  this->paramsCount = 0;
+  this->queryCount = 0;
+  this->fieldsCount = 0;
+  this->headersCount = 0;
+  this->headerIndex.clear();
+  this->body = HTTP_StringView{};
+  this->bodyStreamed = false;
+  this->_onData = nullptr;
+  this->_onEnd = nullptr;
+  this->_json = JsonVariant{};
+  this->_jsonState = JSON_UNPARSED;
+  this->_jsonBuffer.reset();
+
+  this->user.user_id = "";
+  this->user.user_auth = "";
+
+#if ARDUINOEXPRESS_METRICS
+  this->metrics = HTTP_RequestMetrics{};
+#endif
+}
+
+
+HTTP_StringView HTTP_Request::getHeader(HTTP_HeaderId id) const
+{
+  int slot = this->headerIndex.slot(id);
+  if(slot == -1) return HTTP_StringView{};
+  return this->headers[slot].value;
+}
+
+
+HTTP_StringView HTTP_Request::getHeader(const char* headerKey) const
 {
-  for(int i = 0; i < this->MAX_HEADERS_COUNT; ++i){
-    if (this->headers[i].key == headerKey) return this->headers[i].value; 
+  int slot = headerSlot(headerKey);
+  if(slot == -1) return HTTP_StringView{};
+  return this->headers[slot].value;
+}
+
+
+int HTTP_Request::headerSlot(const char* headerKey) const
+{
+  size_t length = strlen(headerKey);
+  HTTP_HeaderId id = toHeaderId(headerKey, length);
+  if(id != HEADER_OTHER) return this->headerIndex.slot(id);
+
+  // the hash rules out most headers, the name is compared for the ones left
+  uint16_t hash = headerHash(headerKey, length);
+  for(int slot = this->headerIndex.nextSlot(hash, 0, this->headersCount); slot != -1; 
+      slot = this->headerIndex.nextSlot(hash, slot + 1, this->headersCount)){
+    if(this->headers[slot].key.equalsIgnoreCase(headerKey)) return slot;
   }
   
-  return "";
+  return -1;
 }
 
 
-const String& HTTP_Request::getParam(const String& paramKey) const 
+HTTP_StringView HTTP_Request::getParam(const char* paramKey) const 
 {
-  for(int i = 0; i < this->MAX_PARAMS_COUNT; ++i){
+  for(int i = 0; i < this->paramsCount; ++i){
     if (this->params[i].key == paramKey) return this->params[i].value; 
   }
   
-  return "";
+  return HTTP_StringView{};
 }
 
 
-bool HTTP_Request::hasHeader(const String& headerKey) const
+HTTP_StringView HTTP_Request::getQuery(const char* queryKey) const 
 {
-  for(int i = 0; i < this->MAX_HEADERS_COUNT; ++i){
-    if (this->headers[i].key == headerKey) return true; 
+  for(int i = 0; i < this->queryCount; ++i){
+    if (this->query[i].key == queryKey) return this->query[i].value; 
   }
   
-  return false;
+  return HTTP_StringView{};
+}
+
+
+HTTP_StringView HTTP_Request::getField(const char* fieldKey) const
+{
+  for(int i = 0; i < this->fieldsCount; ++i){
+    if (this->fields[i].key == fieldKey) return this->fields[i].value;
+  }
+
+  return HTTP_StringView{};
 }
 
 
-bool HTTP_Request::hasParam(const String& paramKey) const
+bool HTTP_Request::hasParam(const char* paramKey) const
 {
-  for(int i = 0; i < this->MAX_PARAMS_COUNT; ++i){
+  for(int i = 0; i < this->paramsCount; ++i){
     if (this->params[i].key == paramKey) return true; 
   }
   
   return false;
 }
 
-ArduinoJson::Internals::JsonObjectSubscript<const String &> HTTP_Request::bodyJSON(const String& key)
+
+bool HTTP_Request::hasQuery(const char* queryKey) const
+{
+  for(int i = 0; i < this->queryCount; ++i){
+    if (this->query[i].key == queryKey) return true; 
+  }
+  
+  return false;
+}
+
+
+bool HTTP_Request::hasField(const char* fieldKey) const
+{
+  for(int i = 0; i < this->fieldsCount; ++i){
+    if (this->fields[i].key == fieldKey) return true;
+  }
+
+  return false;
+}
+
+
+bool HTTP_Request::addField(const HTTP_StringView& key, const HTTP_StringView& value)
+{
+  if(this->fieldsCount == MAX_FIELDS_COUNT) return false;
+
+  this->fields[this->fieldsCount].key = key;
+  this->fields[this->fieldsCount].value = value;
+  ++this->fieldsCount;
+  return true;
+}
+
+
+HTTP_StringView HTTP_Request::pathSegment(size_t offset) const
+{
+  // the index of the segment: the number of segments that start before offset
+  int index = 0;
+  for(size_t i = 0; i < offset && i < this->route.length(); ++i){
+    if(this->route[i] != '/' && (i == 0 || this->route[i - 1] == '/')) ++index;
+  }
+
+  const char* segment = this->pathSegments.c_str();
+  const char* end = segment + this->pathSegments.length();
+  while(index-- > 0 && segment < end) segment += strlen(segment) + 1;
+
+  if(segment >= end) return HTTP_StringView{};
+  return HTTP_StringView{segment, strlen(segment)};
+}
+
+JsonVariant HTTP_Request::json()
+{
+  if(this->_jsonState != JSON_UNPARSED) return this->_json;
+
+  // a document rarely needs more than twice the size of its text. When it does, the arena is
+  // grown and the body parsed again
+  const size_t MAX_JSON_BUFFER_SIZE = ArduinoExpressConfig::MAX_JSON_BUFFER_SIZE;
+  size_t capacity = 2 * this->body.length() + JSON_OBJECT_SIZE(1);
+  this->_jsonState = JSON_INVALID;
+
+  while(true)
   {
-    DynamicJsonBuffer buffer(200);
-    auto json = buffer.parse(body);
+    if(capacity > MAX_JSON_BUFFER_SIZE) capacity = MAX_JSON_BUFFER_SIZE;
+    if(!this->_jsonBuffer.reserve(capacity)){
+      logerr("Not enough memory to parse the JSON body");
+      this->_jsonState = JSON_TOO_LARGE;
+      break;
+    }
+
+    this->_json = this->_jsonBuffer.parse(this->body.c_str());
+    if(this->_json.success()){
+      this->_jsonState = JSON_VALID;
+      break;
+    }
 
-    if(!json.success())
-      logErr("Could not convert request body to JSON");
-    
-    return json[key];
+    if(!this->_jsonBuffer.overflowed()) break;
+    if(capacity == MAX_JSON_BUFFER_SIZE){
+      this->_jsonState = JSON_TOO_LARGE;
+      break;
+    }
+    capacity *= 2;
   }
+
+  if(this->_jsonState != JSON_VALID) this->_json = JsonVariant{};
+  return this->_json;
+}
+
+
+int HTTP_Request::jsonStatus() const
+{
+  if(this->_jsonState == JSON_INVALID) return 400;
+  if(this->_jsonState == JSON_TOO_LARGE) return 413;
+  return 0;
+}
+
+
+HTTP_MultipartParser* HTTP_Request::multipart()
+{
+  if(!this->_multipart){
+    this->_multipart = new (std::nothrow) HTTP_MultipartParser;
+    if(!this->_multipart) logerr("Not enough memory for a multipart parser");
+  }
+  return this->_multipart;
+}
+
+
+bool HTTP_Request::multipartDone() const
+{
+  return this->_multipart && this->_multipart->done();
+}
+
+
+JsonVariant HTTP_Request::bodyJSON(const String& key)
+{
+  JsonVariant document = json();
+  if(!document.is<JsonObject&>()){
+    logerr("Could not convert request body to JSON");
+    return JsonVariant{};
+  }
+
+  return document.as<JsonObject&>().get<JsonVariant>(key);
+}
+
@@ -6,34 +6,186 @@
 #define HTTP_REQUEST_HEADER
 
 #include "HTTP_Utilities.h"
+#include "HTTP_Headers.h"
+#include "HTTP_Metrics.h"
+#include "HTTP_Arena.h"
+#include "InplaceFunction.h"
 
+struct HTTP_MultipartParser;
+
+/* The arena the JSON body of a request is parsed into. Its memory is allocated when the first JSON
+  * body is parsed, and reused by the next requests of the connection. It only grows when a body
+  * needs more, up to MAX_JSON_BUFFER_SIZE.
+*/
+struct HTTP_JsonBuffer : ArduinoJson::Internals::JsonBufferBase<HTTP_JsonBuffer>{
+  private:
+    HTTP_Arena _arena;
+
+  public:
+    // bool reserve(capacity)
+    // empties the arena and makes sure it can hold capacity bytes. Returns false if it's out of memory
+    bool reserve(size_t capacity) {return this->_arena.reserve(capacity);}
+
+    virtual void* alloc(size_t size) override {return this->_arena.alloc(size);}
+    // frees the document, the memory is kept for the next one
+    void reset() {this->_arena.reset();}
+
+    bool overflowed() const {return this->_arena.overflowed();}
+    size_t capacity() const {return this->_arena.capacity();}
+};
+
+enum HTTP_JsonState : uint8_t {JSON_UNPARSED, JSON_VALID, JSON_INVALID, JSON_TOO_LARGE};
+
+// the consumers of a streamed body: onData gets each piece of the body as it arrives, onEnd is
+// called once it's complete
+using HTTP_BodyDataFunction = InplaceFunction<void(const uint8_t*, size_t), ArduinoExpressConfig::BODY_CONSUMER_STORAGE_SIZE>;
+using HTTP_BodyEndFunction = InplaceFunction<void(), ArduinoExpressConfig::BODY_CONSUMER_STORAGE_SIZE>;
+
+
+/* The request line, headers and body are views into the request buffer of the connection's
+  * HTTP_RequestParser. They are valid until the parser starts on the next request.
+*/
 struct HTTP_Request{
-  String method = "";
-  String route = "";
+  HTTP_StringView method;
+  HTTP_StringView route;  // the path of the request, without the query string
+  HTTP_StringView rawQuery; // the query string as it was sent, without the '?'
+  HTTP_StringView version;
+
+  // the percent-decoded segments of route, each null-terminated: "a\0b c\0" for "/a/b%20c"
+  HTTP_StringView pathSegments;
 
+  // the parameters of the matched route, set when the route is executed.
+  // ":name" segments are decoded, the "*" parameter is the rest of the path as it was sent
   const static int MAX_PARAMS_COUNT = ArduinoExpressConfig::MAX_PARAMS_COUNT;
   HTTP_Param params[MAX_PARAMS_COUNT];
+  int paramsCount = 0;
+
+  // the query string parameters, percent-decoded
+  const static int MAX_QUERY_COUNT = ArduinoExpressConfig::MAX_QUERY_COUNT;
+  HTTP_Param query[MAX_QUERY_COUNT];
+  int queryCount = 0;
+
+  // the fields of a form body, decoded by the ArduinoExpress::Form() middleware
+  const static int MAX_FIELDS_COUNT = ArduinoExpressConfig::MAX_FIELDS_COUNT;
+  HTTP_Param fields[MAX_FIELDS_COUNT];
+  int fieldsCount = 0;
 
   const static int MAX_HEADERS_COUNT = ArduinoExpressConfig::MAX_HEADERS_COUNT;
-  HTTP_Header headers[MAX_HEADERS_COUNT];
+  HTTP_HeaderView headers[MAX_HEADERS_COUNT];
+  int headersCount = 0;
+  HTTP_HeaderIndex headerIndex; // filled by the HTTP_RequestParser as headers are parsed
   
-  String body = "";
+  HTTP_StringView body;
 
+  // set when the body doesn't fit in the request buffer. The request is then routed as soon as its
+  // headers are read, body is empty, and the body must be read with onData()
+  bool bodyStreamed = false;
 
   HTTP_User user;
 
-  const String& getHeader(const String& ) const;
-  const String& getParam(const String& ) const;
-  bool hasHeader(const String& ) const;
-  bool hasParam(const String& ) const;
+  // the IPv4 address of the client, as an IPAddress converts to uint32_t. It's set when the client
+  // connects and kept for all the requests of the connection; 0 if the transport doesn't know it
+  uint32_t remoteIP = 0;
+
+#if ARDUINOEXPRESS_METRICS
+  HTTP_RequestMetrics metrics;
+#endif
+
+  // header names are case-insensitive. Well known headers are found faster by their HTTP_HeaderId.
+  // When a header is repeated, the first one is returned
+  HTTP_StringView getHeader(HTTP_HeaderId ) const;
+  HTTP_StringView getHeader(const char* ) const;
+  HTTP_StringView getHeader(const String& key) const {return getHeader(key.c_str());}
+  bool hasHeader(HTTP_HeaderId id) const {return this->headerIndex.slot(id) != -1;}
+  bool hasHeader(const char* key) const {return headerSlot(key) != -1;}
+  bool hasHeader(const String& key) const {return headerSlot(key.c_str()) != -1;}
+
+  // int headerSlot(key)
+  // returns the index in headers of the header named key, -1 if there's none
+  int headerSlot(const char* ) const;
+
+  HTTP_StringView getParam(const char* ) const;
+  HTTP_StringView getParam(const String& key) const {return getParam(key.c_str());}
+  bool hasParam(const char* ) const;
+  bool hasParam(const String& key) const {return hasParam(key.c_str());}
+
+  HTTP_StringView getQuery(const char* ) const;
+  HTTP_StringView getQuery(const String& key) const {return getQuery(key.c_str());}
+  bool hasQuery(const char* ) const;
+  bool hasQuery(const String& key) const {return hasQuery(key.c_str());}
+
+  HTTP_StringView getField(const char* ) const;
+  HTTP_StringView getField(const String& key) const {return getField(key.c_str());}
+  bool hasField(const char* ) const;
+  bool hasField(const String& key) const {return hasField(key.c_str());}
+
+  // bool addField(key, value)
+  // adds a form field. Returns false if the fields are full
+  bool addField(const HTTP_StringView&, const HTTP_StringView&);
+
+  // HTTP_StringView pathSegment(offset)
+  // returns the decoded segment of route that starts at offset
+  HTTP_StringView pathSegment(size_t ) const;
+
   void printToSerial() const;
 
-  void clear()
-  {
-    *this = HTTP_Request{};
-  }
+  HTTP_Request() {}
+  HTTP_Request(const HTTP_Request&) = delete;
+  HTTP_Request& operator=(const HTTP_Request&) = delete;
+  ~HTTP_Request();
+
+  // resets the request, without reallocating the parameters and user. Its JSON document is freed
+  void clear();
+
+  // JsonVariant json()
+  // returns the body parsed as JSON. The body is parsed on the first call only, the middlewares and
+  // the handler of a request all get the same document, which lives until the request is cleared.
+  // It fails success() if the body is not JSON, or is too large to parse (see jsonStatus())
+  JsonVariant json();
+
+  // int jsonStatus()
+  // returns the status to answer a body that json() could not parse with: 400 if it's not JSON,
+  // 413 if its document doesn't fit in MAX_JSON_BUFFER_SIZE. 0 otherwise
+  int jsonStatus() const;
+
+  // JsonVariant bodyJSON(key)
+  // returns the member key of the JSON body. It fails success() if the body is not a JSON object
+  JsonVariant bodyJSON(const String& key);
+
+  /* STREAMED BODY: a handler or middleware reads the body a piece at a time by registering consumers,
+    * e.g. req.onData([](const uint8_t* data, size_t length){ Update.write(...); });
+    *      req.onEnd([&res](){ res.send(200, "text/plain", "OK"); });
+    * A streamed body goes to the consumers as it arrives, a buffered body all at once after the
+    * callbacks have run. The response can be sent from onEnd(). onEnd() is not called if the client
+    * disconnects or sends an invalid body.
+    * */
+  void onData(HTTP_BodyDataFunction consumer) {this->_onData = consumer;}
+  void onEnd(HTTP_BodyEndFunction consumer) {this->_onEnd = consumer;}
+  bool hasBodyConsumer() const {return this->_onData || this->_onEnd;}
+
+  // pass the body to the consumers, called by the parser and ArduinoExpress
+  void streamData(const uint8_t* data, size_t length) {if(this->_onData) this->_onData(data, length);}
+  void streamEnd() {if(this->_onEnd) this->_onEnd();}
+
+  // HTTP_MultipartParser* multipart()
+  // returns the parser of the request's multipart body. It's allocated on the first call and reused
+  // by the next requests of the connection. Returns null if it's out of memory
+  HTTP_MultipartParser* multipart();
+
+  // bool multipartDone()
+  // returns true once the closing boundary of a multipart body was read, so onEnd() can tell a
+  // complete form from a truncated one
+  bool multipartDone() const;
+
+  private:
+    HTTP_BodyDataFunction _onData;
+    HTTP_BodyEndFunction _onEnd;
+
+    HTTP_JsonBuffer _jsonBuffer;
+    JsonVariant _json;
+    HTTP_JsonState _jsonState = JSON_UNPARSED;
 
-  ArduinoJson::Internals::JsonObjectSubscript<const String &> bodyJSON(const String& key);
+    HTTP_MultipartParser* _multipart = nullptr;
 };
 
 #endif
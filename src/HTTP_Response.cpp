@@ -1,58 +1,132 @@
 #include "HTTP_Response.h"
 
+// the constant parts of a response head are kept in flash
+static const char STATUS_LINE_START[] PROGMEM = "HTTP/1.1 ";
+static const char HEADER_SEPARATOR[] PROGMEM = ": ";
+static const char LINE_END[] PROGMEM = "\r\n";
+static const char CONTENT_LENGTH_HEADER[] PROGMEM = "Content-Length: ";
+static const char CHUNKED_HEADER[] PROGMEM = "Transfer-Encoding: chunked\r\n";
+static const char KEEP_ALIVE_HEADER[] PROGMEM = "Connection: keep-alive\r\n\r\n";
+static const char CLOSE_HEADER[] PROGMEM = "Connection: close\r\n\r\n";
+static const char LAST_CHUNK[] PROGMEM = "0\r\n\r\n";
+
+
 void HTTP_Response::setStatus(int status, const String& statusText = "")
 {
   // the status text is optional, it will be filled if none is provided
   this->_status = status;
-  if(!statusText.isEmpty()) this->_statusText = statusText;
-  else{
-    this->_statusText = HTTPStatusText(status);
+  this->_statusText = HTTP_StringView{};
+  this->_statusText_P = nullptr;
+
+  const char* copy = statusText.isEmpty() ? nullptr : this->_arena.copy(statusText.c_str(), statusText.length());
+  if(copy) this->_statusText = HTTP_StringView{copy, statusText.length()};
+  else this->_statusText_P = HTTPStatusText_P(status);
+}
+
+
+bool HTTP_Response::setHeader(HTTP_HeaderId id, const char* value, size_t length)
+{
+  int slot = this->_headerIndex.slot(id);
+  if(slot != -1) return setValue(slot, value, length);
+  if(id == HEADER_OTHER) return false;
+
+  // the name is copied from flash, without a String
+  PGM_P name = headerName(id);
+  size_t keyLength = strlen_P(name);
+  char* key = (char*)this->_arena.alloc(keyLength + 1);
+  if(key) memcpy_P(key, name, keyLength + 1);
+  return addHeader(id, key, keyLength, value, length);
+}
+
+
+bool HTTP_Response::setHeader(const char* key, size_t keyLength, const char* value, size_t length)
+{
+  HTTP_HeaderId id = toHeaderId(key, keyLength);
+  int slot = headerSlot(id, key, keyLength);
+  if(slot != -1) return setValue(slot, value, length);
+  return addHeader(id, this->_arena.copy(key, keyLength), keyLength, value, length);
+}
+
+
+bool HTTP_Response::addHeader(HTTP_HeaderId id, const char* key, size_t keyLength, const char* value, size_t length)
+{
+  if(this->_headersCount >= this->MAX_HEADERS_COUNT){
+    logwarn("Too many response headers, %s is not sent", key ? key : "a header");
+    return false;
   }
+
+  const char* copy = key ? this->_arena.copy(value, length) : nullptr;
+  if(!copy){
+    logerr("Not enough memory for the response headers, %s is not sent", key ? key : "a header");
+    return false;
+  }
+
+  HTTP_HeaderView& header = this->_headers[this->_headersCount];
+  header.key = HTTP_StringView{key, keyLength};
+  header.value = HTTP_StringView{copy, length};
+  this->_headerIndex.add(this->_headersCount, id, key, keyLength);
+  ++this->_headersCount;
+  return true;
 }
 
 
-void HTTP_Response::setHeader(const String& key, const String& value)
+bool HTTP_Response::setValue(int slot, const char* value, size_t length)
 {
-  int index = getHeaderIndex(key);
-  if (index != -1){
-    this->_headers[index].value = value;
+  HTTP_HeaderView& header = this->_headers[slot];
+
+  // the previous value is reused: in place if the new one fits in it or it's the arena's last
+  // allocation, else it stays in the arena until reset(). value can be a part of it
+  char* previous = (char*)header.value.c_str();
+  size_t previousLength = header.value.length();
+  char* storage = (char*)this->_arena.resize(previous, previousLength + 1, length + 1);
+  if(!storage && length <= previousLength) storage = previous;
+  if(storage){
+    memmove(storage, value, length);
+    storage[length] = '\0';
+    header.value = HTTP_StringView{storage, length};
+    return true;
   }
-  else if (this->_headersCount < this->MAX_HEADERS_COUNT){
-    HTTP_Header newHeader;
-    newHeader.key = key;
-    newHeader.value = value;
-    
-    this->_headers[this->_headersCount] = newHeader;
 
-    this->_headersCount = this->_headersCount + 1;
+  const char* copy = this->_arena.copy(value, length);
+  if(!copy){
+    logerr("Not enough memory for the response headers, %s is not changed", header.key.c_str());
+    return false;
   }
+  header.value = HTTP_StringView{copy, length};
+  return true;
 }
 
 
 bool HTTP_Response::hasHeader(const String& headerKey) const
 {
-  for(int i = 0; i < this->MAX_HEADERS_COUNT; ++i){
-    if (this->_headers[i].key == headerKey) return true; 
-  }
-  
-  return false;
+  return headerSlot(toHeaderId(headerKey.c_str(), headerKey.length()), headerKey.c_str(), headerKey.length()) != -1;
 }
 
 
-const String& HTTP_Response::getHeader(const String& headerKey) const
+HTTP_StringView HTTP_Response::getHeader(HTTP_HeaderId id) const
 {
-  for(int i = 0; i < this->MAX_HEADERS_COUNT; ++i){
-    if (this->_headers[i].key == headerKey) return this->_headers[i].value; 
-  }
-  
-  return "";
+  int slot = this->_headerIndex.slot(id);
+  return slot != -1 ? this->_headers[slot].value : HTTP_StringView{};
 }
 
 
-int HTTP_Response::getHeaderIndex(const String& headerKey) const
+HTTP_StringView HTTP_Response::getHeader(const String& headerKey) const
 {
-  for(int i = 0; i < this->MAX_HEADERS_COUNT; ++i){
-    if (this->_headers[i].key == headerKey) return i;
+  int slot = headerSlot(toHeaderId(headerKey.c_str(), headerKey.length()), headerKey.c_str(), headerKey.length());
+  return slot != -1 ? this->_headers[slot].value : HTTP_StringView{};
+}
+
+
+int HTTP_Response::headerSlot(HTTP_HeaderId id, const char* headerKey, size_t length) const
+{
+  if(id != HEADER_OTHER) return this->_headerIndex.slot(id);
+
+  // the hash rules out most headers, the name is compared for the ones left
+  uint16_t hash = headerHash(headerKey, length);
+  for(int slot = this->_headerIndex.nextSlot(hash, 0, this->_headersCount); slot != -1; 
+      slot = this->_headerIndex.nextSlot(hash, slot + 1, this->_headersCount)){
+    const HTTP_StringView& key = this->_headers[slot].key;
+    if(key.length() == length && strncasecmp(key.c_str(), headerKey, length) == 0) return slot;
   }
   
   return -1;
@@ -61,63 +135,274 @@ int HTTP_Response::getHeaderIndex(const String& headerKey) const
 
 void HTTP_Response::setBody(const String& contentType, const String& body)
 {
-  setHeader("Content-type", contentType);
+  setHeader(HEADER_CONTENT_TYPE, contentType);
   this->_body = body;
+  this->_bodyView = HTTP_StringView{this->_body.c_str(), this->_body.length()};
 }
 
 
-bool HTTP_Response::send()
+void HTTP_Response::setBodyText(const char* body, size_t length)
+{
+  this->_body = String();
+  const char* copy = this->_arena.size() + length < this->_arena.capacity() ? this->_arena.copy(body, length) : nullptr;
+  this->_bodyView = HTTP_StringView{copy ? copy : body, length};
+}
+
+
+bool HTTP_Response::readyToSend() const
 {
   // CONFIRM STATUS AND STATUS TEXT IS SET
-  if(this->_status == 0 || this->_statusText.isEmpty()){
+  if(this->_status == 0 || (!this->_statusText_P && this->_statusText.isEmpty())){
     // throw "Status and/or statusText not set";
-    Serial.println("Status and/or statusText not set");
+    logerr("Status and/or statusText not set");
     return false;
   }
   
   // CONFIRIM A RESPONSE HAS NOT BEING SENT
   if(responseSent()){
     // throw "A response has being sent earlier";
-    Serial.println("A response has being sent earlier");
+    logerr("A response has being sent earlier");
     return false;
   }
 
   // CONFIRM THERE IS A CLIENT
   if(!this->_client){
     //throw "No client to send response to";
-    Serial.println("No client to send response to");
+    logerr("No client to send response to");
     return false;
   }
 
+  return true;
+}
+
+
+bool HTTP_Response::send()
+{
+  if(!readyToSend()) return false;
+
+  if(this->_sendObserver){
+    HTTP_SendObserver* observer = this->_sendObserver;
+    this->_sendObserver = nullptr;
+    observer->sending(*this);
+  }
+
   // -------------------------------------------------------------
 
-  // ADD STATUS LINE
-  String response = "HTTP/1.1 " + String(this->_status) + " " + this->_statusText + "\n";
+  if(compressible()){
+    sendCompressed();
+    return true;
+  }
+
+  // ADD STATUS LINE AND HEADERS, to the output buffer
+  writeHead(this->_bodyView.length(), false);
+  sendBody((const uint8_t*)this->_bodyView.c_str(), this->_bodyView.length());
+  return true;
+}
 
-  // ADD HEADERS
-  setHeader("Content-Length", String(this->_body.length()));
-  setHeader("Connection", "close");
-  for(int i = 0; i < this->MAX_HEADERS_COUNT; ++i){
-    HTTP_Header header = this->_headers[i];
-    if(header.key == "") continue;
 
-    response += header.key + ": " + header.value + "\n";
+bool HTTP_Response::send_P(int status, const char* contentType, PGM_P body, size_t length)
+{
+  setStatus(status);
+  setHeader(HEADER_CONTENT_TYPE, contentType);
+  if(!readyToSend()) return false;
+
+  // the cache only stores bodies held in RAM
+  this->_sendObserver = nullptr;
+  writeHead(length, false);
+  if(bodyAllowed()) writeOutput_P(body, length);
+  flushOutput();
+  this->_streaming = false;
+  loginfo("RESPONSE SENT: %d %s", this->_status, statusText().c_str());
+  return true;
+}
+
+
+bool HTTP_Response::compressible() const
+{
+  if(this->_encoding == ENCODING_IDENTITY || this->_bodyView.length() < this->_compressMinSize) return false;
+  if(this->_status == 204 || this->_status == 304 || hasHeader(HEADER_CONTENT_ENCODING)) return false;
+
+  HTTP_StringView contentType = getHeader(HEADER_CONTENT_TYPE);
+  return contentType.startsWith("text/") || contentType.startsWith("application/json") ||
+         contentType.startsWith("application/javascript") || contentType.startsWith("application/xml") ||
+         contentType.startsWith("image/svg+xml");
+}
+
+
+void HTTP_Response::sendCompressed()
+{
+  // the body is sent as it is if it can't be compressed, or if the client couldn't be told it is
+  HTTP_Deflate* deflate = HTTP_Deflate::shared();
+  if(!deflate || !setHeader(HEADER_CONTENT_ENCODING, this->_encoding == ENCODING_GZIP ? "gzip" : "deflate")){
+    writeHead(this->_bodyView.length(), false);
+    sendBody((const uint8_t*)this->_bodyView.c_str(), this->_bodyView.length());
+    return;
   }
-  response += "\n";
+
+  HTTP_StringView vary = getHeader(HEADER_VARY);
+  if(vary.isEmpty()) setHeader(HEADER_VARY, "Accept-Encoding");
+  else if(!vary.containsToken("Accept-Encoding")) setHeader(HEADER_VARY, vary.toString() + ", Accept-Encoding");
+
+  writeHead(0, true);
+  deflate->compress(this->_encoding, (const uint8_t*)this->_bodyView.c_str(), this->_bodyView.length(),
+                    [this](const uint8_t* data, size_t length){write(data, length);});
+  end();
+  loginfo("RESPONSE SENT: %d %s, compressed", this->_status, statusText().c_str());
+}
+
+
+bool HTTP_Response::sendSerialized(int status, const char* head, size_t headLength, 
+                                   const uint8_t* body, size_t bodyLength)
+{
+  setStatus(status);
+  if(!readyToSend()) return false;
+
+  writeOutput(head, headLength);
+  writeFraming(bodyLength, false);
+  sendBody(body, bodyLength);
+  return true;
+}
+
+
+void HTTP_Response::sendBody(const uint8_t* body, size_t length)
+{
+  if(!bodyAllowed()) length = 0;
 
   // ADD BODY
-  response += this->_body;
-  response += "\n";
+  // A body that fits in the output buffer goes out with the headers, in one write. 
+  // A larger one is written from the body, without copying it: the caller's at once, the one in
+  // _body across polls, by sendMore().
+  // Nothing may follow the body, the client reads the next response right after it
+  size_t space = OUTPUT_BUFFER_SIZE - this->_outputSize;
+  if(length <= space){
+    writeOutput((const char*)body, length);
+  }else if(body == (const uint8_t*)this->_body.c_str()){
+    writeOutput((const char*)body, space);
+    this->_pendingBody = body + space;
+    this->_pendingLength = length - space;
+  }else{
+    flushOutput();
+    writeClient(body, length);
+  }
 
   // SEND THE RESPONSE
-  this->_client->print(response);
+  flushOutput();
+  this->_streaming = false;
   this->_responseSent = true;
-  loginfo("RESPONSE START <=====\n" + response + "\nRESPONSE END =====>");
+  loginfo("RESPONSE SENT: %d %s", this->_status, statusText().c_str());
+}
+
 
+bool HTTP_Response::sendSource(int status, const char* contentType, size_t length, BodySource* source)
+{
+  this->_source = source;
+  setStatus(status);
+  setHeader(HEADER_CONTENT_TYPE, contentType);
+  if(!readyToSend()){
+    endSource();
+    return false;
+  }
+
+  // the cache only stores bodies held in RAM
+  this->_sendObserver = nullptr;
+  writeHead(length, false);
+  this->_streaming = false;
+  this->_pendingLength = bodyAllowed() ? length : 0;
+
+  if(this->_pendingLength == 0){
+    flushOutput();
+    endSource();
+  }
+  else sendMore();
+  loginfo("RESPONSE SENT: %d %s", this->_status, statusText().c_str());
   return true;
 }
 
 
+size_t HTTP_Response::sendMore()
+{
+  if(!this->_client) return 0;
+
+  // a chunk at a time, as long as the client takes them without waiting
+  size_t written = 0;
+  uint8_t buffer[ArduinoExpressConfig::STATIC_CHUNK_SIZE];
+  int available;
+  while(this->_pendingLength > 0 && (available = this->_client->availableForWrite()) > 0)
+  {
+    size_t count = this->_pendingLength < (size_t)available ? this->_pendingLength : available;
+    if(count > sizeof(buffer)) count = sizeof(buffer);
+
+    const uint8_t* data = this->_pendingBody;
+    if(this->_source){
+      count = this->_source->read(buffer, count);
+      data = buffer;
+    }
+    else this->_pendingBody += count;
+
+    if(count == 0){
+      // the client can't find the end of the body, the connection has to be closed
+      logwarn("Body ended before its Content-Length");
+      this->_keepAlive = false;
+      this->_pendingLength = 0;
+    }
+    else this->_pendingLength -= count;
+
+    // the head of the response goes out with the first chunk
+    if(this->_outputSize + count <= OUTPUT_BUFFER_SIZE){
+      writeOutput((const char*)data, count);
+      flushOutput();
+    }else{
+      flushOutput();
+      writeClient(data, count);
+    }
+    written += count;
+  }
+
+  if(this->_pendingLength == 0) endSource();
+  return written;
+}
+
+
+void HTTP_Response::endSource()
+{
+  if(this->_source) this->_source->~BodySource();
+  this->_source = nullptr;
+}
+
+
+void HTTP_Response::reset()
+{
+  endSource();
+  this->_pendingBody = nullptr;
+  this->_pendingLength = 0;
+  this->_arena.reset();
+  this->_status = 0;
+  this->_statusText = HTTP_StringView{};
+  this->_statusText_P = nullptr;
+  this->_headersCount = 0;
+  this->_headerIndex.clear();
+  this->_bodyView = HTTP_StringView{};
+  this->_body = String();
+  this->_responseSent = false;
+  this->_keepAlive = false;
+  this->_sendObserver = nullptr;
+  this->_encoding = ENCODING_IDENTITY;
+  this->_compressMinSize = 0;
+
+  this->_outputSize = 0;
+  this->_chunkStart = -1;
+  this->_streaming = false;
+  this->_chunked = false;
+  this->_contentLength = 0;
+  this->_streamedLength = 0;
+
+#if ARDUINOEXPRESS_METRICS
+  this->_bytesSent = 0;
+  this->_sendTime = 0;
+#endif
+}
+
+
 bool HTTP_Response::send(int status, const String& contentType, const String& body)
 {
   setStatus(status);
@@ -125,7 +410,289 @@ bool HTTP_Response::send(int status, const String& contentType, const String& bo
   return send();
 }
 
+bool HTTP_Response::send(int status, const char* contentType, const String& body)
+{
+  setStatus(status);
+  setHeader(HEADER_CONTENT_TYPE, contentType);
+  this->_body = body;
+  this->_bodyView = HTTP_StringView{this->_body.c_str(), this->_body.length()};
+  return send();
+}
+
+bool HTTP_Response::send(int status, const char* contentType, const char* body)
+{
+  setStatus(status);
+  setHeader(HEADER_CONTENT_TYPE, contentType);
+  setBodyText(body, strlen(body));
+  return send();
+}
+
 bool HTTP_Response::json(int status, const String& body)
 {
   return send(status, "application/json", body);
 }
+
+bool HTTP_Response::json(int status, const char* body)
+{
+  return send(status, "application/json", body);
+}
+
+
+// ----------------------STREAMING--------------------------------------
+// ---------------------------------------------------------------------
+
+
+bool HTTP_Response::beginStream(int status, const char* contentType)
+{
+  setStatus(status);
+  setHeader(HEADER_CONTENT_TYPE, contentType);
+  if(!readyToSend()) return false;
+
+  writeHead(0, true);
+  return true;
+}
+
+
+bool HTTP_Response::beginStream(int status, const char* contentType, size_t contentLength)
+{
+  setStatus(status);
+  setHeader(HEADER_CONTENT_TYPE, contentType);
+  if(!readyToSend()) return false;
+
+  writeHead(contentLength, false);
+  return true;
+}
+
+
+void HTTP_Response::writeHead(size_t contentLength, bool chunked)
+{
+  if(getHeader(HEADER_CONNECTION).equalsIgnoreCase("close")) this->_keepAlive = false;
+
+  // STATUS LINE
+  char number[12];
+  writeOutput_P(STATUS_LINE_START, sizeof(STATUS_LINE_START) - 1);
+  writeOutput(number, snprintf(number, sizeof(number), "%d ", this->_status));
+  if(this->_statusText_P) writeOutput_P(this->_statusText_P, strlen_P(this->_statusText_P));
+  else writeOutput(this->_statusText);
+  writeOutput_P(LINE_END, sizeof(LINE_END) - 1);
+
+  // HEADERS, the framing headers are written by the response
+  for(int i = 0; i < this->_headersCount; ++i){
+    const HTTP_HeaderView& header = this->_headers[i];
+    HTTP_HeaderId id = this->_headerIndex.id(i);
+    if(id == HEADER_CONTENT_LENGTH || id == HEADER_TRANSFER_ENCODING || id == HEADER_CONNECTION) continue;
+
+    writeOutput(header.key);
+    writeOutput_P(HEADER_SEPARATOR, sizeof(HEADER_SEPARATOR) - 1);
+    writeOutput(header.value);
+    writeOutput_P(LINE_END, sizeof(LINE_END) - 1);
+  }
+
+  writeFraming(contentLength, chunked);
+}
+
+
+void HTTP_Response::writeFraming(size_t contentLength, bool chunked)
+{
+  this->_streaming = true;
+  this->_chunked = chunked;
+  this->_contentLength = contentLength;
+  this->_streamedLength = 0;
+  this->_responseSent = true;
+
+  // 1xx, 204 and 304 responses have no body, so they're not framed (RFC 9112 6.3)
+  if(!bodyAllowed()){
+    this->_chunked = false;
+    this->_contentLength = 0;
+  }
+  else if(chunked){
+    writeOutput_P(CHUNKED_HEADER, sizeof(CHUNKED_HEADER) - 1);
+  }else{
+    char number[12];
+    writeOutput_P(CONTENT_LENGTH_HEADER, sizeof(CONTENT_LENGTH_HEADER) - 1);
+    writeOutput(number, snprintf(number, sizeof(number), "%u\r\n", (unsigned)contentLength));
+  }
+  if(this->_keepAlive) writeOutput_P(KEEP_ALIVE_HEADER, sizeof(KEEP_ALIVE_HEADER) - 1);
+  else writeOutput_P(CLOSE_HEADER, sizeof(CLOSE_HEADER) - 1);
+}
+
+
+size_t HTTP_Response::serializeHead(char* buffer, size_t capacity) const
+{
+  // the head is measured and written in one pass, like snprintf
+  size_t length = 0;
+  auto append = [&](const char* text, size_t textLength){
+    if(buffer && length + textLength <= capacity) memcpy(buffer + length, text, textLength);
+    length += textLength;
+  };
+
+  char number[12];
+  append("HTTP/1.1 ", 9);
+  append(number, snprintf(number, sizeof(number), "%d ", this->_status));
+  if(this->_statusText_P){
+    size_t textLength = strlen_P(this->_statusText_P);
+    if(buffer && length + textLength <= capacity) memcpy_P(buffer + length, this->_statusText_P, textLength);
+    length += textLength;
+  }else{
+    append(this->_statusText.c_str(), this->_statusText.length());
+  }
+  append("\r\n", 2);
+
+  for(int i = 0; i < this->_headersCount; ++i){
+    const HTTP_HeaderView& header = this->_headers[i];
+    HTTP_HeaderId id = this->_headerIndex.id(i);
+    if(id == HEADER_CONTENT_LENGTH || id == HEADER_TRANSFER_ENCODING || id == HEADER_CONNECTION) continue;
+
+    append(header.key.c_str(), header.key.length());
+    append(": ", 2);
+    append(header.value.c_str(), header.value.length());
+    append("\r\n", 2);
+  }
+
+  return length;
+}
+
+
+size_t HTTP_Response::write(const uint8_t* data, size_t length)
+{
+  if(!this->_streaming || length == 0 || !bodyAllowed()) return 0;
+  this->_streamedLength += length;
+
+  // large writes skip the output buffer. A chunk's size line goes out with what is buffered, and
+  // its CRLF with the next write: a chunk takes two writes
+  if(length >= OUTPUT_BUFFER_SIZE){
+    if(this->_chunked){
+      char sizeLine[12];
+      closeChunk();
+      writeOutput(sizeLine, snprintf(sizeLine, sizeof(sizeLine), "%x\r\n", (unsigned)length));
+      flushOutput();
+      writeClient(data, length);
+      writeOutput("\r\n", 2);
+    }else{
+      flushOutput();
+      writeClient(data, length);
+    }
+    return length;
+  }
+
+  if(!this->_chunked){
+    writeOutput((const char*)data, length);
+    return length;
+  }
+
+  size_t written = 0;
+  while(written < length)
+  {
+    if(this->_chunkStart == -1){
+      // a chunk needs its size line, at least one byte and its CRLF
+      if(OUTPUT_BUFFER_SIZE - this->_outputSize < CHUNK_HEADER_SIZE + 3) flushOutput();
+      this->_chunkStart = this->_outputSize;
+      this->_outputSize += CHUNK_HEADER_SIZE;
+    }
+
+    // room is kept for the CRLF that closes the chunk
+    size_t space = OUTPUT_BUFFER_SIZE - this->_outputSize - 2;
+    size_t count = length - written < space ? length - written : space;
+    memcpy(this->_output + this->_outputSize, data + written, count);
+    this->_outputSize += count;
+    written += count;
+
+    if(this->_outputSize + 2 == OUTPUT_BUFFER_SIZE) flushOutput();
+  }
+
+  return length;
+}
+
+
+bool HTTP_Response::end()
+{
+  if(!this->_streaming) return false;
+
+  if(this->_chunked){
+    closeChunk();
+    writeOutput_P(LAST_CHUNK, sizeof(LAST_CHUNK) - 1);
+  }
+  else if(this->_streamedLength != this->_contentLength){
+    // the client can't find the end of the body, the connection has to be closed
+    logwarn("Streamed body length does not match its Content-Length");
+    this->_keepAlive = false;
+  }
+
+  flushOutput();
+  this->_streaming = false;
+  return true;
+}
+
+
+void HTTP_Response::writeOutput(const char* data, size_t length)
+{
+  while(length > 0)
+  {
+    if(this->_outputSize == OUTPUT_BUFFER_SIZE) flushOutput();
+
+    size_t space = OUTPUT_BUFFER_SIZE - this->_outputSize;
+    size_t count = length < space ? length : space;
+    memcpy(this->_output + this->_outputSize, data, count);
+    this->_outputSize += count;
+    data += count;
+    length -= count;
+  }
+}
+
+
+void HTTP_Response::writeOutput_P(PGM_P data, size_t length)
+{
+  while(length > 0)
+  {
+    if(this->_outputSize == OUTPUT_BUFFER_SIZE) flushOutput();
+
+    size_t space = OUTPUT_BUFFER_SIZE - this->_outputSize;
+    size_t count = length < space ? length : space;
+    memcpy_P(this->_output + this->_outputSize, data, count);
+    this->_outputSize += count;
+    data += count;
+    length -= count;
+  }
+}
+
+
+void HTTP_Response::closeChunk()
+{
+  if(this->_chunkStart != -1)
+  {
+    size_t chunkLength = this->_outputSize - this->_chunkStart - CHUNK_HEADER_SIZE;
+    if(chunkLength == 0){
+      // an empty chunk would end the body
+      this->_outputSize = this->_chunkStart;
+    }else{
+      char sizeLine[CHUNK_HEADER_SIZE + 1];
+      snprintf(sizeLine, sizeof(sizeLine), "%04x\r\n", (unsigned)chunkLength);
+      memcpy(this->_output + this->_chunkStart, sizeLine, CHUNK_HEADER_SIZE);
+      this->_output[this->_outputSize++] = '\r';
+      this->_output[this->_outputSize++] = '\n';
+    }
+    this->_chunkStart = -1;
+  }
+}
+
+
+void HTTP_Response::flushOutput()
+{
+  closeChunk();
+  if(this->_outputSize > 0) writeClient(this->_output, this->_outputSize);
+  this->_outputSize = 0;
+}
+
+
+void HTTP_Response::writeClient(const uint8_t* data, size_t length)
+{
+  if(!this->_client) return;
+
+#if ARDUINOEXPRESS_METRICS
+  unsigned long start = metricsNow();
+  this->_bytesSent += this->_client->write(data, length);
+  this->_sendTime += metricsNow() - start;
+#else
+  this->_client->write(data, length);
+#endif
+}
@@ -6,48 +6,311 @@
 #define HTTP_RESPONSE_HEADER
 
 #include "HTTP_Utilities.h"
-#include <ESP8266WiFi.h>
+#include "HTTP_Headers.h"
+#include "HTTP_Metrics.h"
+#include "HTTP_Deflate.h"
+#include "HTTP_Transport.h"
+#include "HTTP_Arena.h"
+
+#include <new>
+#include <utility>
+
+struct HTTP_Response;
+
+// notified by an HTTP_Response right before it sends a buffered response, the observer can still
+// change it. See HTTP_Response::setSendObserver()
+struct HTTP_SendObserver{
+  virtual void sending(HTTP_Response&) = 0;
+};
+
 
 struct HTTP_Response{
   private:
+    // the headers and a custom status text are copied to the arena, and all freed by reset().
+    // Headers larger than the arena get a heap block, freed by reset() as well
+    HTTP_Arena _arena{ArduinoExpressConfig::RESPONSE_ARENA_SIZE, true};
+
     int _status = 0;
-    String _statusText;
+    // the reason phrase: the standard one is read from flash, only a custom one is in the arena
+    PGM_P _statusText_P = nullptr;
+    HTTP_StringView _statusText;
   
     const static int MAX_HEADERS_COUNT = ArduinoExpressConfig::MAX_HEADERS_COUNT;
-    HTTP_Header _headers[MAX_HEADERS_COUNT];
+    HTTP_HeaderView _headers[MAX_HEADERS_COUNT];
     int _headersCount = 0;
+    HTTP_HeaderIndex _headerIndex;
   
+    // the body send() sends: _body, a copy in the arena, or the caller's buffer. _body only holds
+    // the String of send(status, contentType, String&), and is freed by reset()
+    HTTP_StringView _bodyView;
     String _body;
-    
-    WiFiClient *_client = nullptr;
+
+    HTTP_Client *_client = nullptr;
     bool _responseSent = false;
+    bool _keepAlive = false;  // keep the connection open after this response
+    HTTP_SendObserver* _sendObserver = nullptr;
+
+    // the encoding send() compresses bodies of at least _compressMinSize bytes with
+    HTTP_Encoding _encoding = ENCODING_IDENTITY;
+    size_t _compressMinSize = 0;
+
+    // STREAMING
+    // bytes are written to the client through _output. In a chunked stream, the body bytes in _output
+    // are one chunk which starts at _chunkStart, with room reserved for its size line
+    const static int OUTPUT_BUFFER_SIZE = ArduinoExpressConfig::OUTPUT_BUFFER_SIZE;
+    const static int CHUNK_HEADER_SIZE = 6; // "%04x\r\n"
+    uint8_t _output[OUTPUT_BUFFER_SIZE];
+    size_t _outputSize = 0;
+    int _chunkStart = -1;
+
+    bool _streaming = false;
+    bool _chunked = false;
+    size_t _contentLength = 0;
+    size_t _streamedLength = 0;
+
+    // BODY SENT ACROSS POLLS
+    // the rest of a body larger than the output buffer that the response holds, in _body or read
+    // by _source, is written by sendMore() as the client takes it, so a slow client doesn't hold up
+    // the others. _source is in the arena, e.g. with the open file it reads
+    struct BodySource{
+      // reads at most length bytes of the body, returns the bytes read
+      virtual size_t read(uint8_t*, size_t length) = 0;
+      virtual ~BodySource() {}
+    };
+    template<typename Reader>
+    struct BodyReader : public BodySource{
+      Reader reader;
+      BodyReader(Reader&& reader): reader{std::move(reader)} {}
+      size_t read(uint8_t* data, size_t length) override {return this->reader(data, length);}
+    };
+    BodySource* _source = nullptr;
+    const uint8_t* _pendingBody = nullptr;
+    size_t _pendingLength = 0;
+
+#if ARDUINOEXPRESS_METRICS
+    size_t _bytesSent = 0;
+    unsigned long _sendTime = 0;  // time spent writing to the client
+#endif
 
 
     // ALWAYS UPDATE CLEAR
 
-    int getHeaderIndex(const String& ) const;
+    // int headerSlot(id, key, length)
+    // returns the index in _headers of the header named key, whose HTTP_HeaderId is id. -1 if it's not set
+    int headerSlot(HTTP_HeaderId, const char*, size_t) const;
+
+    // bool addHeader(id, key, keyLength, value, valueLength)
+    // stores a header which is not set yet. key is its name copied to the arena, null if it didn't fit.
+    // Returns false if the header is not stored
+    bool addHeader(HTTP_HeaderId, const char*, size_t, const char*, size_t);
+
+    // void setBodyText(body, length)
+    // makes text the body send() sends. It's copied to the arena if it fits in what's left of it,
+    // else it's sent from the caller's buffer, which send() writes before returning
+    void setBodyText(const char*, size_t);
+
+    // bool setValue(slot, value, length)
+    // replaces the value of the header in slot. Returns false, and keeps the value, if there's not
+    // enough memory for the new one
+    bool setValue(int, const char*, size_t);
+
+    // bool readyToSend()
+    // returns true if the status is set, there is a client and no response has been sent yet
+    bool readyToSend() const;
+
+    // returns false for the statuses that can't have a body: 1xx, 204 and 304
+    bool bodyAllowed() const {return this->_status >= 200 && this->_status != 204 && this->_status != 304;}
+
+    // void writeHead(contentLength, chunked)
+    // writes the status line and the headers to the output buffer. Used by send() and beginStream()
+    void writeHead(size_t, bool);
+
+    // void writeFraming(contentLength, chunked)
+    // writes the headers the response sets itself, which end the head: the body's length or
+    // chunked encoding, and Connection
+    void writeFraming(size_t, bool);
+
+    // void sendBody(body, length)
+    // writes the body of a buffered response after its head, and sends the response. The rest of
+    // a large body held in _body is left to sendMore()
+    void sendBody(const uint8_t*, size_t);
+
+    // bool sendSource(status, contentType, length, source)
+    // sends the head of a response whose body source reads, and leaves the body to sendMore()
+    bool sendSource(int, const char*, size_t, BodySource* );
+
+    // void endSource()
+    // destroys the body source, e.g. closing the file it reads
+    void endSource();
+
+    // bool compressible()
+    // returns true if send() compresses the body: compression is enabled, the body is large enough,
+    // its Content-Type is text and it's not encoded yet
+    bool compressible() const;
+
+    // void sendCompressed()
+    // sends the body compressed, as a chunked stream since its compressed length is not known
+    void sendCompressed();
+
+    // void writeOutput(data, length)
+    // copies bytes to the output buffer, flushing it whenever it's full
+    void writeOutput(const char*, size_t);
+    void writeOutput(const String& text) {writeOutput(text.c_str(), text.length());}
+    void writeOutput(const HTTP_StringView& text) {writeOutput(text.c_str(), text.length());}
+    // copies bytes from flash (PROGMEM) to the output buffer
+    void writeOutput_P(PGM_P, size_t);
+
+    // void writeClient(data, length)
+    // writes bytes to the client, every write of the response goes through it
+    void writeClient(const uint8_t*, size_t);
+
+    // void closeChunk()
+    // ends the open chunk of a chunked stream in the output buffer, without writing it
+    void closeChunk();
+
+    // void flushOutput()
+    // writes the output buffer to the client, closing the open chunk of a chunked stream
+    void flushOutput();
 
   public:
-    HTTP_Response(WiFiClient *client): _client{client} {};
+    HTTP_Response(HTTP_Client *client): _client{client} {};
+    ~HTTP_Response() {endSource();}
 
     int status() const {return this->_status;}
-    const String& statusText() const {return this->_statusText;}
-    const HTTP_Header* headers() const {return this->_headers;}
-    const String& body() const {return this->_body;}
+    String statusText() const {return this->_statusText_P ? String(FPSTR(this->_statusText_P)) : this->_statusText.toString();}
+    const HTTP_HeaderView* headers() const {return this->_headers;}
+    // the body of a buffered response, until reset(). A body sent from the caller's buffer is only
+    // valid while send() writes it
+    HTTP_StringView body() const {return this->_bodyView;}
     bool responseSent() const {return this->_responseSent;}
+
+    // the connection is kept open after the response if keepAlive is set, and the handler has
+    // not set a "Connection: close" header. Once the head is written, keepAlive() is what it said,
+    // and setKeepAlive() can't change it
+    bool keepAlive() const {return this->_keepAlive;}
+    void setKeepAlive(bool keepAlive) {if(!this->_responseSent) this->_keepAlive = keepAlive;}
     
     void setStatus(int, const String& ); // the status text is optional, it will be filled if none is provided
+
+    // header names are case-insensitive. Well known headers are found faster by their HTTP_HeaderId
+    bool hasHeader(HTTP_HeaderId id) const {return this->_headerIndex.slot(id) != -1;}
     bool hasHeader(const String& ) const;
-    const String& getHeader(const String& ) const;
-    void setHeader(const String&, const String& );
+    HTTP_StringView getHeader(HTTP_HeaderId ) const;  // empty if the header is not set
+    HTTP_StringView getHeader(const String& ) const;
+    // the text arguments are copied: literals are passed as they are, without making a String of them.
+    // setHeader() returns false if the header is not set: there are MAX_HEADERS_COUNT already, or
+    // the heap is out of memory
+    bool setHeader(HTTP_HeaderId id, const String& value) {return setHeader(id, value.c_str(), value.length());}
+    bool setHeader(HTTP_HeaderId id, const char* value) {return setHeader(id, value, strlen(value));}
+    bool setHeader(HTTP_HeaderId, const char*, size_t);
+    bool setHeader(const String& key, const String& value) {return setHeader(key.c_str(), key.length(), value.c_str(), value.length());}
+    bool setHeader(const char* key, const char* value) {return setHeader(key, strlen(key), value, strlen(value));}
+    bool setHeader(const char*, size_t, const char*, size_t);
     void setBody(const String&, const String& );  //Content-Type, Body
     
 
     bool send();
     bool send(int, const String&, const String& ); //status, Content-Type, Body
+    bool send(int, const char*, const String& );
+    bool send(int, const char*, const char* );
     bool json(int, const String& ); // use the send function with content-type = text/json
+    bool json(int, const char* );
+
+    /* bool send_P(status, contentType, body, length)
+      * sends a body kept in flash (PROGMEM), e.g. a page compressed at build time, which is sent with
+      * res.setHeader(HEADER_CONTENT_ENCODING, "gzip"). The body is never copied to RAM whole, nor
+      * compressed again
+      * */
+    bool send_P(int, const char*, PGM_P, size_t);
+    bool send_P(int status, const String& contentType, PGM_P body, size_t length) {return send_P(status, contentType.c_str(), body, length);}
+
+    /* bool sendFrom(status, contentType, length, reader)
+      * sends a body of length bytes read by reader(data, size), a callable that reads at most size
+      * bytes into data and returns the bytes read, e.g. from a file it holds. The body is sent
+      * STATIC_CHUNK_SIZE bytes at a time, across passes of handle(), as fast as the client takes
+      * it: the reader is kept by the response until then, and destroyed after. Returns false,
+      * without sending anything, if there's no memory for the reader or the response can't be sent
+      * */
+    template<typename Reader>
+    bool sendFrom(int status, const char* contentType, size_t length, Reader reader)
+    {
+      void* storage = this->_arena.alloc(sizeof(BodyReader<Reader>));
+      if(!storage){
+        logerr("Not enough memory for the body of the response");
+        return false;
+      }
+      return sendSource(status, contentType, length, new (storage) BodyReader<Reader>(std::move(reader)));
+    }
+
+    // size_t sendMore()
+    // writes the next chunks of a body sent across polls, as many as the client takes without
+    // waiting. Returns the bytes written
+    size_t sendMore();
+    // returns true until the whole body is written
+    bool sendingBody() const {return this->_pendingLength > 0;}
+
+    /* void setCompression(encoding, minSize)
+      * makes send() compress bodies of at least minSize bytes with encoding (ENCODING_GZIP or
+      * ENCODING_DEFLATE), if their Content-Type is text (text/ types, JSON, JavaScript, XML or SVG) and
+      * no Content-Encoding is set. Set by the Compress() middleware from the request's Accept-Encoding.
+      * Compressed bodies are sent chunked. Streamed responses are not compressed
+      * */
+    void setCompression(HTTP_Encoding encoding, size_t minSize)
+    {
+      this->_encoding = encoding;
+      this->_compressMinSize = minSize;
+    }
+    HTTP_Encoding compression() const {return this->_encoding;}
+
+    /* size_t serializeHead(buffer, capacity)
+      * writes the status line and headers of the response to buffer, without the headers the response
+      * sets itself (Content-Length, Transfer-Encoding and Connection). Returns the length of the head, 
+      * it's only written if it fits in capacity.
+      * */
+    size_t serializeHead(char*, size_t) const;
+
+    /* bool sendSerialized(status, head, headLength, body, bodyLength)
+      * sends a response serialized earlier: head is the output of serializeHead().
+      * The response sets the Content-Length and Connection headers, as send() does.
+      * */
+    bool sendSerialized(int, const char*, size_t, const uint8_t*, size_t);
+
+    // the observer is notified by the next send(), before the response is written.
+    // Used by the response cache to store the response. reset() removes it
+    void setSendObserver(HTTP_SendObserver* observer) {this->_sendObserver = observer;}
+
+    /* Streaming responses: the body is written a piece at a time instead of being held in a String.
+      * beginStream(status, contentType) sends the body with "Transfer-Encoding: chunked",
+      * beginStream(status, contentType, contentLength) with a Content-Length, in which case exactly 
+      * contentLength bytes must be written.
+      * The status line and headers set so far are sent with the first bytes of the body, and can't
+      * be changed after beginStream(). end() finishes the response, it is called by ArduinoExpress
+      * if the handler doesn't.
+      * */
+    bool beginStream(int, const char* );
+    bool beginStream(int, const char*, size_t );
+    bool beginStream(int status, const String& contentType) {return beginStream(status, contentType.c_str());}
+    bool beginStream(int status, const String& contentType, size_t contentLength) {return beginStream(status, contentType.c_str(), contentLength);}
+    size_t write(const uint8_t*, size_t );
+    size_t write(const char* text) {return write((const uint8_t*)text, strlen(text));}
+    bool end();
+    bool streaming() const {return this->_streaming;}
+
+#if ARDUINOEXPRESS_METRICS
+    size_t bytesSent() const {return this->_bytesSent;}
+    unsigned long sendTime() const {return this->_sendTime;}
+#endif
+
+    void clear()
+    {
+      reset();
+      this->_client = nullptr;
+    }
 
-    void clear() {*this = HTTP_Response{nullptr};}
+    // void reset()
+    // prepares the response for the next request on the same client. 
+    // Unlike clear(), the client is kept
+    void reset();
  };
 
 
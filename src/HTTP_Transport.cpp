@@ -0,0 +1,25 @@
+#include "HTTP_Transport.h"
+
+#if !ARDUINOEXPRESS_POSIX_TRANSPORT
+
+bool HTTP_WiFiTransport::begin(int port)
+{
+  // begin() can be called again, to move to another port
+  this->_server.stop();
+  this->_server = WiFiServer{(uint16_t)port};
+  this->_server.begin();
+  return true;
+}
+
+
+bool HTTP_WiFiTransport::accept(int slot)
+{
+  // clients that find no free slot wait in the server's backlog
+  WiFiClient client = this->_server.available();
+  if(!client) return false;
+
+  this->_clients[slot] = client;
+  return true;
+}
+
+#endif
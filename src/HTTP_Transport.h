@@ -0,0 +1,108 @@
+/*
+ * This library provides HTTP_Transport, what ArduinoExpress accepts its clients from and reads and
+ * writes them with, and HTTP_WiFiTransport, the transport of the ESP8266's WiFiServer
+ */
+
+#ifndef HTTP_TRANSPORT_HEADER
+#define HTTP_TRANSPORT_HEADER
+
+#include "HTTP_Utilities.h"
+
+#include <limits.h>
+
+/* HTTP_Transport is the network under ArduinoExpress. Its clients are kept in slots, one per
+  * connection, numbered from 0 to MAX_CONNECTIONS_COUNT - 1: a connection only knows its slot.
+  * None of the calls waits for the network, except write(), which returns once the bytes are sent,
+  * or once they are buffered by a transport that sends them later, see sending()
+*/
+struct HTTP_Transport{
+  // bool begin(port)
+  // starts listening on port. Returns false if it can't
+  virtual bool begin(int port) = 0;
+
+  // bool accept(slot)
+  // takes a waiting client into the free slot. Returns false if no client is waiting
+  virtual bool accept(int slot) = 0;
+
+  // returns the bytes of the slot's client that can be read without waiting
+  virtual int available(int slot) = 0;
+  // reads at most length bytes, returns the bytes read
+  virtual int read(int slot, uint8_t*, size_t length) = 0;
+  // writes length bytes, returns the bytes written, less if the client is gone
+  virtual size_t write(int slot, const uint8_t*, size_t length) = 0;
+  // returns the bytes write() takes without waiting for the client, or buffering them. Transports
+  // that can't tell return INT_MAX
+  virtual int availableForWrite(int ) {return INT_MAX;}
+  // returns true while bytes written to the slot are still waiting to be sent, by a transport that
+  // buffers what its client doesn't take at once. Transports whose write() waits return false
+  virtual bool sending(int ) {return false;}
+  // returns false once the client has disconnected, and its remaining bytes were read
+  virtual bool connected(int slot) = 0;
+  // disconnects the client and frees the slot
+  virtual void stop(int slot) = 0;
+  // half-closes the client: what was written is sent, followed by the end of the stream, and what
+  // the client sends can still be read. Transports that can't do nothing
+  virtual void shutdown(int ) {}
+  // returns the IPv4 address of the slot's client, 0 if the transport doesn't know it
+  virtual uint32_t remoteIP(int ) {return 0;}
+
+  // void wait(timeout)
+  // waits at most timeout milliseconds for a client to connect or send bytes. Transports that
+  // can't wait return at once
+  virtual void wait(unsigned long ) {}
+
+  virtual ~HTTP_Transport() {}
+};
+
+
+/* HTTP_Client is the client of one slot of a transport, what a connection and its response read
+  * and write. It's false if it has no transport
+*/
+struct HTTP_Client{
+  private:
+    HTTP_Transport* _transport = nullptr;
+    int _slot = -1;
+
+  public:
+    HTTP_Client() {}
+    HTTP_Client(HTTP_Transport& transport, int slot): _transport{&transport}, _slot{slot} {}
+
+    explicit operator bool() const {return this->_transport != nullptr;}
+    int slot() const {return this->_slot;}
+
+    int available() {return this->_transport->available(this->_slot);}
+    int read(uint8_t* data, size_t length) {return this->_transport->read(this->_slot, data, length);}
+    size_t write(const uint8_t* data, size_t length) {return this->_transport->write(this->_slot, data, length);}
+    int availableForWrite() {return this->_transport->availableForWrite(this->_slot);}
+    bool sending() {return this->_transport->sending(this->_slot);}
+    bool connected() {return this->_transport->connected(this->_slot);}
+    void stop() {this->_transport->stop(this->_slot);}
+    void shutdown() {this->_transport->shutdown(this->_slot);}
+    uint32_t remoteIP() {return this->_transport->remoteIP(this->_slot);}
+};
+
+
+#if !ARDUINOEXPRESS_POSIX_TRANSPORT
+
+// HTTP_WiFiTransport serves the WiFiClients of a WiFiServer, it's the transport of ArduinoExpress
+// unless another one is set
+struct HTTP_WiFiTransport : public HTTP_Transport{
+  private:
+    WiFiServer _server{80};
+    WiFiClient _clients[ArduinoExpressConfig::MAX_CONNECTIONS_COUNT];
+
+  public:
+    bool begin(int port) override;
+    bool accept(int slot) override;
+    int available(int slot) override {return this->_clients[slot].available();}
+    int read(int slot, uint8_t* data, size_t length) override {return this->_clients[slot].read(data, length);}
+    size_t write(int slot, const uint8_t* data, size_t length) override {return this->_clients[slot].write(data, length);}
+    int availableForWrite(int slot) override {return this->_clients[slot].availableForWrite();}
+    bool connected(int slot) override {return this->_clients[slot].connected();}
+    void stop(int slot) override {this->_clients[slot].stop();}
+    uint32_t remoteIP(int slot) override {return (uint32_t)this->_clients[slot].remoteIP();}
+};
+
+#endif
+
+#endif
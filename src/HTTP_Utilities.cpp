@@ -1,16 +1,204 @@
 #include "HTTP_Utilities.h"
 
+// the names of the methods, by HTTP_Method - 1
+static const char METHOD_NAMES[HTTP_METHODS_COUNT][8] PROGMEM = {"GET", "POST", "PUT", "DELETE", "INSPECT"};
+
+PGM_P toText_P(HTTP_Method method)
+{
+  if(method < 1 || method > HTTP_METHODS_COUNT) return PSTR("");
+  return METHOD_NAMES[method - 1];
+}
+
+
 String toText(const HTTP_Method& method)
 {
-  switch(method)
+  return String(FPSTR(toText_P(method)));
+}
+
+
+HTTP_Method toMethod(const char* text)
+{
+  for(int method = 1; method <= HTTP_METHODS_COUNT; ++method){
+    if(strcmp_P(text, METHOD_NAMES[method - 1]) == 0) return static_cast<HTTP_Method>(method);
+  }
+  return static_cast<HTTP_Method>(0);
+}
+
+String HTTP_StringView::toString() const
+{
+  String text;
+  text.reserve(this->_length);
+  text.concat(this->_data, this->_length);
+  return text;
+}
+
+
+bool HTTP_StringView::equals(const char* text) const
+{
+  return strncmp(this->_data, text, this->_length) == 0 && text[this->_length] == '\0';
+}
+
+
+bool HTTP_StringView::equalsIgnoreCase(const char* text) const
+{
+  return strncasecmp(this->_data, text, this->_length) == 0 && text[this->_length] == '\0';
+}
+
+
+bool HTTP_StringView::startsWith(const String& prefix) const
+{
+  return prefix.length() <= this->_length && memcmp(this->_data, prefix.c_str(), prefix.length()) == 0;
+}
+
+
+long HTTP_StringView::toInt() const
+{
+  long value = 0;
+  for(size_t i = 0; i < this->_length && isdigit(this->_data[i]); ++i){
+    value = value * 10 + (this->_data[i] - '0');
+  }
+  return value;
+}
+
+
+bool HTTP_StringView::containsToken(const char* token) const
+{
+  size_t tokenLength = strlen(token);
+  size_t position = 0;
+  while(position < this->_length)
   {
-    case HTTP_Method::GET: return "GET";
-    case HTTP_Method::POST: return "POST";
-    case HTTP_Method::PUT: return "PUT";
-    case HTTP_Method::DELETE: return "DELETE";
-    case HTTP_Method::INSPECT: return "INSPECT";
+    while(position < this->_length && (this->_data[position] == ' ' || this->_data[position] == ',')) ++position;
+    size_t start = position;
+    while(position < this->_length && this->_data[position] != ',') ++position;
+
+    // parameters of the token, e.g. ";q=0.8", are ignored
+    size_t end = start;
+    while(end < position && this->_data[end] != ';') ++end;
+    while(end > start && this->_data[end - 1] == ' ') --end;
+    if(end - start == tokenLength && strncasecmp(this->_data + start, token, tokenLength) == 0) return true;
   }
-  return "";
+
+  return false;
+}
+
+
+// int parseQuality(parameters, length)
+// returns the q parameter of a token's parameters (";q=0.8") in thousandths, 1000 if there's none
+static int parseQuality(const char* parameters, size_t length)
+{
+  size_t position = 0;
+  while(position < length)
+  {
+    while(position < length && (parameters[position] == ';' || parameters[position] == ' ')) ++position;
+    if(position + 1 < length && (parameters[position] == 'q' || parameters[position] == 'Q') && parameters[position + 1] == '='){
+      position += 2;
+      int quality = 0;
+      if(position < length && parameters[position] == '1') return 1000;
+      if(position < length && parameters[position] == '0') ++position;
+      if(position < length && parameters[position] == '.'){
+        ++position;
+        for(int scale = 100; scale > 0 && position < length && isdigit((unsigned char)parameters[position]); scale /= 10){
+          quality += (parameters[position++] - '0') * scale;
+        }
+      }
+      return quality;
+    }
+    while(position < length && parameters[position] != ';') ++position;
+  }
+
+  return 1000;
+}
+
+
+int HTTP_StringView::tokenQuality(const char* token) const
+{
+  size_t tokenLength = strlen(token);
+  int wildcard = -1;
+  size_t position = 0;
+  while(position < this->_length)
+  {
+    while(position < this->_length && (this->_data[position] == ' ' || this->_data[position] == ',')) ++position;
+    size_t start = position;
+    while(position < this->_length && this->_data[position] != ',') ++position;
+
+    size_t end = start;
+    while(end < position && this->_data[end] != ';') ++end;
+    size_t parameters = end;
+    while(end > start && this->_data[end - 1] == ' ') --end;
+
+    int quality = parseQuality(this->_data + parameters, position - parameters);
+    if(end - start == tokenLength && strncasecmp(this->_data + start, token, tokenLength) == 0) return quality;
+    if(end - start == 1 && this->_data[start] == '*') wildcard = quality;
+  }
+
+  return wildcard;
+}
+
+
+bool operator==(const HTTP_StringView& view, const char* text)
+{
+  return view.equals(text);
+}
+
+
+bool operator==(const HTTP_StringView& view, const String& text)
+{
+  return view.length() == text.length() && memcmp(view.c_str(), text.c_str(), view.length()) == 0;
+}
+
+static int hexValue(char c)
+{
+  if(c >= '0' && c <= '9') return c - '0';
+  if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+
+size_t percentDecode(char* text, bool plusAsSpace)
+{
+  char* write = text;
+  for(const char* read = text; *read; ++read, ++write){
+    int high, low;
+    if(*read == '%' && (high = hexValue(read[1])) != -1 && (low = hexValue(read[2])) != -1){
+      *write = (char)(high * 16 + low);
+      read += 2;
+    }
+    else if(*read == '+' && plusAsSpace){
+      *write = ' ';
+    }
+    else{
+      *write = *read;
+    }
+  }
+  *write = '\0';
+  return write - text;
+}
+
+
+int parseUrlEncoded(char* text, HTTP_Param* params, int count, int maxCount)
+{
+  while(*text)
+  {
+    char* end = strchr(text, '&');
+    if(end) *end = '\0';
+
+    // "key=value", or "key" for an empty value
+    if(*text && count < maxCount){
+      char* value = strchr(text, '=');
+      if(value) *value++ = '\0';
+      else value = text + strlen(text);
+
+      HTTP_Param& param = params[count++];
+      param.key = HTTP_StringView{text, percentDecode(text, true)};
+      param.value = HTTP_StringView{value, percentDecode(value, true)};
+    }
+
+    if(!end) break;
+    text = end + 1;
+  }
+
+  return count;
 }
 
 // JsonObject& textToJSON(const char* text, int size)
@@ -26,41 +214,133 @@ String toText(const HTTP_Method& method)
 // }
 
 
-String HTTPStatusText(int status)
-{
-  if(status == 200) return "OK";
-  else if(status == 400) return "Bad Request";
-  else if(status == 401) return "Unauthorized";
-  else if(status == 403) return "Forbidden";
-  else if(status == 404) return "Not Found";
-  else if(status == 405) return "Method Not Allowed";
-  else if(status == 500) return "Internal Server Error";
-  return "Unknown";
-}
+// the reason phrases of the statuses the library and most handlers send
+struct StatusText{
+  uint16_t status;
+  char text[32];
+};
 
+static const StatusText STATUS_TEXTS[] PROGMEM = {
+  {200, "OK"},
+  {201, "Created"},
+  {202, "Accepted"},
+  {204, "No Content"},
+  {206, "Partial Content"},
+  {301, "Moved Permanently"},
+  {302, "Found"},
+  {304, "Not Modified"},
+  {400, "Bad Request"},
+  {401, "Unauthorized"},
+  {403, "Forbidden"},
+  {404, "Not Found"},
+  {405, "Method Not Allowed"},
+  {406, "Not Acceptable"},
+  {408, "Request Timeout"},
+  {413, "Payload Too Large"},
+  {414, "URI Too Long"},
+  {416, "Range Not Satisfiable"},
+  {429, "Too Many Requests"},
+  {431, "Request Header Fields Too Large"},
+  {500, "Internal Server Error"},
+  {501, "Not Implemented"},
+  {503, "Service Unavailable"},
+};
 
-// ----------- LOGGING ------------
-void logdebug(const String& debugString)
+PGM_P HTTPStatusText_P(int status)
 {
-  Serial.println(String("DEBUG: ") + debugString);
+  for(const StatusText& entry : STATUS_TEXTS){
+    if(pgm_read_word(&entry.status) == status) return entry.text;
+  }
+  return PSTR("Unknown");
 }
 
-void loginfo(const String& info)
+
+String HTTPStatusText(int status)
 {
-  Serial.println(String("INFO: ") + info);
+  return String(FPSTR(HTTPStatusText_P(status)));
 }
 
-void logwarn(const String& warning)
+
+// ----------- LOGGING ------------
+static const char LOG_DEBUG_PREFIX[] PROGMEM = "DEBUG: ";
+static const char LOG_INFO_PREFIX[] PROGMEM = "INFO: ";
+static const char LOG_WARN_PREFIX[] PROGMEM = "WARN: ";
+static const char LOG_ERROR_PREFIX[] PROGMEM = "ERROR: ";
+static const char LOG_FATAL_PREFIX[] PROGMEM = "FATAL: ";
+static const char* const LOG_PREFIXES[] PROGMEM = {LOG_DEBUG_PREFIX, LOG_INFO_PREFIX, LOG_WARN_PREFIX, 
+                                                   LOG_ERROR_PREFIX, LOG_FATAL_PREFIX};
+
+#if ARDUINOEXPRESS_LOG_BUFFER_SIZE > 0
+// the log buffer: messages are queued at _logTail, and written to Serial from _logHead.
+// A message that doesn't fit is dropped whole
+static char _logBuffer[ARDUINOEXPRESS_LOG_BUFFER_SIZE];
+static size_t _logHead = 0;
+static size_t _logSize = 0;
+static unsigned long _logDropped = 0;
+
+static void logqueue(const char* line, size_t length)
 {
-  Serial.println(String("WARN: ") + warning);
+  if(length > ARDUINOEXPRESS_LOG_BUFFER_SIZE - _logSize){
+    ++_logDropped;
+    return;
+  }
+
+  size_t tail = (_logHead + _logSize) % ARDUINOEXPRESS_LOG_BUFFER_SIZE;
+  size_t first = ARDUINOEXPRESS_LOG_BUFFER_SIZE - tail < length ? ARDUINOEXPRESS_LOG_BUFFER_SIZE - tail : length;
+  memcpy(_logBuffer + tail, line, first);
+  memcpy(_logBuffer, line + first, length - first);
+  _logSize += length;
 }
+#endif
+
 
-void logerr(const String& err)
+void logprint_P(int level, PGM_P format, ...)
 {
-  Serial.println(String("ERROR: ") + err);
+  const size_t MAX_LOG_LINE_LENGTH = ArduinoExpressConfig::MAX_LOG_LINE_LENGTH;
+  char line[MAX_LOG_LINE_LENGTH];
+
+  // "LEVEL: message\r\n", the message is cut to fit the line
+  PGM_P prefix = (PGM_P)pgm_read_ptr(&LOG_PREFIXES[level]);
+  size_t length = strlen_P(prefix);
+  memcpy_P(line, prefix, length);
+
+  size_t space = MAX_LOG_LINE_LENGTH - length - 2;
+  va_list args;
+  va_start(args, format);
+  int written = vsnprintf_P(line + length, space, format, args);
+  va_end(args);
+  if(written > 0) length += (size_t)written < space ? written : space - 1;
+  line[length++] = '\r';
+  line[length++] = '\n';
+
+#if ARDUINOEXPRESS_LOG_BUFFER_SIZE > 0
+  logqueue(line, length);
+#else
+  Serial.write((const uint8_t*)line, length);
+#endif
 }
 
-void logfatal(const String& info)
+
+void logflush()
 {
-  Serial.println(String("FATAL: ") + info);
+#if ARDUINOEXPRESS_LOG_BUFFER_SIZE > 0
+  while(_logSize > 0)
+  {
+    int space = Serial.availableForWrite();
+    if(space <= 0) return;
+
+    size_t contiguous = ARDUINOEXPRESS_LOG_BUFFER_SIZE - _logHead < _logSize ? ARDUINOEXPRESS_LOG_BUFFER_SIZE - _logHead : _logSize;
+    size_t count = contiguous < (size_t)space ? contiguous : space;
+    Serial.write((const uint8_t*)_logBuffer + _logHead, count);
+    _logHead = (_logHead + count) % ARDUINOEXPRESS_LOG_BUFFER_SIZE;
+    _logSize -= count;
+  }
+
+  // the dropped messages are reported once the buffer has room again
+  if(_logDropped > 0){
+    unsigned long dropped = _logDropped;
+    _logDropped = 0;
+    logprint_P(ARDUINOEXPRESS_LOG_WARN, PSTR("%lu log messages dropped"), dropped);
+  }
+#endif
 }
@@ -1,40 +1,147 @@
 #ifndef HTTP_UTILITIES_HEADER
 #define HTTP_UTILITIES_HEADER
 
-#include <Arduino.h>
+#include "platform.h"
 #include <ArduinoJson.h>
 #include "config.h"
 #include "utilities.h"
 
 enum HTTP_Method : int{GET = 1, POST = 2, PUT = 3, DELETE = 4, INSPECT = 5};
+const int HTTP_METHODS_COUNT = 5;
 
+// PGM_P toText_P(method)
+// returns the name of a method, in flash. Empty if method is not a known method
+PGM_P toText_P(HTTP_Method method);
 String toText(const HTTP_Method& method);
 
+// HTTP_Method toMethod(text)
+// returns the HTTP_Method named by text, or 0 if text is not a known method
+HTTP_Method toMethod(const char* text);
+
+/* A read-only view of characters owned by someone else, usually the request buffer of a connection.
+  * Views created by the HTTP_RequestParser are null-terminated, so c_str() can be used on them.
+  * A view is only valid until the request it belongs to is cleared.
+*/
+struct HTTP_StringView{
+  private:
+    const char* _data = "";
+    size_t _length = 0;
+
+  public:
+    HTTP_StringView() {}
+    HTTP_StringView(const char* data, size_t length): _data{data}, _length{length} {}
+
+    const char* c_str() const {return this->_data;}
+    size_t length() const {return this->_length;}
+    bool isEmpty() const {return this->_length == 0;}
+    char operator[](size_t index) const {return this->_data[index];}
+
+    // returns a copy of the viewed characters
+    String toString() const;
+
+    bool equals(const char* ) const;
+    bool equalsIgnoreCase(const char* ) const;
+    bool startsWith(const String& ) const;
+    long toInt() const;
+
+    // bool containsToken(token)
+    // returns true if this comma separated list (e.g. a Connection header) contains token,
+    // ignoring case and the token's parameters (";q=0.5")
+    bool containsToken(const char* ) const;
+
+    // int tokenQuality(token)
+    // returns the quality this comma separated list (e.g. an Accept-Encoding header) gives token, in
+    // thousandths: 1000 for "gzip" or "gzip;q=1", 500 for "gzip;q=0.5", 0 for "gzip;q=0", which
+    // refuses it. A token that's not listed gets the quality of "*", -1 if there's none
+    int tokenQuality(const char* ) const;
+};
+
+bool operator==(const HTTP_StringView&, const char* );
+bool operator==(const HTTP_StringView&, const String& );
+inline bool operator==(const char* text, const HTTP_StringView& view) {return view == text;}
+inline bool operator==(const String& text, const HTTP_StringView& view) {return view == text;}
+inline bool operator!=(const HTTP_StringView& view, const char* text) {return !(view == text);}
+inline bool operator!=(const HTTP_StringView& view, const String& text) {return !(view == text);}
+
 struct HTTP_User{
   String user_id;
   String user_auth;
 };
 
-struct HTTP_Header{
-  String key;
-  String value;
+// a request header, viewing the request buffer
+struct HTTP_HeaderView{
+  HTTP_StringView key;
+  HTTP_StringView value;
 };
 
+// a route or query parameter, viewing the request buffer
 struct HTTP_Param{
-  String key;
-  String value;
+  HTTP_StringView key;
+  HTTP_StringView value;
 };
 
+// size_t percentDecode(text, plusAsSpace)
+// decodes the %XX escapes of a null-terminated text in place, and '+' as ' ' if plusAsSpace is set
+// (query strings). Returns the length of the decoded text
+size_t percentDecode(char* text, bool plusAsSpace);
+
+// int parseUrlEncoded(text, params, count, maxCount)
+// splits a null-terminated "key=value&key2=value2" text (a query string or a form body) in place,
+// and appends its decoded parameters to params, after the count already there. Parameters past
+// maxCount are dropped. Returns the new count
+int parseUrlEncoded(char* text, HTTP_Param* params, int count, int maxCount);
+
 // JsonObject& textToJSON(const char* , int );
 
+// PGM_P HTTPStatusText_P(status)
+// returns the reason phrase of a status, in flash: "Not Found" for 404, "Unknown" for unknown statuses
+PGM_P HTTPStatusText_P(int status);
 String HTTPStatusText(int status);
 
 
 // ---------- LOGGING ---------------
-void logdebug(const String& message);
-void loginfo(const String& message);
-void logerr(const String& message);
-void logwarn(const String& message);
-void logfatal(const String& message);
+/* logdebug(format, ...), loginfo, logwarn, logerr and logfatal log a printf-style message, whose
+  * format is a string literal kept in flash: logwarn("%d clients waiting", count).
+  * The calls below ARDUINOEXPRESS_LOG_LEVEL compile to nothing, their arguments are not evaluated.
+*/
+
+// void logprint_P(level, format, ...)
+// formats a message and writes it to Serial, or to the log buffer if there is one
+void logprint_P(int level, PGM_P format, ...);
+
+// void logflush()
+// writes the messages queued in the log buffer to Serial, as much as Serial takes without blocking.
+// ArduinoExpress calls it between requests
+void logflush();
+
+#if ARDUINOEXPRESS_LOG_LEVEL <= ARDUINOEXPRESS_LOG_DEBUG
+#define logdebug(format, ...) logprint_P(ARDUINOEXPRESS_LOG_DEBUG, PSTR(format), ##__VA_ARGS__)
+#else
+#define logdebug(format, ...) ((void)0)
+#endif
+
+#if ARDUINOEXPRESS_LOG_LEVEL <= ARDUINOEXPRESS_LOG_INFO
+#define loginfo(format, ...) logprint_P(ARDUINOEXPRESS_LOG_INFO, PSTR(format), ##__VA_ARGS__)
+#else
+#define loginfo(format, ...) ((void)0)
+#endif
+
+#if ARDUINOEXPRESS_LOG_LEVEL <= ARDUINOEXPRESS_LOG_WARN
+#define logwarn(format, ...) logprint_P(ARDUINOEXPRESS_LOG_WARN, PSTR(format), ##__VA_ARGS__)
+#else
+#define logwarn(format, ...) ((void)0)
+#endif
+
+#if ARDUINOEXPRESS_LOG_LEVEL <= ARDUINOEXPRESS_LOG_ERROR
+#define logerr(format, ...) logprint_P(ARDUINOEXPRESS_LOG_ERROR, PSTR(format), ##__VA_ARGS__)
+#else
+#define logerr(format, ...) ((void)0)
+#endif
+
+#if ARDUINOEXPRESS_LOG_LEVEL <= ARDUINOEXPRESS_LOG_FATAL
+#define logfatal(format, ...) logprint_P(ARDUINOEXPRESS_LOG_FATAL, PSTR(format), ##__VA_ARGS__)
+#else
+#define logfatal(format, ...) ((void)0)
+#endif
 
 #endif
@@ -0,0 +1,132 @@
+/*
+ * This library provides InplaceFunction, the callable wrapper handlers and middlewares are stored in with
+ * ARDUINOEXPRESS_INPLACE_CALLBACKS, and body consumers always.
+ * Unlike std::function it doesn't allocate to store the callable: it's kept inside the InplaceFunction.
+ * Copying one copies the callable, and so its captures: a captured String is copied like any String
+ */
+
+#ifndef INPLACE_FUNCTION_HEADER
+#define INPLACE_FUNCTION_HEADER
+
+#include <stddef.h>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+template<typename Signature, size_t Capacity>
+class InplaceFunction;
+
+/* InplaceFunction<R(Args...), Capacity> holds any callable (a function, a lambda, a functor) whose
+  * size is at most Capacity bytes, in its own storage. A captureless lambda or a function is called
+  * through a single indirect call, with no allocation. Moving an InplaceFunction moves the callable,
+  * so a stored lambda's captured Strings are handed over instead of copied.
+  * Storing a callable that doesn't fit (e.g. a lambda with too many captures) fails to compile.
+*/
+template<typename R, typename... Args, size_t Capacity>
+class InplaceFunction<R(Args...), Capacity>{
+  private:
+    using Invoker = R (*)(void*, Args...);
+    enum Operation {COPY, MOVE, DESTROY};
+    // copies or moves the callable at source to destination, or destroys the callable at destination
+    using Manager = void (*)(Operation, void*, void*);
+
+    typename std::aligned_storage<Capacity, alignof(void*)>::type _storage;
+    Invoker _invoke = nullptr;
+    Manager _manage = nullptr;
+
+    // the template parameters are not named F, it's the flash string macro of Arduino
+    template<typename Callable>
+    static R invoke(void* callable, Args... args)
+    {
+      return (*static_cast<Callable*>(callable))(std::forward<Args>(args)...);
+    }
+
+    template<typename Callable>
+    static void manage(Operation operation, void* destination, void* source)
+    {
+      switch(operation){
+        case COPY: new (destination) Callable(*static_cast<const Callable*>(source)); break;
+        case MOVE: new (destination) Callable(std::move(*static_cast<Callable*>(source))); break;
+        case DESTROY: static_cast<Callable*>(destination)->~Callable(); break;
+      }
+    }
+
+    void copy(const InplaceFunction& other)
+    {
+      if(other._manage) other._manage(COPY, &this->_storage, const_cast<void*>(static_cast<const void*>(&other._storage)));
+      this->_invoke = other._invoke;
+      this->_manage = other._manage;
+    }
+
+    // takes other's callable, other is left empty
+    void take(InplaceFunction& other)
+    {
+      if(other._manage) other._manage(MOVE, &this->_storage, &other._storage);
+      this->_invoke = other._invoke;
+      this->_manage = other._manage;
+      other.reset();
+    }
+
+    void reset()
+    {
+      if(this->_manage) this->_manage(DESTROY, &this->_storage, nullptr);
+      this->_invoke = nullptr;
+      this->_manage = nullptr;
+    }
+
+  public:
+    InplaceFunction() {}
+    InplaceFunction(decltype(nullptr)) {}
+
+    template<typename Function, typename Callable = typename std::decay<Function>::type,
+             typename = typename std::enable_if<!std::is_same<Callable, InplaceFunction>::value>::type,
+             typename = decltype(std::declval<Callable&>()(std::declval<Args>()...))>
+    InplaceFunction(Function&& callable)
+    {
+      static_assert(sizeof(Callable) <= Capacity,
+                    "The callable is too large for InplaceFunction: capture less, or increase the storage size in config.h");
+      static_assert(alignof(Callable) <= alignof(void*), "The callable's alignment is not supported by InplaceFunction");
+
+      new (&this->_storage) Callable(std::forward<Function>(callable));
+      this->_invoke = &InplaceFunction::invoke<Callable>;
+      this->_manage = &InplaceFunction::manage<Callable>;
+    }
+
+    InplaceFunction(const InplaceFunction& other) {copy(other);}
+    InplaceFunction(InplaceFunction&& other) {take(other);}
+
+    InplaceFunction& operator=(const InplaceFunction& other)
+    {
+      if(this != &other){
+        reset();
+        copy(other);
+      }
+      return *this;
+    }
+
+    InplaceFunction& operator=(InplaceFunction&& other)
+    {
+      if(this != &other){
+        reset();
+        take(other);
+      }
+      return *this;
+    }
+
+    InplaceFunction& operator=(decltype(nullptr))
+    {
+      reset();
+      return *this;
+    }
+
+    ~InplaceFunction() {reset();}
+
+    explicit operator bool() const {return this->_invoke != nullptr;}
+
+    R operator()(Args... args) const
+    {
+      return this->_invoke(const_cast<void*>(static_cast<const void*>(&this->_storage)), std::forward<Args>(args)...);
+    }
+};
+
+#endif
@@ -0,0 +1,36 @@
+#include "ArduinoExpress.h"
+
+/* The middleware created by ArduinoExpress::Json */
+struct JsonBody{
+  size_t maxBodySize;
+
+  void* operator()(Req& req, Res& res, Next next) const
+  {
+    if((req.body.isEmpty() && !req.bodyStreamed) || !req.getHeader(HEADER_CONTENT_TYPE).containsToken("application/json")){
+      next();
+      return nullptr;
+    }
+
+    // a streamed body is larger than the request buffer, it can't be parsed
+    if(req.bodyStreamed || (maxBodySize > 0 && req.body.length() > maxBodySize)){
+      res.send(413, "text/plain", HTTPStatusText(413));
+      return nullptr;
+    }
+
+    // the document is kept by the request, the handler's req.json() doesn't parse it again
+    if(!req.json().success()){
+      int status = req.jsonStatus();
+      res.send(status, "text/plain", HTTPStatusText(status));
+      return nullptr;
+    }
+
+    next();
+    return nullptr;
+  }
+};
+
+
+MiddlewareFunction ArduinoExpress::Json(size_t maxBodySize)
+{
+  return JsonBody{maxBodySize};
+}
@@ -0,0 +1,113 @@
+#include "ArduinoExpress.h"
+
+#if ARDUINOEXPRESS_METRICS
+
+static const char PHASE_NAMES[METRICS_PHASES_COUNT][9] PROGMEM = {"parse", "dispatch", "handler", "send"};
+static const char STATUS_CLASSES[5][4] PROGMEM = {"1xx", "2xx", "3xx", "4xx", "5xx"};
+
+// void writeSeconds(text, size, microseconds)
+// formats a duration in seconds, without trailing zeros: 1500 is "0.0015"
+static void writeSeconds(char* text, size_t size, uint64_t microseconds)
+{
+  int length = snprintf(text, size, "%lu.%06lu", (unsigned long)(microseconds / 1000000), 
+                        (unsigned long)(microseconds % 1000000));
+  while(length > 2 && text[length - 1] == '0' && text[length - 2] != '.') text[--length] = '\0';
+}
+
+
+/* The endpoint created by ArduinoExpress::Metrics. The metrics are written a line at a time,
+  * to a chunked response
+*/
+struct MetricsEndpoint{
+  void* operator()(Req&, Res& res) const
+  {
+    const int METRICS_BUCKETS_COUNT = ArduinoExpressConfig::METRICS_BUCKETS_COUNT;
+    char line[160];
+    char seconds[24];
+    char phase[9];
+    char status[4];
+    char method[8];
+
+    int routesCount;
+    const HTTP_RouteMetrics* routes = metricsRoutes(routesCount);
+
+    res.beginStream(200, "text/plain; version=0.0.4");
+
+    res.write("# TYPE arduinoexpress_requests_total counter\n");
+    for(int i = 0; i < routesCount; ++i){
+      strcpy_P(method, toText_P(routes[i].method));
+      snprintf_P(line, sizeof(line), PSTR("arduinoexpress_requests_total{method=\"%s\",route=\"%s\"} %lu\n"), 
+                 method, routes[i].path.c_str(), (unsigned long)routes[i].requests);
+      res.write(line);
+    }
+
+    res.write("# TYPE arduinoexpress_responses_total counter\n");
+    for(int i = 0; i < routesCount; ++i){
+      strcpy_P(method, toText_P(routes[i].method));
+      for(int statusClass = 0; statusClass < 5; ++statusClass){
+        if(routes[i].statuses[statusClass] == 0) continue;
+        strcpy_P(status, STATUS_CLASSES[statusClass]);
+        snprintf_P(line, sizeof(line), PSTR("arduinoexpress_responses_total{method=\"%s\",route=\"%s\",code=\"%s\"} %lu\n"),
+                   method, routes[i].path.c_str(), status, 
+                   (unsigned long)routes[i].statuses[statusClass]);
+        res.write(line);
+      }
+    }
+
+    res.write("# TYPE arduinoexpress_received_bytes_total counter\n");
+    for(int i = 0; i < routesCount; ++i){
+      strcpy_P(method, toText_P(routes[i].method));
+      snprintf_P(line, sizeof(line), PSTR("arduinoexpress_received_bytes_total{method=\"%s\",route=\"%s\"} %lu\n"), 
+                 method, routes[i].path.c_str(), (unsigned long)routes[i].bytesIn);
+      res.write(line);
+    }
+
+    res.write("# TYPE arduinoexpress_sent_bytes_total counter\n");
+    for(int i = 0; i < routesCount; ++i){
+      strcpy_P(method, toText_P(routes[i].method));
+      snprintf_P(line, sizeof(line), PSTR("arduinoexpress_sent_bytes_total{method=\"%s\",route=\"%s\"} %lu\n"), 
+                 method, routes[i].path.c_str(), (unsigned long)routes[i].bytesOut);
+      res.write(line);
+    }
+
+    res.write("# TYPE arduinoexpress_phase_duration_seconds histogram\n");
+    for(int i = 0; i < routesCount; ++i){
+      strcpy_P(method, toText_P(routes[i].method));
+      for(int p = 0; p < METRICS_PHASES_COUNT; ++p){
+        const HTTP_Histogram& histogram = routes[i].phases[p];
+        strcpy_P(phase, PHASE_NAMES[p]);
+
+        // buckets are cumulative in the Prometheus format
+        uint32_t cumulative = 0;
+        for(int bucket = 0; bucket <= METRICS_BUCKETS_COUNT; ++bucket){
+          cumulative += histogram.buckets[bucket];
+          if(bucket < METRICS_BUCKETS_COUNT) writeSeconds(seconds, sizeof(seconds), ArduinoExpressConfig::METRICS_BUCKETS_US[bucket]);
+          else strcpy(seconds, "+Inf");
+
+          snprintf_P(line, sizeof(line), PSTR("arduinoexpress_phase_duration_seconds_bucket{method=\"%s\",route=\"%s\",phase=\"%s\",le=\"%s\"} %lu\n"),
+                     method, routes[i].path.c_str(), phase, seconds, (unsigned long)cumulative);
+          res.write(line);
+        }
+
+        writeSeconds(seconds, sizeof(seconds), histogram.sum);
+        snprintf_P(line, sizeof(line), PSTR("arduinoexpress_phase_duration_seconds_sum{method=\"%s\",route=\"%s\",phase=\"%s\"} %s\n"),
+                   method, routes[i].path.c_str(), phase, seconds);
+        res.write(line);
+        snprintf_P(line, sizeof(line), PSTR("arduinoexpress_phase_duration_seconds_count{method=\"%s\",route=\"%s\",phase=\"%s\"} %lu\n"),
+                   method, routes[i].path.c_str(), phase, (unsigned long)histogram.count);
+        res.write(line);
+      }
+    }
+
+    res.end();
+    return nullptr;
+  }
+};
+
+
+EndpointFunction ArduinoExpress::Metrics()
+{
+  return MetricsEndpoint{};
+}
+
+#endif
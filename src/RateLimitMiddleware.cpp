@@ -0,0 +1,34 @@
+#include "ArduinoExpress.h"
+
+/* The middleware created by ArduinoExpress::RateLimit */
+struct RateLimited{
+  HTTP_RateLimiter* limiter;
+  String keyHeader;
+
+  void* operator()(Req& req, Res& res, Next next) const
+  {
+    HTTP_StringView value;
+    if(!this->keyHeader.isEmpty()) value = req.getHeader(this->keyHeader);
+    uint32_t key = value.isEmpty() ? HTTP_RateLimiter::keyOf(&req.remoteIP, sizeof(req.remoteIP))
+                                   : HTTP_RateLimiter::keyOf(value.c_str(), value.length());
+
+    uint32_t retryAfter = 0;
+    if(this->limiter->take(key, retryAfter)){
+      next();
+      return nullptr;
+    }
+
+    logdebug("%s rate limited", req.route.c_str());
+    char seconds[12];
+    snprintf(seconds, sizeof(seconds), "%lu", (unsigned long)retryAfter);
+    res.setHeader(HEADER_RETRY_AFTER, seconds);
+    res.send(429, "text/plain", HTTPStatusText(429));
+    return nullptr;
+  }
+};
+
+
+MiddlewareFunction ArduinoExpress::RateLimit(HTTP_RateLimiter& limiter, const String& keyHeader)
+{
+  return RateLimited{&limiter, keyHeader};
+}
@@ -0,0 +1,127 @@
+/*
+ * This library provides RoutePath, the path routes, middlewares and routers are registered on.
+ * A literal path is kept where the sketch has it, instead of in a String of its own
+ */
+
+#ifndef ROUTE_PATH_HEADER
+#define ROUTE_PATH_HEADER
+
+#include "HTTP_Utilities.h"
+
+// bool endsOnSegment(route, length)
+// returns true if the first length characters of route are whole segments of it: "/api" is a
+// prefix of "/api" and "/api/led", not of "/apix"
+inline bool endsOnSegment(const HTTP_StringView& route, size_t length)
+{
+  return length == 0 || length >= route.length() || route.c_str()[length] == '/' || route.c_str()[length - 1] == '/';
+}
+
+
+/* RoutePath is the path given to get(), post() or use():
+  * - a literal, "/led", is kept where it is, without a copy. It must outlive the router, which any
+  *   string literal does: don't register the c_str() of a String that goes away
+  * - a flash literal, F("/led"), is kept in flash and compared there, it takes no RAM at all
+  * - a String is copied, once, to the heap
+  * A RoutePath can be moved, but not copied. A copy of a String that doesn't fit in memory is
+  * not valid(), registering it fails.
+*/
+class RoutePath{
+  private:
+    const char* _text = "";
+    uint16_t _length = 0;
+    bool _flash = false;  // _text is in flash, read with the _P functions
+    bool _owned = false;  // _text is a copy of a String, freed with the path
+
+    void release()
+    {
+      if(this->_owned) free((void*)this->_text);
+      this->_text = "";
+      this->_length = 0;
+      this->_flash = this->_owned = false;
+    }
+
+  public:
+    RoutePath() {}
+    RoutePath(const char* text): _text{text}, _length{(uint16_t)strlen(text)} {}
+    RoutePath(const __FlashStringHelper* text)
+      : _text{(PGM_P)text}, _length{(uint16_t)strlen_P((PGM_P)text)}, _flash{true} {}
+
+    RoutePath(const String& text)
+    {
+      char* copy = (char*)malloc(text.length() + 1);
+      if(copy) memcpy(copy, text.c_str(), text.length() + 1);
+      this->_text = copy;
+      this->_length = copy ? text.length() : 0;
+      this->_owned = copy != nullptr;
+    }
+
+    RoutePath(const RoutePath&) = delete;
+    RoutePath& operator=(const RoutePath&) = delete;
+
+    RoutePath(RoutePath&& other)
+      : _text{other._text}, _length{other._length}, _flash{other._flash}, _owned{other._owned}
+    {
+      other._owned = false;
+      other.release();
+    }
+
+    RoutePath& operator=(RoutePath&& other)
+    {
+      if(this != &other){
+        release();
+        this->_text = other._text;
+        this->_length = other._length;
+        this->_flash = other._flash;
+        this->_owned = other._owned;
+        other._owned = false;
+        other.release();
+      }
+      return *this;
+    }
+
+    ~RoutePath() {release();}
+
+    bool valid() const {return this->_text != nullptr;}
+    size_t length() const {return this->_length;}
+    bool isEmpty() const {return this->_length == 0;}
+    bool inFlash() const {return this->_flash;}
+    // the path's null-terminated characters, in flash if inFlash(). They don't move when the path
+    // is moved, so they can be referenced for as long as the path lives
+    const char* text() const {return this->_text;}
+
+    // bool prefixOf(text, length)
+    // returns true if text starts with this path
+    bool prefixOf(const char* text, size_t length) const
+    {
+      if(this->_length > length) return false;
+      if(this->_flash) return memcmp_P(text, this->_text, this->_length) == 0;
+      return memcmp(text, this->_text, this->_length) == 0;
+    }
+
+    // bool matchesStart(prefix, route)
+    // returns true if route starts with prefix followed by this path, without joining them. The
+    // match ends on a segment boundary of route, see endsOnSegment()
+    bool matchesStart(const String& prefix, const HTTP_StringView& route) const
+    {
+      return route.length() >= prefix.length() && memcmp(route.c_str(), prefix.c_str(), prefix.length()) == 0 &&
+             prefixOf(route.c_str() + prefix.length(), route.length() - prefix.length()) &&
+             endsOnSegment(route, prefix.length() + this->_length);
+    }
+
+    // appends the path to text
+    void appendTo(String& text) const
+    {
+      if(this->_flash) text += FPSTR(this->_text);
+      else if(this->_text) text.concat(this->_text, this->_length);
+    }
+
+    // returns a copy of the path, for the logs and the code that needs a String
+    String toString() const
+    {
+      String text;
+      appendTo(text);
+      return text;
+    }
+};
+
+#endif
@@ -0,0 +1,249 @@
+#include "RouteTrie.h"
+
+// bool nextSegment(path, length, position, segment, segmentLength)
+// finds the next non-empty segment of path starting at position and moves position past it.
+// Returns false if there are no more segments
+static bool nextSegment(const char* path, size_t length, size_t& position,
+                        const char*& segment, size_t& segmentLength)
+{
+  while(position < length && path[position] == '/') ++position;
+  if(position >= length) return false;
+
+  size_t start = position;
+  while(position < length && path[position] != '/') ++position;
+
+  segment = path + start;
+  segmentLength = position - start;
+  return true;
+}
+
+
+void RouteTrie::clear()
+{
+  this->_nodes.clear();
+  this->_segments.clear();
+  this->_dynamic = false;
+}
+
+
+bool RouteTrie::addRoot()
+{
+  if(this->_nodes.size() > 0) return true;
+
+  RouteTrieNode root;
+  for(int i = 0; i < HTTP_METHODS_COUNT; ++i) root.routes[i] = -1;
+  return this->_nodes.push_back(root);
+}
+
+
+void RouteTrie::freeze()
+{
+  this->_nodes.freeze();
+  this->_segments.freeze();
+}
+
+
+int16_t RouteTrie::findChild(int16_t node, RouteTrieNode::Type type, const char* segment, size_t length) const
+{
+  for(int16_t child = this->_nodes[node].firstChild; child != -1; child = this->_nodes[child].nextSibling){
+    const RouteTrieNode& candidate = this->_nodes[child];
+    if(candidate.type == type && candidate.segmentLength == length &&
+       memcmp(segmentOf(candidate), segment, length) == 0){
+      return child;
+    }
+  }
+
+  return -1;
+}
+
+
+int16_t RouteTrie::addChild(int16_t node, RouteTrieNode::Type type, const char* segment, size_t length, bool pooled)
+{
+  // nodes are linked by int16_t indices, pooled segments by uint16_t offsets
+  int segmentOffset = this->_segments.size();
+  if(this->_nodes.size() >= INT16_MAX || length > 255 || (pooled && segmentOffset + length + 1 > UINT16_MAX)){
+    return -1;
+  }
+
+  RouteTrieNode newNode;
+  newNode.type = type;
+  newNode.segmentLength = length;
+  newNode.pooled = pooled;
+  for(int i = 0; i < HTTP_METHODS_COUNT; ++i) newNode.routes[i] = -1;
+  if(pooled){
+    // pooled segments are null-terminated, like the ones in a RoutePath
+    const char terminator = '\0';
+    newNode.segmentOffset = segmentOffset;
+    if(!this->_segments.append(segment, length) || !this->_segments.push_back(terminator)){
+      this->_segments.truncate(segmentOffset);
+      return -1;
+    }
+  }
+  else{
+    newNode.segment = segment;
+  }
+  if(!this->_nodes.push_back(newNode)){
+    this->_segments.truncate(segmentOffset);
+    return -1;
+  }
+  int16_t child = this->_nodes.size() - 1;
+
+  // children are appended, so siblings keep their registration order
+  int16_t* link = &this->_nodes[node].firstChild;
+  while(*link != -1) link = &this->_nodes[*link].nextSibling;
+  *link = child;
+
+  return child;
+}
+
+
+void RouteTrie::removeFrom(int16_t node, int segmentsSize)
+{
+  // the removed nodes are only linked from the nodes before them
+  for(int16_t i = 0; i < node; ++i){
+    if(this->_nodes[i].firstChild >= node) this->_nodes[i].firstChild = -1;
+    if(this->_nodes[i].nextSibling >= node) this->_nodes[i].nextSibling = -1;
+  }
+  this->_nodes.truncate(node);
+  this->_segments.truncate(segmentsSize);
+}
+
+
+bool RouteTrie::insert(const RoutePath& path, HTTP_Method method, int16_t route)
+{
+  if(method < 1 || method > HTTP_METHODS_COUNT || !path.valid() || !addRoot()) return false;
+
+  // a path in flash is read into RAM to be split, and its segments are pooled
+  String flashCopy;
+  const char* text = path.text();
+  if(path.inFlash()){
+    flashCopy = path.toString();
+    if(flashCopy.length() != path.length()) return false;
+    text = flashCopy.c_str();
+  }
+
+  int16_t firstNode = this->_nodes.size();
+  int segmentsSize = this->_segments.size();
+  int16_t node = 0;
+  const char* segment;
+  size_t segmentLength;
+  size_t position = 0;
+  while(nextSegment(text, path.length(), position, segment, segmentLength)){
+    // a wildcard matches the rest of the path, nothing can follow it
+    if(this->_nodes[node].type == RouteTrieNode::WILDCARD){
+      removeFrom(firstNode, segmentsSize);
+      return false;
+    }
+
+    RouteTrieNode::Type type = RouteTrieNode::STATIC;
+    if(segment[0] == ':' && segmentLength > 1){
+      type = RouteTrieNode::PARAM;
+      ++segment;
+      --segmentLength;
+    }
+    else if(segmentLength == 1 && segment[0] == '*'){
+      type = RouteTrieNode::WILDCARD;
+    }
+
+    int16_t child = findChild(node, type, segment, segmentLength);
+    if(child == -1) child = addChild(node, type, segment, segmentLength, path.inFlash());
+    if(child == -1){
+      removeFrom(firstNode, segmentsSize);
+      return false;
+    }
+    node = child;
+
+    if(type != RouteTrieNode::STATIC) this->_dynamic = true;
+  }
+
+  RouteTrieNode& routeNode = this->_nodes[node];
+  if(routeNode.routes[method - 1] == -1){
+    routeNode.routes[method - 1] = route;
+    routeNode.methods |= (1 << method);
+  }
+  return true;
+}
+
+
+void RouteTrie::candidate(int16_t node, HTTP_Method method, const RouteTrieMatch& current, RouteTrieMatch& best) const
+{
+  if(!(this->_nodes[node].methods & (1 << method))) return;
+
+  int16_t route = this->_nodes[node].routes[method - 1];
+  if(best.route == -1 || route < best.route){
+    best = current;
+    best.route = route;
+  }
+}
+
+
+void RouteTrie::search(int16_t node, const char* path, size_t length, size_t position,
+                       HTTP_Method method, RouteTrieMatch& current, RouteTrieMatch& best) const
+{
+  const char* segment;
+  size_t segmentLength;
+  size_t next = position;
+  bool hasSegment = nextSegment(path, length, next, segment, segmentLength);
+
+  if(!hasSegment) candidate(node, method, current, best);
+
+  for(int16_t child = this->_nodes[node].firstChild; child != -1; child = this->_nodes[child].nextSibling)
+  {
+    const RouteTrieNode& childNode = this->_nodes[child];
+
+    if(childNode.type == RouteTrieNode::WILDCARD){
+      // the wildcard captures the rest of the path, which can be empty
+      if(current.paramsCount >= ArduinoExpressConfig::MAX_PARAMS_COUNT) continue;
+      current.params[current.paramsCount++] = RouteTrieParam{child, (uint16_t)(hasSegment ? segment - path : length)};
+      candidate(child, method, current, best);
+      --current.paramsCount;
+    }
+    else if(!hasSegment){
+      continue;
+    }
+    else if(childNode.type == RouteTrieNode::PARAM){
+      if(current.paramsCount >= ArduinoExpressConfig::MAX_PARAMS_COUNT) continue;
+      current.params[current.paramsCount++] = RouteTrieParam{child, (uint16_t)(segment - path)};
+      search(child, path, length, next, method, current, best);
+      --current.paramsCount;
+    }
+    else if(childNode.segmentLength == segmentLength &&
+            memcmp(segmentOf(childNode), segment, segmentLength) == 0){
+      search(child, path, length, next, method, current, best);
+    }
+  }
+}
+
+
+bool RouteTrie::lookup(const char* path, size_t length, HTTP_Method method, RouteTrieMatch& match) const
+{
+  match = RouteTrieMatch{};
+  if(method < 1 || method > HTTP_METHODS_COUNT || this->_nodes.size() == 0) return false;
+
+  if(this->_dynamic){
+    RouteTrieMatch current;
+    search(0, path, length, 0, method, current, match);
+    return match.route != -1;
+  }
+
+  // only static routes: follow the single path through the trie
+  int16_t node = 0;
+  const char* segment;
+  size_t segmentLength;
+  size_t position = 0;
+  while(nextSegment(path, length, position, segment, segmentLength)){
+    node = findChild(node, RouteTrieNode::STATIC, segment, segmentLength);
+    if(node == -1) return false;
+  }
+
+  if(!(this->_nodes[node].methods & (1 << method))) return false;
+  match.route = this->_nodes[node].routes[method - 1];
+  return true;
+}
+
+
+HTTP_StringView RouteTrie::paramName(const RouteTrieParam& param) const
+{
+  const RouteTrieNode& node = this->_nodes[param.node];
+  return HTTP_StringView{segmentOf(node), node.segmentLength};
+}
@@ -0,0 +1,134 @@
+/*
+ * This library provides the route index used by the ArduinoExpressRouter to find the RouteCallback
+ * of a request without scanning every registered route
+ */
+
+#ifndef ROUTE_TRIE_HEADER
+#define ROUTE_TRIE_HEADER
+
+#include "HTTP_Utilities.h"
+#include "RoutePath.h"
+#include "RouterTable.h"
+
+/* A node of the RouteTrie. Each node is one path segment (the text between two '/') of one or
+  * more registered routes. Nodes are linked by index, so the trie's tables can be moved as they grow.
+  * A segment is either static text, a parameter (":name") that matches any one segment, or a
+  * wildcard ("*") that matches the rest of the path.
+  * The segment is not copied: the node points into the RoutePath of the route that created it,
+  * which the router keeps. Only the segments of a path in flash, which can't be compared or used as
+  * a parameter name where they are, are copied to the trie's segment pool.
+*/
+struct RouteTrieNode{
+  enum Type : uint8_t {STATIC, PARAM, WILDCARD};
+
+  union{
+    const char* segment;      // this node's segment (or parameter name), in the RoutePath it was registered with
+    uint16_t segmentOffset;   // or its offset in the trie's segment pool, if pooled
+  };
+  uint8_t segmentLength = 0;
+  Type type = STATIC;
+  bool pooled = false;
+  uint8_t methods = 0;  // bitmask of the HTTP methods registered on this node, bit (1 << method)
+  int16_t firstChild = -1;
+  int16_t nextSibling = -1;
+  int16_t routes[HTTP_METHODS_COUNT]; // index of the route registered for each method, (method - 1)
+
+  RouteTrieNode(): segment{""} {}
+};
+
+
+// a parameter captured by a lookup: the PARAM or WILDCARD node,
+// and the offset in the looked up path of the segment it matched
+struct RouteTrieParam{
+  int16_t node;
+  uint16_t offset;
+};
+
+// the result of a RouteTrie lookup
+struct RouteTrieMatch{
+  int16_t route = -1;
+  uint8_t paramsCount = 0;
+  RouteTrieParam params[ArduinoExpressConfig::MAX_PARAMS_COUNT];
+};
+
+
+/* The RouteTrie maps a (path, method) pair to the index of the route registered on it.
+  * The trie is built once, when routes are registered. A lookup walks the request's path one
+  * segment at a time and never allocates. The nodes and segments are RouterTables: they grow as
+  * routes are inserted, and freeze() compacts them once the router is set up. When no parameter or wildcard route is registered, it
+  * costs O(path length). Otherwise every route that matches is considered, and the one registered
+  * first wins, as it is the one Express would call.
+  * Paths are split on '/', empty segments are ignored: "/a/b", "a/b" and "/a/b/" are the same route.
+*/
+struct RouteTrie{
+  private:
+    // _nodes[0] is the root of the router, it's created by the first insert
+    RouterTable<RouteTrieNode> _nodes;
+
+    // the segments of the paths in flash, see RouteTrieNode
+    RouterTable<char> _segments;
+
+    bool _dynamic = false;  // true once a parameter or wildcard route is registered
+
+    // returns the text of node's segment
+    const char* segmentOf(const RouteTrieNode& node) const
+    {
+      return node.pooled ? this->_segments.data() + node.segmentOffset : node.segment;
+    }
+
+    // int16_t findChild(node, type, segment, length)
+    // returns the index of the child of node with the given segment, or -1 if there's none
+    int16_t findChild(int16_t, RouteTrieNode::Type, const char*, size_t) const;
+
+    // int16_t addChild(node, type, segment, length, pooled)
+    // creates a child of node for the given segment, copied to the segment pool if pooled.
+    // Returns -1 if there's not enough memory
+    int16_t addChild(int16_t, RouteTrieNode::Type, const char*, size_t, bool);
+
+    // void removeFrom(node, segmentsSize)
+    // removes the nodes from index node on, and the pooled segments from segmentsSize on, and the
+    // links to them: undoes an insert that failed
+    void removeFrom(int16_t, int);
+
+    // void candidate(node, method, current, best)
+    // makes the route on node the best match if it was registered before best's
+    void candidate(int16_t, HTTP_Method, const RouteTrieMatch&, RouteTrieMatch&) const;
+
+    // void search(node, path, length, position, method, current, best)
+    // finds the first registered route that matches the rest of the path from node
+    void search(int16_t, const char*, size_t, size_t, HTTP_Method, RouteTrieMatch&, RouteTrieMatch&) const;
+
+    // bool addRoot()
+    // creates the root node, if it doesn't exist. Returns false if there's not enough memory
+    bool addRoot();
+
+  public:
+    // bool insert(path, method, route)
+    // registers route as the handler of (path, method). The trie points into path, which must live
+    // as long as the trie, or until clear().
+    // The first route registered on a (path, method) is kept, as it is the one Express would call.
+    // Returns false, and leaves the trie as it was, if there's not enough memory for the path, if
+    // the trie is frozen, or if the path is invalid
+    bool insert(const RoutePath&, HTTP_Method, int16_t);
+
+    // bool lookup(path, length, method, match)
+    // finds the route registered on (path, method), and the parameters it captures.
+    // Returns false if there's none
+    bool lookup(const char*, size_t, HTTP_Method, RouteTrieMatch&) const;
+
+    // returns the name of a captured parameter, "*" for a wildcard
+    HTTP_StringView paramName(const RouteTrieParam& ) const;
+    bool isWildcard(const RouteTrieParam& param) const {return this->_nodes[param.node].type == RouteTrieNode::WILDCARD;}
+
+    // void freeze()
+    // shrinks the trie to the routes inserted so far, no route can be inserted after it
+    void freeze();
+    bool frozen() const {return this->_nodes.frozen();}
+
+    // the bytes of the nodes and segments of the trie
+    size_t memoryUsage() const {return this->_nodes.memoryUsage() + this->_segments.memoryUsage();}
+
+    void clear();
+};
+
+#endif
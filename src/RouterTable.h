@@ -0,0 +1,161 @@
+/*
+ * This library provides RouterTable, the array the routers store their routes, middlewares and
+ * route index in. It is sized by what is registered instead of a fixed capacity from config.h
+ */
+
+#ifndef ROUTER_TABLE_HEADER
+#define ROUTER_TABLE_HEADER
+
+#include <stddef.h>
+#include <new>
+#include <utility>
+
+/* RouterTable<T> is an array that grows while a router is set up, and is frozen once it's done.
+  * - push_back() grows the array from the heap when it's full, doubling its capacity. reserve()
+  *   allocates the capacity once, for routers whose size is known
+  * - freeze() shrinks the array to its exact size and makes it read-only: push_back() fails after it
+  * Growing only happens at setup, serving requests never allocates from a RouterTable.
+  * T must be default constructible. A RouterTable can be moved, but not copied.
+*/
+template<typename T>
+class RouterTable{
+  private:
+    T* _items = nullptr;
+    int _size = 0;
+    int _capacity = 0;
+    bool _frozen = false;
+
+    const static int MIN_CAPACITY = 4;
+
+    // bool reallocate(capacity)
+    // moves the items to a new array of the given capacity. Returns false if there's not enough memory
+    bool reallocate(int capacity)
+    {
+      T* items = nullptr;
+      if(capacity > 0){
+        items = new (std::nothrow) T[capacity];
+        if(!items) return false;
+        for(int i = 0; i < this->_size; ++i) items[i] = std::move(this->_items[i]);
+      }
+
+      delete[] this->_items;
+      this->_items = items;
+      this->_capacity = capacity;
+      return true;
+    }
+
+    // bool grow(count)
+    // makes room for count more items, doubling the capacity when the table is full. Returns false
+    // if the table is frozen or there's not enough memory
+    bool grow(int count)
+    {
+      if(this->_frozen) return false;
+      if(this->_size + count <= this->_capacity) return true;
+
+      int capacity = this->_capacity < MIN_CAPACITY ? MIN_CAPACITY : 2 * this->_capacity;
+      if(capacity < this->_size + count) capacity = this->_size + count;
+      return reallocate(capacity);
+    }
+
+  public:
+    RouterTable() {}
+    RouterTable(const RouterTable&) = delete;
+    RouterTable& operator=(const RouterTable&) = delete;
+
+    RouterTable(RouterTable&& other)
+      : _items{other._items}, _size{other._size}, _capacity{other._capacity}, _frozen{other._frozen}
+    {
+      other._items = nullptr;
+      other._size = other._capacity = 0;
+    }
+
+    RouterTable& operator=(RouterTable&& other)
+    {
+      if(this != &other){
+        delete[] this->_items;
+        this->_items = other._items;
+        this->_size = other._size;
+        this->_capacity = other._capacity;
+        this->_frozen = other._frozen;
+        other._items = nullptr;
+        other._size = other._capacity = 0;
+      }
+      return *this;
+    }
+
+    ~RouterTable() {delete[] this->_items;}
+
+    // bool reserve(capacity)
+    // makes room for capacity items. Returns false if the table is frozen or there's not enough memory
+    bool reserve(int capacity)
+    {
+      if(this->_frozen) return false;
+      if(capacity <= this->_capacity) return true;
+      return reallocate(capacity);
+    }
+
+    // bool append(items, count)
+    // appends count items, growing the table if it's full. Returns false, and appends nothing, if
+    // the table is frozen or there's not enough memory
+    bool append(const T* items, int count)
+    {
+      if(!grow(count)) return false;
+      for(int i = 0; i < count; ++i) this->_items[this->_size++] = items[i];
+      return true;
+    }
+
+    // bool push_back(item)
+    // appends an item. Returns false if the table is frozen or there's not enough memory
+    bool push_back(const T& item) {return append(&item, 1);}
+
+    // appends an item by moving it, for items that can't be copied
+    bool push_back(T&& item)
+    {
+      if(!grow(1)) return false;
+      this->_items[this->_size++] = std::move(item);
+      return true;
+    }
+
+    void pop_back() {truncate(this->_size - 1);}
+
+    // void truncate(size)
+    // removes the items from size on
+    void truncate(int size)
+    {
+      while(this->_size > size && this->_size > 0) this->_items[--this->_size] = T{};
+    }
+
+    // void freeze()
+    // shrinks the table to its size and makes it read-only. If there's not enough memory to shrink
+    // it, it keeps its capacity
+    void freeze()
+    {
+      if(this->_frozen) return;
+      if(this->_size < this->_capacity) reallocate(this->_size);
+      this->_frozen = true;
+    }
+
+    bool frozen() const {return this->_frozen;}
+
+    void clear()
+    {
+      delete[] this->_items;
+      this->_items = nullptr;
+      this->_size = this->_capacity = 0;
+      this->_frozen = false;
+    }
+
+    T& operator[](int index) {return this->_items[index];}
+    const T& operator[](int index) const {return this->_items[index];}
+    T& back() {return this->_items[this->_size - 1];}
+    T* data() {return this->_items;}
+    const T* data() const {return this->_items;}
+
+    int size() const {return this->_size;}
+    int capacity() const {return this->_capacity;}
+
+    // the bytes of the array the table holds
+    size_t memoryUsage() const {return this->_capacity * sizeof(T);}
+};
+
+#endif
@@ -0,0 +1,214 @@
+#include "ArduinoExpress.h"
+#include ARDUINOEXPRESS_FS_HEADER
+
+// const char* contentTypeOf(path)
+// returns the Content-Type of a file from its extension
+static const char* contentTypeOf(const char* path)
+{
+  const char* extension = strrchr(path, '.');
+  if(!extension) return "application/octet-stream";
+  ++extension;
+
+  if(strcasecmp(extension, "html") == 0 || strcasecmp(extension, "htm") == 0) return "text/html";
+  else if(strcasecmp(extension, "css") == 0) return "text/css";
+  else if(strcasecmp(extension, "js") == 0) return "application/javascript";
+  else if(strcasecmp(extension, "json") == 0) return "application/json";
+  else if(strcasecmp(extension, "txt") == 0) return "text/plain";
+  else if(strcasecmp(extension, "xml") == 0) return "text/xml";
+  else if(strcasecmp(extension, "png") == 0) return "image/png";
+  else if(strcasecmp(extension, "jpg") == 0 || strcasecmp(extension, "jpeg") == 0) return "image/jpeg";
+  else if(strcasecmp(extension, "gif") == 0) return "image/gif";
+  else if(strcasecmp(extension, "svg") == 0) return "image/svg+xml";
+  else if(strcasecmp(extension, "ico") == 0) return "image/x-icon";
+  else if(strcasecmp(extension, "woff") == 0) return "font/woff";
+  else if(strcasecmp(extension, "woff2") == 0) return "font/woff2";
+  else if(strcasecmp(extension, "pdf") == 0) return "application/pdf";
+  else if(strcasecmp(extension, "wasm") == 0) return "application/wasm";
+  return "application/octet-stream";
+}
+
+
+enum StaticRange {NO_RANGE, VALID_RANGE, INVALID_RANGE};
+
+// StaticRange parseRange(range, size, start, end)
+// parses the Range header of a request for a file of the given size, into [start, end].
+// Only a single "bytes=" range is supported, other ranges are ignored and the whole file is sent
+static StaticRange parseRange(const HTTP_StringView& range, size_t size, size_t& start, size_t& end)
+{
+  if(range.length() < 6 || strncmp(range.c_str(), "bytes=", 6) != 0) return NO_RANGE;
+
+  const char* spec = range.c_str() + 6;
+  const char* dash = strchr(spec, '-');
+  if(!dash || strchr(spec, ',')) return NO_RANGE;
+
+  char* numberEnd;
+  if(dash == spec){
+    // the last n bytes: "bytes=-n"
+    unsigned long suffix = strtoul(dash + 1, &numberEnd, 10);
+    if(numberEnd == dash + 1 || *numberEnd != '\0') return NO_RANGE;
+    if(suffix == 0 || size == 0) return INVALID_RANGE;
+
+    start = suffix >= size ? 0 : size - suffix;
+    end = size - 1;
+    return VALID_RANGE;
+  }
+
+  start = strtoul(spec, &numberEnd, 10);
+  if(numberEnd != dash) return NO_RANGE;
+
+  if(dash[1] == '\0'){
+    end = size - 1;
+  }else{
+    end = strtoul(dash + 1, &numberEnd, 10);
+    if(*numberEnd != '\0' || end < start) return NO_RANGE;
+    if(end >= size) end = size - 1;
+  }
+
+  return start < size ? VALID_RANGE : INVALID_RANGE;
+}
+
+
+/* The middleware created by ArduinoExpress::Static */
+struct StaticFiles{
+  String mountPath;
+  fs::FS* fs;
+  String root;
+  String cacheControl;
+
+  void* operator()(Req& req, Res& res, Next next) const
+  {
+    if(!(req.method == "GET")){
+      next();
+      return nullptr;
+    }
+
+    const char* route = req.route.c_str();
+    size_t routeLength = req.route.length();
+
+    // the path relative to the mount path
+    if(routeLength < mountPath.length() || strncmp(route, mountPath.c_str(), mountPath.length()) != 0){
+      next();
+      return nullptr;
+    }
+    const char* relative = route + mountPath.length();
+    size_t relativeLength = routeLength - mountPath.length();
+    if(relativeLength > 0 && relative[0] != '/' && !mountPath.endsWith("/")){
+      next();
+      return nullptr;
+    }
+
+    // files outside root are never served
+    for(size_t i = 0; i + 1 < relativeLength; ++i){
+      if(relative[i] == '.' && relative[i + 1] == '.' && (i == 0 || relative[i - 1] == '/') &&
+         (i + 2 == relativeLength || relative[i + 2] == '/')){
+        res.send(403, "text/plain", HTTPStatusText(403));
+        return nullptr;
+      }
+    }
+
+    // THE FILE SYSTEM PATH: root + relative, with index.html for directories
+    const int MAX_STATIC_PATH_LENGTH = ArduinoExpressConfig::MAX_STATIC_PATH_LENGTH;
+    char path[MAX_STATIC_PATH_LENGTH];
+    bool needsSlash = relativeLength == 0 || relative[0] != '/';
+    bool isDirectory = relativeLength == 0 || relative[relativeLength - 1] == '/';
+    size_t length = root.length() + (needsSlash ? 1 : 0) + relativeLength + (isDirectory ? 10 : 0);
+    if(length + 3 >= MAX_STATIC_PATH_LENGTH){
+      next();
+      return nullptr;
+    }
+
+    char* cursor = path;
+    memcpy(cursor, root.c_str(), root.length());
+    cursor += root.length();
+    if(needsSlash) *cursor++ = '/';
+    memcpy(cursor, relative, relativeLength);
+    cursor += relativeLength;
+    if(isDirectory){
+      memcpy(cursor, "index.html", 10);
+      cursor += 10;
+    }
+    *cursor = '\0';
+
+    // OPEN THE FILE, or its precompressed variant
+    fs::File file;
+    bool gzip = false;
+    if(req.getHeader(HEADER_ACCEPT_ENCODING).tokenQuality("gzip") > 0){
+      memcpy(path + length, ".gz", 4);
+      file = fs->open(path, "r");
+      gzip = (bool)file;
+      path[length] = '\0';
+    }
+    if(!file) file = fs->open(path, "r");
+
+    if(!file || file.isDirectory()){
+      next();
+      return nullptr;
+    }
+
+    // HEADERS
+    size_t size = file.size();
+    const char* contentType = contentTypeOf(path);
+
+    char etag[24];
+    snprintf(etag, sizeof(etag), "\"%x-%lx\"", (unsigned)size, (unsigned long)file.getLastWrite());
+
+    res.setHeader(HEADER_ETAG, etag);
+    res.setHeader(HEADER_CACHE_CONTROL, cacheControl);
+    res.setHeader(HEADER_ACCEPT_RANGES, "bytes");
+    res.setHeader(HEADER_VARY, "Accept-Encoding");
+    // the gzip file is never sent without the header that says it is
+    if(gzip && !res.setHeader(HEADER_CONTENT_ENCODING, "gzip")){
+      file.close();
+      res.send(500, "text/plain", HTTPStatusText(500));
+      return nullptr;
+    }
+
+    // CONDITIONAL REQUEST
+    HTTP_StringView ifNoneMatch = req.getHeader(HEADER_IF_NONE_MATCH);
+    if(!ifNoneMatch.isEmpty() && (ifNoneMatch.equals("*") || ifNoneMatch.containsToken(etag))){
+      file.close();
+      res.send(304, contentType, "");
+      return nullptr;
+    }
+
+    // RANGE REQUEST
+    int status = 200;
+    size_t start = 0;
+    size_t end = size - 1;
+    char contentRange[40];
+    StaticRange range = parseRange(req.getHeader(HEADER_RANGE), size, start, end);
+    if(range == INVALID_RANGE){
+      file.close();
+      snprintf(contentRange, sizeof(contentRange), "bytes */%u", (unsigned)size);
+      res.setHeader(HEADER_CONTENT_RANGE, contentRange);
+      res.send(416, "text/plain", "");
+      return nullptr;
+    }
+    if(range == VALID_RANGE){
+      status = 206;
+      snprintf(contentRange, sizeof(contentRange), "bytes %u-%u/%u", (unsigned)start, (unsigned)end, (unsigned)size);
+      res.setHeader(HEADER_CONTENT_RANGE, contentRange);
+      file.seek(start, fs::SeekSet);
+    }
+
+    // SEND THE FILE across passes of handle(): the response keeps it open until it's sent
+    size_t bodyLength = size == 0 ? 0 : end - start + 1;
+    if(!res.sendFrom(status, contentType, bodyLength, [file](uint8_t* data, size_t count) mutable -> size_t {return file.read(data, count);})){
+      file.close();
+      if(!res.responseSent()) res.send(500, "text/plain", HTTPStatusText(500));
+    }
+    return nullptr;
+  }
+};
+
+
+MiddlewareFunction ArduinoExpress::Static(const String& mountPath, fs::FS& fs, const String& root,
+                                          const String& cacheControl)
+{
+  StaticFiles staticFiles{mountPath, &fs, root, cacheControl};
+
+  // paths are joined with a single '/'
+  if(staticFiles.root.endsWith("/")) staticFiles.root = staticFiles.root.substring(0, staticFiles.root.length() - 1);
+
+  return staticFiles;
+}
@@ -1,10 +1,160 @@
+#include "platform.h"
+
+// LOGGING: log calls below ARDUINOEXPRESS_LOG_LEVEL are removed at compile time, their arguments
+// included. Set it with a build flag, e.g. -DARDUINOEXPRESS_LOG_LEVEL=ARDUINOEXPRESS_LOG_DEBUG
+#define ARDUINOEXPRESS_LOG_DEBUG 0
+#define ARDUINOEXPRESS_LOG_INFO 1
+#define ARDUINOEXPRESS_LOG_WARN 2
+#define ARDUINOEXPRESS_LOG_ERROR 3
+#define ARDUINOEXPRESS_LOG_FATAL 4
+#define ARDUINOEXPRESS_LOG_NONE 5
+
+#ifndef ARDUINOEXPRESS_LOG_LEVEL
+#define ARDUINOEXPRESS_LOG_LEVEL ARDUINOEXPRESS_LOG_WARN
+#endif
+
+// with a log buffer, messages are queued in a ring buffer of this size and written to Serial
+// between requests, as fast as Serial takes them. With 0, messages are written to Serial directly
+#ifndef ARDUINOEXPRESS_LOG_BUFFER_SIZE
+#define ARDUINOEXPRESS_LOG_BUFFER_SIZE 0
+#endif
+
+// METRICS: per-route request counters and latency histograms, served by ArduinoExpress::Metrics().
+// Enable them with -DARDUINOEXPRESS_METRICS=1, when disabled the instrumentation compiles to nothing
+#ifndef ARDUINOEXPRESS_METRICS
+#define ARDUINOEXPRESS_METRICS 0
+#endif
+
+// TRANSPORT: clients are accepted from a WiFiServer by default. With -DARDUINOEXPRESS_POSIX_TRANSPORT=1
+// they are accepted from a TCP socket instead, for builds that run on Linux (see HTTP_PosixTransport.h)
+#ifndef ARDUINOEXPRESS_POSIX_TRANSPORT
+#define ARDUINOEXPRESS_POSIX_TRANSPORT 0
+#endif
+
+// CALLBACKS: handlers and middlewares are stored in a std::function by default, which allocates
+// the captures that don't fit in it. With -DARDUINOEXPRESS_INPLACE_CALLBACKS=1 they are stored in
+// place instead, in an InplaceFunction of the sizes below: storing them never allocates, but each
+// one takes the whole size
+#ifndef ARDUINOEXPRESS_INPLACE_CALLBACKS
+#define ARDUINOEXPRESS_INPLACE_CALLBACKS 0
+#endif
+
+// CONNECTIONS: the clients served at the same time, 4 by default. A gateway can serve more, e.g.
+// with -DARDUINOEXPRESS_MAX_CONNECTIONS=32. Each connection holds its own request buffer
+#ifndef ARDUINOEXPRESS_MAX_CONNECTIONS
+#define ARDUINOEXPRESS_MAX_CONNECTIONS 4
+#endif
+
+
 namespace ArduinoExpressConfig {
-  const int MAX_ROUTECALLBACKS_COUNT = 7;
-  const int MAX_MIDDLEWARECALLBACKS_COUNT = 1;
-  const int MAX_ROUTERS_COUNT = 3;
-  const int MAX_CALLBACKS_COUNT = MAX_ROUTECALLBACKS_COUNT + MAX_MIDDLEWARECALLBACKS_COUNT + MAX_ROUTERS_COUNT;
+  // with ARDUINOEXPRESS_INPLACE_CALLBACKS, a lambda's captures must fit in these sizes, a larger one
+  // fails to compile. An endpoint holds 4 pointers or references. A middleware holds what the
+  // largest of the library's takes, Static(): 3 Strings and the FS, with one pointer to spare, 52
+  // bytes on the ESP8266. Every route and use() holds an endpoint, a route's middleware is only
+  // allocated when it has one
+  const int ENDPOINT_STORAGE_SIZE = 4 * sizeof(void*);
+  const int MIDDLEWARE_STORAGE_SIZE = 3 * sizeof(String) + 2 * sizeof(void*);
 
+  // routes, middlewares and routers have no fixed limit: each router's tables grow as they are
+  // registered, see RouterTable and ArduinoExpressRouter::freeze()
 
-  const int MAX_PARAMS_COUNT = 1;
+  // route parameters (":name" and "*") of a route, and query string parameters of a request
+  const int MAX_PARAMS_COUNT = 4;
+  const int MAX_QUERY_COUNT = 8;
   const int MAX_HEADERS_COUNT = 12;
+
+  // every connection parses its request into a buffer of this size. The request line, the headers
+  // and the body must all fit in it
+  const int REQUEST_BUFFER_SIZE = 1024;
+  const int MAX_REQUEST_LINE_LENGTH = 256;
+  const int MAX_HEADER_LINE_LENGTH = 256;
+
+  // a body that doesn't fit in the request buffer is streamed to the request's onData() consumer.
+  // Bodies larger than MAX_BODY_SIZE (0 for no limit) are answered with 413, it can be changed with
+  // ArduinoExpress::setMaxBodySize(). The consumers' captures must fit in BODY_CONSUMER_STORAGE_SIZE
+  const size_t MAX_BODY_SIZE = 1048576;
+  const int BODY_CONSUMER_STORAGE_SIZE = 4 * sizeof(void*);
+
+  // number of clients served at the same time, see ARDUINOEXPRESS_MAX_CONNECTIONS
+  const int MAX_CONNECTIONS_COUNT = ARDUINOEXPRESS_MAX_CONNECTIONS;
+  // bytes read from a connection each time it is polled
+  const int READ_CHUNK_SIZE = 128;
+  // a connection that sends nothing for this long is closed
+  const unsigned long REQUEST_TIMEOUT_MS = 5000;
+  // listen() lets the transport wait this long for a client between passes, when no connection
+  // has bytes left to parse. The WiFi transport doesn't wait
+  const unsigned long TRANSPORT_WAIT_MS = 10;
+  // connections waiting to be accepted by the POSIX transport
+  const int LISTEN_BACKLOG = 16;
+
+  // persistent connections: a kept-alive connection that doesn't start a new request within
+  // KEEP_ALIVE_TIMEOUT_MS is closed, and is closed after MAX_KEEP_ALIVE_REQUESTS requests
+  const unsigned long KEEP_ALIVE_TIMEOUT_MS = 2000;
+  const int MAX_KEEP_ALIVE_REQUESTS = 100;
+
+  // responses are written to the client through a buffer of this size (at most 65535)
+  const int OUTPUT_BUFFER_SIZE = 256;
+  // the headers of a response, and its status text if it's not the standard one, are copied to an
+  // arena of this size, allocated once per connection and emptied after each response
+  const size_t RESPONSE_ARENA_SIZE = 256;
+
+  // static files: longest file system path that can be served, and the size of the chunks
+  // files are read and sent in. Files, and the larger bodies a response holds, are sent across
+  // passes of handle(), as fast as the client takes them
+  const int MAX_STATIC_PATH_LENGTH = 64;
+  const int STATIC_CHUNK_SIZE = 512;
+
+  // JSON bodies: the Json() middleware answers larger bodies with 413 by default. A request's JSON
+  // document is parsed into an arena of at most MAX_JSON_BUFFER_SIZE bytes, kept by its connection
+  const int MAX_JSON_BODY_SIZE = 512;
+  const int MAX_JSON_BUFFER_SIZE = 4096;
+
+  // form bodies: the Form() middleware decodes at most MAX_FIELDS_COUNT fields. The values of
+  // multipart fields that are not files are kept in MULTIPART_FIELDS_SIZE bytes, and the headers of
+  // a part must fit in MAX_PART_HEADER_LENGTH. The part callback's captures must fit in
+  // PART_FUNCTION_STORAGE_SIZE
+  const int MAX_FIELDS_COUNT = 8;
+  const int MAX_BOUNDARY_LENGTH = 70;
+  const int MAX_PART_HEADER_LENGTH = 128;
+  const int MULTIPART_FIELDS_SIZE = 256;
+  const int PART_FUNCTION_STORAGE_SIZE = 4 * sizeof(void*);
+
+  // compression: the Compress() middleware compresses bodies of at least MIN_COMPRESS_SIZE bytes by
+  // default. Matches are searched at most DEFLATE_WINDOW_SIZE bytes back (at most 32768), through a
+  // hash table of 2^DEFLATE_HASH_BITS positions (2 bytes each) allocated on the first compressed body
+  const size_t MIN_COMPRESS_SIZE = 256;
+  const size_t DEFLATE_WINDOW_SIZE = 4096;
+  const int DEFLATE_HASH_BITS = 10;
+
+  // response cache: cached responses are stored in an arena of CACHE_ARENA_SIZE bytes by default.
+  // The key of a response (method, route, query and the headers it varies on) must fit in
+  // MAX_CACHE_KEY_LENGTH, requests with a longer key are not cached
+  const int MAX_CACHE_ENTRIES_COUNT = 8;
+  const int MAX_CACHE_KEY_LENGTH = 128;
+  const size_t CACHE_ARENA_SIZE = 4096;
+
+  // rate limiting: an HTTP_RateLimiter keeps a bucket for RATE_LIMIT_ENTRIES_COUNT clients. A client's
+  // bucket is searched in RATE_LIMIT_PROBE_LENGTH slots from its hash, when they are all taken the
+  // least recently used is given to the new client
+  const int RATE_LIMIT_ENTRIES_COUNT = 32;
+  const int RATE_LIMIT_PROBE_LENGTH = 4;
+
+  // admission control: new clients are answered 503, Retry-After ADMISSION_RETRY_AFTER_S seconds, while
+  // this many connections are active or the free heap is under this many bytes. By default none is
+  // turned away while a connection is free, the others wait in the backlog. A client turned away is
+  // read and its bytes discarded until it disconnects, at most ADMISSION_DRAIN_MS, so it gets the
+  // whole 503. See ArduinoExpress::setAdmission()
+  const int MAX_ACTIVE_CONNECTIONS_COUNT = MAX_CONNECTIONS_COUNT;
+  const size_t MIN_FREE_HEAP = 0;
+  const int ADMISSION_RETRY_AFTER_S = 1;
+  const unsigned long ADMISSION_DRAIN_MS = 500;
+
+  // a log message is formatted into a line of this size, longer messages are cut
+  const int MAX_LOG_LINE_LENGTH = 128;
+
+  // metrics are kept for this many routes, the requests of other routes are counted with the
+  // requests no route handled. Latencies are counted in buckets up to these bounds, in microseconds
+  const int MAX_METRICS_ROUTES_COUNT = 8;
+  const unsigned long METRICS_BUCKETS_US[] = {100, 500, 1000, 5000, 10000, 50000, 100000, 500000};
+  const int METRICS_BUCKETS_COUNT = sizeof(METRICS_BUCKETS_US) / sizeof(METRICS_BUCKETS_US[0]);
 }
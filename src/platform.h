@@ -0,0 +1,36 @@
+/*
+ * This library provides the platform ArduinoExpress is built on: the Arduino core (String, Serial,
+ * millis(), micros(), yield(), the PROGMEM functions), WiFiClient and WiFiServer. All the library's
+ * sources get them from here
+ */
+
+#ifndef PLATFORM_HEADER
+#define PLATFORM_HEADER
+
+// the ESP8266 core by default. The host build of the tests and benchmarks puts its stand-ins,
+// host/Arduino.h and host/ESP8266WiFi.h, first on the include path instead. A build for another
+// target can also set ARDUINOEXPRESS_PLATFORM_HEADER to a header of its own that provides the same
+// names, e.g. -DARDUINOEXPRESS_PLATFORM_HEADER='"my_platform.h"'
+#ifdef ARDUINOEXPRESS_PLATFORM_HEADER
+#include ARDUINOEXPRESS_PLATFORM_HEADER
+#else
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#endif
+
+// the file system the static middleware serves files from, only included where files are served
+#ifndef ARDUINOEXPRESS_FS_HEADER
+#define ARDUINOEXPRESS_FS_HEADER <FS.h>
+#endif
+
+// the free heap in bytes, that ArduinoExpress::setAdmission() turns clients away under. A platform
+// header that doesn't define it never runs low
+#ifndef ARDUINOEXPRESS_FREE_HEAP
+#ifdef ARDUINOEXPRESS_PLATFORM_HEADER
+#define ARDUINOEXPRESS_FREE_HEAP() ((size_t)-1)
+#else
+#define ARDUINOEXPRESS_FREE_HEAP() ((size_t)ESP.getFreeHeap())
+#endif
+#endif
+
+#endif
@@ -0,0 +1,208 @@
+// The response cache: a miss runs the handler and stores its response, a hit is sent from the
+// cache without it. Entries expire with the cache's clock, responses that set a cookie aren't
+// stored, and each response is stored under the key of its own request
+
+#include "HostTest.h"
+#include "ArduinoExpress.h"
+
+static int _handled = 0;
+
+static void* sendInfo(Req& req, Res& res)
+{
+  ++_handled;
+  res.send(200, "application/json", String("{\"route\":\"") + req.route.toString() + "\"}");
+  return nullptr;
+}
+
+static void* sendWithCookie(Req&, Res& res)
+{
+  ++_handled;
+  res.setHeader("Set-Cookie", "session=secret");
+  res.send(200, "text/plain", "yours only");
+  return nullptr;
+}
+
+static std::string get(ArduinoExpress& app, const std::string& path, const std::string& headers = "")
+{
+  return host::exchange(app, "GET " + path + " HTTP/1.1\r\nHost: device\r\n" + headers + "\r\n");
+}
+
+static std::string headerOf(const std::string& response, const std::string& name)
+{
+  size_t start = response.find("\r\n" + name + ": ");
+  if(start == std::string::npos) return "";
+  start += name.size() + 4;
+  return response.substr(start, response.find("\r\n", start) - start);
+}
+
+static unsigned long _now = 0;
+static unsigned long fakeClock() {return _now;}
+
+// a transport whose clients are always there, and take whatever is written
+struct DiscardingTransport : public HTTP_Transport{
+  bool begin(int) override {return true;}
+  bool accept(int) override {return false;}
+  int available(int) override {return 0;}
+  int read(int, uint8_t*, size_t) override {return 0;}
+  size_t write(int, const uint8_t*, size_t length) override {return length;}
+  bool connected(int) override {return true;}
+  void stop(int) override {}
+};
+
+
+TEST(hitsAreServedWithoutTheHandler)
+{
+  HTTP_ResponseCache cache;
+  ArduinoExpress app;
+  app.get("/info", ArduinoExpress::Cache(cache, 5000), sendInfo);
+  app.begin(80);
+  _handled = 0;
+
+  std::string miss = get(app, "/info");
+  std::string hit = get(app, "/info");
+  CHECK(_handled == 1);
+  CHECK(cache.entriesCount() == 1);
+  CHECK(host::contains(hit, "200 OK"));
+  CHECK(host::contains(hit, "{\"route\":\"/info\"}"));
+  CHECK(!headerOf(miss, "ETag").empty());
+  CHECK(headerOf(hit, "ETag") == headerOf(miss, "ETag"));
+}
+
+
+TEST(matchingETagsAreAnsweredWith304)
+{
+  HTTP_ResponseCache cache;
+  ArduinoExpress app;
+  app.get("/info", ArduinoExpress::Cache(cache, 5000), sendInfo);
+  app.begin(80);
+
+  std::string etag = headerOf(get(app, "/info"), "ETag");
+  std::string notModified = get(app, "/info", "If-None-Match: " + etag + "\r\n");
+  CHECK(host::contains(notModified, "304 Not Modified"));
+  CHECK(!host::contains(notModified, "{\"route\""));
+  CHECK(host::contains(get(app, "/info", "If-None-Match: \"other\"\r\n"), "200 OK"));
+}
+
+
+TEST(entriesExpireWithTheCachesClock)
+{
+  HTTP_ResponseCache cache;
+  cache.setClock(fakeClock);
+  ArduinoExpress app;
+  app.get("/info", ArduinoExpress::Cache(cache, 5000), sendInfo);
+  app.begin(80);
+  _handled = 0;
+  _now = 1000;
+
+  get(app, "/info");
+  _now += 4999;
+  get(app, "/info");
+  CHECK(_handled == 1);
+
+  _now += 1;
+  get(app, "/info");
+  CHECK(_handled == 2);
+}
+
+
+TEST(responsesSettingACookieAreNotStored)
+{
+  HTTP_ResponseCache cache;
+  ArduinoExpress app;
+  app.get("/session", ArduinoExpress::Cache(cache, 5000), sendWithCookie);
+  app.begin(80);
+  _handled = 0;
+
+  CHECK(host::contains(get(app, "/session"), "session=secret"));
+  CHECK(host::contains(get(app, "/session"), "session=secret"));
+  CHECK(_handled == 2);
+  CHECK(cache.entriesCount() == 0);
+}
+
+
+TEST(queriesAndVaryHeadersAreInTheKey)
+{
+  HTTP_ResponseCache cache;
+  ArduinoExpress app;
+  app.get("/info", ArduinoExpress::Cache(cache, 5000, "Accept-Language"), sendInfo);
+  app.begin(80);
+  _handled = 0;
+
+  get(app, "/info?page=1");
+  get(app, "/info?page=2");
+  get(app, "/info?page=1", "Accept-Language: fr\r\n");
+  get(app, "/info?page=1");
+  CHECK(_handled == 3);
+  CHECK(cache.entriesCount() == 3);
+
+  cache.invalidate("/info");
+  CHECK(cache.entriesCount() == 0);
+}
+
+
+TEST(differentTargetsDontShareAKey)
+{
+  HTTP_ResponseCache cache;
+  ArduinoExpress app;
+  app.get("/info", ArduinoExpress::Cache(cache, 5000), [](Req& req, Res& res) -> void* {
+    ++_handled;
+    String body;
+    for(int i = 0; i < req.queryCount; ++i) body += req.query[i].key.toString() + "=" + req.query[i].value.toString() + ";";
+    res.send(200, "text/plain", body);
+    return nullptr;
+  });
+  app.begin(80);
+  _handled = 0;
+
+  // the same decoded parameters
+  CHECK(host::contains(get(app, "/info?a=1%26b=2"), "\r\n\r\na=1&b=2;"));
+  CHECK(host::contains(get(app, "/info?a=1&b=2"), "\r\n\r\na=1;b=2;"));
+
+  // parameters past MAX_QUERY_COUNT are dropped
+  std::string query;
+  for(int i = 0; i < ArduinoExpressConfig::MAX_QUERY_COUNT; ++i) query += "p" + std::to_string(i) + "=1&";
+  get(app, "/info?" + query + "last=1");
+  get(app, "/info?" + query + "last=2");
+  CHECK(_handled == 4);
+  CHECK(cache.entriesCount() == 4);
+}
+
+
+TEST(varyHeadersAreKeyedByName)
+{
+  HTTP_Request req;
+  HTTP_RequestParser parser;
+  parser.begin(req);
+  const char request[] = "GET /info HTTP/1.1\r\nAccept: fr\r\nAccept-Language: fr\r\n\r\n";
+  parser.feed(request, sizeof(request) - 1);
+
+  char first[64], second[64];
+  size_t firstLength = HTTP_ResponseCache::makeKey(req, "Accept", first, sizeof(first));
+  size_t secondLength = HTTP_ResponseCache::makeKey(req, "Accept-Language", second, sizeof(second));
+  CHECK(firstLength > 0 && secondLength > 0);
+  CHECK(firstLength != secondLength || memcmp(first, second, firstLength) != 0);
+}
+
+
+TEST(interleavedMissesAreStoredUnderTheirOwnKeys)
+{
+  // two connections miss before either response is sent
+  DiscardingTransport transport;
+  HTTP_Client first(transport, 0);
+  HTTP_Client second(transport, 1);
+  HTTP_Response firstRes(&first);
+  HTTP_Response secondRes(&second);
+  HTTP_ResponseCache cache;
+
+  cache.expect("GET /a", 6, 5000, firstRes);
+  cache.expect("GET /b", 6, 5000, secondRes);
+  secondRes.send(200, "text/plain", "b");
+  firstRes.send(200, "text/plain", "a");
+  CHECK(cache.entriesCount() == 2);
+
+  HTTP_Request req;
+  HTTP_Response hit(&first);
+  CHECK(cache.serve("GET /a", 6, req, hit));
+  CHECK(hit.status() == 200);
+  CHECK(!cache.serve("GET /c", 6, req, hit));
+}
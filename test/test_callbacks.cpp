@@ -0,0 +1,151 @@
+// The storage of handlers and middlewares. InplaceFunction keeps a callable in place, copying it
+// copies its captures, moving it hands them over, and what it captured is destroyed with it.
+// A route allocates its middleware only when it has one, and keeps it as the route table grows.
+// Also built with ARDUINOEXPRESS_INPLACE_CALLBACKS, as test_callbacks_inplace
+
+#include "HostTest.h"
+#include "ArduinoExpress.h"
+
+using InplaceEndpoint = InplaceFunction<void*(Req&, Res&), ArduinoExpressConfig::ENDPOINT_STORAGE_SIZE>;
+using InplaceMiddleware = InplaceFunction<void*(Req&, Res&, Next), ArduinoExpressConfig::MIDDLEWARE_STORAGE_SIZE>;
+
+static int _alive = 0;
+
+// a capture that counts its live copies
+struct Tracked{
+  Tracked() {++_alive;}
+  Tracked(const Tracked&) {++_alive;}
+  Tracked(Tracked&&) {++_alive;}
+  ~Tracked() {--_alive;}
+};
+
+
+TEST(storingAFunctionDoesNotAllocate)
+{
+  uint64_t before = host::allocationStats().allocations;
+  InplaceEndpoint function = [](Req&, Res&) -> void* {return nullptr;};
+  InplaceEndpoint copy = function;
+  CHECK(host::allocationStats().allocations == before);
+  CHECK((bool)copy);
+}
+
+
+TEST(copyingCopiesTheCapturedStrings)
+{
+  String text = "a String too long for any small string buffer";
+  InplaceMiddleware function = [text](Req&, Res&, Next) -> void* {return (void*)text.c_str();};
+
+  uint64_t before = host::allocationStats().allocations;
+  InplaceMiddleware copy = function;
+  CHECK(host::allocationStats().allocations == before + 1);
+}
+
+
+TEST(movingHandsTheCapturedStringsOver)
+{
+  String text = "a String too long for any small string buffer";
+  InplaceMiddleware function = [text](Req&, Res&, Next) -> void* {return (void*)text.c_str();};
+  HTTP_Request req;
+  HTTP_Response res(nullptr);
+  void* stored = function(req, res, Next{});
+
+  uint64_t before = host::allocationStats().allocations;
+  InplaceMiddleware moved = std::move(function);
+  InplaceMiddleware assigned;
+  assigned = std::move(moved);
+  CHECK(host::allocationStats().allocations == before);
+
+  CHECK(!function);
+  CHECK(!moved);
+  CHECK(assigned(req, res, Next{}) == stored);
+}
+
+
+TEST(capturesAreDestroyedWithTheFunction)
+{
+  {
+    Tracked tracked;
+    InplaceEndpoint function = [tracked](Req&, Res&) -> void* {return nullptr;};
+    InplaceEndpoint copy = function;
+    InplaceEndpoint moved = std::move(function);
+    // tracked, and the captures of copy and moved: function gave its own to moved
+    CHECK(_alive == 3);
+
+    copy = nullptr;
+    CHECK(_alive == 2);
+    moved = copy;
+    CHECK(_alive == 1);
+  }
+  CHECK(_alive == 0);
+}
+
+
+TEST(routesKeepTheirCallbacks)
+{
+  String body = "from a captured String";
+  ArduinoExpress app;
+  app.get("/", [body](Req&, Res& res) -> void* {res.send(200, "text/plain", body); return nullptr;});
+  app.begin(80);
+
+  std::string response = host::exchange(app, "GET / HTTP/1.1\r\nHost: device\r\n\r\n");
+  CHECK(response.find("from a captured String") != std::string::npos);
+}
+
+
+TEST(routeWithoutAMiddlewareDoesntAllocateOne)
+{
+  int64_t before = host::allocationStats().liveBlocks;
+  RouteCallback route{HTTP_Method::GET, "/", [](Req&, Res&) -> void* {return nullptr;}};
+  CHECK(host::allocationStats().liveBlocks == before);
+
+  CHECK(route.setMiddleware([](Req&, Res&, Next next) -> void* {next(); return nullptr;}));
+  CHECK(host::allocationStats().liveBlocks == before + 1);
+  CHECK(route.setMiddleware(nullptr));
+  CHECK(host::allocationStats().liveBlocks == before);
+}
+
+
+TEST(routesKeepTheirMiddlewaresAsTheTableGrows)
+{
+  ArduinoExpress app;
+  String paths[12];
+  for(int i = 0; i < 12; ++i){
+    paths[i] = String("/item") + String(i);
+    // the odd routes' middlewares answer before their callback
+    auto middleware = [i](Req&, Res& res, Next) -> void* {res.send(200, "text/plain", String("m") + String(i)); return nullptr;};
+    auto callback = [i](Req&, Res& res) -> void* {res.send(200, "text/plain", String(i)); return nullptr;};
+    if(i % 2) CHECK(app.get(paths[i], middleware, callback));
+    else CHECK(app.get(paths[i], callback));
+  }
+  app.begin(80);
+
+  for(int i = 0; i < 12; ++i){
+    std::string request = std::string("GET ") + paths[i].c_str() + " HTTP/1.1\r\nHost: device\r\n\r\n";
+    std::string body = (i % 2 ? "m" : "") + std::to_string(i);
+    CHECK(host::contains(host::exchange(app, request), "\r\n\r\n" + body));
+  }
+}
+
+
+// a handler that isn't a lambda
+struct Greeter{
+  String greeting;
+  void* operator()(Req&, Res& res) const {res.send(200, "text/plain", this->greeting); return nullptr;}
+};
+
+TEST(routesTakeAnyCallable)
+{
+  ArduinoExpress app;
+  Greeter greeter{"hello"};
+  EndpointFunction stored = [](Req&, Res& res) -> void* {res.send(200, "text/plain", "stored"); return nullptr;};
+  app.get("/functor", greeter);
+  app.post("/functor", Greeter{"posted"});
+  app.get("/stored", stored);
+  app.get("/none", nullptr, stored);
+  app.begin(80);
+
+  CHECK(host::contains(host::exchange(app, "GET /functor HTTP/1.1\r\n\r\n"), "\r\n\r\nhello"));
+  CHECK(host::contains(host::exchange(app, "POST /functor HTTP/1.1\r\nContent-Length: 0\r\n\r\n"), "\r\n\r\nposted"));
+  CHECK(host::contains(host::exchange(app, "GET /stored HTTP/1.1\r\n\r\n"), "\r\n\r\nstored"));
+  CHECK(host::contains(host::exchange(app, "GET /none HTTP/1.1\r\n\r\n"), "\r\n\r\nstored"));
+}
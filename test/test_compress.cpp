@@ -0,0 +1,191 @@
+// Compressed responses: HTTP_Deflate's gzip and zlib streams are inflated back by zlib, whatever the
+// body. The Compress() middleware picks the encoding from the q-values of Accept-Encoding, where
+// q=0 refuses one, and Asset() answers clients that refuse gzip with 406
+
+#include "HostTest.h"
+#include "ArduinoExpress.h"
+
+#include <zlib.h>
+
+// inflates a gzip or zlib stream with zlib. Returns false if the stream is invalid
+static bool inflateWithZlib(const std::string& compressed, HTTP_Encoding encoding, std::string& inflated)
+{
+  host::AllocationPause pause;
+  z_stream stream{};
+  if(inflateInit2(&stream, encoding == ENCODING_GZIP ? 15 + 16 : 15) != Z_OK) return false;
+
+  stream.next_in = (Bytef*)compressed.data();
+  stream.avail_in = compressed.size();
+  char buffer[4096];
+  int status;
+  inflated.clear();
+  do{
+    stream.next_out = (Bytef*)buffer;
+    stream.avail_out = sizeof(buffer);
+    status = inflate(&stream, Z_NO_FLUSH);
+    inflated.append(buffer, sizeof(buffer) - stream.avail_out);
+  }while(status == Z_OK);
+
+  bool complete = status == Z_STREAM_END && stream.avail_in == 0;
+  inflateEnd(&stream);
+  return complete;
+}
+
+static std::string compress(HTTP_Encoding encoding, const std::string& body)
+{
+  std::string compressed;
+  HTTP_Deflate* deflate = HTTP_Deflate::shared();
+  deflate->compress(encoding, (const uint8_t*)body.data(), body.size(), [&compressed](const uint8_t* data, size_t length){
+    host::AllocationPause pause;
+    compressed.append((const char*)data, length);
+  });
+  return compressed;
+}
+
+static bool roundTrips(const std::string& body)
+{
+  for(HTTP_Encoding encoding : {ENCODING_GZIP, ENCODING_DEFLATE}){
+    std::string inflated;
+    if(!inflateWithZlib(compress(encoding, body), encoding, inflated) || inflated != body) return false;
+  }
+  return true;
+}
+
+static std::string text(size_t size)
+{
+  host::AllocationPause pause;
+  std::string body;
+  for(int i = 0; body.size() < size; ++i){
+    body += "{\"sensor\":\"t" + std::to_string(i % 17) + "\",\"value\":" + std::to_string(i * 7 % 1000) + "},\n";
+  }
+  body.resize(size);
+  return body;
+}
+
+static std::string random(size_t size)
+{
+  host::AllocationPause pause;
+  std::string body(size, '\0');
+  uint32_t state = 2463534242u;
+  for(char& byte : body){
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    byte = (char)state;
+  }
+  return body;
+}
+
+// returns the body of a chunked response, or an empty string if its framing is wrong
+static std::string dechunk(const std::string& response)
+{
+  host::AllocationPause pause;
+  std::string body;
+  size_t at = response.find("\r\n\r\n") + 4;
+  while(true){
+    size_t size = strtoul(response.c_str() + at, nullptr, 16);
+    at = response.find("\r\n", at) + 2;
+    if(size == 0) return body;
+    body.append(response, at, size);
+    at += size + 2;
+  }
+}
+
+static std::string headerOf(const std::string& response, const std::string& name)
+{
+  size_t start = response.find("\r\n" + name + ": ");
+  if(start == std::string::npos) return "";
+  start += name.size() + 4;
+  return response.substr(start, response.find("\r\n", start) - start);
+}
+
+static std::string _page;
+
+static void* sendPage(Req&, Res& res)
+{
+  res.send(200, "application/json", _page.c_str());
+  return nullptr;
+}
+
+static std::string get(ArduinoExpress& app, const std::string& acceptEncoding, const char* version = "HTTP/1.1")
+{
+  return host::exchange(app, std::string("GET /page ") + version + "\r\nHost: device\r\nAccept-Encoding: " + acceptEncoding + "\r\n\r\n");
+}
+
+
+TEST(streamsInflateWithZlib)
+{
+  CHECK(roundTrips(""));
+  CHECK(roundTrips("a"));
+  CHECK(roundTrips("abcabcabcabcabcabcabcabcabc"));
+  CHECK(roundTrips(text(4096)));
+  CHECK(roundTrips(text(256 * 1024)));
+  CHECK(roundTrips(random(64 * 1024)));
+  CHECK(roundTrips(std::string(100000, 'x')));
+}
+
+
+TEST(textIsCompressed)
+{
+  std::string body = text(16 * 1024);
+  CHECK(compress(ENCODING_GZIP, body).size() < body.size() / 3);
+}
+
+
+TEST(qualitiesAreParsed)
+{
+  const char header[] = "gzip;q=0.8, deflate, br;q=0, identity; q=0.125";
+  HTTP_StringView acceptEncoding(header, sizeof(header) - 1);
+  CHECK(acceptEncoding.tokenQuality("gzip") == 800);
+  CHECK(acceptEncoding.tokenQuality("deflate") == 1000);
+  CHECK(acceptEncoding.tokenQuality("br") == 0);
+  CHECK(acceptEncoding.tokenQuality("identity") == 125);
+  CHECK(acceptEncoding.tokenQuality("zstd") == -1);
+
+  const char wildcard[] = "gzip;q=0, *;q=0.5";
+  HTTP_StringView any(wildcard, sizeof(wildcard) - 1);
+  CHECK(any.tokenQuality("gzip") == 0);
+  CHECK(any.tokenQuality("deflate") == 500);
+  CHECK(HTTP_StringView("GZIP;Q=1.0", 10).tokenQuality("gzip") == 1000);
+}
+
+
+TEST(theEncodingFollowsTheQualities)
+{
+  _page = text(8 * 1024);
+  ArduinoExpress app;
+  app.use(ArduinoExpress::Compress());
+  app.get("/page", sendPage);
+  app.begin(80);
+
+  CHECK(headerOf(get(app, "gzip, deflate"), "Content-Encoding") == "gzip");
+  CHECK(headerOf(get(app, "deflate;q=0.5, gzip"), "Content-Encoding") == "gzip");
+  CHECK(headerOf(get(app, "gzip;q=0.5, deflate"), "Content-Encoding") == "deflate");
+  CHECK(headerOf(get(app, "gzip;q=0, deflate"), "Content-Encoding") == "deflate");
+  CHECK(headerOf(get(app, "*"), "Content-Encoding") == "gzip");
+  CHECK(headerOf(get(app, "gzip;q=0, deflate;q=0"), "Content-Encoding") == "");
+  CHECK(headerOf(get(app, "*;q=0"), "Content-Encoding") == "");
+  CHECK(headerOf(get(app, "gzip", "HTTP/1.0"), "Content-Encoding") == "");
+
+  std::string response = get(app, "gzip;q=0, deflate");
+  std::string inflated;
+  CHECK(inflateWithZlib(dechunk(response), ENCODING_DEFLATE, inflated));
+  CHECK(inflated == _page);
+  CHECK(host::contains(get(app, "identity"), _page));
+}
+
+
+TEST(assetsRefusedGzipAnswer406)
+{
+  static const uint8_t PAGE_GZ[] PROGMEM = {0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+  ArduinoExpress app;
+  app.get("/page", ArduinoExpress::Asset("text/html", PAGE_GZ, sizeof(PAGE_GZ)));
+  app.begin(80);
+
+  std::string accepted = get(app, "gzip, deflate");
+  CHECK(host::contains(accepted, "200 OK"));
+  CHECK(headerOf(accepted, "Content-Encoding") == "gzip");
+  CHECK(headerOf(accepted, "Content-Length") == std::to_string(sizeof(PAGE_GZ)));
+  CHECK(host::contains(get(app, "deflate"), "406"));
+  CHECK(host::contains(get(app, "gzip;q=0"), "406"));
+}
@@ -0,0 +1,101 @@
+// The connection slots of ArduinoExpress::handle(): clients are served side by side, a slow or
+// stalled one doesn't hold the others, and each slot times out on its own
+
+#include "HostTest.h"
+#include "ArduinoExpress.h"
+
+static const char* const REQUEST = "GET /led HTTP/1.1\r\nHost: device\r\n\r\n";
+
+static void setupApp(ArduinoExpress& app)
+{
+  app.get("/led", [](Req&, Res& res) -> void* {res.send(200, "text/plain", "on"); return nullptr;});
+  app.begin(80);
+}
+
+
+TEST(slowClientDoesntBlockAFastOne)
+{
+  ArduinoExpress app;
+  setupApp(app);
+
+  host::SimulatedClient slow = host::connect();
+  slow.send("GET /led HTTP/1.1\r\nHo");
+  host::pump(app, [&]{return slow.drained();});
+
+  host::SimulatedClient fast = host::connect();
+  fast.send(REQUEST);
+  CHECK(host::pump(app, [&]{return host::responseLength(fast.received()) > 0;}));
+  CHECK(slow.received().empty());
+
+  slow.send("st: device\r\n\r\n");
+  CHECK(host::pump(app, [&]{return host::responseLength(slow.received()) > 0;}));
+}
+
+
+TEST(requestsAreServedByteByByte)
+{
+  host::useSimulatedClock(true);
+  host::setConditions({1, 1000, 0});
+  ArduinoExpress app;
+  setupApp(app);
+
+  host::SimulatedClient client = host::connect();
+  client.send(REQUEST);
+  CHECK(host::pump(app, [&]{host::advanceClock(100); return host::responseLength(client.received()) > 0;}));
+  CHECK(host::contains(client.received(), "\r\n\r\non"));
+}
+
+
+TEST(everySlotIsServedInOneHandle)
+{
+  ArduinoExpress app;
+  setupApp(app);
+
+  host::SimulatedClient clients[ArduinoExpressConfig::MAX_CONNECTIONS_COUNT];
+  for(host::SimulatedClient& client : clients){
+    client = host::connect();
+    client.send(REQUEST);
+  }
+  app.handle();
+  for(host::SimulatedClient& client : clients) CHECK(host::responseLength(client.received()) > 0);
+}
+
+
+TEST(stalledClientTimesOut)
+{
+  host::useSimulatedClock(true);
+  ArduinoExpress app;
+  setupApp(app);
+
+  host::SimulatedClient stalled = host::connect();
+  stalled.send("GET /led HTTP/1.1\r\n");
+  host::pump(app, [&]{return stalled.drained();});
+
+  host::advanceClock(ArduinoExpressConfig::REQUEST_TIMEOUT_MS * 1000);
+  app.handle();
+  CHECK(!stalled.closedByServer());
+
+  host::advanceClock(1000);
+  app.handle();
+  CHECK(stalled.closedByServer());
+  CHECK(host::contains(stalled.received(), "HTTP/1.1 408"));
+}
+
+
+TEST(clientsBeyondTheSlotsWaitTheirTurn)
+{
+  ArduinoExpress app;
+  setupApp(app);
+
+  const int count = ArduinoExpressConfig::MAX_CONNECTIONS_COUNT + 3;
+  host::SimulatedClient clients[count];
+  for(host::SimulatedClient& client : clients){
+    client = host::connect();
+    client.send(REQUEST);
+    client.close();
+  }
+  for(host::SimulatedClient& client : clients){
+    CHECK(host::pump(app, [&]{return client.closedByServer();}));
+    CHECK(host::contains(client.received(), "\r\n\r\non"));
+  }
+}
@@ -0,0 +1,178 @@
+// Form bodies, decoded by ArduinoExpress::Form(): urlencoded fields are decoded in place in the
+// request buffer, multipart parts are streamed to the part callback as they arrive, and their
+// fields kept, whatever the pieces the body arrives in
+
+#include "HostTest.h"
+#include "ArduinoExpress.h"
+
+static const char BOUNDARY[] = "----form7MA4YWxkTrZu0gW";
+
+// what the part callback was given
+struct ReceivedPart{
+  std::string name;
+  std::string filename;
+  std::string contentType;
+  std::string content;
+  bool final = false;
+};
+
+static std::vector<ReceivedPart> _parts;
+static bool _complete = false;
+
+static void receivePart(HTTP_Request&, const HTTP_FormPart& part, const uint8_t* data, size_t length)
+{
+  host::AllocationPause pause;
+  if(_parts.empty() || _parts.back().final) _parts.push_back({part.name.c_str(), part.filename.c_str(), part.contentType.c_str(), "", false});
+  ReceivedPart& received = _parts.back();
+  if(part.offset != received.content.size()) received.content = "offset mismatch";
+  received.content.append((const char*)data, length);
+  received.final = part.final;
+}
+
+static void* sendFields(Req& req, Res& res)
+{
+  _complete = false;
+  auto respond = [&req, &res](){
+    String text;
+    for(int i = 0; i < req.fieldsCount; ++i) text += req.fields[i].key.toString() + "=" + req.fields[i].value.toString() + ";";
+    _complete = req.multipartDone();
+    res.send(200, "text/plain", text);
+  };
+  if(req.bodyStreamed || req.multipart()) req.onEnd(respond);
+  else respond();
+  return nullptr;
+}
+
+static void setUp(ArduinoExpress& app)
+{
+  _parts.clear();
+  app.use(ArduinoExpress::Form(receivePart));
+  app.post("/form", sendFields);
+  app.begin(80);
+}
+
+static std::string post(ArduinoExpress& app, const std::string& contentType, const std::string& body, size_t segmentSize = 0)
+{
+  host::setConditions({segmentSize, 0, 0, 0});
+  return host::exchange(app, "POST /form HTTP/1.1\r\nContent-Type: " + contentType + "\r\nContent-Length: " +
+                             std::to_string(body.size()) + "\r\n\r\n" + body);
+}
+
+static std::string multipartType()
+{
+  return std::string("multipart/form-data; boundary=") + BOUNDARY;
+}
+
+static std::string field(const std::string& name, const std::string& value)
+{
+  return std::string("--") + BOUNDARY + "\r\nContent-Disposition: form-data; name=\"" + name + "\"\r\n\r\n" + value + "\r\n";
+}
+
+static std::string file(const std::string& name, const std::string& filename, const std::string& content)
+{
+  return std::string("--") + BOUNDARY + "\r\nContent-Disposition: form-data; name=\"" + name + "\"; filename=\"" +
+         filename + "\"\r\nContent-Type: application/octet-stream\r\n\r\n" + content + "\r\n";
+}
+
+static std::string end()
+{
+  return std::string("--") + BOUNDARY + "--\r\n";
+}
+
+// a file's content that has pieces of the delimiter in it, but not the delimiter
+static std::string trickyContent(size_t size)
+{
+  std::string content;
+  while(content.size() < size){
+    content += "\r\n-";
+    content += "\r\n--";
+    content += std::string("\r\n--") + std::string(BOUNDARY, sizeof(BOUNDARY) - 2);
+    content += "firmware bytes ";
+    content += (char)('A' + content.size() % 26);
+  }
+  content.resize(size);
+  return content;
+}
+
+
+TEST(urlencodedFieldsAreDecoded)
+{
+  ArduinoExpress app;
+  setUp(app);
+
+  std::string response = post(app, "application/x-www-form-urlencoded", "ssid=My+Home%20WiFi&password=p%40ss%26word&empty=");
+  CHECK(host::contains(response, "200 OK"));
+  CHECK(host::contains(response, "ssid=My Home WiFi;password=p@ss&word;empty=;"));
+}
+
+
+TEST(streamedUrlencodedBodiesAreRefused)
+{
+  ArduinoExpress app;
+  setUp(app);
+
+  std::string body = "data=" + std::string(4 * ArduinoExpressConfig::REQUEST_BUFFER_SIZE, 'x');
+  CHECK(host::contains(post(app, "application/x-www-form-urlencoded", body), "413"));
+}
+
+
+TEST(multipartFieldsAndFilesAreReceived)
+{
+  ArduinoExpress app;
+  setUp(app);
+
+  std::string body = field("name", "sensor-1") + file("config", "config.json", "{\"interval\":60}") + field("mode", "auto") + end();
+  std::string response = post(app, multipartType(), body);
+
+  CHECK(host::contains(response, "name=sensor-1;mode=auto;"));
+  CHECK(_complete);
+  CHECK(_parts.size() == 3);
+  if(_parts.size() == 3){
+    CHECK(_parts[1].name == "config");
+    CHECK(_parts[1].filename == "config.json");
+    CHECK(_parts[1].contentType == "application/octet-stream");
+    CHECK(_parts[1].content == "{\"interval\":60}");
+    CHECK(_parts[1].final);
+    CHECK(_parts[2].content == "auto");
+  }
+}
+
+
+TEST(multipartFilesAreStreamedWhateverTheSegments)
+{
+  std::string content = trickyContent(64 * 1024);
+  std::string body = field("name", "sensor-1") + file("firmware", "firmware.bin", content) + end();
+
+  for(size_t segmentSize : {1, 7, 536, 1460}){
+    ArduinoExpress app;
+    setUp(app);
+    std::string response = post(app, multipartType(), body, segmentSize);
+
+    CHECK(host::contains(response, "200 OK"));
+    CHECK(host::contains(response, "name=sensor-1;"));
+    CHECK(_complete);
+    CHECK(_parts.size() == 2);
+    if(_parts.size() == 2) CHECK(_parts[1].content == content);
+  }
+}
+
+
+TEST(truncatedMultipartBodiesAreNotComplete)
+{
+  ArduinoExpress app;
+  setUp(app);
+
+  std::string body = field("name", "sensor-1") + file("config", "config.json", "{\"interval\":60}");
+  CHECK(host::contains(post(app, multipartType(), body), "name=sensor-1;"));
+  CHECK(!_complete);
+}
+
+
+TEST(multipartBodiesWithoutABoundaryAreRefused)
+{
+  ArduinoExpress app;
+  setUp(app);
+
+  CHECK(host::contains(post(app, "multipart/form-data", field("name", "x") + end()), "400"));
+  CHECK(host::contains(post(app, "multipart/form-data; boundary=" + std::string(200, 'b'), field("name", "x") + end()), "400"));
+}
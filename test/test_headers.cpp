@@ -0,0 +1,165 @@
+// The header index of requests and responses: names are matched ignoring case, well known ones by
+// their HTTP_HeaderId, others by hash; a repeated header is found by its first value
+
+#include "HostTest.h"
+#include "ArduinoExpress.h"
+
+static void parse(HTTP_RequestParser& parser, HTTP_Request& req, const char* request)
+{
+  req.clear();
+  parser.begin(req);
+  parser.feed(request, strlen(request));
+}
+
+
+TEST(toHeaderIdIgnoresCase)
+{
+  CHECK(toHeaderId("Content-Length", 14) == HEADER_CONTENT_LENGTH);
+  CHECK(toHeaderId("content-length", 14) == HEADER_CONTENT_LENGTH);
+  CHECK(toHeaderId("CONTENT-LENGTH", 14) == HEADER_CONTENT_LENGTH);
+  CHECK(toHeaderId("Content-Lengths", 15) == HEADER_OTHER);
+  CHECK(toHeaderId("X-Device", 8) == HEADER_OTHER);
+  for(int id = 1; id < HTTP_HEADER_IDS_COUNT; ++id){
+    PGM_P name = headerName((HTTP_HeaderId)id);
+    CHECK(toHeaderId(name, strlen_P(name)) == id);
+  }
+  CHECK(headerHash("X-Device", 8) == headerHash("x-device", 8));
+  CHECK(headerHash("", 0) != 0);
+}
+
+
+TEST(requestHeadersAreFoundIgnoringCase)
+{
+  HTTP_RequestParser parser;
+  HTTP_Request req;
+  parse(parser, req, "GET / HTTP/1.1\r\nhost: device\r\nACCEPT-ENCODING: gzip\r\nX-Trace-Id: 7\r\n"
+                     "x-device: gateway\r\nCookie: a=1\r\nCookie: b=2\r\n\r\n");
+  CHECK(parser.complete());
+
+  CHECK(req.getHeader(HEADER_HOST).equals("device"));
+  CHECK(req.getHeader("Host").equals("device"));
+  CHECK(req.getHeader("Accept-Encoding").equals("gzip"));
+  CHECK(req.getHeader("x-trace-id").equals("7"));
+  CHECK(req.getHeader("X-DEVICE").equals("gateway"));
+  CHECK(req.getHeader(HEADER_COOKIE).equals("a=1"));
+  CHECK(req.hasHeader("X-Trace-Id"));
+  CHECK(!req.hasHeader("X-Trace"));
+  CHECK(!req.hasHeader(HEADER_AUTHORIZATION));
+  CHECK(req.getHeader("Authorization").isEmpty());
+
+  // the index is cleared with the request
+  parse(parser, req, "GET / HTTP/1.1\r\n\r\n");
+  CHECK(!req.hasHeader(HEADER_HOST));
+  CHECK(!req.hasHeader("X-Device"));
+}
+
+
+TEST(responseHeadersAreReplacedIgnoringCase)
+{
+  HTTP_Response res(nullptr);
+  res.setHeader("content-type", "text/plain");
+  res.setHeader(HEADER_CONTENT_TYPE, "text/html");
+  res.setHeader("X-Device", "a");
+  res.setHeader("x-device", "b");
+
+  CHECK(res.getHeader("Content-Type").equals("text/html"));
+  CHECK(res.getHeader(HEADER_CONTENT_TYPE).equals("text/html"));
+  CHECK(res.getHeader("X-DEVICE").equals("b"));
+  CHECK(res.hasHeader("x-device"));
+  CHECK(!res.hasHeader("X-Other"));
+
+  int count = 0;
+  for(int i = 0; i < ArduinoExpressConfig::MAX_HEADERS_COUNT; ++i){
+    if(!res.headers()[i].key.isEmpty()) ++count;
+  }
+  CHECK(count == 2);
+
+  res.reset();
+  CHECK(!res.hasHeader(HEADER_CONTENT_TYPE));
+  CHECK(!res.hasHeader("X-Device"));
+}
+
+
+TEST(responseIsSentWithEachHeaderOnce)
+{
+  ArduinoExpress app;
+  app.get("/", [](Req& req, Res& res) -> void* {
+    res.setHeader("content-type", "text/csv");
+    res.setHeader("Cache-Control", "no-store");
+    res.send(200, "text/plain", req.getHeader("user-agent").c_str());
+    return nullptr;
+  });
+  app.begin(80);
+
+  std::string response = host::exchange(app, "GET / HTTP/1.1\r\nUser-Agent: curl/8.4\r\n\r\n");
+  // the name keeps the case it was first set with
+  CHECK(host::contains(response, "\r\ncontent-type: text/plain\r\n"));
+  CHECK(!host::contains(response, "Content-Type"));
+  CHECK(!host::contains(response, "text/csv"));
+  CHECK(host::contains(response, "\r\nCache-Control: no-store\r\n"));
+  CHECK(host::contains(response, "\r\n\r\ncurl/8.4"));
+}
+
+
+TEST(headersLargerThanTheArenaAreKept)
+{
+  HTTP_Response res(nullptr);
+  res.setHeader(HEADER_CACHE_CONTROL, "no-store");
+  res.reset();
+
+  // the value gets a heap block, freed with the others by reset()
+  int64_t before = host::allocationStats().liveBytes;
+  String large(std::string(2 * ArduinoExpressConfig::RESPONSE_ARENA_SIZE, 'a').c_str());
+  int64_t withString = host::allocationStats().liveBytes;
+  CHECK(res.setHeader("Content-Security-Policy", large));
+  CHECK(res.getHeader("Content-Security-Policy").equals(large.c_str()));
+  CHECK(host::allocationStats().liveBytes > withString);
+  res.reset();
+  CHECK(host::allocationStats().liveBytes == withString);
+  large = String();
+  CHECK(host::allocationStats().liveBytes == before);
+}
+
+
+TEST(replacedValuesAreReclaimed)
+{
+  HTTP_Response res(nullptr);
+  res.setHeader(HEADER_CACHE_CONTROL, "public, max-age=86400");
+  res.setHeader("X-Requests", "0");
+
+  // the last value set is resized where it is, an earlier one is rewritten in place when it shrinks
+  uint64_t before = host::allocationStats().allocations;
+  char value[16];
+  for(int i = 0; i < 1000; ++i){
+    snprintf(value, sizeof(value), "%d", i * 997);
+    CHECK(res.setHeader("X-Requests", value));
+    CHECK(res.setHeader(HEADER_CACHE_CONTROL, i % 2 ? "no-store" : "max-age=60"));
+  }
+  CHECK(host::allocationStats().allocations == before);
+  CHECK(res.getHeader("X-Requests").equals("996003"));
+  CHECK(res.getHeader(HEADER_CACHE_CONTROL).equals("no-store"));
+}
+
+
+TEST(bodiesAreNotEncodedWithoutTheirHeader)
+{
+  ArduinoExpress app;
+  app.use(ArduinoExpress::Compress());
+  app.get("/", [](Req&, Res& res) -> void* {
+    // with Content-Type, every header is taken: Content-Encoding can't be set
+    char name[16];
+    for(int i = 0; i + 1 < ArduinoExpressConfig::MAX_HEADERS_COUNT; ++i){
+      snprintf(name, sizeof(name), "X-Filler-%d", i);
+      res.setHeader(name, "1");
+    }
+    res.send(200, "text/plain", String(std::string(4096, 'p').c_str()));
+    return nullptr;
+  });
+  app.begin(80);
+
+  std::string response = host::exchange(app, "GET / HTTP/1.1\r\nAccept-Encoding: gzip\r\n\r\n");
+  CHECK(host::contains(response, "200 OK"));
+  CHECK(!host::contains(response, "Content-Encoding"));
+  CHECK(host::contains(response, "Content-Length: 4096\r\n"));
+  CHECK(host::contains(response, "\r\n\r\n" + std::string(4096, 'p')));
+}
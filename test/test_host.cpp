@@ -0,0 +1,110 @@
+// Tests of the host build itself: the String stand-in, and the simulated network the other tests
+// and the benchmarks serve their clients on
+
+#include "HostTest.h"
+#include "ArduinoExpress.h"
+
+TEST(stringBehavesLikeTheCores)
+{
+  String text("Hello");
+  text += ", ";
+  text += String(42);
+  text.concat(" world", 6);
+  CHECK(text == "Hello, 42 world");
+  CHECK(text.length() == 15);
+  CHECK(text.indexOf("42") == 7);
+  CHECK(text.substring(7, 9) == "42");
+  CHECK(text.startsWith("Hello") && text.endsWith("world"));
+
+  text.remove(5, 4);
+  CHECK(text == "Hello world");
+  text.toUpperCase();
+  CHECK(text.equalsIgnoreCase("hello WORLD"));
+  CHECK(String(-17) == "-17" && String(255u, 16) == "ff");
+}
+
+
+TEST(shortStringsDontAllocate)
+{
+  uint64_t before = host::allocationStats().allocations;
+  String text("eleven char");
+  CHECK(host::allocationStats().allocations == before);
+  text += "s";
+  CHECK(host::allocationStats().allocations == before + 1);
+}
+
+
+TEST(segmentsArriveAfterTheirLatency)
+{
+  host::useSimulatedClock(true, 1000);
+  host::NetworkConditions conditions;
+  conditions.segmentSize = 4;
+  conditions.latencyUs = 500;
+  host::setConditions(conditions);
+
+  WiFiServer server(8080);
+  server.begin();
+  host::SimulatedClient client = host::connect(8080);
+  client.send("GET / HTTP");
+
+  WiFiClient accepted = server.available();
+  CHECK((bool)accepted);
+  CHECK(accepted.available() == 0);
+  host::advanceClock(500);
+  CHECK(accepted.available() == 10);
+
+  uint8_t data[16];
+  CHECK(accepted.read(data, 3) == 3);
+  CHECK(accepted.read(data + 3, sizeof(data) - 3) == 7);
+  CHECK(memcmp(data, "GET / HTTP", 10) == 0);
+  CHECK(client.drained());
+}
+
+
+TEST(bandwidthDelaysTheResponse)
+{
+  host::useSimulatedClock(true, 0);
+  host::NetworkConditions conditions;
+  conditions.bytesPerSecond = 1000;
+  conditions.latencyUs = 2000;
+  host::setConditions(conditions);
+
+  WiFiServer server(80);
+  server.begin();
+  host::SimulatedClient client = host::connect();
+  WiFiClient accepted = server.available();
+  accepted.write((const uint8_t*)"0123456789", 10);
+  accepted.write((const uint8_t*)"0123456789", 10);
+
+  // 20 bytes at 1000 bytes/s take 20 ms, and arrive 2 ms later
+  CHECK(client.receivedAt() == 22000);
+  CHECK(client.writes() == 2);
+  CHECK(client.take() == "01234567890123456789");
+}
+
+
+TEST(clientsWaitInTheBacklog)
+{
+  WiFiServer server(80);
+  server.begin();
+  host::connect();
+  host::connect();
+  CHECK(host::pendingConnections() == 2);
+  CHECK(server.hasClient());
+  server.available();
+  server.available();
+  CHECK(!server.hasClient());
+  CHECK(!server.available());
+}
+
+
+TEST(appServesASimulatedClient)
+{
+  ArduinoExpress app;
+  app.get("/hello", [](Req&, Res& res) -> void* {res.send(200, "text/plain", "hi"); return nullptr;});
+  app.begin(80);
+
+  std::string response = host::exchange(app, "GET /hello HTTP/1.1\r\nHost: device\r\n\r\n");
+  CHECK(host::contains(response, "HTTP/1.1 200 OK\r\n"));
+  CHECK(host::contains(response, "\r\n\r\nhi"));
+}
@@ -0,0 +1,108 @@
+// The JSON body of a request: parsed once, on the first json(), into an arena the connection keeps,
+// and shared by the middlewares and the handler. The Json() middleware answers bodies it can't
+// parse with 400, and bodies over its limit with 413
+
+#include "HostTest.h"
+#include "ArduinoExpress.h"
+
+static void parse(HTTP_RequestParser& parser, HTTP_Request& req, const std::string& body)
+{
+  static std::string request;
+  host::AllocationPause pause;
+  request = "POST /readings HTTP/1.1\r\nContent-Type: application/json\r\nContent-Length: " +
+            std::to_string(body.size()) + "\r\n\r\n" + body;
+  req.clear();
+  parser.begin(req);
+  parser.feed(request.data(), request.size());
+}
+
+
+TEST(bodyIsParsedOnce)
+{
+  HTTP_RequestParser parser;
+  HTTP_Request req;
+  parse(parser, req, "{\"sensor\":\"t1\",\"value\":21.5,\"tags\":[1,2,3]}");
+
+  JsonObject& document = req.json().as<JsonObject&>();
+  CHECK(document.success());
+  CHECK(req.jsonStatus() == 0);
+
+  uint64_t before = host::allocationStats().allocations;
+  CHECK(&req.json().as<JsonObject&>() == &document);
+  CHECK(strcmp(req.bodyJSON("sensor").as<const char*>(), "t1") == 0);
+  CHECK(req.bodyJSON("value").as<double>() == 21.5);
+  CHECK(req.bodyJSON("tags").as<JsonArray&>().size() == 3);
+  CHECK(!req.bodyJSON("missing").success());
+  CHECK(host::allocationStats().allocations == before);
+}
+
+
+TEST(arenaIsKeptForTheNextRequest)
+{
+  HTTP_RequestParser parser;
+  HTTP_Request req;
+  parse(parser, req, "{\"value\":1}");
+  CHECK(req.json().success());
+
+  uint64_t before = host::allocationStats().allocations;
+  parse(parser, req, "{\"value\":2}");
+  CHECK(req.bodyJSON("value").as<int>() == 2);
+  CHECK(host::allocationStats().allocations == before);
+}
+
+
+TEST(invalidAndOversizedDocumentsFail)
+{
+  HTTP_RequestParser parser;
+  HTTP_Request req;
+  parse(parser, req, "{\"value\":");
+  CHECK(!req.json().success());
+  CHECK(req.jsonStatus() == 400);
+  CHECK(!req.bodyJSON("value").success());
+
+  // a document that needs more than twice its text is parsed again in a larger arena
+  std::string numbers = "[1";
+  for(int i = 0; i < 60; ++i) numbers += ",1";
+  numbers += "]";
+  parse(parser, req, numbers);
+  CHECK(req.json().as<JsonArray&>().size() == 61);
+
+  // ...until MAX_JSON_BUFFER_SIZE. An element takes 32 bytes of the arena on the PC
+  std::string many = "[1";
+  while(many.size() < ArduinoExpressConfig::MAX_JSON_BUFFER_SIZE / 8) many += ",1";
+  many += "]";
+  parse(parser, req, many);
+  CHECK(!req.json().success());
+  CHECK(req.jsonStatus() == 413);
+}
+
+
+static void* readValue(Req& req, Res& res)
+{
+  char body[32];
+  snprintf(body, sizeof(body), "value=%d", req.bodyJSON("value").as<int>());
+  res.send(200, "text/plain", body);
+  return nullptr;
+}
+
+static std::string post(ArduinoExpress& app, const char* contentType, const std::string& body)
+{
+  return host::exchange(app, std::string("POST /readings HTTP/1.1\r\nContent-Type: ") + contentType +
+                        "\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body);
+}
+
+
+TEST(middlewareAnswersBodiesItCantParse)
+{
+  ArduinoExpress app;
+  app.use(ArduinoExpress::Json(64));
+  app.post("/readings", readValue);
+  app.begin(80);
+
+  CHECK(host::contains(post(app, "application/json; charset=utf-8", "{\"value\":7}"), "value=7"));
+  CHECK(host::contains(post(app, "application/json", "{value:7"), "HTTP/1.1 400 "));
+  CHECK(host::contains(post(app, "application/json", "{\"value\":7,\"pad\":\"" + std::string(64, 'p') + "\"}"), "HTTP/1.1 413 "));
+
+  // other bodies are left to the handler
+  CHECK(host::contains(post(app, "text/plain", "{value:7"), "value=0"));
+}
@@ -0,0 +1,166 @@
+// Persistent connections: pipelined requests are answered in order on one connection, which is
+// kept open as long as each response says so
+
+#include "HostTest.h"
+#include "ArduinoExpress.h"
+
+static std::string request(const char* path, const char* headers = "")
+{
+  return std::string("GET ") + path + " HTTP/1.1\r\nHost: device\r\n" + headers + "\r\n";
+}
+
+// takes the complete responses off the client, returns how many there were
+static int takeResponses(host::SimulatedClient& client, std::vector<std::string>* responses = nullptr)
+{
+  int count = 0;
+  std::string& received = client.socket().outbound;
+  while(size_t length = host::responseLength(received)){
+    if(responses) responses->push_back(received.substr(0, length));
+    received.erase(0, length);
+    ++count;
+  }
+  return count;
+}
+
+static void setupApp(ArduinoExpress& app)
+{
+  app.get("/echo", [](Req& req, Res& res) -> void* {res.send(200, "text/plain", req.getQuery("n").toString()); return nullptr;});
+  app.get("/close", [](Req&, Res& res) -> void* {
+    res.setHeader(HEADER_CONNECTION, "close");
+    res.send(200, "text/plain", "bye");
+    return nullptr;
+  });
+  app.post("/upload", [](Req& req, Res& res) -> void* {
+    // answered before the body, which is read after the response
+    req.onData([](const uint8_t*, size_t) {});
+    res.send(202, "text/plain", "accepted");
+    return nullptr;
+  });
+  app.begin(80);
+}
+
+
+TEST(pipelinedRequestsAreAnsweredInOrder)
+{
+  ArduinoExpress app;
+  setupApp(app);
+
+  host::SimulatedClient client = host::connect();
+  client.send(request("/echo?n=1") + request("/echo?n=2") + request("/echo?n=3"));
+  std::vector<std::string> responses;
+  host::pump(app, [&]{takeResponses(client, &responses); return responses.size() == 3;});
+
+  CHECK(responses.size() == 3);
+  for(int i = 0; i < (int)responses.size(); ++i){
+    CHECK(host::contains(responses[i], "Connection: keep-alive\r\n"));
+    CHECK(host::contains(responses[i], "\r\n\r\n" + std::to_string(i + 1)));
+  }
+  CHECK(!client.closedByServer());
+}
+
+
+TEST(pipelinedRequestsSplitAcrossSegments)
+{
+  host::useSimulatedClock(true);
+  host::setConditions({7, 100, 0});
+  ArduinoExpress app;
+  setupApp(app);
+
+  host::SimulatedClient client = host::connect();
+  client.send(request("/echo?n=1") + request("/echo?n=2"));
+  int count = 0;
+  CHECK(host::pump(app, [&]{host::advanceClock(50); count += takeResponses(client); return count == 2;}));
+}
+
+
+TEST(connectionIsClosedAfterTheRequestCap)
+{
+  ArduinoExpress app;
+  setupApp(app);
+
+  host::SimulatedClient client = host::connect();
+  std::vector<std::string> responses;
+  for(int i = 0; i < ArduinoExpressConfig::MAX_KEEP_ALIVE_REQUESTS && !client.closedByServer(); ++i){
+    client.send(request("/echo?n=1"));
+    host::pump(app, [&]{return takeResponses(client, &responses) > 0;});
+  }
+  CHECK((int)responses.size() == ArduinoExpressConfig::MAX_KEEP_ALIVE_REQUESTS);
+  CHECK(host::contains(responses.back(), "Connection: close\r\n"));
+  CHECK(host::contains(responses[responses.size() - 2], "Connection: keep-alive\r\n"));
+  CHECK(host::pump(app, [&]{return client.closedByServer();}));
+}
+
+
+TEST(clientsThatDontKeepAliveAreClosed)
+{
+  ArduinoExpress app;
+  setupApp(app);
+
+  host::SimulatedClient client = host::connect();
+  client.send(request("/echo", "Connection: close\r\n"));
+  CHECK(host::pump(app, [&]{return client.closedByServer();}));
+  CHECK(host::contains(client.received(), "Connection: close\r\n"));
+
+  client = host::connect();
+  client.send("GET /echo HTTP/1.0\r\n\r\n");
+  CHECK(host::pump(app, [&]{return client.closedByServer();}));
+
+  client = host::connect();
+  client.send("GET /echo HTTP/1.0\r\nConnection: keep-alive\r\n\r\n");
+  host::pump(app, [&]{return host::responseLength(client.received()) > 0;});
+  CHECK(host::contains(client.received(), "Connection: keep-alive\r\n"));
+  CHECK(!client.closedByServer());
+}
+
+
+TEST(responseThatSaysCloseClosesTheConnection)
+{
+  ArduinoExpress app;
+  setupApp(app);
+
+  host::SimulatedClient client = host::connect();
+  client.send(request("/close") + request("/echo"));
+  CHECK(host::pump(app, [&]{return client.closedByServer();}));
+  CHECK(takeResponses(client) == 1);
+}
+
+
+TEST(earlyResponseKeepsTheConnection)
+{
+  ArduinoExpress app;
+  setupApp(app);
+
+  // the body doesn't fit in the request buffer, it's streamed after the 202 is sent
+  std::string body(ArduinoExpressConfig::REQUEST_BUFFER_SIZE * 2, 'x');
+  host::SimulatedClient client = host::connect();
+  client.send("POST /upload HTTP/1.1\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n");
+  std::vector<std::string> responses;
+  host::pump(app, [&]{return takeResponses(client, &responses) > 0;});
+  CHECK(responses.size() == 1 && host::contains(responses[0], "HTTP/1.1 202 "));
+  CHECK(responses.size() == 1 && host::contains(responses[0], "Connection: keep-alive\r\n"));
+
+  client.send(body + request("/echo?n=2"));
+  host::pump(app, [&]{return takeResponses(client, &responses) > 0;});
+  CHECK(responses.size() == 2 && host::contains(responses[1], "\r\n\r\n2"));
+  CHECK(!client.closedByServer());
+}
+
+
+TEST(idleConnectionTimesOut)
+{
+  host::useSimulatedClock(true);
+  ArduinoExpress app;
+  setupApp(app);
+
+  host::SimulatedClient client = host::connect();
+  client.send(request("/echo"));
+  host::pump(app, [&]{return takeResponses(client) > 0;});
+
+  host::advanceClock(ArduinoExpressConfig::KEEP_ALIVE_TIMEOUT_MS * 1000);
+  app.handle();
+  CHECK(!client.closedByServer());
+  host::advanceClock(1000);
+  app.handle();
+  CHECK(client.closedByServer());
+  CHECK(client.received().empty());
+}
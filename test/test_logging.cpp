@@ -0,0 +1,124 @@
+// Logging through the log buffer (built with ARDUINOEXPRESS_LOG_BUFFER_SIZE=1024 at DEBUG level):
+// messages are queued, written to Serial by logflush() only as fast as the UART takes them, and
+// dropped whole when the buffer is full
+
+#include "HostTest.h"
+#include "ArduinoExpress.h"
+
+// what Serial wrote, since the last call
+static std::string serialOutput()
+{
+  static char* text = nullptr;
+  static size_t size = 0;
+  static FILE* output = nullptr;
+  static size_t read = 0;
+
+  host::AllocationPause pause;
+  if(!output){
+    output = open_memstream(&text, &size);
+    host::setSerialOutput(output);
+  }
+  fflush(output);
+  std::string written(text + read, size - read);
+  read = size;
+  return written;
+}
+
+// empties the log buffer
+static void drain()
+{
+  Serial.begin(0);
+  for(int i = 0; i < 4; ++i) logflush();
+  serialOutput();
+}
+
+
+TEST(messagesWaitForLogflush)
+{
+  drain();
+  logwarn("%d clients waiting", 3);
+  logdebug("%s", "details");
+  CHECK(serialOutput().empty());
+
+  logflush();
+  CHECK(serialOutput() == "WARN: 3 clients waiting\r\nDEBUG: details\r\n");
+}
+
+
+TEST(longMessagesAreCut)
+{
+  drain();
+  std::string text(300, 'x');
+  loginfo("%s", text.c_str());
+  logflush();
+
+  std::string line = serialOutput();
+  CHECK(line.size() <= (size_t)ArduinoExpressConfig::MAX_LOG_LINE_LENGTH);
+  CHECK(line.compare(0, 12, "INFO: xxxxxx") == 0);
+  CHECK(line.compare(line.size() - 3, 3, "x\r\n") == 0);
+}
+
+
+TEST(logflushDoesntWaitForTheUART)
+{
+  drain();
+  host::useSimulatedClock(true, 1000);
+  Serial.begin(115200);
+
+  std::string text(90, 'm');
+  for(int i = 0; i < 5; ++i) logerr("%s", text.c_str());
+
+  // the FIFO takes 128 bytes, the rest is written as it drains, 10 bits a byte
+  logflush();
+  CHECK(serialOutput().size() == (size_t)HardwareSerial::FIFO_SIZE);
+  CHECK(micros() == 1000);
+  logflush();
+  CHECK(serialOutput().empty());
+
+  host::advanceClock(5000);
+  logflush();
+  size_t written = serialOutput().size();
+  CHECK(written > 40 && written <= 60);
+
+  for(int i = 0; i < 10; ++i){
+    host::advanceClock(20000);
+    logflush();
+  }
+  CHECK(serialOutput().size() == 5 * 99 - HardwareSerial::FIFO_SIZE - written);
+
+  host::useSimulatedClock(false);
+}
+
+
+TEST(fullBufferDropsMessages)
+{
+  drain();
+  std::string text(93, 'd');
+  for(int i = 0; i < 12; ++i) logwarn("%s", text.c_str());
+
+  // ten 101 byte messages fit in 1024 bytes, the next ones are dropped and reported once written
+  logflush();
+  std::string output = serialOutput();
+  CHECK(output.size() == 10 * 101);
+  logflush();
+  CHECK(serialOutput() == "WARN: 2 log messages dropped\r\n");
+}
+
+
+TEST(directLoggingWaitsForTheUART)
+{
+  drain();
+  host::useSimulatedClock(true, 0);
+  Serial.begin(115200);
+
+  // 1000 bytes at 115200 baud take about 87 ms, the write returns when the last 128 are in the FIFO
+  Serial.write((const uint8_t*)std::string(1000, 'u').data(), 1000);
+  CHECK(micros() >= 75000 && micros() <= 76000);
+  CHECK(Serial.availableForWrite() == 0);
+
+  host::advanceClock(12000);
+  CHECK(Serial.availableForWrite() == HardwareSerial::FIFO_SIZE);
+
+  host::useSimulatedClock(false);
+  drain();
+}
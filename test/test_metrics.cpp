@@ -0,0 +1,175 @@
+// The request metrics (built with ARDUINOEXPRESS_METRICS=1): counters and phase histograms of each
+// route, timed with a fake clock that only the handlers and middlewares move, and served by the
+// Metrics() endpoint in the Prometheus text format
+
+#include "HostTest.h"
+#include "ArduinoExpress.h"
+
+static unsigned long _now = 0;
+static unsigned long fakeClock() {return _now;}
+
+static void* slowHandler(Req&, Res& res)
+{
+  _now += 2000;
+  res.send(200, "text/plain", "done");
+  return nullptr;
+}
+
+static void* slowMiddleware(Req&, Res&, Next next)
+{
+  _now += 300;
+  next();
+  return nullptr;
+}
+
+static const HTTP_RouteMetrics* findRoute(HTTP_Method method, const char* path)
+{
+  int count;
+  const HTTP_RouteMetrics* routes = metricsRoutes(count);
+  for(int slot = 1; slot < count; ++slot){
+    if(routes[slot].method == method && routes[slot].path == path) return &routes[slot];
+  }
+  return nullptr;
+}
+
+// returns the head of a chunked response followed by its body, without the chunks' framing
+static std::string dechunk(const std::string& response)
+{
+  size_t position = response.find("\r\n\r\n") + 4;
+  std::string text = response.substr(0, position);
+  while(position < response.size()){
+    size_t lineEnd = response.find("\r\n", position);
+    size_t size = strtoul(response.c_str() + position, nullptr, 16);
+    if(size == 0) break;
+    text += response.substr(lineEnd + 2, size);
+    position = lineEnd + 2 + size + 2;
+  }
+  return text;
+}
+
+
+TEST(requestsAreCountedByRoute)
+{
+  setMetricsClock(fakeClock);
+  ArduinoExpress app;
+  app.get("/counted", slowHandler);
+  app.post("/counted", slowHandler);
+  app.begin(80);
+
+  const std::string request = "GET /counted HTTP/1.1\r\n\r\n";
+  size_t bytesOut = 0;
+  for(int i = 0; i < 3; ++i) bytesOut += host::exchange(app, request).size();
+  host::exchange(app, "POST /counted HTTP/1.1\r\nContent-Length: 2\r\n\r\nab");
+
+  const HTTP_RouteMetrics* get = findRoute(HTTP_Method::GET, "/counted");
+  const HTTP_RouteMetrics* post = findRoute(HTTP_Method::POST, "/counted");
+  CHECK(get && get->requests == 3 && get->statuses[1] == 3);
+  CHECK(get && get->bytesIn == 3 * request.size());
+  CHECK(get && get->bytesOut == bytesOut);
+  CHECK(post && post->requests == 1);
+
+  // requests no route handled are counted in the slot 0
+  int count;
+  uint32_t unrouted = metricsRoutes(count)[0].requests;
+  host::exchange(app, "GET /nowhere HTTP/1.1\r\n\r\n");
+  CHECK(metricsRoutes(count)[0].requests == unrouted + 1);
+  CHECK(metricsRoutes(count)[0].statuses[4] >= 1);
+}
+
+
+TEST(phasesAreTimedWithTheMetricsClock)
+{
+  setMetricsClock(fakeClock);
+  ArduinoExpress app;
+  app.use(slowMiddleware);
+  app.get("/timed", slowHandler);
+  app.begin(80);
+
+  host::exchange(app, "GET /timed HTTP/1.1\r\n\r\n");
+  const HTTP_RouteMetrics* route = findRoute(HTTP_Method::GET, "/timed");
+  CHECK(route != nullptr);
+  if(!route) return;
+
+  // the buckets are 100, 500, 1000, 5000... us
+  const HTTP_Histogram& handler = route->phases[PHASE_HANDLER];
+  CHECK(handler.count == 1 && handler.sum == 2000 && handler.buckets[3] == 1);
+  const HTTP_Histogram& dispatch = route->phases[PHASE_DISPATCH];
+  CHECK(dispatch.count == 1 && dispatch.sum == 300 && dispatch.buckets[1] == 1);
+  CHECK(route->phases[PHASE_PARSE].sum == 0 && route->phases[PHASE_PARSE].buckets[0] == 1);
+  CHECK(route->phases[PHASE_SEND].sum == 0);
+}
+
+
+TEST(endpointServesPrometheusText)
+{
+  setMetricsClock(fakeClock);
+  ArduinoExpress app;
+  app.get("/scraped", slowHandler);
+  app.get("/metrics", ArduinoExpress::Metrics());
+  app.begin(80);
+
+  host::exchange(app, "GET /scraped HTTP/1.1\r\n\r\n");
+  host::exchange(app, "GET /scraped HTTP/1.1\r\n\r\n");
+  std::string metrics = dechunk(host::exchange(app, "GET /metrics HTTP/1.1\r\n\r\n"));
+
+  CHECK(host::contains(metrics, "Content-Type: text/plain; version=0.0.4"));
+  CHECK(host::contains(metrics, "# TYPE arduinoexpress_requests_total counter\n"));
+  CHECK(host::contains(metrics, "arduinoexpress_requests_total{method=\"GET\",route=\"/scraped\"} 2\n"));
+  CHECK(host::contains(metrics, "arduinoexpress_responses_total{method=\"GET\",route=\"/scraped\",code=\"2xx\"} 2\n"));
+
+  // the buckets are cumulative
+  CHECK(host::contains(metrics, "{method=\"GET\",route=\"/scraped\",phase=\"handler\",le=\"0.001\"} 0\n"));
+  CHECK(host::contains(metrics, "{method=\"GET\",route=\"/scraped\",phase=\"handler\",le=\"0.005\"} 2\n"));
+  CHECK(host::contains(metrics, "{method=\"GET\",route=\"/scraped\",phase=\"handler\",le=\"+Inf\"} 2\n"));
+  CHECK(host::contains(metrics, "arduinoexpress_phase_duration_seconds_sum{method=\"GET\",route=\"/scraped\",phase=\"handler\"} 0.004\n"));
+  CHECK(host::contains(metrics, "arduinoexpress_phase_duration_seconds_count{method=\"GET\",route=\"/scraped\",phase=\"handler\"} 2\n"));
+}
+
+
+TEST(requestsAreMeasuredWithoutAllocating)
+{
+  setMetricsClock(fakeClock);
+  ArduinoExpress app;
+  app.use(slowMiddleware);
+  app.get("/measured", slowHandler);
+  app.begin(80);
+
+  const std::string request = "GET /measured HTTP/1.1\r\n\r\n";
+  host::SimulatedClient client = host::connect();
+  client.send(request);
+  host::pump(app, [&]{return host::responseLength(client.received()) != 0;});
+
+  uint64_t before = host::allocationStats().allocations;
+  client.send(request);
+  client.send(request);
+  host::pump(app, [&]{return findRoute(HTTP_Method::GET, "/measured")->requests == 3;});
+  CHECK(host::allocationStats().allocations == before);
+}
+
+
+TEST(routesBeyondTheSlotsAreCountedAsUnrouted)
+{
+  setMetricsClock(fakeClock);
+  ArduinoExpress app;
+  char path[16];
+  const int ROUTES_COUNT = ArduinoExpressConfig::MAX_METRICS_ROUTES_COUNT;
+  for(int i = 0; i < ROUTES_COUNT; ++i){
+    snprintf(path, sizeof(path), "/route%d", i);
+    app.get(String(path), slowHandler);  // the buffer is reused, the route keeps a copy
+  }
+  app.begin(80);
+
+  // a route takes its slot when it's first requested, the earlier tests took some
+  int count;
+  uint32_t unrouted = metricsRoutes(count)[0].requests;
+  int free = ROUTES_COUNT + 1 - count;
+  for(int i = 0; i < ROUTES_COUNT; ++i){
+    snprintf(path, sizeof(path), "/route%d", i);
+    host::exchange(app, std::string("GET ") + path + " HTTP/1.1\r\n\r\n");
+    CHECK((findRoute(HTTP_Method::GET, path) != nullptr) == (i < free));
+  }
+
+  metricsRoutes(count);
+  CHECK(count == ROUTES_COUNT + 1);
+  CHECK(metricsRoutes(count)[0].requests == unrouted + ROUTES_COUNT - free);
+}
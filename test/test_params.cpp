@@ -0,0 +1,121 @@
+// Route parameters (":name"), wildcards ("*") and the query string: what getParam() and getQuery()
+// return, and that a request to a parameterized route is routed without allocating
+
+#include "HostTest.h"
+#include "ArduinoExpress.h"
+
+static void* echoParams(Req& req, Res& res)
+{
+  char body[128];
+  snprintf(body, sizeof(body), "id=%s name=%s rest=%s", req.getParam("id").c_str(), req.getParam("name").c_str(),
+           req.getParam("*").c_str());
+  res.send(200, "text/plain", body);
+  return nullptr;
+}
+
+static void* echoQuery(Req& req, Res& res)
+{
+  char body[128];
+  snprintf(body, sizeof(body), "q=%s page=%s has=%d count=%d", req.getQuery("q").c_str(), req.getQuery("page").c_str(),
+           req.hasQuery("flag") ? 1 : 0, req.queryCount);
+  res.send(200, "text/plain", body);
+  return nullptr;
+}
+
+static std::string get(ArduinoExpress& app, const std::string& target, uint16_t port = 80)
+{
+  std::string response = host::exchange(app, "GET " + target + " HTTP/1.1\r\n\r\n", port);
+  size_t end = response.find("\r\n\r\n");
+  return end == std::string::npos ? response : response.substr(end + 4);
+}
+
+
+TEST(parametersAreCaptured)
+{
+  ArduinoExpress app;
+  app.get("/devices/:id", echoParams);
+  app.get("/users/:name/devices/:id", echoParams);
+  app.begin(80);
+
+  CHECK(get(app, "/devices/42") == "id=42 name= rest=");
+  CHECK(get(app, "/users/ada/devices/7/") == "id=7 name=ada rest=");
+  CHECK(get(app, "/devices/a%20b") == "id=a b name= rest=");
+  CHECK(!host::contains(get(app, "/devices/42/more"), "id="));
+  CHECK(!host::contains(get(app, "/devices"), "id="));
+}
+
+
+// as with Express, the route registered first is called when several match
+static void* count(Req&, Res& res)
+{
+  res.send(200, "text/plain", "count");
+  return nullptr;
+}
+
+TEST(firstRegisteredRouteWins)
+{
+  ArduinoExpress staticFirst;
+  staticFirst.get("/devices/count", count);
+  staticFirst.get("/devices/:id", echoParams);
+  staticFirst.begin(80);
+  CHECK(get(staticFirst, "/devices/count") == "count");
+  CHECK(get(staticFirst, "/devices/counts") == "id=counts name= rest=");
+
+  ArduinoExpress parameterFirst;
+  parameterFirst.get("/devices/:id", echoParams);
+  parameterFirst.get("/devices/count", count);
+  parameterFirst.begin(81);
+  CHECK(get(parameterFirst, "/devices/count", 81) == "id=count name= rest=");
+}
+
+
+TEST(wildcardCapturesTheRestOfThePath)
+{
+  ArduinoExpress app;
+  app.get("/files/*", echoParams);
+  app.begin(80);
+
+  CHECK(get(app, "/files/a/b/c.txt") == "id= name= rest=a/b/c.txt");
+  CHECK(get(app, "/files/") == "id= name= rest=");
+}
+
+
+TEST(queryStringIsSplitAndDecoded)
+{
+  ArduinoExpress app;
+  app.get("/search", echoQuery);
+  app.begin(80);
+
+  CHECK(get(app, "/search?q=a+b%21&page=2&flag") == "q=a b! page=2 has=1 count=3");
+  CHECK(get(app, "/search") == "q= page= has=0 count=0");
+  CHECK(get(app, "/search?") == "q= page= has=0 count=0");
+
+  // the query doesn't take part in routing
+  CHECK(host::contains(get(app, "/search?q=/devices/1"), "q=/devices/1"));
+}
+
+
+TEST(parameterizedRouteDoesntAllocate)
+{
+  ArduinoExpress app;
+  app.get("/devices/:id/readings/:name", echoParams);
+  app.get("/search", echoQuery);
+  app.begin(80);
+
+  // the first requests size the response's body String, which is kept for the next ones
+  const std::string requests = "GET /devices/42/readings/temperature?unit=c HTTP/1.1\r\n\r\n"
+                               "GET /search?q=x&page=3 HTTP/1.1\r\n\r\n";
+  host::SimulatedClient client = host::connect();
+  client.send(requests);
+  host::pump(app, [&]{return host::contains(client.received(), "page=3");});
+  {
+    host::AllocationPause pause;
+    client.socket().outbound.clear();
+  }
+
+  uint64_t before = host::allocationStats().allocations;
+  client.send(requests);
+  host::pump(app, [&]{return host::contains(client.received(), "page=3");});
+  CHECK(host::allocationStats().allocations == before);
+  CHECK(host::contains(client.received(), "id=42 name=temperature"));
+}
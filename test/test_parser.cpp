@@ -0,0 +1,199 @@
+// HTTP_RequestParser: captured requests fed in every segmentation parse the same as in one piece,
+// malformed and smuggled framings are rejected, and random bytes never take it out of its buffer
+
+#include "HostTest.h"
+#include "HTTP_Parser.h"
+
+#include <random>
+#include <vector>
+
+static const char* const CAPTURED[] = {
+  "GET /api/status HTTP/1.1\r\nHost: 192.168.4.1\r\nAccept: application/json\r\nConnection: keep-alive\r\n\r\n",
+  "GET /api/sensors?since=1700000000&limit=20&name=room%201 HTTP/1.1\r\nHost: 192.168.4.1\r\n\r\n",
+  "GET /files/my%20docs/a%2Fb.txt HTTP/1.0\r\nHost: device\r\nConnection: keep-alive\r\n\r\n",
+  "POST /api/devices/4/state HTTP/1.1\r\nHost: 192.168.4.1\r\nContent-Type: application/json\r\n"
+    "Content-Length: 16\r\n\r\n{\"state\":\"on\"}\r\n",
+  "POST /upload HTTP/1.1\r\nHost: device\r\nTransfer-Encoding: chunked\r\n\r\n"
+    "5\r\nhello\r\n7;ext=1\r\n, world\r\n0\r\nX-Trailer: 1\r\n\r\n",
+  "\r\nPUT /led HTTP/1.1\r\nhost:device\r\ncontent-length:   3  \r\n\r\non!",
+  "GET / HTTP/1.1\nHost: device\n\n",
+};
+
+
+// everything the parser found in a request, to compare two parses of it
+static std::string describe(const HTTP_RequestParser& parser, const HTTP_Request& req, size_t consumed)
+{
+  host::AllocationPause pause;
+  std::string text = std::to_string(parser.state()) + " " + std::to_string(parser.errorStatus()) + " " +
+                     std::to_string(consumed) + "\n";
+  if(!parser.complete()) return text;
+
+  text += std::string(req.method.c_str()) + " " + req.route.c_str() + " " + req.version.c_str() + "\n";
+  text.append(req.pathSegments.c_str(), req.pathSegments.length());
+  for(int i = 0; i < req.queryCount; ++i) text += std::string("\n?") + req.query[i].key.c_str() + "=" + req.query[i].value.c_str();
+  for(int i = 0; i < req.headersCount; ++i) text += std::string("\n") + req.headers[i].key.c_str() + ": " + req.headers[i].value.c_str();
+  text += "\n" + std::string(req.body.c_str(), req.body.length());
+  return text + (parser.keepAlive() ? "\nkeep-alive" : "\nclose");
+}
+
+
+// parses request, fed in the pieces cut at the given offsets
+static std::string parse(const std::string& request, const std::vector<size_t>& cuts)
+{
+  static HTTP_RequestParser parser;
+  static HTTP_Request req;
+  req.clear();
+  parser.begin(req);
+
+  size_t consumed = 0, start = 0;
+  for(size_t i = 0; i <= cuts.size() && !parser.complete() && !parser.failed(); ++i){
+    size_t end = i < cuts.size() ? cuts[i] : request.size();
+    size_t count = parser.feed(request.data() + start, end - start);
+    CHECK(count <= end - start);
+    consumed += count;
+    start = end;
+  }
+  return describe(parser, req, consumed);
+}
+
+static int statusOf(const std::string& request)
+{
+  static HTTP_RequestParser parser;
+  static HTTP_Request req;
+  req.clear();
+  parser.begin(req);
+  parser.feed(request.data(), request.size());
+  return parser.failed() ? parser.errorStatus() : parser.complete() ? 200 : 0;
+}
+
+
+TEST(capturedRequestsParse)
+{
+  for(const char* request : CAPTURED){
+    std::string whole = parse(request, {});
+    CHECK(whole.compare(0, 2, "8 ") == 0);  // COMPLETE
+  }
+  CHECK(host::contains(parse(CAPTURED[4], {}), "\nhello, world\n"));
+  CHECK(host::contains(parse(CAPTURED[1], {}), "?name=room 1"));
+}
+
+
+TEST(everySplitParsesTheSame)
+{
+  for(const char* request : CAPTURED){
+    std::string whole = parse(request, {});
+    for(size_t cut = 1; cut < strlen(request); ++cut) CHECK(parse(request, {cut}) == whole);
+  }
+}
+
+
+TEST(byteByByteParsesTheSame)
+{
+  for(const char* request : CAPTURED){
+    std::vector<size_t> cuts;
+    for(size_t cut = 1; cut < strlen(request); ++cut) cuts.push_back(cut);
+    CHECK(parse(request, cuts) == parse(request, {}));
+  }
+}
+
+
+TEST(randomSegmentationsParseTheSame)
+{
+  std::mt19937 random(2);
+  for(int round = 0; round < 2000; ++round)
+  {
+    std::string request = CAPTURED[random() % (sizeof(CAPTURED) / sizeof(CAPTURED[0]))];
+    std::vector<size_t> cuts;
+    for(size_t cut = 1 + random() % 8; cut < request.size(); cut += 1 + random() % 16) cuts.push_back(cut);
+    CHECK(parse(request, cuts) == parse(request, {}));
+  }
+}
+
+
+TEST(pipelinedRequestsStopAtTheirEnd)
+{
+  std::string first = CAPTURED[3];
+  std::string pipelined = first + CAPTURED[0];
+  CHECK(host::contains(parse(pipelined, {}), "8 0 " + std::to_string(first.size()) + "\n"));
+}
+
+
+TEST(ambiguousFramingIsRejected)
+{
+  // RFC 9112 6.3: a request framed twice could be read differently by a proxy
+  CHECK(statusOf("POST / HTTP/1.1\r\nContent-Length: 3\r\nTransfer-Encoding: chunked\r\n\r\n0\r\n\r\n") == 400);
+  CHECK(statusOf("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\nContent-Length: 3\r\n\r\n0\r\n\r\n") == 400);
+  CHECK(statusOf("POST / HTTP/1.1\r\nContent-Length: 3\r\nContent-Length: 4\r\n\r\nabcd") == 400);
+  CHECK(statusOf("POST / HTTP/1.1\r\nContent-Length: 3\r\nContent-Length: 3\r\n\r\nabc") == 400);
+  CHECK(statusOf("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\nTransfer-Encoding: chunked\r\n\r\n0\r\n\r\n") == 400);
+  CHECK(statusOf("POST / HTTP/1.1\r\nContent-Length: +3\r\n\r\nabc") == 400);
+  CHECK(statusOf("POST / HTTP/1.1\r\nContent-Length: \xb3\r\n\r\nabc") == 400);
+  CHECK(statusOf("POST / HTTP/1.1\r\nContent-Length: 3\r\n\r\nabc") == 200);
+  // RFC 9112 5.1: a name followed by whitespace would not be read as the framing header, and
+  // the body would be parsed as a pipelined request
+  CHECK(statusOf("POST / HTTP/1.1\r\nContent-Length : 5\r\n\r\nGET /") == 400);
+  CHECK(statusOf("POST / HTTP/1.1\r\nTransfer-Encoding\t: chunked\r\n\r\n0\r\n\r\n") == 400);
+}
+
+
+TEST(bareCRAndNULAreRejected)
+{
+  CHECK(statusOf("GET /a\rb HTTP/1.1\r\n\r\n") == 400);
+  CHECK(statusOf("GET / HTTP/1.1\r\nHost: a\rX-Smuggled: 1\r\n\r\n") == 400);
+  CHECK(statusOf("GET / HTTP/1.1\r\r\n\r\n") == 400);
+  CHECK(statusOf(std::string("GET /a\0b HTTP/1.1\r\n\r\n", 21)) == 400);
+  CHECK(statusOf(std::string("GET / HTTP/1.1\r\nHost: a\0b\r\n\r\n", 29)) == 400);
+  CHECK(statusOf("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n3\rx\r\nabc\r\n0\r\n\r\n") == 400);
+  // the body is not a line, it can hold any byte
+  CHECK(statusOf(std::string("POST / HTTP/1.1\r\nContent-Length: 3\r\n\r\n\0\r\0", 41)) == 200);
+}
+
+
+TEST(limitsAreEnforced)
+{
+  CHECK(statusOf("GET /" + std::string(ArduinoExpressConfig::MAX_REQUEST_LINE_LENGTH, 'a') + " HTTP/1.1\r\n\r\n") == 414);
+  CHECK(statusOf("GET / HTTP/1.1\r\nX: " + std::string(ArduinoExpressConfig::MAX_HEADER_LINE_LENGTH, 'a') + "\r\n\r\n") == 431);
+
+  std::string manyHeaders = "GET / HTTP/1.1\r\n";
+  for(int i = 0; i <= ArduinoExpressConfig::MAX_HEADERS_COUNT; ++i) manyHeaders += "X-" + std::to_string(i) + ": 1\r\n";
+  CHECK(statusOf(manyHeaders + "\r\n") == 431);
+
+  const std::string chunked = "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n";
+  const std::string extension(ArduinoExpressConfig::MAX_HEADER_LINE_LENGTH, 'e');
+  CHECK(statusOf(chunked + "1;" + extension.substr(2) + "\r\na\r\n0\r\n\r\n") == 200);
+  CHECK(statusOf(chunked + "1;" + extension + "\r\na\r\n0\r\n\r\n") == 400);
+  CHECK(statusOf(chunked + "1" + std::string(ArduinoExpressConfig::MAX_HEADER_LINE_LENGTH, ' ') + "\r\na\r\n0\r\n\r\n") == 400);
+}
+
+
+TEST(randomBytesStayInBounds)
+{
+  // mutated captured requests and random bytes, fed in random segments. The parser must stop in a
+  // valid state without reading or writing out of its buffer (run with ARDUINOEXPRESS_SANITIZE)
+  std::mt19937 random(7);
+  for(int round = 0; round < 20000; ++round)
+  {
+    std::string request = CAPTURED[random() % (sizeof(CAPTURED) / sizeof(CAPTURED[0]))];
+    if(round % 4 == 0){
+      request.resize(random() % 600);
+      for(char& c : request) c = random() % 4 ? "GET /:\r\n 0123456789abcdefHTP"[random() % 30] : (char)random();
+    }
+    else{
+      for(int mutations = 1 + random() % 4; mutations > 0; --mutations){
+        size_t at = random() % request.size();
+        switch(random() % 3){
+          case 0: request[at] = (char)random(); break;
+          case 1: request.erase(at, 1 + random() % 4); break;
+          default: request.insert(at, std::string(1 + random() % 300, (char)random())); break;
+        }
+        if(request.empty()) request = "\r\n";
+      }
+    }
+
+    std::vector<size_t> cuts;
+    for(size_t cut = 1 + random() % 32; cut < request.size(); cut += 1 + random() % 32) cuts.push_back(cut);
+    std::string result = parse(request, cuts);
+    int state = atoi(result.c_str());
+    CHECK(state <= HTTP_RequestParser::ERROR);
+  }
+}
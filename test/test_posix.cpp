@@ -0,0 +1,199 @@
+// HTTP_PosixTransport: requests served over real TCP sockets on localhost, clients turned away
+// half-closed, slow readers sent their responses without holding up the others, and the sockets
+// begin() opens closed when it fails or is called again
+
+#include "HostTest.h"
+#include "ArduinoExpress.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// returns the file descriptors the process has open
+static int openFiles()
+{
+  int count = 0;
+  DIR* directory = opendir("/proc/self/fd");
+  while(readdir(directory)) ++count;
+  closedir(directory);
+  return count;
+}
+
+// int listenOn(port)
+// returns a socket listening on port, on a free port if port is 0
+static int listenOn(uint16_t port)
+{
+  int listener = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(port);
+  bind(listener, (sockaddr*)&address, sizeof(address));
+  ::listen(listener, 1);
+  return listener;
+}
+
+static uint16_t portOf(int listener)
+{
+  sockaddr_in address = {};
+  socklen_t length = sizeof(address);
+  getsockname(listener, (sockaddr*)&address, &length);
+  return ntohs(address.sin_port);
+}
+
+// returns a port nothing listens on
+static uint16_t freePort()
+{
+  int listener = listenOn(0);
+  uint16_t port = portOf(listener);
+  close(listener);
+  return port;
+}
+
+
+TEST(beginAgainClosesThePreviousSockets)
+{
+  HTTP_PosixTransport transport;
+  CHECK(transport.begin(freePort()));
+  int files = openFiles();
+
+  CHECK(transport.begin(freePort()));
+  CHECK(openFiles() == files);
+}
+
+
+TEST(aFailedBeginLeavesNoSocketOpen)
+{
+  int taken = listenOn(0);
+  HTTP_PosixTransport transport;
+  int files = openFiles();
+
+  CHECK(!transport.begin(portOf(taken)));
+  CHECK(openFiles() == files);
+  close(taken);
+}
+
+
+TEST(requestsAreServedOverTcp)
+{
+  uint16_t port = freePort();
+  ArduinoExpress app;
+  app.get("/led", [](Req&, Res& res) -> void* {res.send(200, "text/plain", "on"); return nullptr;});
+  CHECK(app.begin(port));
+
+  int client = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(port);
+  CHECK(connect(client, (sockaddr*)&address, sizeof(address)) == 0);
+  const std::string request = "GET /led HTTP/1.1\r\nHost: gateway\r\n\r\n";
+  send(client, request.data(), request.size(), 0);
+
+  std::string response;
+  CHECK(host::pump(app, [&]{
+    char buffer[256];
+    ssize_t count = recv(client, buffer, sizeof(buffer), MSG_DONTWAIT);
+    if(count > 0) response.append(buffer, count);
+    return host::responseLength(response) != 0;
+  }));
+  CHECK(host::contains(response, "200 OK"));
+  CHECK(host::contains(response, "\r\n\r\non"));
+  close(client);
+}
+
+
+TEST(turnedAwayClientGetsTheWholeResponse)
+{
+  uint16_t port = freePort();
+  ArduinoExpress app;
+  app.get("/led", [](Req&, Res& res) -> void* {res.send(200, "text/plain", "on"); return nullptr;});
+  app.setAdmission(0);
+  CHECK(app.begin(port));
+
+  int client = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(port);
+  CHECK(connect(client, (sockaddr*)&address, sizeof(address)) == 0);
+  const std::string request = "GET /led HTTP/1.1\r\nHost: gateway\r\n\r\n";
+  send(client, request.data(), request.size(), 0);
+
+  // the request is not read before the 503: the server half-closes instead of resetting the
+  // connection, the client reads the response and then the end of the stream
+  std::string response;
+  ssize_t count = 0;
+  CHECK(host::pump(app, [&]{
+    char buffer[256];
+    count = recv(client, buffer, sizeof(buffer), MSG_DONTWAIT);
+    if(count > 0) response.append(buffer, count);
+    return count == 0 || (count == -1 && errno != EAGAIN);
+  }));
+  CHECK(count == 0);
+  CHECK(host::contains(response, "HTTP/1.1 503"));
+  CHECK(host::responseLength(response) == response.size());
+  close(client);
+}
+
+
+TEST(aClientThatDoesntReadHoldsUpNoOther)
+{
+  // a body much larger than what the sockets buffer
+  static uint8_t block[65536];
+  const int BLOCKS_COUNT = 128;
+  uint16_t port = freePort();
+  ArduinoExpress app;
+  app.get("/log", [](Req&, Res& res) -> void* {
+    res.beginStream(200, "application/octet-stream", sizeof(block) * BLOCKS_COUNT);
+    for(int i = 0; i < BLOCKS_COUNT; ++i) res.write(block, sizeof(block));
+    return nullptr;
+  });
+  app.get("/led", [](Req&, Res& res) -> void* {res.send(200, "text/plain", "on"); return nullptr;});
+  CHECK(app.begin(port));
+
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(port);
+  int slow = socket(AF_INET, SOCK_STREAM, 0);
+  int receiveBuffer = 4096;
+  setsockopt(slow, SOL_SOCKET, SO_RCVBUF, &receiveBuffer, sizeof(receiveBuffer));
+  CHECK(connect(slow, (sockaddr*)&address, sizeof(address)) == 0);
+  const std::string download = "GET /log HTTP/1.1\r\nConnection: close\r\n\r\n";
+  send(slow, download.data(), download.size(), 0);
+  unsigned long start = millis();
+  host::pump(app, [&]{return false;}, 100);
+
+  // served while the slow client reads nothing
+  int fast = socket(AF_INET, SOCK_STREAM, 0);
+  CHECK(connect(fast, (sockaddr*)&address, sizeof(address)) == 0);
+  const std::string request = "GET /led HTTP/1.1\r\n\r\n";
+  send(fast, request.data(), request.size(), 0);
+  std::string response;
+  CHECK(host::pump(app, [&]{
+    char buffer[256];
+    ssize_t count = recv(fast, buffer, sizeof(buffer), MSG_DONTWAIT);
+    if(count > 0) response.append(buffer, count);
+    return host::responseLength(response) != 0;
+  }));
+  CHECK(millis() - start < ArduinoExpressConfig::REQUEST_TIMEOUT_MS / 10);
+  CHECK(host::contains(response, "\r\n\r\non"));
+  close(fast);
+
+  // the slow client is sent the whole body, then the end of the stream
+  size_t received = 0;
+  ssize_t count = 0;
+  CHECK(host::pump(app, [&]{
+    static char buffer[65536];
+    count = recv(slow, buffer, sizeof(buffer), MSG_DONTWAIT);
+    if(count > 0) received += count;
+    return count == 0 || (count == -1 && errno != EAGAIN);
+  }, 10000000));
+  CHECK(count == 0);
+  CHECK(received > sizeof(block) * BLOCKS_COUNT);
+  CHECK(received - sizeof(block) * BLOCKS_COUNT < 256);
+  close(slow);
+}
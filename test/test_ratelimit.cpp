@@ -0,0 +1,302 @@
+// Rate limiting and admission control on the simulated clock: the token buckets of HTTP_RateLimiter
+// and the 429s of ArduinoExpress::RateLimit(), and the clients setAdmission() turns away with 503,
+// which are drained before they are closed
+
+#include "HostTest.h"
+#include "ArduinoExpress.h"
+
+#include <climits>
+
+static const char* const REQUEST = "GET /led HTTP/1.1\r\nHost: device\r\n\r\n";
+
+static void setupApp(ArduinoExpress& app)
+{
+  app.get("/led", [](Req&, Res& res) -> void* {res.send(200, "text/plain", "on"); return nullptr;});
+  app.begin(80);
+}
+
+// std::string requestFrom(app, remoteIP, request)
+// like host::exchange(), from a client at remoteIP
+static std::string requestFrom(ArduinoExpress& app, uint32_t remoteIP, const std::string& request = REQUEST)
+{
+  host::SimulatedClient client = host::connect(80, remoteIP);
+  client.send(request);
+  client.close();
+  host::pump(app, [&]{return client.closedByServer();});
+  return client.received();
+}
+
+static unsigned long _now = 0;
+static unsigned long now() {return _now;}
+
+
+TEST(burstIsServedThenRefilledAtTheRate)
+{
+  host::useSimulatedClock(true);
+  HTTP_RateLimiter limiter(60, 3);
+  uint32_t retryAfter = 0;
+
+  for(int i = 0; i < 3; ++i) CHECK(limiter.take(1, retryAfter));
+  CHECK(!limiter.take(1, retryAfter));
+  CHECK(retryAfter == 1);
+
+  host::advanceClock(999 * 1000);
+  CHECK(!limiter.take(1, retryAfter));
+  host::advanceClock(1000);
+  CHECK(limiter.take(1, retryAfter));
+  CHECK(!limiter.take(1, retryAfter));
+}
+
+
+TEST(bucketHoldsAtMostTheBurst)
+{
+  host::useSimulatedClock(true);
+  HTTP_RateLimiter limiter(60, 2);
+  uint32_t retryAfter = 0;
+
+  CHECK(limiter.take(1, retryAfter));
+  host::advanceClock(600000000UL);
+  CHECK(limiter.take(1, retryAfter));
+  CHECK(limiter.take(1, retryAfter));
+  CHECK(!limiter.take(1, retryAfter));
+}
+
+
+TEST(retryAfterIsRoundedUpToSeconds)
+{
+  host::useSimulatedClock(true);
+  HTTP_RateLimiter limiter(1, 1);
+  uint32_t retryAfter = 0;
+
+  CHECK(limiter.take(1, retryAfter));
+  CHECK(!limiter.take(1, retryAfter));
+  CHECK(retryAfter == 60);
+
+  host::advanceClock(30500 * 1000);
+  CHECK(!limiter.take(1, retryAfter));
+  CHECK(retryAfter == 30);
+}
+
+
+TEST(bucketsAreRefilledAcrossTheClockWrapping)
+{
+  _now = ULONG_MAX - 500;
+  HTTP_RateLimiter limiter(60, 1);
+  limiter.setClock(now);
+  uint32_t retryAfter = 0;
+
+  CHECK(limiter.take(1, retryAfter));
+  CHECK(!limiter.take(1, retryAfter));
+  _now += 1000;
+  CHECK(limiter.take(1, retryAfter));
+}
+
+
+TEST(leastRecentlyUsedClientIsForgotten)
+{
+  host::useSimulatedClock(true);
+  HTTP_RateLimiter limiter(1, 1);
+  uint32_t retryAfter = 0;
+
+  // keys of the same probe window, each uses its whole bucket
+  const int entries = ArduinoExpressConfig::RATE_LIMIT_ENTRIES_COUNT;
+  for(int i = 1; i <= ArduinoExpressConfig::RATE_LIMIT_PROBE_LENGTH; ++i){
+    CHECK(limiter.take(i * entries, retryAfter));
+    host::advanceClock(1000);
+  }
+
+  // the first one is forgotten for the new one, and starts again with a full bucket
+  CHECK(limiter.take(100 * entries, retryAfter));
+  CHECK(limiter.take(1 * entries, retryAfter));
+  // the others are still limited
+  CHECK(!limiter.take(3 * entries, retryAfter));
+  CHECK(!limiter.take(100 * entries, retryAfter));
+}
+
+
+TEST(clearForgetsEveryClient)
+{
+  host::useSimulatedClock(true);
+  HTTP_RateLimiter limiter(1, 1);
+  uint32_t retryAfter = 0;
+
+  CHECK(limiter.take(1, retryAfter));
+  CHECK(!limiter.take(1, retryAfter));
+  limiter.clear();
+  CHECK(limiter.take(1, retryAfter));
+}
+
+
+TEST(requestsBeyondTheBurstAreAnswered429)
+{
+  host::useSimulatedClock(true);
+  HTTP_RateLimiter limiter(60, 2);
+  ArduinoExpress app;
+  app.use(ArduinoExpress::RateLimit(limiter));
+  setupApp(app);
+
+  CHECK(host::contains(host::exchange(app, REQUEST), "\r\n\r\non"));
+  CHECK(host::contains(host::exchange(app, REQUEST), "\r\n\r\non"));
+  std::string limited = host::exchange(app, REQUEST);
+  CHECK(host::contains(limited, "HTTP/1.1 429 Too Many Requests"));
+  CHECK(host::contains(limited, "Retry-After: 1\r\n"));
+
+  host::advanceClock(1000 * 1000);
+  CHECK(host::contains(host::exchange(app, REQUEST), "\r\n\r\non"));
+}
+
+
+TEST(clientsAreLimitedByTheirAddress)
+{
+  host::useSimulatedClock(true);
+  HTTP_RateLimiter limiter(60, 1);
+  ArduinoExpress app;
+  app.use(ArduinoExpress::RateLimit(limiter));
+  setupApp(app);
+
+  CHECK(host::contains(requestFrom(app, IPAddress(192, 168, 4, 2)), "200 OK"));
+  CHECK(host::contains(requestFrom(app, IPAddress(192, 168, 4, 2)), "429"));
+  CHECK(host::contains(requestFrom(app, IPAddress(192, 168, 4, 3)), "200 OK"));
+}
+
+
+TEST(clientsAreLimitedByTheirKeyHeader)
+{
+  host::useSimulatedClock(true);
+  HTTP_RateLimiter limiter(60, 1);
+  ArduinoExpress app;
+  app.use(ArduinoExpress::RateLimit(limiter, "X-Api-Key"));
+  setupApp(app);
+
+  const std::string first = "GET /led HTTP/1.1\r\nX-Api-Key: sensor-1\r\n\r\n";
+  const std::string second = "GET /led HTTP/1.1\r\nX-Api-Key: sensor-2\r\n\r\n";
+  CHECK(host::contains(host::exchange(app, first), "200 OK"));
+  CHECK(host::contains(host::exchange(app, first), "429"));
+  CHECK(host::contains(host::exchange(app, second), "200 OK"));
+  // without the header, the client's address is its key
+  CHECK(host::contains(host::exchange(app, REQUEST), "200 OK"));
+}
+
+
+// the active connections of the tests of admission control: the last one turns clients away
+static const int ACTIVE_COUNT = ArduinoExpressConfig::MAX_CONNECTIONS_COUNT - 1;
+
+// opens count connections, each with a request it hasn't finished sending
+static std::vector<host::SimulatedClient> occupy(ArduinoExpress& app, int count = ACTIVE_COUNT)
+{
+  std::vector<host::SimulatedClient> clients;
+  for(int i = 0; i < count; ++i){
+    clients.push_back(host::connect());
+    clients.back().send("GET /led HTTP/1.1\r\n");
+  }
+  host::pump(app, [&]{
+    for(host::SimulatedClient& client : clients) if(!client.drained()) return false;
+    return true;
+  });
+  return clients;
+}
+
+
+TEST(noClientIsTurnedAwayByDefault)
+{
+  host::useSimulatedClock(true);
+  ArduinoExpress app;
+  setupApp(app);
+  std::vector<host::SimulatedClient> clients = occupy(app, ArduinoExpressConfig::MAX_CONNECTIONS_COUNT);
+
+  for(host::SimulatedClient& client : clients) client.send("Host: device\r\n\r\n");
+  for(host::SimulatedClient& client : clients){
+    CHECK(host::pump(app, [&]{return host::responseLength(client.received()) > 0;}));
+    CHECK(host::contains(client.received(), "\r\n\r\non"));
+  }
+}
+
+
+TEST(clientBeyondTheActiveConnectionsIsAnswered503)
+{
+  host::useSimulatedClock(true);
+  ArduinoExpress app;
+  setupApp(app);
+  app.setAdmission(ACTIVE_COUNT);
+  std::vector<host::SimulatedClient> active = occupy(app);
+
+  host::SimulatedClient turnedAway = host::connect();
+  turnedAway.send(REQUEST);
+  CHECK(host::pump(app, [&]{return host::responseLength(turnedAway.received()) > 0;}));
+  CHECK(host::contains(turnedAway.received(), "HTTP/1.1 503 Service Unavailable"));
+  CHECK(host::contains(turnedAway.received(), "Retry-After: 1\r\n"));
+  CHECK(host::contains(turnedAway.received(), "Connection: close"));
+
+  // its request is read and discarded, the connection is closed once the client is gone
+  CHECK(host::pump(app, [&]{return turnedAway.drained();}));
+  CHECK(!turnedAway.closedByServer());
+  turnedAway.close();
+  CHECK(host::pump(app, [&]{return turnedAway.closedByServer();}));
+
+  // the active clients are still served
+  for(host::SimulatedClient& client : active) client.send("Host: device\r\n\r\n");
+  for(host::SimulatedClient& client : active){
+    CHECK(host::pump(app, [&]{return host::responseLength(client.received()) > 0;}));
+    CHECK(host::contains(client.received(), "\r\n\r\non"));
+  }
+}
+
+
+TEST(drainedClientIsClosedAfterTheDrainTimeout)
+{
+  host::useSimulatedClock(true);
+  ArduinoExpress app;
+  setupApp(app);
+  app.setAdmission(ACTIVE_COUNT);
+  std::vector<host::SimulatedClient> active = occupy(app);
+
+  host::SimulatedClient turnedAway = host::connect();
+  CHECK(host::pump(app, [&]{return host::responseLength(turnedAway.received()) > 0;}));
+
+  // what it keeps sending doesn't keep it open
+  host::advanceClock(ArduinoExpressConfig::ADMISSION_DRAIN_MS * 1000 / 2);
+  turnedAway.send(REQUEST);
+  CHECK(host::pump(app, [&]{return turnedAway.drained();}));
+  host::advanceClock(ArduinoExpressConfig::ADMISSION_DRAIN_MS * 1000 / 2);
+  app.handle();
+  CHECK(!turnedAway.closedByServer());
+
+  host::advanceClock(1000);
+  app.handle();
+  CHECK(turnedAway.closedByServer());
+  CHECK(host::responseLength(turnedAway.received()) == turnedAway.received().size());
+}
+
+
+TEST(waitingClientsAreTurnedAwayInTurn)
+{
+  host::useSimulatedClock(true);
+  ArduinoExpress app;
+  setupApp(app);
+  app.setAdmission(ACTIVE_COUNT);
+  std::vector<host::SimulatedClient> active = occupy(app);
+
+  host::SimulatedClient first = host::connect();
+  host::SimulatedClient second = host::connect();
+  CHECK(host::pump(app, [&]{return host::responseLength(first.received()) > 0;}));
+  // the draining connection is not active, but holds its slot
+  app.handle();
+  CHECK(!second.accepted());
+
+  first.close();
+  CHECK(host::pump(app, [&]{return host::responseLength(second.received()) > 0;}));
+  CHECK(host::contains(second.received(), "503"));
+}
+
+
+TEST(clientsAreTurnedAwayWhileTheHeapIsLow)
+{
+  ArduinoExpress app;
+  setupApp(app);
+  app.setAdmission(ArduinoExpressConfig::MAX_CONNECTIONS_COUNT, 16384);
+
+  host::setFreeHeap(12000);
+  CHECK(host::contains(host::exchange(app, REQUEST), "503"));
+  host::setFreeHeap(40000);
+  CHECK(host::contains(host::exchange(app, REQUEST), "200 OK"));
+}
@@ -0,0 +1,155 @@
+// The router: routes indexed by RouteTrie, and the prefixes of middlewares and routers
+
+#include "HostTest.h"
+#include "ArduinoExpress.h"
+
+static void* sendPath(Req& req, Res& res)
+{
+  res.send(200, "text/plain", req.route.toString());
+  return nullptr;
+}
+
+static std::string get(ArduinoExpress& app, const char* path)
+{
+  return host::exchange(app, std::string("GET ") + path + " HTTP/1.1\r\nHost: device\r\n\r\n");
+}
+
+
+TEST(routesAreNormalised)
+{
+  ArduinoExpress app;
+  app.get("a/b", sendPath);
+  app.begin(80);
+
+  // "/a/b", "a/b" and "/a/b/" are the same route
+  CHECK(host::contains(get(app, "/a/b"), "200 OK"));
+  CHECK(host::contains(get(app, "/a/b/"), "200 OK"));
+  CHECK(!host::contains(get(app, "/a/b/c"), "200 OK"));
+}
+
+
+TEST(routesMatchTheirMethod)
+{
+  ArduinoExpress app;
+  app.post("/led", sendPath);
+  app.begin(80);
+
+  CHECK(!host::contains(get(app, "/led"), "200 OK"));
+  CHECK(host::contains(host::exchange(app, "POST /led HTTP/1.1\r\nContent-Length: 0\r\n\r\n"), "200 OK"));
+}
+
+
+TEST(middlewaresBeforeARouteRunFirst)
+{
+  static int order;
+  order = 0;
+  ArduinoExpress app;
+  app.use([](Req&, Res&, Next next) -> void* {order = order * 10 + 1; next(); return nullptr;});
+  app.get("/led", [](Req& req, Res& res) -> void* {order = order * 10 + 2; return sendPath(req, res);});
+  app.use([](Req&, Res&, Next next) -> void* {order = order * 10 + 3; next(); return nullptr;});
+  app.begin(80);
+
+  get(app, "/led");
+  CHECK(order == 12);
+}
+
+
+TEST(middlewarePrefixesEndOnASegment)
+{
+  static int calls;
+  calls = 0;
+  ArduinoExpress app;
+  app.use("/api", [](Req&, Res&, Next next) -> void* {++calls; next(); return nullptr;});
+  app.get("/api", sendPath);
+  app.get("/api/led", sendPath);
+  app.get("/apix", sendPath);
+  app.begin(80);
+
+  get(app, "/api");
+  get(app, "/api/led");
+  CHECK(calls == 2);
+  get(app, "/apix");
+  CHECK(calls == 2);
+}
+
+
+TEST(routerPrefixesEndOnASegment)
+{
+  ArduinoExpress app;
+  ArduinoExpressRouter api;
+  api.get("/led", sendPath);
+  app.use("/api", &api);
+  app.get("/apix/led", [](Req&, Res& res) -> void* {res.send(200, "text/plain", "app"); return nullptr;});
+  app.begin(80);
+
+  CHECK(host::contains(get(app, "/api/led"), "\r\n\r\n/api/led"));
+  CHECK(host::contains(get(app, "/apix/led"), "\r\n\r\napp"));
+}
+
+
+TEST(aRouterIsMountedOnce)
+{
+  ArduinoExpress app;
+  ArduinoExpressRouter api, other;
+  api.get("/led", sendPath);
+  CHECK(app.use("/api", &api));
+  CHECK(!app.use("/v2", &api));
+  CHECK(!other.use("/api", &api));
+  app.begin(80);
+
+  CHECK(host::contains(get(app, "/api/led"), "\r\n\r\n/api/led"));
+  CHECK(!host::contains(get(app, "/v2/led"), "200 OK"));
+}
+
+
+// int64_t routeBytes(paths)
+// returns the bytes a router with a GET route on each of the 3 paths allocates
+static int64_t routeBytes(const char* const* paths)
+{
+  ArduinoExpressRouter router;
+  int64_t before = host::allocationStats().liveBytes;
+  for(int i = 0; i < 3; ++i) CHECK(router.get(paths[i], sendPath));
+  return host::allocationStats().liveBytes - before;
+}
+
+
+TEST(routeSegmentsAreNotCopied)
+{
+  // the route index points into the literals, longer segments take no more RAM
+  static const char* const shortPaths[] = {"/a/:b", "/a/c", "/d"};
+  static const char* const longPaths[] = {
+    "/aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa/:bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb",
+    "/aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa/cccccccccccccccccccccccccccccccccccccccccccccccccc",
+    "/dddddddddddddddddddddddddddddddddddddddddddddddddd"};
+  CHECK(routeBytes(shortPaths) == routeBytes(longPaths));
+}
+
+
+TEST(flashRoutesCaptureParams)
+{
+  ArduinoExpress app;
+  app.get(F("/led/:pin"), [](Req& req, Res& res) -> void* {
+    res.send(200, "text/plain", req.params[0].key.toString() + "=" + req.getParam("pin").toString());
+    return nullptr;
+  });
+  app.begin(80);
+
+  CHECK(host::contains(get(app, "/led/4"), "\r\n\r\npin=4"));
+}
+
+
+TEST(aRejectedRouteLeavesTheIndexAsItWas)
+{
+  ArduinoExpress app;
+  CHECK(app.get("/files/*", sendPath));
+  {
+    // nothing can follow a wildcard: the route is dropped, and so are the nodes it added
+    String invalid("/new/segments/*/x");
+    CHECK(!app.get(invalid, sendPath));
+  }
+  CHECK(app.get("/new/segments", sendPath));
+  app.begin(80);
+
+  CHECK(host::contains(get(app, "/new/segments"), "\r\n\r\n/new/segments"));
+  CHECK(host::contains(get(app, "/files/a/b"), "\r\n\r\n/files/a/b"));
+}
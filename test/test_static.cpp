@@ -0,0 +1,215 @@
+// ArduinoExpress::Static serving the files of a directory of the PC: content types, index.html,
+// precompressed variants, ETag and 304, byte ranges, and large files streamed in chunks, across
+// passes of handle() for a slow client
+
+#include "HostTest.h"
+#include "ArduinoExpress.h"
+#include "FS.h"
+
+static std::string bigFile()
+{
+  std::string data(200 * 1024, '\0');
+  for(size_t i = 0; i < data.size(); ++i) data[i] = (char)(i * 7 + i / 251);
+  return data;
+}
+
+struct Site{
+  host::TemporaryDirectory directory;
+  fs::FS files{directory.path()};
+  ArduinoExpress app;
+
+  Site()
+  {
+    directory.write("www/index.html", "<h1>home</h1>");
+    directory.write("www/app.js", "console.log('plain')");
+    directory.write("www/app.js.gz", "gzipped app.js");
+    directory.write("www/docs/index.html", "<h1>docs</h1>");
+    directory.write("www/firmware.bin", bigFile());
+    directory.write("secret.txt", "password");
+
+    app.use(ArduinoExpress::Static("/assets", files, "/www/"));
+    app.get("/assets/missing", [](Req&, Res& res) -> void* {res.send(200, "text/plain", "route"); return nullptr;});
+    app.begin(80);
+  }
+
+  std::string get(const char* path, const std::string& headers = "")
+  {
+    return host::exchange(app, std::string("GET ") + path + " HTTP/1.1\r\nHost: device\r\n" + headers + "\r\n");
+  }
+};
+
+static std::string bodyOf(const std::string& response)
+{
+  size_t end = response.find("\r\n\r\n");
+  return end == std::string::npos ? "" : response.substr(end + 4);
+}
+
+static std::string headerOf(const std::string& response, const std::string& name)
+{
+  size_t start = response.find("\r\n" + name + ": ");
+  if(start == std::string::npos) return "";
+  start += name.size() + 4;
+  return response.substr(start, response.find("\r\n", start) - start);
+}
+
+
+TEST(filesAreServedWithTheirType)
+{
+  Site site;
+  std::string response = site.get("/assets/app.js");
+  CHECK(host::contains(response, "HTTP/1.1 200 OK\r\n"));
+  CHECK(headerOf(response, "Content-Type") == "application/javascript");
+  CHECK(headerOf(response, "Cache-Control") == "public, max-age=86400");
+  CHECK(headerOf(response, "Accept-Ranges") == "bytes");
+  CHECK(headerOf(response, "Content-Encoding").empty());
+  CHECK(bodyOf(response) == "console.log('plain')");
+}
+
+
+TEST(directoriesServeTheirIndex)
+{
+  Site site;
+  CHECK(bodyOf(site.get("/assets/")) == "<h1>home</h1>");
+  CHECK(bodyOf(site.get("/assets/docs/")) == "<h1>docs</h1>");
+  CHECK(headerOf(site.get("/assets/docs/"), "Content-Type") == "text/html");
+}
+
+
+TEST(precompressedVariantIsServedToGzipClients)
+{
+  Site site;
+  std::string response = site.get("/assets/app.js", "Accept-Encoding: gzip, deflate\r\n");
+  CHECK(headerOf(response, "Content-Encoding") == "gzip");
+  CHECK(headerOf(response, "Vary") == "Accept-Encoding");
+  CHECK(headerOf(response, "Content-Type") == "application/javascript");
+  CHECK(bodyOf(response) == "gzipped app.js");
+
+  CHECK(bodyOf(site.get("/assets/app.js", "Accept-Encoding: deflate\r\n")) == "console.log('plain')");
+}
+
+
+TEST(precompressedVariantIsNotSentWithoutItsHeader)
+{
+  host::TemporaryDirectory directory;
+  directory.write("www/app.js.gz", "gzipped app.js");
+  fs::FS files{directory.path()};
+  ArduinoExpress app;
+  // Static sets 5 headers before Content-Encoding: it can't be set once these are added
+  app.use([](Req&, Res& res, Next next) -> void* {
+    char name[16];
+    for(int i = 0; i + 4 < ArduinoExpressConfig::MAX_HEADERS_COUNT; ++i){
+      snprintf(name, sizeof(name), "X-Filler-%d", i);
+      res.setHeader(name, "1");
+    }
+    next();
+    return nullptr;
+  });
+  app.use(ArduinoExpress::Static("/assets", files, "/www/"));
+  app.begin(80);
+
+  std::string response = host::exchange(app, "GET /assets/app.js HTTP/1.1\r\nAccept-Encoding: gzip\r\n\r\n");
+  CHECK(host::contains(response, "500 Internal Server Error"));
+  CHECK(!host::contains(response, "gzipped"));
+}
+
+
+TEST(matchingETagIsAnswered304)
+{
+  Site site;
+  std::string etag = headerOf(site.get("/assets/app.js"), "ETag");
+  CHECK(!etag.empty());
+
+  // a 304 has no body, and no framing: the next response on the connection follows its head
+  host::SimulatedClient client = host::connect();
+  client.send("GET /assets/app.js HTTP/1.1\r\nIf-None-Match: " + etag + "\r\n\r\nGET /assets/ HTTP/1.1\r\n\r\n");
+  host::pump(site.app, [&]{return host::contains(client.received(), "<h1>home</h1>");});
+  std::string first = client.received().substr(0, client.received().find("HTTP/1.1 200"));
+  CHECK(host::contains(first, "HTTP/1.1 304 "));
+  CHECK(headerOf(first, "ETag") == etag);
+  CHECK(!host::contains(first, "Content-Length"));
+  CHECK(!host::contains(first, "Transfer-Encoding"));
+  CHECK(first.size() == first.find("\r\n\r\n") + 4);
+
+  CHECK(host::contains(site.get("/assets/app.js", "If-None-Match: \"other\"\r\n"), "HTTP/1.1 200"));
+  CHECK(host::contains(site.get("/assets/app.js", "If-None-Match: *\r\n"), "HTTP/1.1 304"));
+}
+
+
+TEST(byteRangesAreServed)
+{
+  Site site;
+  std::string response = site.get("/assets/app.js", "Range: bytes=0-6\r\n");
+  CHECK(host::contains(response, "HTTP/1.1 206 "));
+  CHECK(headerOf(response, "Content-Range") == "bytes 0-6/20");
+  CHECK(bodyOf(response) == "console");
+
+  CHECK(bodyOf(site.get("/assets/app.js", "Range: bytes=-7\r\n")) == "plain')");
+  CHECK(bodyOf(site.get("/assets/app.js", "Range: bytes=12-\r\n")) == "'plain')");
+
+  response = site.get("/assets/app.js", "Range: bytes=20-30\r\n");
+  CHECK(host::contains(response, "HTTP/1.1 416 "));
+  CHECK(headerOf(response, "Content-Range") == "bytes */20");
+
+  // several ranges are not supported, the whole file is sent
+  CHECK(host::contains(site.get("/assets/app.js", "Range: bytes=0-1,4-5\r\n"), "HTTP/1.1 200"));
+}
+
+
+TEST(filesOutsideTheRootAreNotServed)
+{
+  Site site;
+  CHECK(host::contains(site.get("/assets/../secret.txt"), "HTTP/1.1 403 "));
+  CHECK(!host::contains(site.get("/assets/..%2Fsecret.txt"), "password"));
+}
+
+
+TEST(otherRequestsGoToTheNextCallback)
+{
+  Site site;
+  CHECK(bodyOf(site.get("/assets/missing")) == "route");
+  CHECK(!host::contains(site.get("/assetsx/app.js"), "console.log"));
+  CHECK(!host::contains(host::exchange(site.app, "POST /assets/app.js HTTP/1.1\r\nContent-Length: 0\r\n\r\n"), "console.log"));
+}
+
+
+TEST(largeFileIsStreamedInChunks)
+{
+  Site site;
+  host::SimulatedClient client = host::connect();
+  client.send("GET /assets/firmware.bin HTTP/1.1\r\nConnection: close\r\n\r\n");
+  int64_t before = host::allocationStats().liveBytes;
+  host::resetPeak();
+  host::pump(site.app, [&]{return client.closedByServer();});
+
+  CHECK(host::allocationStats().peakBytes - before < 1024);
+  CHECK(headerOf(client.received(), "Content-Length") == std::to_string(200 * 1024));
+  CHECK(bodyOf(client.received()) == bigFile());
+}
+
+
+TEST(slowClientDoesntHoldUpTheOthers)
+{
+  host::useSimulatedClock(true);
+  Site site;
+  host::NetworkConditions slowLink;
+  slowLink.bytesPerSecond = 20000;
+  host::setConditions(slowLink);
+  host::SimulatedClient slow = host::connect();
+  slow.send("GET /assets/firmware.bin HTTP/1.1\r\nConnection: close\r\n\r\n");
+  unsigned long start = micros();
+  CHECK(host::pump(site.app, [&]{host::advanceClock(1000); return slow.drained();}));
+
+  // the other client is served while the file is a tenth sent
+  host::setConditions({});
+  host::SimulatedClient fast = host::connect();
+  fast.send("GET /assets/app.js HTTP/1.1\r\nConnection: close\r\n\r\n");
+  CHECK(host::pump(site.app, [&]{return fast.closedByServer();}));
+  CHECK(bodyOf(fast.received()) == "console.log('plain')");
+  CHECK(micros() - start < bigFile().size() * 1000000 / slowLink.bytesPerSecond / 10);
+  CHECK(!slow.closedByServer());
+
+  // the file is kept open, and sent as fast as the slow client takes it
+  CHECK(host::pump(site.app, [&]{host::advanceClock(1000); return slow.closedByServer();}));
+  CHECK(bodyOf(slow.received()) == bigFile());
+  CHECK(micros() - start >= bigFile().size() * 1000000 / slowLink.bytesPerSecond - 500000);
+}
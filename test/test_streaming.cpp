@@ -0,0 +1,213 @@
+// Streamed responses: a 64 KB body goes out chunked, or with its Content-Length, through the
+// response's output buffer, and the heap never holds more than a piece of it. A body in the
+// caller's buffer is sent from it, and a String body is freed with its response
+
+#include "HostTest.h"
+#include "ArduinoExpress.h"
+
+static const size_t BODY_SIZE = 64 * 1024;
+static const size_t PIECE_SIZE = 512;
+
+// the byte at offset of the body the handlers send
+static char bodyByte(size_t offset) {return 'a' + offset % 26;}
+
+static void* streamChunked(Req&, Res& res)
+{
+  char piece[PIECE_SIZE];
+  res.beginStream(200, "text/plain");
+  for(size_t offset = 0; offset < BODY_SIZE; offset += PIECE_SIZE){
+    for(size_t i = 0; i < PIECE_SIZE; ++i) piece[i] = bodyByte(offset + i);
+    res.write((const uint8_t*)piece, PIECE_SIZE);
+  }
+  res.end();
+  return nullptr;
+}
+
+static void* streamWithLength(Req&, Res& res)
+{
+  char piece[PIECE_SIZE];
+  res.beginStream(200, "text/plain", BODY_SIZE);
+  for(size_t offset = 0; offset < BODY_SIZE; offset += PIECE_SIZE){
+    for(size_t i = 0; i < PIECE_SIZE; ++i) piece[i] = bodyByte(offset + i);
+    res.write((const uint8_t*)piece, PIECE_SIZE);
+  }
+  return nullptr; // ended by ArduinoExpress
+}
+
+static void* sendInOneString(Req&, Res& res)
+{
+  String body;
+  for(size_t offset = 0; offset < BODY_SIZE; ++offset) body += bodyByte(offset);
+  res.send(200, "text/plain", body);
+  return nullptr;
+}
+
+static void* sendFromABuffer(Req&, Res& res)
+{
+  static char body[BODY_SIZE + 1];
+  for(size_t offset = 0; offset < BODY_SIZE; ++offset) body[offset] = bodyByte(offset);
+  res.send(200, "text/plain", (const char*)body);
+  return nullptr;
+}
+
+// returns the body of a chunked response, or an empty string if its framing is wrong
+static std::string dechunk(const std::string& response)
+{
+  std::string body;
+  size_t at = response.find("\r\n\r\n") + 4;
+  while(true){
+    size_t size = strtoul(response.c_str() + at, nullptr, 16);
+    at = response.find("\r\n", at) + 2;
+    if(size == 0) return response.compare(at, 2, "\r\n") == 0 ? body : "";
+    body.append(response, at, size);
+    at += size;
+    if(response.compare(at, 2, "\r\n") != 0) return "";
+    at += 2;
+  }
+}
+
+static bool isTheBody(const std::string& body)
+{
+  if(body.size() != BODY_SIZE) return false;
+  for(size_t offset = 0; offset < BODY_SIZE; ++offset){
+    if(body[offset] != bodyByte(offset)) return false;
+  }
+  return true;
+}
+
+// serves path, returns the response and the most the heap grew meanwhile
+static std::string serve(const char* path, int64_t& peakGrowth)
+{
+  ArduinoExpress app;
+  app.get("/chunked", streamChunked);
+  app.get("/length", streamWithLength);
+  app.get("/string", sendInOneString);
+  app.get("/buffer", sendFromABuffer);
+  app.begin(80);
+
+  host::SimulatedClient client = host::connect();
+  client.send(std::string("GET ") + path + " HTTP/1.1\r\nConnection: close\r\n\r\n");
+  int64_t before = host::allocationStats().liveBytes;
+  host::resetPeak();
+  host::pump(app, [&]{return client.closedByServer();});
+  peakGrowth = host::allocationStats().peakBytes - before;
+  return client.received();
+}
+
+
+TEST(chunkedStreamKeepsTheHeapFlat)
+{
+  int64_t peak;
+  std::string response = serve("/chunked", peak);
+  CHECK(host::contains(response, "Transfer-Encoding: chunked\r\n"));
+  CHECK(isTheBody(dechunk(response)));
+  CHECK(peak < 1024);
+}
+
+
+TEST(streamWithLengthKeepsTheHeapFlat)
+{
+  int64_t peak;
+  std::string response = serve("/length", peak);
+  CHECK(host::contains(response, "Content-Length: 65536\r\n"));
+  CHECK(isTheBody(response.substr(response.find("\r\n\r\n") + 4)));
+  CHECK(peak < 1024);
+}
+
+
+TEST(bodyInAStringTakesItsSize)
+{
+  // what streaming saves: the same body sent from a String needs all of it on the heap
+  int64_t peak;
+  std::string response = serve("/string", peak);
+  CHECK(isTheBody(response.substr(response.find("\r\n\r\n") + 4)));
+  CHECK(peak >= (int64_t)BODY_SIZE);
+}
+
+
+TEST(bodyInABufferIsNotCopied)
+{
+  int64_t peak;
+  std::string response = serve("/buffer", peak);
+  CHECK(host::contains(response, "Content-Length: 65536\r\n"));
+  CHECK(isTheBody(response.substr(response.find("\r\n\r\n") + 4)));
+  CHECK(peak < 1024);
+}
+
+
+TEST(smallBodyIsCopiedToTheArena)
+{
+  ArduinoExpress app;
+  app.get("/led", [](Req&, Res& res) -> void* {
+    char body[] = "on";
+    res.send(200, "text/plain", (const char*)body);
+    body[0] = 'x';
+    CHECK(res.body().equals("on"));
+    return nullptr;
+  });
+  app.begin(80);
+  CHECK(host::contains(host::exchange(app, "GET /led HTTP/1.1\r\n\r\n"), "\r\n\r\non"));
+}
+
+
+TEST(stringBodyIsFreedWithItsResponse)
+{
+  ArduinoExpress app;
+  app.get("/string", sendInOneString);
+  app.get("/led", [](Req&, Res& res) -> void* {res.send(200, "text/plain", "on"); return nullptr;});
+  app.begin(80);
+
+  host::SimulatedClient client = host::connect();
+  client.send("GET /led HTTP/1.1\r\n\r\n");
+  host::pump(app, [&]{return host::responseLength(client.received()) > 0;});
+  size_t first = host::responseLength(client.received());
+  // what the client received is on the heap too
+  int64_t before = host::allocationStats().liveBytes - client.received().capacity();
+
+  // the connection doesn't keep the body for its next request
+  client.send("GET /string HTTP/1.1\r\n\r\n");
+  host::pump(app, [&]{
+    host::AllocationPause pause;
+    return host::responseLength(client.received().substr(first)) > 0;
+  });
+  CHECK(host::allocationStats().liveBytes - (int64_t)client.received().capacity() - before < 1024);
+}
+
+
+TEST(streamIsWrittenInFewWrites)
+{
+  ArduinoExpress app;
+  app.get("/chunked", streamChunked);
+  app.begin(80);
+  host::SimulatedClient client = host::connect();
+  client.send("GET /chunked HTTP/1.1\r\nConnection: close\r\n\r\n");
+  host::pump(app, [&]{return client.closedByServer();});
+
+  // a piece is a chunk: its size line goes out with the end of the previous one, then its data
+  CHECK(client.writes() <= 2 * BODY_SIZE / PIECE_SIZE + 1);
+}
+
+
+TEST(smallAndLargeWritesMix)
+{
+  ArduinoExpress app;
+  app.get("/mixed", [](Req&, Res& res) -> void* {
+    static char piece[700];
+    res.beginStream(200, "text/plain");
+    size_t offset = 0;
+    for(size_t size : {10, 600, 100, 100, 700, 1, 300}){
+      for(size_t i = 0; i < size; ++i) piece[i] = bodyByte(offset + i);
+      res.write((const uint8_t*)piece, size);
+      offset += size;
+    }
+    return nullptr;
+  });
+  app.begin(80);
+
+  std::string response = host::exchange(app, "GET /mixed HTTP/1.1\r\nConnection: close\r\n\r\n");
+  std::string body = dechunk(response);
+  CHECK(body.size() == 1811);
+  bool same = true;
+  for(size_t offset = 0; offset < body.size(); ++offset) same = same && body[offset] == bodyByte(offset);
+  CHECK(same);
+}
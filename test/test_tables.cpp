@@ -0,0 +1,105 @@
+// The router's tables: sized by what's registered, with no limit from config.h. Hundreds of routes
+// are all served, registering fails loudly once the router is frozen, and freeze() gives back
+// what the tables reserved and don't use
+
+#include "HostTest.h"
+#include "ArduinoExpress.h"
+
+static const int ROUTES_COUNT = 500;
+
+static String routePath(int index)
+{
+  // a static route, and every fourth one a parameterised one
+  if(index % 4 == 3) return String("/api/group") + String(index) + "/:id";
+  return String("/api/group") + String(index / 8) + "/item" + String(index);
+}
+
+static void* sendRoute(Req& req, Res& res)
+{
+  res.send(200, "text/plain", req.route.toString());
+  return nullptr;
+}
+
+static std::string get(ArduinoExpress& app, const std::string& path)
+{
+  return host::exchange(app, "GET " + path + " HTTP/1.1\r\nHost: device\r\n\r\n");
+}
+
+
+TEST(hundredsOfRoutesAreServed)
+{
+  ArduinoExpress app;
+  for(int i = 0; i < ROUTES_COUNT; ++i) CHECK(app.get(routePath(i), sendRoute));
+  app.freeze();
+  app.begin(80);
+
+  for(int i = 0; i < ROUTES_COUNT; ++i){
+    std::string path = routePath(i).c_str();
+    if(i % 4 == 3) path.replace(path.find(":id"), 3, "42");
+    std::string response = get(app, path);
+    CHECK(host::contains(response, "200 OK"));
+    CHECK(host::contains(response, path));
+  }
+  CHECK(host::contains(get(app, "/api/group0/item8"), "500"));
+}
+
+
+TEST(hundredsOfRoutersAreServed)
+{
+  ArduinoExpress app;
+  std::vector<ArduinoExpressRouter> routers(100);
+  for(size_t i = 0; i < routers.size(); ++i){
+    routers[i].get("/status", sendRoute);
+    CHECK(app.use(String("/device") + String((int)i), &routers[i]));
+  }
+  app.freeze();
+  app.begin(80);
+
+  CHECK(host::contains(get(app, "/device0/status"), "200 OK"));
+  CHECK(host::contains(get(app, "/device99/status"), "200 OK"));
+  CHECK(!host::contains(get(app, "/device100/status"), "200 OK"));
+}
+
+
+TEST(frozenRoutersRefuseRoutes)
+{
+  ArduinoExpressRouter router;
+  CHECK(router.get("/a", sendRoute));
+  router.freeze();
+
+  CHECK(router.frozen());
+  CHECK(!router.get("/b", sendRoute));
+  CHECK(!router.use([](Req&, Res&, Next next) -> void* {next(); return nullptr;}));
+}
+
+
+TEST(freezeGivesBackTheUnusedCapacity)
+{
+  ArduinoExpressRouter router;
+  for(int i = 0; i < 33; ++i) router.get(routePath(i), sendRoute);
+
+  size_t grown = router.memoryUsage();
+  int64_t liveBefore = host::allocationStats().liveBytes;
+  router.freeze();
+  CHECK(router.memoryUsage() < grown);
+  CHECK(host::allocationStats().liveBytes < liveBefore);
+}
+
+
+TEST(reservedTablesDontGrow)
+{
+  ArduinoExpressRouter grown;
+  ArduinoExpressRouter reserved;
+  CHECK(reserved.reserve(ROUTES_COUNT, 0));
+
+  uint64_t before = host::allocationStats().allocations;
+  for(int i = 0; i < ROUTES_COUNT; ++i) grown.get(routePath(i), sendRoute);
+  uint64_t grownAllocations = host::allocationStats().allocations - before;
+
+  before = host::allocationStats().allocations;
+  for(int i = 0; i < ROUTES_COUNT; ++i) reserved.get(routePath(i), sendRoute);
+  uint64_t reservedAllocations = host::allocationStats().allocations - before;
+
+  // the routes' paths allocate either way, only the growing of the tables is saved
+  CHECK(reservedAllocations < grownAllocations);
+}
@@ -0,0 +1,135 @@
+// Streamed request bodies: a 1 MB upload, with its Content-Length or chunked, goes to the request's
+// onData() consumer a piece at a time as it arrives, and nothing is allocated for it
+
+#include "HostTest.h"
+#include "ArduinoExpress.h"
+
+static const size_t BODY_SIZE = 1024 * 1024;
+
+static char bodyByte(size_t offset) {return 'a' + offset % 23;}
+
+// what the consumer was given
+struct Upload{
+  size_t length = 0;
+  size_t pieces = 0;
+  size_t largestPiece = 0;
+  bool intact = true;
+  bool ended = false;
+};
+
+static Upload _upload;
+
+static void* receive(Req& req, Res& res)
+{
+  _upload = Upload{};
+  req.onData([](const uint8_t* data, size_t length){
+    for(size_t i = 0; i < length; ++i){
+      if(data[i] != (uint8_t)bodyByte(_upload.length + i)) _upload.intact = false;
+    }
+    _upload.length += length;
+    ++_upload.pieces;
+    if(length > _upload.largestPiece) _upload.largestPiece = length;
+  });
+  req.onEnd([&res](){
+    _upload.ended = true;
+    res.send(200, "text/plain", String((unsigned long)_upload.length));
+  });
+  return nullptr;
+}
+
+static std::string body(size_t size)
+{
+  host::AllocationPause pause;
+  std::string data(size, '\0');
+  for(size_t offset = 0; offset < size; ++offset) data[offset] = bodyByte(offset);
+  return data;
+}
+
+static std::string chunked(const std::string& data, size_t chunkSize)
+{
+  host::AllocationPause pause;
+  std::string framed;
+  char size[16];
+  for(size_t offset = 0; offset < data.size(); offset += chunkSize){
+    size_t length = std::min(chunkSize, data.size() - offset);
+    snprintf(size, sizeof(size), "%zx\r\n", length);
+    framed += size;
+    framed.append(data, offset, length);
+    framed += "\r\n";
+  }
+  return framed + "0\r\n\r\n";
+}
+
+// uploads request on a connection cut in TCP segments, returns the response and the allocations
+// serving it took. The harness frees the segments as they're read, the allocations tell what the
+// library held
+static std::string upload(ArduinoExpress& app, const std::string& request, uint64_t& allocations)
+{
+  host::setConditions({1460, 0, 0, 0});
+  host::SimulatedClient client = host::connect();
+  client.send(request);
+  uint64_t before = host::allocationStats().allocations;
+  host::pump(app, [&]{return client.drained() && host::responseLength(client.received()) > 0;}, 1000000);
+  allocations = host::allocationStats().allocations - before;
+  return client.received();
+}
+
+
+TEST(megabyteWithLengthIsStreamed)
+{
+  ArduinoExpress app;
+  app.post("/firmware", receive);
+  app.begin(80);
+
+  std::string request;
+  {
+    host::AllocationPause pause;
+    request = "POST /firmware HTTP/1.1\r\nContent-Length: " + std::to_string(BODY_SIZE) + "\r\n\r\n" + body(BODY_SIZE);
+  }
+  uint64_t allocations;
+  std::string response = upload(app, request, allocations);
+
+  CHECK(host::contains(response, "200 OK"));
+  CHECK(host::contains(response, "\r\n\r\n1048576"));
+  CHECK(_upload.ended);
+  CHECK(_upload.intact);
+  CHECK(_upload.length == BODY_SIZE);
+  CHECK(_upload.largestPiece <= (size_t)ArduinoExpressConfig::REQUEST_BUFFER_SIZE);
+  // a few for the response, none for the body's pieces
+  CHECK(allocations < 8);
+}
+
+
+TEST(chunkedMegabyteIsStreamed)
+{
+  ArduinoExpress app;
+  app.post("/firmware", receive);
+  app.begin(80);
+
+  std::string request;
+  {
+    host::AllocationPause pause;
+    request = "POST /firmware HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n" + chunked(body(BODY_SIZE), 4000);
+  }
+  uint64_t allocations;
+  std::string response = upload(app, request, allocations);
+
+  CHECK(host::contains(response, "200 OK"));
+  CHECK(_upload.ended);
+  CHECK(_upload.intact);
+  CHECK(_upload.length == BODY_SIZE);
+  // a few for the response, none for the body's pieces
+  CHECK(allocations < 8);
+}
+
+
+TEST(bodiesOverTheLimitAreRefused)
+{
+  ArduinoExpress app;
+  app.post("/firmware", receive);
+  app.setMaxBodySize(BODY_SIZE);
+  app.begin(80);
+
+  std::string request = "POST /firmware HTTP/1.1\r\nContent-Length: " + std::to_string(BODY_SIZE + 1) + "\r\n\r\n";
+  CHECK(host::contains(host::exchange(app, request), "413"));
+}